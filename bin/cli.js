@@ -7,11 +7,162 @@ const path = require('path');
 
 const program = new Command();
 
+/**
+ * Собирает список существующих входных файлов
+ */
+function collectInputFiles(patterns) {
+  const inputFiles = [];
+  for (const pattern of patterns) {
+    if (pattern.includes('*')) {
+      // Для простоты, пока обрабатываем только прямые пути
+      console.warn(`⚠️  Glob patterns not yet supported: ${pattern}`);
+      continue;
+    }
+    
+    const filePath = path.resolve(pattern);
+    if (fs.existsSync(filePath)) {
+      inputFiles.push(filePath);
+    } else {
+      console.warn(`⚠️  File not found: ${filePath}`);
+    }
+  }
+  
+  if (inputFiles.length === 0) {
+    console.error('❌ No input files found');
+    process.exit(1);
+  }
+  return inputFiles;
+}
+
 program
   .name('ts-cpp-bridge')
   .description('TypeScript to C++ bridge generator for Node.js N-API')
   .version('1.0.0');
 
+/**
+ * Разбирает входные файлы и генерирует C++/TS код.
+ * Файлы с неизмененным содержимым не перезаписываются и сохраняют mtime
+ */
+function runGenerate(generator, inputFiles, options, verbose) {
+  // Парсим файлы
+  const parseResult = generator.parseFiles(inputFiles);
+  
+  console.log(`📊 Found ${parseResult.structs.length} structs and ${parseResult.exports.length} exports`);
+  
+  if (verbose && parseResult.structs.length > 0) {
+    console.log('📋 Structs:');
+    parseResult.structs.forEach(s => {
+      console.log(`  - ${s.name} (${s.fields.length} fields)`);
+    });
+  }
+  
+  if (verbose && parseResult.exports.length > 0) {
+    console.log('🔗 Exports:');
+    parseResult.exports.forEach(e => {
+      console.log(`  - ${e.className}::${e.name}(${e.paramType}) -> ${e.returnType}`);
+    });
+  }
+
+  if (verbose && parseResult.classes.length > 0) {
+    console.log('🧩 Classes:');
+    parseResult.classes.forEach(c => {
+      console.log(`  - ${c.name}(${c.constructorParamType}): ${c.methods.map(m => m.methodName).join(', ')}`);
+    });
+  }
+  
+  // Создаем выходную директорию
+  const outputDir = path.resolve(options.output);
+  if (!fs.existsSync(outputDir)) {
+    fs.mkdirSync(outputDir, { recursive: true });
+  }
+  
+  // Генерируем C++ код
+  generator.generateCppCode(parseResult, outputDir, { splitStructs: !!options.splitStructs });
+  
+  // Генерируем TypeScript код, если указана ts-output директория
+  if (options.tsOutput) {
+    const tsOutputDir = path.resolve(options.tsOutput);
+    if (!fs.existsSync(tsOutputDir)) {
+      fs.mkdirSync(tsOutputDir, { recursive: true });
+    }
+    
+    // Генерируем основные файлы
+    generator.generateTypesFile(parseResult, tsOutputDir);
+    generator.generateAddonFile(parseResult, tsOutputDir);
+    
+    if (verbose) {
+      console.log('✅ TypeScript code generation completed!');
+      console.log(`📁 Generated TS files in: ${tsOutputDir}`);
+      console.log('   - generated_types.ts');
+      console.log('   - generated_addon.ts');
+      console.log('   - generated_api.ts');
+    }
+  }
+
+  const stats = generator.takeWriteStats();
+  console.log(`📝 Updated ${stats.written.length} files, ${stats.unchanged.length} unchanged`);
+  stats.written.forEach(f => console.log(`   ~ ${path.relative(process.cwd(), f)}`));
+  
+  if (!verbose) {
+    return;
+  }
+  console.log('✅ C++ code generation completed!');
+  console.log(`📁 Generated files in: ${outputDir}`);
+  console.log('   - generated_runtime.hpp');
+  if (options.splitStructs) {
+    console.log('   - generated_structs.hpp, generated_enums.hpp, generated_property_keys.hpp');
+    console.log('   - generated_struct_<Name>.hpp/.cpp (one per struct)');
+    console.log('   - generated_structs.cpp');
+    console.log('   - generated_sources.gypi (list of .cpp files for binding.gyp)');
+  } else {
+    console.log('   - generated_structs.hpp');
+    console.log('   - generated_structs.cpp');
+  }
+  console.log('   - generated_api.cpp (includes module initialization)');
+  console.log('   - generated_api.h');
+  console.log(`📁 Implementation file: ${path.dirname(outputDir)}/implementation.cpp`);
+  console.log('');
+  console.log('🔧 Next steps:');
+  console.log('   1. Implement the required functions in implementation.cpp');
+  if (options.splitStructs) {
+    console.log(`   2. Add "includes": ["${path.relative(process.cwd(), outputDir) || '.'}/generated_sources.gypi"] and implementation.cpp to your binding.gyp target`);
+  } else {
+    console.log('   2. Add all files to your binding.gyp');
+  }
+  console.log('   3. Run npm run build');
+}
+
+/**
+ * Перегенерирует код при изменении входных файлов, переиспользуя проект ts-morph генератора
+ */
+function watchInputs(inputFiles, regenerate) {
+  let timer = null;
+  const schedule = () => {
+    // Редактор сохраняет файл несколькими событиями - собираем их в одну перегенерацию
+    clearTimeout(timer);
+    timer = setTimeout(() => {
+      console.log(`\n🔄 Change detected, regenerating...`);
+      try {
+        regenerate();
+      } catch (error) {
+        console.error('❌ Error during code generation:', error.message);
+        if (process.env.DEBUG) {
+          console.error(error.stack);
+        }
+      }
+    }, 100);
+  };
+  // watchFile, а не watch: переживает сохранение через переименование временного файла
+  for (const file of inputFiles) {
+    fs.watchFile(file, { interval: 200 }, (curr, prev) => {
+      if (curr.mtimeMs !== prev.mtimeMs) {
+        schedule();
+      }
+    });
+  }
+  console.log('👀 Watching for changes (Ctrl+C to stop)...');
+}
+
 program
   .command('generate')
   .description('Generate C++ glue code from TypeScript decorators')
@@ -19,7 +170,11 @@ program
   .option('-o, --output <dir>', 'Output directory for generated C++ files', './src')
   .option('--ts-output <dir>', 'Output directory for generated TypeScript files')
   .option('-t, --tsconfig <path>', 'Path to tsconfig.json', './tsconfig.json')
+  .option('--split-structs', 'Emit one translation unit per struct (sources listed in generated_sources.gypi)')
+  .option('-w, --watch', 'Regenerate on input changes, reusing the parsed project')
   .action((options) => {
+    let generator;
+    let inputFiles;
     try {
       console.log('🚀 Starting ts-cpp-bridge code generation...');
       
@@ -29,93 +184,102 @@ program
         console.warn(`⚠️  tsconfig.json not found at ${tsConfigPath}, proceeding without it`);
       }
       
-      const generator = new CppGenerator(fs.existsSync(tsConfigPath) ? tsConfigPath : undefined);
+      generator = new CppGenerator(fs.existsSync(tsConfigPath) ? tsConfigPath : undefined);
       
       // Собираем список файлов для парсинга
-      const inputFiles = [];
-      for (const pattern of options.input) {
-        if (pattern.includes('*')) {
-          // Для простоты, пока обрабатываем только прямые пути
-          console.warn(`⚠️  Glob patterns not yet supported: ${pattern}`);
-          continue;
-        }
-        
-        const filePath = path.resolve(pattern);
-        if (fs.existsSync(filePath)) {
-          inputFiles.push(filePath);
-        } else {
-          console.warn(`⚠️  File not found: ${filePath}`);
-        }
-      }
-      
-      if (inputFiles.length === 0) {
-        console.error('❌ No input files found');
-        process.exit(1);
-      }
+      inputFiles = collectInputFiles(options.input);
       
       console.log(`📂 Processing files: ${inputFiles.map(f => path.basename(f)).join(', ')}`);
       
-      // Парсим файлы
-      const parseResult = generator.parseFiles(inputFiles);
-      
-      console.log(`📊 Found ${parseResult.structs.length} structs and ${parseResult.exports.length} exports`);
-      
-      if (parseResult.structs.length > 0) {
-        console.log('📋 Structs:');
-        parseResult.structs.forEach(s => {
-          console.log(`  - ${s.name} (${s.fields.length} fields)`);
-        });
+      runGenerate(generator, inputFiles, options, true);
+    } catch (error) {
+      console.error('❌ Error during code generation:', error.message);
+      if (process.env.DEBUG) {
+        console.error(error.stack);
       }
+      if (!options.watch || !generator) {
+        process.exit(1);
+      }
+    }
+
+    if (options.watch) {
+      watchInputs(inputFiles, () => runGenerate(generator, inputFiles, options, false));
+    }
+  });
+
+program
+  .command('bench')
+  .description('Generate a micro-benchmark addon measuring FromNapi, call and ToNapi costs')
+  .option('-i, --input <files...>', 'Input TypeScript files', ['src/**/*.ts'])
+  .option('-o, --output <dir>', 'Output directory for the benchmark addon', './bench')
+  .option('-t, --tsconfig <path>', 'Path to tsconfig.json', './tsconfig.json')
+  .option('--sizes <list>', 'Comma-separated payload sizes (array/string lengths)', '1,100,10000')
+  .option('--iterations <n>', 'Iterations per measurement', '10000')
+  .option('--run', 'Build with node-gyp and run the benchmark')
+  .action((options) => {
+    try {
+      console.log('⏱️  Generating ts-cpp-bridge benchmark...');
       
-      if (parseResult.exports.length > 0) {
-        console.log('🔗 Exports:');
-        parseResult.exports.forEach(e => {
-          console.log(`  - ${e.className}::${e.name}(${e.paramType}) -> ${e.returnType}`);
-        });
+      const tsConfigPath = path.resolve(options.tsconfig);
+      const generator = new CppGenerator(fs.existsSync(tsConfigPath) ? tsConfigPath : undefined);
+      const parseResult = generator.parseFiles(collectInputFiles(options.input));
+      
+      const sizes = options.sizes.split(',').map(Number).filter(n => Number.isInteger(n) && n >= 0);
+      const iterations = parseInt(options.iterations, 10);
+      if (sizes.length === 0 || !(iterations > 0)) {
+        console.error('❌ --sizes must list non-negative integers and --iterations must be positive');
+        process.exit(1);
       }
       
-      // Создаем выходную директорию
       const outputDir = path.resolve(options.output);
-      if (!fs.existsSync(outputDir)) {
-        fs.mkdirSync(outputDir, { recursive: true });
-      }
+      generator.generateBenchmark(parseResult, outputDir, { sizes, iterations });
       
-      // Генерируем C++ код
-      generator.generateCppCode(parseResult, outputDir);
+      console.log(`📁 Benchmark generated in: ${outputDir}`);
+      console.log('   - binding.gyp, bench.js');
+      console.log('   - src/bench_api.cpp, src/bench_noop.cpp + generated bindings');
       
-      // Генерируем TypeScript код, если указана ts-output директория
-      if (options.tsOutput) {
-        const tsOutputDir = path.resolve(options.tsOutput);
-        if (!fs.existsSync(tsOutputDir)) {
-          fs.mkdirSync(tsOutputDir, { recursive: true });
-        }
-        
-        // Генерируем основные файлы
-        generator.generateTypesFile(parseResult, tsOutputDir);
-        generator.generateAddonFile(parseResult, tsOutputDir);
-        
-        console.log('✅ TypeScript code generation completed!');
-        console.log(`📁 Generated TS files in: ${tsOutputDir}`);
-        console.log('   - generated_types.ts');
-        console.log('   - generated_addon.ts');
-        console.log('   - generated_api.ts');
+      if (options.run) {
+        const { execSync } = require('child_process');
+        const { buildCommandEnv } = require('../dist/prebuild');
+        execSync('node-gyp rebuild', { cwd: outputDir, stdio: 'inherit', env: buildCommandEnv() });
+        execSync('node bench.js', { cwd: outputDir, stdio: 'inherit' });
+      } else {
+        console.log('');
+        console.log('🔧 Run:');
+        console.log(`   cd ${path.relative(process.cwd(), outputDir) || '.'} && node-gyp rebuild && node bench.js`);
+      }
+    } catch (error) {
+      console.error('❌ Error during benchmark generation:', error.message);
+      if (process.env.DEBUG) {
+        console.error(error.stack);
+      }
+      process.exit(1);
+    }
+  });
+
+program
+  .command('build')
+  .description('Build the addon with node-gyp, reusing binaries cached by a hash of the sources')
+  .option('-d, --dir <dir>', 'Directory with binding.gyp', '.')
+  .option('--cache-dir <dir>', 'Binary cache directory (default: $TSCB_CACHE_DIR or ~/.cache/ts-cpp-bridge)')
+  .option('--command <cmd>', 'Build command on a cache miss', 'node-gyp rebuild')
+  .option('--print-key', 'Only print the cache key for the current sources')
+  .action((options) => {
+    try {
+      const { cachedBuild, computeBuildKey } = require('../dist/prebuild');
+      if (options.printKey) {
+        console.log(computeBuildKey(options.dir, options.command));
+        return;
       }
       
-      console.log('✅ C++ code generation completed!');
-      console.log(`📁 Generated files in: ${outputDir}`);
-      console.log('   - generated_structs.hpp');
-      console.log('   - generated_structs.cpp');
-      console.log('   - generated_api.cpp (includes module initialization)');
-      console.log('   - generated_api.h');
-      console.log(`📁 Implementation file: ${path.dirname(outputDir)}/implementation.cpp`);
-      console.log('');
-      console.log('🔧 Next steps:');
-      console.log('   1. Implement the required functions in implementation.cpp');
-      console.log('   2. Add all files to your binding.gyp');
-      console.log('   3. Run npm run build');
-      
+      const result = cachedBuild({ projectDir: options.dir, cacheDir: options.cacheDir, buildCommand: options.command });
+      if (result.hit) {
+        console.log(`📦 Restored ${result.files.join(', ')} from cache (${result.key.slice(0, 12)})`);
+      } else {
+        console.log(`🔨 Built and cached ${result.files.join(', ')} (${result.key.slice(0, 12)})`);
+      }
     } catch (error) {
-      console.error('❌ Error during code generation:', error.message);
+      console.error('❌ Error during build:', error.message);
       if (process.env.DEBUG) {
         console.error(error.stack);
       }
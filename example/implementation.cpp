@@ -8,6 +8,7 @@
 // OutputData Solver_process(const InputData& param);
 // TaskResult Solver_processLongTask(const LongTask& param);
 // OutputData Solver_processHeavyComputation(const InputData& param);
+// OutputData Solver_processHeavyComputationNative(const InputData& param);
 
 
 // Пример реализации:
@@ -83,3 +84,20 @@ OutputData Solver_processHeavyComputation(const InputData& input) {
     return result;
 }
 
+OutputData Solver_processHeavyComputationNative(const InputData& input) {
+    // Выполняется в нативном пуле (@CppAsync({ pool: 'native' })): вычисление то же,
+    // но элементы массива независимы, поэтому цикл делится между потоками того же пула
+    OutputData result;
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    result.greeting = "Heavy computation for " + input.name + " completed!";
+    result.doubled = input.value * input.value + input.value;
+    result.squared.resize(input.numbers.size());
+    tscb::ParallelFor(size_t(0), input.numbers.size(), [&](size_t i) {
+        int heavy_result = input.numbers[i];
+        for (int j = 0; j < 1000; j++) {
+            heavy_result = (heavy_result * 2 + 1) % 10000;
+        }
+        result.squared[i] = heavy_result;
+    });
+    return result;
+}
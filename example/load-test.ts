@@ -0,0 +1,232 @@
+// Нагрузочный тест примера: пропускная способность и задержки p50/p99
+// при росте конкурентности и размера входа, sync против async пулов.
+//
+// Запуск: npx ts-node load-test.ts [--modes sync,uv,native] [--concurrency 1,16,256]
+//         [--sizes 10,1000,100000] [--duration 2000] [--out results.json]
+//         [--baseline previous.json] [--threshold 0.1]
+
+import * as fs from 'fs';
+import * as os from 'os';
+import { Solver } from './src/generated_api';
+import { InputData } from './src/generated_types';
+
+interface Mode {
+  name: string;
+  description: string;
+  // В пакетных режимах один вызов несет `concurrency` входов
+  batch: boolean;
+  call: (input: InputData, batch: InputData[]) => unknown;
+}
+
+const MODES: Mode[] = [
+  { name: 'sync', description: 'Solver.process, клиенты разделяют главный поток', batch: false, call: input => Solver.process(input) },
+  { name: 'sync-batch', description: 'Solver.processBatch, один вызов на всех клиентов', batch: true, call: (_, batch) => Solver.processBatch(batch) },
+  { name: 'uv', description: 'Solver.processHeavyComputation в пуле libuv', batch: false, call: input => Solver.processHeavyComputation(input) },
+  { name: 'uv-batch', description: 'Solver.processHeavyComputationBatch', batch: true, call: (_, batch) => Solver.processHeavyComputationBatch(batch) },
+  { name: 'native', description: 'Solver.processHeavyComputationNative в нативном пуле', batch: false, call: input => Solver.processHeavyComputationNative(input) },
+];
+
+interface Options {
+  modes: string[];
+  concurrency: number[];
+  sizes: number[];
+  durationMs: number;
+  // Ячейки, где concurrency * size больше, пропускаются: вход 10^7 при 256 вызовах не помещается в память
+  maxInflight: number;
+  out: string;
+  baseline?: string;
+  threshold: number;
+}
+
+interface Row {
+  mode: string;
+  concurrency: number;
+  size: number;
+  skipped?: string;
+  calls?: number;
+  elapsedMs?: number;
+  throughput?: number;  // входов в секунду
+  meanMs?: number;
+  p50Ms?: number;
+  p99Ms?: number;
+  maxMs?: number;
+}
+
+function parseList(value: string): number[] {
+  return value.split(',').map(Number);
+}
+
+function parseArgs(argv: string[]): Options {
+  const options: Options = {
+    modes: MODES.map(mode => mode.name),
+    concurrency: [1, 4, 16, 64, 256],
+    sizes: [10, 1000, 100000, 10000000],
+    durationMs: 2000,
+    maxInflight: 10000000,
+    out: 'load-test-results.json',
+    threshold: 0.1,
+  };
+  for (let i = 0; i < argv.length; i++) {
+    const value = argv[i + 1];
+    switch (argv[i]) {
+      case '--modes': options.modes = value.split(','); i++; break;
+      case '--concurrency': options.concurrency = parseList(value); i++; break;
+      case '--sizes': options.sizes = parseList(value); i++; break;
+      case '--duration': options.durationMs = Number(value); i++; break;
+      case '--max-inflight': options.maxInflight = Number(value); i++; break;
+      case '--out': options.out = value; i++; break;
+      case '--baseline': options.baseline = value; i++; break;
+      case '--threshold': options.threshold = Number(value); i++; break;
+      default: throw new Error(`Unknown option: ${argv[i]}`);
+    }
+  }
+  const unknown = options.modes.filter(name => !MODES.some(mode => mode.name === name));
+  if (unknown.length > 0) {
+    throw new Error(`Unknown modes: ${unknown.join(', ')}`);
+  }
+  return options;
+}
+
+function makeInput(size: number): InputData {
+  const numbers = new Array<number>(size);
+  for (let i = 0; i < size; i++) numbers[i] = i % 100;
+  return { name: 'load', value: size, numbers };
+}
+
+function nowMs(): number {
+  return Number(process.hrtime.bigint()) / 1e6;
+}
+
+function percentile(sorted: Float64Array, p: number): number {
+  const index = Math.min(sorted.length - 1, Math.ceil(p * sorted.length) - 1);
+  return sorted[Math.max(0, index)];
+}
+
+function round(value: number): number {
+  return Math.round(value * 1000) / 1000;
+}
+
+// Замкнутый цикл: `concurrency` клиентов, каждый отправляет следующий вызов после
+// завершения предыдущего. Синхронный вызов ждет своей очереди в главном потоке
+// (setImmediate), поэтому его задержка включает время обслуживания остальных клиентов.
+async function runCell(mode: Mode, concurrency: number, size: number, durationMs: number): Promise<Row> {
+  const input = makeInput(size);
+  const batch = mode.batch ? new Array<InputData>(concurrency).fill(input) : [];
+  const clients = mode.batch ? 1 : concurrency;
+  const perCall = mode.batch ? concurrency : 1;
+
+  let latencies = new Float64Array(1024);
+  let count = 0;
+  const record = (ms: number) => {
+    if (count === latencies.length) {
+      const grown = new Float64Array(latencies.length * 2);
+      grown.set(latencies);
+      latencies = grown;
+    }
+    latencies[count++] = ms;
+  };
+
+  await mode.call(input, batch); // прогрев
+  const start = nowMs();
+  const deadline = start + durationMs;
+  const client = async () => {
+    // Каждый клиент завершает хотя бы один вызов, даже если он дольше durationMs
+    do {
+      const issued = nowMs();
+      await new Promise(resolve => setImmediate(resolve));
+      await mode.call(input, batch);
+      record(nowMs() - issued);
+    } while (nowMs() < deadline);
+  };
+  await Promise.all(Array.from({ length: clients }, client));
+  const elapsedMs = nowMs() - start;
+
+  const sorted = latencies.slice(0, count).sort();
+  const total = sorted.reduce((sum, value) => sum + value, 0);
+  return {
+    mode: mode.name,
+    concurrency,
+    size,
+    calls: count,
+    elapsedMs: round(elapsedMs),
+    throughput: round((count * perCall) / (elapsedMs / 1000)),
+    meanMs: round(total / count),
+    p50Ms: round(percentile(sorted, 0.5)),
+    p99Ms: round(percentile(sorted, 0.99)),
+    maxMs: round(sorted[count - 1]),
+  };
+}
+
+// Регрессия: пропускная способность упала или p99 вырос больше чем на threshold
+function compareWithBaseline(rows: Row[], baselinePath: string, threshold: number): string[] {
+  const baseline: { results: Row[] } = JSON.parse(fs.readFileSync(baselinePath, 'utf-8'));
+  const regressions: string[] = [];
+  for (const row of rows) {
+    const previous = baseline.results.find(other =>
+      other.mode === row.mode && other.concurrency === row.concurrency && other.size === row.size);
+    if (!previous || row.skipped || previous.skipped) {
+      continue;
+    }
+    const cell = `${row.mode} c=${row.concurrency} size=${row.size}`;
+    if (row.throughput! < previous.throughput! * (1 - threshold)) {
+      regressions.push(`${cell}: throughput ${previous.throughput} -> ${row.throughput} /s`);
+    }
+    if (row.p99Ms! > previous.p99Ms! * (1 + threshold)) {
+      regressions.push(`${cell}: p99 ${previous.p99Ms} -> ${row.p99Ms} ms`);
+    }
+  }
+  return regressions;
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const modes = MODES.filter(mode => options.modes.includes(mode.name));
+  const rows: Row[] = [];
+
+  console.log('🚀 Load test:', modes.map(mode => mode.name).join(', '));
+  for (const mode of modes) {
+    console.log(`\n📋 ${mode.name}: ${mode.description}`);
+    for (const size of options.sizes) {
+      for (const concurrency of options.concurrency) {
+        if (concurrency * size > options.maxInflight) {
+          rows.push({ mode: mode.name, concurrency, size, skipped: 'max-inflight' });
+          continue;
+        }
+        const row = await runCell(mode, concurrency, size, options.durationMs);
+        rows.push(row);
+        console.log(`   size=${size} c=${concurrency}: ${row.throughput}/s, p50 ${row.p50Ms}ms, p99 ${row.p99Ms}ms (${row.calls} calls)`);
+      }
+    }
+  }
+
+  const report = {
+    meta: {
+      date: new Date().toISOString(),
+      node: process.version,
+      platform: process.platform,
+      arch: process.arch,
+      cpus: os.cpus().length,
+      uvThreadpoolSize: Number(process.env.UV_THREADPOOL_SIZE || 4),
+    },
+    options: { durationMs: options.durationMs, maxInflight: options.maxInflight },
+    results: rows,
+  };
+  fs.writeFileSync(options.out, JSON.stringify(report, null, 2));
+  console.log(`\n✅ Results written to ${options.out}`);
+
+  if (options.baseline) {
+    const regressions = compareWithBaseline(rows, options.baseline, options.threshold);
+    if (regressions.length > 0) {
+      console.error(`❌ ${regressions.length} regression(s) against ${options.baseline}:`);
+      regressions.forEach(line => console.error(`   ${line}`));
+      process.exitCode = 1;
+    } else {
+      console.log(`✅ No regressions against ${options.baseline} (threshold ${options.threshold * 100}%)`);
+    }
+  }
+}
+
+main().catch(error => {
+  console.error('❌ Load test failed:', error);
+  process.exitCode = 1;
+});
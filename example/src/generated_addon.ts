@@ -4,36 +4,88 @@ import { InputData, OutputData, LongTask, TaskResult } from './generated_types';
 
 declare const require: any;
 
+export interface BridgePhaseStats {
+  count: number;
+  totalNs: number;
+  maxNs: number;
+  avgNs: number;
+}
+
+export interface BridgeCallStats {
+  decode: BridgePhaseStats;
+  execute: BridgePhaseStats;
+  encode: BridgePhaseStats;
+  queueWait: BridgePhaseStats;
+}
+
+export type BridgeStats = { [exportName: string]: BridgeCallStats };
+
+export interface BridgeMemoryGauge {
+  bytes: number;
+  peakBytes: number;
+}
+
+export type BridgeMemory = { [exportName: string]: BridgeMemoryGauge };
+
 interface AddonExports {
   Solver_process: (input: InputData) => OutputData;
+  Solver_process_batch: (inputs: InputData[]) => OutputData[];
   Solver_processLongTask: (input: LongTask) => Promise<TaskResult>;
+  Solver_processLongTask_batch: (inputs: LongTask[]) => Promise<TaskResult[]>;
   Solver_processHeavyComputation: (input: InputData) => Promise<OutputData>;
+  Solver_processHeavyComputation_batch: (inputs: InputData[]) => Promise<OutputData[]>;
+  Solver_processHeavyComputationNative: (input: InputData) => Promise<OutputData>;
+  Solver_processHeavyComputationNative_batch: (inputs: InputData[]) => Promise<OutputData[]>;
+  __initPool: (size: number) => void;
+  __bridgeStats: (reset?: boolean) => BridgeStats;
+  __bridgeMemory: () => BridgeMemory;
 }
 
-let addon: AddonExports;
+let native: AddonExports | undefined;
 
-try {
-  // Пробуем разные пути для поддержки ts-node и обычного node
-  let addonPath;
+/**
+ * Загружает нативный addon (повторные вызовы возвращают тот же объект).
+ * Вызывается автоматически при первом обращении к экспорту; явный вызов переносит загрузку на старт.
+ */
+export function loadAddon(): AddonExports {
+  if (native !== undefined) {
+    return native;
+  }
   try {
-    addonPath = require.resolve('../../../build/Release/addon.node');
-    addon = require(addonPath);
-  } catch (e1) {
+    // Пробуем разные пути для поддержки ts-node и обычного node
+    let addonPath;
     try {
-      addonPath = require.resolve('../../build/Release/addon.node');
-      addon = require(addonPath);
-    } catch (e2) {
+      addonPath = require.resolve('../../../build/Release/addon.node');
+    } catch (e1) {
       try {
-        addonPath = require.resolve('../build/Release/addon.node');
-        addon = require(addonPath);
-      } catch (e3) {
-        addonPath = require.resolve('./build/Release/addon.node');
-        addon = require(addonPath);
+        addonPath = require.resolve('../../build/Release/addon.node');
+      } catch (e2) {
+        try {
+          addonPath = require.resolve('../build/Release/addon.node');
+        } catch (e3) {
+          addonPath = require.resolve('./build/Release/addon.node');
+        }
       }
     }
+    native = require(addonPath) as AddonExports;
+  } catch (e) {
+    throw new Error('Native addon not found. Run npm run build first.');
   }
-} catch (e) {
-  throw new Error('Native addon not found. Run npm run build first.');
+  return native;
+}
+
+const addon = {} as AddonExports;
+const exportNames: (keyof AddonExports)[] = ['Solver_process', 'Solver_process_batch', 'Solver_processLongTask', 'Solver_processLongTask_batch', 'Solver_processHeavyComputation', 'Solver_processHeavyComputation_batch', 'Solver_processHeavyComputationNative', 'Solver_processHeavyComputationNative_batch', '__initPool', '__bridgeStats', '__bridgeMemory'];
+for (const name of exportNames) {
+  Object.defineProperty(addon, name, {
+    configurable: true,
+    enumerable: true,
+    get() {
+      const value = loadAddon()[name];
+      Object.defineProperty(addon, name, { value, enumerable: true });
+      return value;
+    },
+  });
 }
 
 export default addon;
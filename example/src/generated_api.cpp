@@ -7,10 +7,38 @@
 extern OutputData Solver_process(const InputData& param);
 extern TaskResult Solver_processLongTask(const LongTask& param);
 extern OutputData Solver_processHeavyComputation(const InputData& param);
+extern OutputData Solver_processHeavyComputationNative(const InputData& param);
 
 
 // N-API wrapper functions
 
+// Точки профилирования (используются при define TSCB_PROFILE)
+namespace {
+enum ProfileSite : size_t {
+    kSite_Solver_process,
+    kSite_Solver_process_batch,
+    kSite_Solver_processLongTask,
+    kSite_Solver_processLongTask_batch,
+    kSite_Solver_processHeavyComputation,
+    kSite_Solver_processHeavyComputation_batch,
+    kSite_Solver_processHeavyComputationNative,
+    kSite_Solver_processHeavyComputationNative_batch,
+    kProfileSiteCount
+};
+
+const char* const kProfileSiteNames[] = {
+    "Solver_process",
+    "Solver_process_batch",
+    "Solver_processLongTask",
+    "Solver_processLongTask_batch",
+    "Solver_processHeavyComputation",
+    "Solver_processHeavyComputation_batch",
+    "Solver_processHeavyComputationNative",
+    "Solver_processHeavyComputationNative_batch",
+    nullptr
+};
+} // namespace
+
 Napi::Value Solver_process_wrapper(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     
@@ -20,25 +48,77 @@ Napi::Value Solver_process_wrapper(const Napi::CallbackInfo& info) {
     }
     
     try {
+        TSCB_PROFILE_START(decodeStart);
         InputData input = InputData::FromNapi(info[0].As<Napi::Object>());
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_process, kDecode);
+        TSCB_PROFILE_START(executeStart);
         OutputData result = Solver_process(input);
-        return result.ToNapi(env);
+        TSCB_PROFILE_STOP(executeStart, kSite_Solver_process, kExecute);
+        TSCB_PROFILE_START(encodeStart);
+        Napi::Value output = result.ToNapi(env);
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_process, kEncode);
+        return output;
     } catch (const std::exception& e) {
         Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
 }
 
+Napi::Value Solver_process_batch_wrapper(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array inputs = info[0].As<Napi::Array>();
+    const uint32_t count = inputs.Length();
+    Napi::Array outputs = Napi::Array::New(env, count);
+    uint32_t i = 0;
+    try {
+        for (; i < count; i++) {
+            // Отдельный scope на элемент, чтобы не копить handles на весь пакет
+            Napi::HandleScope scope(env);
+            Napi::Value item = inputs.Get(i);
+            if (!item.IsObject()) {
+                throw std::runtime_error("Expected an object");
+            }
+            TSCB_PROFILE_START(decodeStart);
+            InputData input = InputData::FromNapi(item.As<Napi::Object>());
+            TSCB_PROFILE_STOP(decodeStart, kSite_Solver_process_batch, kDecode);
+            TSCB_PROFILE_START(executeStart);
+            OutputData result = Solver_process(input);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_process_batch, kExecute);
+            TSCB_PROFILE_START(encodeStart);
+            outputs.Set(i, result.ToNapi(env));
+            TSCB_PROFILE_STOP(encodeStart, kSite_Solver_process_batch, kEncode);
+        }
+    } catch (const std::exception& e) {
+        Napi::Error::New(env, "Batch item " + std::to_string(i) + ": " + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return outputs;
+}
+
 // AsyncWorker class for Solver_processLongTask
 class Solver_processLongTask_AsyncWorker : public Napi::AsyncWorker {
 public:
-    Solver_processLongTask_AsyncWorker(Napi::Function& callback, const LongTask& input)
-        : Napi::AsyncWorker(callback), input_(input) {}
+    Solver_processLongTask_AsyncWorker(Napi::Env env, LongTask&& input)
+        : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)), input_(std::move(input)) {
+        memory_.Hold(env, tscb::NativeBytes(input_));
+    }
     ~Solver_processLongTask_AsyncWorker() {}
 
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
     void Execute() override {
+        tscb::profile::RecordWait(kSite_Solver_processLongTask, queued_);
         try {
+            TSCB_PROFILE_START(executeStart);
             result_ = Solver_processLongTask(input_);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_processLongTask, kExecute);
+            memory_.Add(tscb::NativeBytes(result_));
         } catch (const std::exception& e) {
             SetError(e.what());
         } catch (...) {
@@ -48,17 +128,25 @@ public:
 
     void OnOK() override {
         Napi::HandleScope scope(Env());
-        Callback().Call({Env().Null(), result_.ToNapi(Env())});
+        memory_.Release(Env());
+        TSCB_PROFILE_START(encodeStart);
+        Napi::Value output = result_.ToNapi(Env());
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_processLongTask, kEncode);
+        deferred_.Resolve(output);
     }
 
     void OnError(const Napi::Error& error) override {
         Napi::HandleScope scope(Env());
-        Callback().Call({error.Value(), Env().Undefined()});
+        memory_.Release(Env());
+        deferred_.Reject(error.Value());
     }
 
 private:
+    Napi::Promise::Deferred deferred_;
+    tscb::ExternalMemory memory_{kSite_Solver_processLongTask};
     LongTask input_;
     TaskResult result_;
+    tscb::profile::Stamp queued_;
 };
 
 Napi::Value Solver_processLongTask_wrapper(const Napi::CallbackInfo& info) {
@@ -71,47 +159,167 @@ Napi::Value Solver_processLongTask_wrapper(const Napi::CallbackInfo& info) {
     
     LongTask input;
     try {
+        TSCB_PROFILE_START(decodeStart);
         input = LongTask::FromNapi(info[0].As<Napi::Object>());
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_processLongTask, kDecode);
     } catch (const std::exception& e) {
         Napi::TypeError::New(env, std::string("Failed to parse input: ") + e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    // Создаем Promise
-    auto deferred = Napi::Promise::Deferred::New(env);
+    // Worker сам владеет Deferred и разрешает Promise в OnOK/OnError
+    Solver_processLongTask_AsyncWorker* worker = new Solver_processLongTask_AsyncWorker(env, std::move(input));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
     
-    // Создаем callback функцию для Promise
-    auto callback = Napi::Function::New(env, [deferred](const Napi::CallbackInfo& info) {
-        Napi::Env env = info.Env();
-        if (info.Length() > 0 && !info[0].IsNull()) {
-            // Ошибка
-            deferred.Reject(info[0]);
-        } else if (info.Length() > 1) {
-            // Успех
-            deferred.Resolve(info[1]);
-        } else {
-            deferred.Reject(Napi::Error::New(env, "Invalid callback arguments").Value());
+    return promise;
+}
+
+// Общее состояние пакетного вызова Solver_processLongTask
+struct Solver_processLongTask_BatchState {
+    explicit Solver_processLongTask_BatchState(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+    Napi::Promise::Deferred deferred;
+    tscb::ExternalMemory memory{kSite_Solver_processLongTask_batch};
+    std::vector<LongTask> inputs;
+    std::vector<TaskResult> results;
+    size_t pending = 0;
+    std::string error;
+};
+
+class Solver_processLongTask_BatchWorker : public Napi::AsyncWorker {
+public:
+    Solver_processLongTask_BatchWorker(Napi::Env env, std::shared_ptr<Solver_processLongTask_BatchState> state, size_t begin, size_t end)
+        : Napi::AsyncWorker(env), state_(std::move(state)), begin_(begin), end_(end) {}
+
+    void Execute() override {
+        tscb::profile::RecordWait(kSite_Solver_processLongTask_batch, queued_);
+        // Каждый worker пишет только в свой диапазон results
+        try {
+            TSCB_PROFILE_START(executeStart);
+            for (size_t i = begin_; i < end_; i++) {
+                state_->results[i] = Solver_processLongTask(state_->inputs[i]);
+            }
+            size_t resultBytes = 0;
+            for (size_t i = begin_; i < end_; i++) {
+                resultBytes += tscb::HeapBytes(state_->results[i]);
+            }
+            state_->memory.Add(resultBytes);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_processLongTask_batch, kExecute);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        } catch (...) {
+            SetError("Unknown error occurred");
         }
-        return env.Undefined();
-    });
+    }
+
+    void OnOK() override {
+        Finish(Env());
+    }
+
+    void OnError(const Napi::Error& error) override {
+        if (state_->error.empty()) {
+            state_->error = error.Message();
+        }
+        Finish(Env());
+    }
+
+private:
+    // Завершение выполняется в главном потоке, поэтому счетчик не атомарный
+    void Finish(Napi::Env env) {
+        if (--state_->pending > 0) {
+            return;
+        }
+        Napi::HandleScope scope(env);
+        state_->memory.Release(env);
+        if (!state_->error.empty()) {
+            state_->deferred.Reject(Napi::Error::New(env, state_->error).Value());
+            return;
+        }
+        TSCB_PROFILE_START(encodeStart);
+        const size_t count = state_->results.size();
+        Napi::Array outputs = Napi::Array::New(env, count);
+        for (size_t i = 0; i < count; i++) {
+            outputs.Set(static_cast<uint32_t>(i), state_->results[i].ToNapi(env));
+        }
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_processLongTask_batch, kEncode);
+        state_->deferred.Resolve(outputs);
+    }
+
+    std::shared_ptr<Solver_processLongTask_BatchState> state_;
+    size_t begin_;
+    size_t end_;
+    tscb::profile::Stamp queued_;
+};
+
+Napi::Value Solver_processLongTask_batch_wrapper(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    // Запускаем AsyncWorker
-    Solver_processLongTask_AsyncWorker* worker = new Solver_processLongTask_AsyncWorker(callback, input);
-    worker->Queue();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array items = info[0].As<Napi::Array>();
+    const uint32_t count = items.Length();
+    auto state = std::make_shared<Solver_processLongTask_BatchState>(env);
     
-    return deferred.Promise();
+    // Разбор входов возможен только в главном потоке
+    state->inputs.reserve(count);
+    uint32_t i = 0;
+    try {
+        TSCB_PROFILE_START(decodeStart);
+        for (; i < count; i++) {
+            Napi::HandleScope scope(env);
+            Napi::Value item = items.Get(i);
+            if (!item.IsObject()) {
+                throw std::runtime_error("Expected an object");
+            }
+            state->inputs.push_back(LongTask::FromNapi(item.As<Napi::Object>()));
+        }
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_processLongTask_batch, kDecode);
+    } catch (const std::exception& e) {
+        Napi::TypeError::New(env, "Failed to parse batch item " + std::to_string(i) + ": " + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Promise promise = state->deferred.Promise();
+    if (count == 0) {
+        state->deferred.Resolve(Napi::Array::New(env, 0));
+        return promise;
+    }
+    state->results.resize(count);
+    state->memory.Hold(env, tscb::NativeBytes(state->inputs) + tscb::NativeBytes(state->results));
+    
+    // Делим пакет на непрерывные диапазоны, по одному AsyncWorker на поток
+    const size_t chunks = tscb::BatchChunkCount(count);
+    state->pending = chunks;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        const size_t begin = count * chunk / chunks;
+        const size_t end = count * (chunk + 1) / chunks;
+        (new Solver_processLongTask_BatchWorker(env, state, begin, end))->Queue();
+    }
+    
+    return promise;
 }
 
 // AsyncWorker class for Solver_processHeavyComputation
 class Solver_processHeavyComputation_AsyncWorker : public Napi::AsyncWorker {
 public:
-    Solver_processHeavyComputation_AsyncWorker(Napi::Function& callback, const InputData& input)
-        : Napi::AsyncWorker(callback), input_(input) {}
+    Solver_processHeavyComputation_AsyncWorker(Napi::Env env, InputData&& input)
+        : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)), input_(std::move(input)) {
+        memory_.Hold(env, tscb::NativeBytes(input_));
+    }
     ~Solver_processHeavyComputation_AsyncWorker() {}
 
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
     void Execute() override {
+        tscb::profile::RecordWait(kSite_Solver_processHeavyComputation, queued_);
         try {
+            TSCB_PROFILE_START(executeStart);
             result_ = Solver_processHeavyComputation(input_);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_processHeavyComputation, kExecute);
+            memory_.Add(tscb::NativeBytes(result_));
         } catch (const std::exception& e) {
             SetError(e.what());
         } catch (...) {
@@ -121,17 +329,25 @@ public:
 
     void OnOK() override {
         Napi::HandleScope scope(Env());
-        Callback().Call({Env().Null(), result_.ToNapi(Env())});
+        memory_.Release(Env());
+        TSCB_PROFILE_START(encodeStart);
+        Napi::Value output = result_.ToNapi(Env());
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_processHeavyComputation, kEncode);
+        deferred_.Resolve(output);
     }
 
     void OnError(const Napi::Error& error) override {
         Napi::HandleScope scope(Env());
-        Callback().Call({error.Value(), Env().Undefined()});
+        memory_.Release(Env());
+        deferred_.Reject(error.Value());
     }
 
 private:
+    Napi::Promise::Deferred deferred_;
+    tscb::ExternalMemory memory_{kSite_Solver_processHeavyComputation};
     InputData input_;
     OutputData result_;
+    tscb::profile::Stamp queued_;
 };
 
 Napi::Value Solver_processHeavyComputation_wrapper(const Napi::CallbackInfo& info) {
@@ -144,48 +360,398 @@ Napi::Value Solver_processHeavyComputation_wrapper(const Napi::CallbackInfo& inf
     
     InputData input;
     try {
+        TSCB_PROFILE_START(decodeStart);
         input = InputData::FromNapi(info[0].As<Napi::Object>());
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_processHeavyComputation, kDecode);
     } catch (const std::exception& e) {
         Napi::TypeError::New(env, std::string("Failed to parse input: ") + e.what()).ThrowAsJavaScriptException();
         return env.Null();
     }
     
-    // Создаем Promise
-    auto deferred = Napi::Promise::Deferred::New(env);
+    // Worker сам владеет Deferred и разрешает Promise в OnOK/OnError
+    Solver_processHeavyComputation_AsyncWorker* worker = new Solver_processHeavyComputation_AsyncWorker(env, std::move(input));
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
     
-    // Создаем callback функцию для Promise
-    auto callback = Napi::Function::New(env, [deferred](const Napi::CallbackInfo& info) {
-        Napi::Env env = info.Env();
-        if (info.Length() > 0 && !info[0].IsNull()) {
-            // Ошибка
-            deferred.Reject(info[0]);
-        } else if (info.Length() > 1) {
-            // Успех
-            deferred.Resolve(info[1]);
-        } else {
-            deferred.Reject(Napi::Error::New(env, "Invalid callback arguments").Value());
+    return promise;
+}
+
+// Общее состояние пакетного вызова Solver_processHeavyComputation
+struct Solver_processHeavyComputation_BatchState {
+    explicit Solver_processHeavyComputation_BatchState(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+    Napi::Promise::Deferred deferred;
+    tscb::ExternalMemory memory{kSite_Solver_processHeavyComputation_batch};
+    std::vector<InputData> inputs;
+    std::vector<OutputData> results;
+    size_t pending = 0;
+    std::string error;
+};
+
+class Solver_processHeavyComputation_BatchWorker : public Napi::AsyncWorker {
+public:
+    Solver_processHeavyComputation_BatchWorker(Napi::Env env, std::shared_ptr<Solver_processHeavyComputation_BatchState> state, size_t begin, size_t end)
+        : Napi::AsyncWorker(env), state_(std::move(state)), begin_(begin), end_(end) {}
+
+    void Execute() override {
+        tscb::profile::RecordWait(kSite_Solver_processHeavyComputation_batch, queued_);
+        // Каждый worker пишет только в свой диапазон results
+        try {
+            TSCB_PROFILE_START(executeStart);
+            for (size_t i = begin_; i < end_; i++) {
+                state_->results[i] = Solver_processHeavyComputation(state_->inputs[i]);
+            }
+            size_t resultBytes = 0;
+            for (size_t i = begin_; i < end_; i++) {
+                resultBytes += tscb::HeapBytes(state_->results[i]);
+            }
+            state_->memory.Add(resultBytes);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_processHeavyComputation_batch, kExecute);
+        } catch (const std::exception& e) {
+            SetError(e.what());
+        } catch (...) {
+            SetError("Unknown error occurred");
+        }
+    }
+
+    void OnOK() override {
+        Finish(Env());
+    }
+
+    void OnError(const Napi::Error& error) override {
+        if (state_->error.empty()) {
+            state_->error = error.Message();
+        }
+        Finish(Env());
+    }
+
+private:
+    // Завершение выполняется в главном потоке, поэтому счетчик не атомарный
+    void Finish(Napi::Env env) {
+        if (--state_->pending > 0) {
+            return;
         }
-        return env.Undefined();
-    });
+        Napi::HandleScope scope(env);
+        state_->memory.Release(env);
+        if (!state_->error.empty()) {
+            state_->deferred.Reject(Napi::Error::New(env, state_->error).Value());
+            return;
+        }
+        TSCB_PROFILE_START(encodeStart);
+        const size_t count = state_->results.size();
+        Napi::Array outputs = Napi::Array::New(env, count);
+        for (size_t i = 0; i < count; i++) {
+            outputs.Set(static_cast<uint32_t>(i), state_->results[i].ToNapi(env));
+        }
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_processHeavyComputation_batch, kEncode);
+        state_->deferred.Resolve(outputs);
+    }
+
+    std::shared_ptr<Solver_processHeavyComputation_BatchState> state_;
+    size_t begin_;
+    size_t end_;
+    tscb::profile::Stamp queued_;
+};
+
+Napi::Value Solver_processHeavyComputation_batch_wrapper(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
     
-    // Запускаем AsyncWorker
-    Solver_processHeavyComputation_AsyncWorker* worker = new Solver_processHeavyComputation_AsyncWorker(callback, input);
-    worker->Queue();
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array items = info[0].As<Napi::Array>();
+    const uint32_t count = items.Length();
+    auto state = std::make_shared<Solver_processHeavyComputation_BatchState>(env);
     
-    return deferred.Promise();
+    // Разбор входов возможен только в главном потоке
+    state->inputs.reserve(count);
+    uint32_t i = 0;
+    try {
+        TSCB_PROFILE_START(decodeStart);
+        for (; i < count; i++) {
+            Napi::HandleScope scope(env);
+            Napi::Value item = items.Get(i);
+            if (!item.IsObject()) {
+                throw std::runtime_error("Expected an object");
+            }
+            state->inputs.push_back(InputData::FromNapi(item.As<Napi::Object>()));
+        }
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_processHeavyComputation_batch, kDecode);
+    } catch (const std::exception& e) {
+        Napi::TypeError::New(env, "Failed to parse batch item " + std::to_string(i) + ": " + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Promise promise = state->deferred.Promise();
+    if (count == 0) {
+        state->deferred.Resolve(Napi::Array::New(env, 0));
+        return promise;
+    }
+    state->results.resize(count);
+    state->memory.Hold(env, tscb::NativeBytes(state->inputs) + tscb::NativeBytes(state->results));
+    
+    // Делим пакет на непрерывные диапазоны, по одному AsyncWorker на поток
+    const size_t chunks = tscb::BatchChunkCount(count);
+    state->pending = chunks;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        const size_t begin = count * chunk / chunks;
+        const size_t end = count * (chunk + 1) / chunks;
+        (new Solver_processHeavyComputation_BatchWorker(env, state, begin, end))->Queue();
+    }
+    
+    return promise;
+}
+
+// Задача нативного пула для Solver_processHeavyComputationNative
+class Solver_processHeavyComputationNative_PoolJob : public tscb::PoolJob {
+public:
+    Solver_processHeavyComputationNative_PoolJob(Napi::Env env, InputData&& input)
+        : deferred_(Napi::Promise::Deferred::New(env)), input_(std::move(input)) {
+        memory_.Hold(env, tscb::NativeBytes(input_));
+    }
+    Napi::Promise Promise() const { return deferred_.Promise(); }
+
+    void Execute() override {
+        tscb::profile::RecordWait(kSite_Solver_processHeavyComputationNative, queued_);
+        try {
+            TSCB_PROFILE_START(executeStart);
+            result_ = Solver_processHeavyComputationNative(input_);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_processHeavyComputationNative, kExecute);
+            memory_.Add(tscb::NativeBytes(result_));
+        } catch (const std::exception& e) {
+            error_ = e.what();
+            failed_ = true;
+        } catch (...) {
+            error_ = "Unknown error occurred";
+            failed_ = true;
+        }
+    }
+
+    void Complete(Napi::Env env) override {
+        memory_.Release(env);
+        if (failed_) {
+            deferred_.Reject(Napi::Error::New(env, error_).Value());
+            return;
+        }
+        TSCB_PROFILE_START(encodeStart);
+        Napi::Value output = result_.ToNapi(env);
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_processHeavyComputationNative, kEncode);
+        deferred_.Resolve(output);
+    }
+
+private:
+    Napi::Promise::Deferred deferred_;
+    tscb::ExternalMemory memory_{kSite_Solver_processHeavyComputationNative};
+    InputData input_;
+    OutputData result_;
+    std::string error_;
+    bool failed_ = false;
+    tscb::profile::Stamp queued_;
+};
+
+Napi::Value Solver_processHeavyComputationNative_wrapper(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    InputData input;
+    try {
+        TSCB_PROFILE_START(decodeStart);
+        input = InputData::FromNapi(info[0].As<Napi::Object>());
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_processHeavyComputationNative, kDecode);
+    } catch (const std::exception& e) {
+        Napi::TypeError::New(env, std::string("Failed to parse input: ") + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Solver_processHeavyComputationNative_PoolJob* job = new Solver_processHeavyComputationNative_PoolJob(env, std::move(input));
+    Napi::Promise promise = job->Promise();
+    tscb::QueueJob(env, job);
+    
+    return promise;
+}
+
+// Общее состояние пакетного вызова Solver_processHeavyComputationNative
+struct Solver_processHeavyComputationNative_BatchState {
+    explicit Solver_processHeavyComputationNative_BatchState(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+    Napi::Promise::Deferred deferred;
+    tscb::ExternalMemory memory{kSite_Solver_processHeavyComputationNative_batch};
+    std::vector<InputData> inputs;
+    std::vector<OutputData> results;
+    size_t pending = 0;
+    std::string error;
+};
+
+class Solver_processHeavyComputationNative_BatchWorker : public tscb::PoolJob {
+public:
+    Solver_processHeavyComputationNative_BatchWorker(std::shared_ptr<Solver_processHeavyComputationNative_BatchState> state, size_t begin, size_t end)
+        : state_(std::move(state)), begin_(begin), end_(end) {}
+
+    void Execute() override {
+        tscb::profile::RecordWait(kSite_Solver_processHeavyComputationNative_batch, queued_);
+        // Каждый worker пишет только в свой диапазон results
+        try {
+            TSCB_PROFILE_START(executeStart);
+            for (size_t i = begin_; i < end_; i++) {
+                state_->results[i] = Solver_processHeavyComputationNative(state_->inputs[i]);
+            }
+            size_t resultBytes = 0;
+            for (size_t i = begin_; i < end_; i++) {
+                resultBytes += tscb::HeapBytes(state_->results[i]);
+            }
+            state_->memory.Add(resultBytes);
+            TSCB_PROFILE_STOP(executeStart, kSite_Solver_processHeavyComputationNative_batch, kExecute);
+        } catch (const std::exception& e) {
+            error_ = e.what();
+        } catch (...) {
+            error_ = "Unknown error occurred";
+        }
+    }
+
+    void Complete(Napi::Env env) override {
+        if (!error_.empty() && state_->error.empty()) {
+            state_->error = error_;
+        }
+        Finish(env);
+    }
+
+private:
+    // Завершение выполняется в главном потоке, поэтому счетчик не атомарный
+    void Finish(Napi::Env env) {
+        if (--state_->pending > 0) {
+            return;
+        }
+        Napi::HandleScope scope(env);
+        state_->memory.Release(env);
+        if (!state_->error.empty()) {
+            state_->deferred.Reject(Napi::Error::New(env, state_->error).Value());
+            return;
+        }
+        TSCB_PROFILE_START(encodeStart);
+        const size_t count = state_->results.size();
+        Napi::Array outputs = Napi::Array::New(env, count);
+        for (size_t i = 0; i < count; i++) {
+            outputs.Set(static_cast<uint32_t>(i), state_->results[i].ToNapi(env));
+        }
+        TSCB_PROFILE_STOP(encodeStart, kSite_Solver_processHeavyComputationNative_batch, kEncode);
+        state_->deferred.Resolve(outputs);
+    }
+
+    std::shared_ptr<Solver_processHeavyComputationNative_BatchState> state_;
+    size_t begin_;
+    size_t end_;
+    tscb::profile::Stamp queued_;
+    std::string error_;
+};
+
+Napi::Value Solver_processHeavyComputationNative_batch_wrapper(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected an array").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Array items = info[0].As<Napi::Array>();
+    const uint32_t count = items.Length();
+    auto state = std::make_shared<Solver_processHeavyComputationNative_BatchState>(env);
+    
+    // Разбор входов возможен только в главном потоке
+    state->inputs.reserve(count);
+    uint32_t i = 0;
+    try {
+        TSCB_PROFILE_START(decodeStart);
+        for (; i < count; i++) {
+            Napi::HandleScope scope(env);
+            Napi::Value item = items.Get(i);
+            if (!item.IsObject()) {
+                throw std::runtime_error("Expected an object");
+            }
+            state->inputs.push_back(InputData::FromNapi(item.As<Napi::Object>()));
+        }
+        TSCB_PROFILE_STOP(decodeStart, kSite_Solver_processHeavyComputationNative_batch, kDecode);
+    } catch (const std::exception& e) {
+        Napi::TypeError::New(env, "Failed to parse batch item " + std::to_string(i) + ": " + e.what()).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    Napi::Promise promise = state->deferred.Promise();
+    if (count == 0) {
+        state->deferred.Resolve(Napi::Array::New(env, 0));
+        return promise;
+    }
+    state->results.resize(count);
+    state->memory.Hold(env, tscb::NativeBytes(state->inputs) + tscb::NativeBytes(state->results));
+    
+    // Делим пакет на непрерывные диапазоны, по одной задаче на поток нативного пула
+    const size_t chunks = tscb::BatchChunkCount(count, tscb::ThreadPool::Instance().Size());
+    state->pending = chunks;
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        const size_t begin = count * chunk / chunks;
+        const size_t end = count * (chunk + 1) / chunks;
+        tscb::QueueJob(env, new Solver_processHeavyComputationNative_BatchWorker(state, begin, end));
+    }
+    
+    return promise;
 }
 
+Napi::Value InitPool_wrapper(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0) {
+        Napi::TypeError::New(env, "Expected a non-negative pool size").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    
+    const size_t size = static_cast<size_t>(info[0].As<Napi::Number>().Uint32Value());
+    if (!tscb::ThreadPool::Instance().Configure(size)) {
+        Napi::Error::New(env, "Thread pool is already running with a different size").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    return env.Undefined();
+}
+
+Napi::Value BridgeStats_wrapper(const Napi::CallbackInfo& info) {
+    const bool reset = info.Length() > 0 && info[0].ToBoolean().Value();
+    return tscb::profile::StatsToNapi(info.Env(), reset);
+}
+
+Napi::Value BridgeMemory_wrapper(const Napi::CallbackInfo& info) {
+    return tscb::memory::ToNapi(info.Env());
+}
+
+// Экспорты модуля: функция создается при первом обращении к свойству
+static const tscb::LazyExport kLazyExports[] = {
+    { "Solver_process", Solver_process_wrapper },
+    { "Solver_process_batch", Solver_process_batch_wrapper },
+    { "Solver_processLongTask", Solver_processLongTask_wrapper },
+    { "Solver_processLongTask_batch", Solver_processLongTask_batch_wrapper },
+    { "Solver_processHeavyComputation", Solver_processHeavyComputation_wrapper },
+    { "Solver_processHeavyComputation_batch", Solver_processHeavyComputation_batch_wrapper },
+    { "Solver_processHeavyComputationNative", Solver_processHeavyComputationNative_wrapper },
+    { "Solver_processHeavyComputationNative_batch", Solver_processHeavyComputationNative_batch_wrapper },
+    { "__bridgeStats", BridgeStats_wrapper },
+    { "__bridgeMemory", BridgeMemory_wrapper },
+    { "__initPool", InitPool_wrapper },
+};
+
 
 // Module initialization
 Napi::Object InitGeneratedAPI(Napi::Env env, Napi::Object exports) {
-    exports.Set("Solver_process", Napi::Function::New(env, Solver_process_wrapper));
-    exports.Set("Solver_processLongTask", Napi::Function::New(env, Solver_processLongTask_wrapper));
-    exports.Set("Solver_processHeavyComputation", Napi::Function::New(env, Solver_processHeavyComputation_wrapper));
+    InitStructKeys(env);
+    tscb::profile::Configure(kProfileSiteNames, kProfileSiteCount);
+    tscb::memory::Configure(kProfileSiteNames, kProfileSiteCount);
+    tscb::DefineLazyExports(exports, kLazyExports, 11);
 
     return exports;
 }
 
-// Main module initialization
+// Main module initialization. Модуль N-API context-aware: загружается в каждом
+// worker_thread, состояние привязано к Napi::Env через tscb::EnvData
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
     return InitGeneratedAPI(env, exports);
 }
@@ -6,6 +6,7 @@
 extern OutputData Solver_process(const InputData& param);
 extern TaskResult Solver_processLongTask(const LongTask& param);
 extern OutputData Solver_processHeavyComputation(const InputData& param);
+extern OutputData Solver_processHeavyComputationNative(const InputData& param);
 
 
 // API wrapper initialization
@@ -1,20 +1,63 @@
 // Сгенерированный API с удобными классами
 
 import { InputData, OutputData, LongTask, TaskResult } from './generated_types';
-import addon from './generated_addon';
+import addon, { BridgeStats, BridgeMemory } from './generated_addon';
 
 export class Solver {
   static process(input: InputData): OutputData {
     return addon.Solver_process(input);
   }
 
+  static processBatch(inputs: InputData[]): OutputData[] {
+    return addon.Solver_process_batch(inputs);
+  }
+
   static async processLongTask(input: LongTask): Promise<TaskResult> {
     return addon.Solver_processLongTask(input);
   }
 
+  static async processLongTaskBatch(inputs: LongTask[]): Promise<TaskResult[]> {
+    return addon.Solver_processLongTask_batch(inputs);
+  }
+
   static async processHeavyComputation(input: InputData): Promise<OutputData> {
     return addon.Solver_processHeavyComputation(input);
   }
 
+  static async processHeavyComputationBatch(inputs: InputData[]): Promise<OutputData[]> {
+    return addon.Solver_processHeavyComputation_batch(inputs);
+  }
+
+  static async processHeavyComputationNative(input: InputData): Promise<OutputData> {
+    return addon.Solver_processHeavyComputationNative(input);
+  }
+
+  static async processHeavyComputationNativeBatch(inputs: InputData[]): Promise<OutputData[]> {
+    return addon.Solver_processHeavyComputationNative_batch(inputs);
+  }
+
+}
+
+/**
+ * Задает размер нативного пула для @CppAsync({ pool: 'native' }).
+ * Вызывать до первого асинхронного вызова; 0 - по числу аппаратных потоков.
+ */
+export function initThreadPool(size: number): void {
+  addon.__initPool(size);
 }
 
+/**
+ * Счетчики горячего пути по экспортам: decode/execute/encode/queueWait.
+ * Заполняются только в сборке с define TSCB_PROFILE; reset обнуляет счетчики.
+ */
+export function bridgeStats(reset: boolean = false): BridgeStats {
+  return addon.__bridgeStats(reset);
+}
+
+/**
+ * Байты, которые держит нативная сторона: входы и результаты незавершенных
+ * async вызовов по экспортам и ленивые view. peakBytes - максимум с запуска.
+ */
+export function bridgeMemory(): BridgeMemory {
+  return addon.__bridgeMemory();
+}
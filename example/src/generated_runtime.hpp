@@ -0,0 +1,2717 @@
+#pragma once
+
+// Вспомогательный runtime ts-cpp-bridge (генерируется автоматически, НЕ ИЗМЕНЯЙТЕ)
+
+#include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tscb {
+
+/**
+ * Пул потоков с work stealing для @CppAsync({ pool: 'native' }).
+ * Один на процесс, не зависит от UV_THREADPOOL_SIZE и не делит потоки с fs/dns/zlib.
+ * У каждого потока своя очередь; задачи, поставленные из рабочего потока, попадают
+ * в его очередь, свободные потоки забирают задачи из хвоста чужих очередей.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // Пул не разрушается: статический деструктор при выходе ждал бы потоков,
+    // заблокированных в BlockingCall к уже завершенному Env. Потоки завершаются вместе с процессом
+    static ThreadPool& Instance() {
+        static ThreadPool* pool = new ThreadPool();
+        return *pool;
+    }
+
+    /**
+     * Задает размер пула до первого запуска задачи (0 - по числу аппаратных потоков).
+     * Возвращает false, если пул уже запущен с другим размером.
+     */
+    bool Configure(size_t size) {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        if (!queues_.empty()) {
+            return size == 0 || size == queues_.size();
+        }
+        size_ = size;
+        return true;
+    }
+
+    size_t Size() {
+        EnsureStarted();
+        return queues_.size();
+    }
+
+    void Submit(Task task) {
+        EnsureStarted();
+        size_t index = CurrentIndex();
+        if (index >= queues_.size()) {
+            index = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        // Счетчик растет только после того, как задача лежит в очереди
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            pending_++;
+        }
+        wake_.notify_one();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    ThreadPool() = default;
+
+    static size_t& CurrentIndex() {
+        thread_local size_t index = SIZE_MAX;
+        return index;
+    }
+
+    void EnsureStarted() {
+        std::call_once(started_, [this]() {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            size_t count = size_ > 0 ? size_ : std::thread::hardware_concurrency();
+            count = std::max<size_t>(1, count);
+            for (size_t i = 0; i < count; i++) {
+                queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+            }
+            for (size_t i = 0; i < count; i++) {
+                std::thread([this, i]() { Run(i); }).detach();
+            }
+        });
+    }
+
+    bool TryPop(size_t index, Task& task) {
+        // Своя очередь - с головы (FIFO), чужие - с хвоста
+        {
+            Queue& own = *queues_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues_.size(); offset++) {
+            Queue& victim = *queues_[(index + offset) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Run(size_t index) {
+        CurrentIndex() = index;
+        for (;;) {
+            // Поток сначала резервирует одну из поставленных задач и только потом ищет ее:
+            // pending_ не уходит в минус, а свободные потоки не перебирают пустые очереди
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wake_.wait(lock, [this]() { return pending_ > 0; });
+                pending_--;
+            }
+            // Задач в очередях не меньше, чем резервов, но обход может разминуться с задачей,
+            // поставленной в уже проверенную очередь: тогда обход повторяется
+            Task task;
+            while (!TryPop(index, task)) {
+                std::this_thread::yield();
+            }
+            task();
+        }
+    }
+
+    std::once_flag started_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> next_{0};
+    size_t size_ = 0;
+    size_t pending_ = 0;
+};
+
+/**
+ * Задача нативного пула: Execute выполняется в рабочем потоке,
+ * Complete - в главном потоке после доставки через ThreadSafeFunction
+ */
+class PoolJob {
+public:
+    virtual ~PoolJob() = default;
+    virtual void Execute() = 0;
+    virtual void Complete(Napi::Env env) = 0;
+};
+
+void CompletePoolJob(Napi::Env env, Napi::Function, std::nullptr_t*, PoolJob* job);
+
+using JobDispatcher = Napi::TypedThreadSafeFunction<std::nullptr_t, PoolJob, CompletePoolJob>;
+
+/**
+ * Данные модуля, привязанные к конкретному Napi::Env (instance data).
+ * Ключ свойства создается при первом обращении и переиспользуется
+ * во всех FromNapi/ToNapi вместо повторной интернализации UTF-8 строк.
+ */
+class EnvData {
+public:
+    static EnvData& Get(Napi::Env env) {
+        EnvData* data = env.GetInstanceData<EnvData>();
+        if (data == nullptr) {
+            data = new EnvData(env);
+            env.SetInstanceData<EnvData>(data);
+        }
+        return *data;
+    }
+
+    // Имена ключей запоминаются, сами строки создает первый Key(): загрузка модуля не зависит от числа полей
+    void InitKeys(Napi::Env env, const char* const* names, size_t count) {
+        (void)env;
+        keyNames_ = names;
+        keyCount_ = count;
+        keys_.Reset();
+    }
+
+    // Строки лежат в массиве JS: N-API создает ссылки только на объекты
+    Napi::String Key(size_t index) const {
+        if (keys_.IsEmpty()) {
+            Napi::Array keys = Napi::Array::New(env_, keyCount_);
+            for (size_t i = 0; i < keyCount_; i++) {
+                keys.Set(static_cast<uint32_t>(i), Napi::String::New(env_, keyNames_[i]));
+            }
+            keys_ = Napi::Persistent(keys);
+        }
+        return keys_.Value().Get(static_cast<uint32_t>(index)).As<Napi::String>();
+    }
+
+    /**
+     * Конструкторы классов, созданных через DefineClass (ленивые view и т.п.)
+     */
+    void SetConstructor(size_t index, Napi::Function ctor) {
+        if (constructors_.size() <= index) {
+            constructors_.resize(index + 1);
+        }
+        constructors_[index] = Napi::Persistent(ctor);
+    }
+
+    Napi::Function Constructor(size_t index) const { return constructors_[index].Value(); }
+
+    // JS строки интернированных значений по идентификатору (InternedString::ToNapi),
+    // в массиве по той же причине, что и ключи
+    Napi::Array InternedStrings() {
+        if (interned_.IsEmpty()) {
+            interned_ = Napi::Persistent(Napi::Array::New(env_));
+        }
+        return interned_.Value();
+    }
+
+    // Класс дескриптора потока @CppStream (создается при первом вызове)
+    Napi::FunctionReference& StreamConstructor() { return streamConstructor_; }
+
+    // Класс __CancelToken для @CppAsync({ cancellable: true })
+    Napi::FunctionReference& CancelConstructor() { return cancelConstructor_; }
+
+    // Глобальный конструктор JS (SharedArrayBuffer, Float64Array, ...) этого Env
+    Napi::Function GlobalConstructor(Napi::Env env, const char* name) {
+        Napi::FunctionReference& ctor = globals_[name];
+        if (ctor.IsEmpty()) {
+            ctor = Napi::Persistent(env.Global().Get(name).As<Napi::Function>());
+        }
+        return ctor.Value();
+    }
+
+    // Функция JS, скомпилированная из source один раз на Env (копирование массивов, помощники Map/Set и т.п.)
+    Napi::Function Script(Napi::Env env, const char* source) {
+        Napi::FunctionReference& fn = scripts_[source];
+        if (fn.IsEmpty()) {
+            napi_value result;
+            napi_status status = napi_run_script(env, Napi::String::New(env, source), &result);
+            if (status != napi_ok) {
+                throw Napi::Error::New(env);
+            }
+            fn = Napi::Persistent(Napi::Value(env, result).As<Napi::Function>());
+        }
+        return fn.Value();
+    }
+
+    /**
+     * Диспетчер завершения задач пула. Удерживает event loop только
+     * пока есть незавершенные задачи.
+     */
+    JobDispatcher Dispatcher(Napi::Env env) {
+        if (dispatcher_ == nullptr) {
+            dispatcher_ = JobDispatcher::New(env, "tscb_pool_dispatcher", 0, 1);
+            dispatcher_.Unref(env);
+        }
+        return dispatcher_;
+    }
+
+    void JobStarted(Napi::Env env) {
+        if (jobsInFlight_++ == 0) {
+            dispatcher_.Ref(env);
+        }
+    }
+
+    void JobFinished(Napi::Env env) {
+        if (--jobsInFlight_ == 0) {
+            dispatcher_.Unref(env);
+        }
+    }
+
+private:
+    explicit EnvData(Napi::Env env) : env_(env) {}
+
+    Napi::Env env_;
+    const char* const* keyNames_ = nullptr;
+    size_t keyCount_ = 0;
+    mutable Napi::Reference<Napi::Array> keys_;
+    std::vector<Napi::FunctionReference> constructors_;
+    Napi::Reference<Napi::Array> interned_;
+    Napi::FunctionReference streamConstructor_;
+    Napi::FunctionReference cancelConstructor_;
+    std::unordered_map<std::string, Napi::FunctionReference> globals_;
+    std::unordered_map<const char*, Napi::FunctionReference> scripts_;
+    JobDispatcher dispatcher_;
+    size_t jobsInFlight_ = 0;
+};
+
+/**
+ * Экспорт модуля, Napi::Function которого создается при первом чтении свойства
+ */
+struct LazyExport {
+    const char* name;
+    Napi::Function::Callback callback;
+};
+
+// Getter ленивого экспорта: создает функцию и заменяет себя обычным свойством,
+// следующие обращения читают его без перехода в C++
+inline Napi::Value LazyExportGetter(const Napi::CallbackInfo& info) {
+    const LazyExport* entry = static_cast<const LazyExport*>(info.Data());
+    Napi::Function fn = Napi::Function::New(info.Env(), entry->callback, entry->name);
+    const auto attributes = static_cast<napi_property_attributes>(napi_writable | napi_enumerable | napi_configurable);
+    info.This().As<Napi::Object>().DefineProperty(Napi::PropertyDescriptor::Value(entry->name, fn, attributes));
+    return fn;
+}
+
+/**
+ * Определяет экспорты одним napi_define_properties: на каждый - getter без
+ * своей обертки и CallbackData, функции создаются только для вызываемых экспортов
+ */
+inline void DefineLazyExports(Napi::Object exports, const LazyExport* entries, size_t count) {
+    std::vector<Napi::PropertyDescriptor> properties;
+    properties.reserve(count);
+    const auto attributes = static_cast<napi_property_attributes>(napi_enumerable | napi_configurable);
+    for (size_t i = 0; i < count; i++) {
+        properties.push_back(Napi::PropertyDescriptor::Accessor<LazyExportGetter>(
+            entries[i].name, attributes, const_cast<LazyExport*>(&entries[i])));
+    }
+    exports.DefineProperties(properties);
+}
+
+inline void CompletePoolJob(Napi::Env env, Napi::Function, std::nullptr_t*, PoolJob* job) {
+    // env == nullptr, если окружение уже завершается: результат некуда доставить,
+    // а деструктор задачи обращался бы к handles несуществующего Env - задача не освобождается
+    if (env == nullptr) {
+        return;
+    }
+    Napi::HandleScope scope(env);
+    EnvData::Get(env).JobFinished(env);
+    job->Complete(env);
+    delete job;
+}
+
+/**
+ * Ставит задачу в нативный пул; владение job переходит пулу.
+ * Вызывается только из главного потока.
+ */
+inline void QueueJob(Napi::Env env, PoolJob* job) {
+    EnvData& data = EnvData::Get(env);
+    JobDispatcher dispatcher = data.Dispatcher(env);
+    data.JobStarted(env);
+    ThreadPool::Instance().Submit([job, dispatcher]() {
+        job->Execute();
+        // При napi_closing окружение уже уничтожено, задача намеренно не освобождается
+        // (см. CompletePoolJob)
+        dispatcher.BlockingCall(job);
+    });
+}
+
+/**
+ * Выполняет body(chunk) для chunk из [0, chunks) в нативном пуле (tscb::ThreadPool).
+ * Вызывающий поток тоже разбирает части, поэтому вызов из задачи пула или из
+ * Execute() не блокируется на занятом пуле. Первое исключение пробрасывается вызывающему,
+ * оставшиеся части после него не запускаются.
+ */
+inline void ParallelChunks(size_t chunks, const std::function<void(size_t)>& body) {
+    if (chunks == 0) {
+        return;
+    }
+    if (chunks == 1) {
+        body(0);
+        return;
+    }
+
+    struct State {
+        const std::function<void(size_t)>* body;
+        size_t chunks;
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+
+        // Забирает части, пока они есть; body используется только для забранных частей,
+        // поэтому помощник, запущенный после возврата вызова, ничего не трогает
+        void Drain() {
+            for (size_t chunk = next.fetch_add(1); chunk < chunks; chunk = next.fetch_add(1)) {
+                if (!failed.load(std::memory_order_relaxed)) {
+                    try {
+                        (*body)(chunk);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                        failed = true;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++done == chunks) {
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+
+    auto state = std::make_shared<State>();
+    state->body = &body;
+    state->chunks = chunks;
+    ThreadPool& pool = ThreadPool::Instance();
+    const size_t helpers = std::min(chunks - 1, pool.Size());
+    for (size_t i = 0; i < helpers; i++) {
+        pool.Submit([state]() { state->Drain(); });
+    }
+    state->Drain();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state]() { return state->done == state->chunks; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+/**
+ * Число частей для ParallelFor/ParallelReduce: не меньше grain элементов в части,
+ * по умолчанию - около четырех частей на поток пула для выравнивания нагрузки
+ */
+inline size_t ParallelChunkCount(size_t count, size_t grain) {
+    if (grain == 0) {
+        grain = std::max<size_t>(1, count / (ThreadPool::Instance().Size() * 4));
+    }
+    return (count + grain - 1) / grain;
+}
+
+/**
+ * Параллельный цикл для реализаций экспортов: fn(i) для i в [begin, end)
+ * на том же пуле, что и @CppAsync({ pool: 'native' }).
+ *
+ *     tscb::ParallelFor(size_t(0), input.numbers.size(), [&](size_t i) {
+ *         result.squared[i] = input.numbers[i] * input.numbers[i];
+ *     });
+ */
+template <typename Index, typename Fn>
+void ParallelFor(Index begin, Index end, Fn&& fn, size_t grain = 0) {
+    if (end <= begin) {
+        return;
+    }
+    const size_t count = static_cast<size_t>(end - begin);
+    const size_t chunks = ParallelChunkCount(count, grain);
+    const size_t step = (count + chunks - 1) / chunks;
+    ParallelChunks(chunks, [&](size_t chunk) {
+        const size_t first = chunk * step;
+        const size_t last = std::min(count, first + step);
+        for (size_t i = first; i < last; i++) {
+            fn(static_cast<Index>(begin + static_cast<Index>(i)));
+        }
+    });
+}
+
+/**
+ * Параллельная свертка: combine(acc, map(i)) для i в [begin, end).
+ * Каждая часть начинается с identity (нейтральный элемент combine), затем части
+ * объединяются по порядку: результат для заданного grain не зависит от расписания потоков.
+ *
+ *     double sum = tscb::ParallelReduce(size_t(0), v.size(), 0.0,
+ *         [&](size_t i) { return v[i]; }, std::plus<double>());
+ */
+template <typename Index, typename T, typename Map, typename Combine>
+T ParallelReduce(Index begin, Index end, T identity, Map&& map, Combine&& combine, size_t grain = 0) {
+    if (end <= begin) {
+        return identity;
+    }
+    const size_t count = static_cast<size_t>(end - begin);
+    const size_t chunks = ParallelChunkCount(count, grain);
+    const size_t step = (count + chunks - 1) / chunks;
+    std::vector<T> partials(chunks, identity);
+    ParallelChunks(chunks, [&](size_t chunk) {
+        const size_t first = chunk * step;
+        const size_t last = std::min(count, first + step);
+        T acc = identity;
+        for (size_t i = first; i < last; i++) {
+            acc = combine(std::move(acc), map(static_cast<Index>(begin + static_cast<Index>(i))));
+        }
+        partials[chunk] = std::move(acc);
+    });
+    T result = std::move(identity);
+    for (T& partial : partials) {
+        result = combine(std::move(result), std::move(partial));
+    }
+    return result;
+}
+
+/**
+ * Очередь вызовов одного экземпляра @CppClass: async методы выполняются по одному
+ * в порядке вызова и не занимают поток пула ожиданием. Start/Finish/Busy вызываются
+ * только из главного потока, поэтому блокировок нет.
+ */
+class InstanceQueue {
+public:
+    // Запускает задачу сразу или после завершения предыдущих
+    void Start(std::function<void()> start) {
+        if (busy_) {
+            pending_.push_back(std::move(start));
+            return;
+        }
+        busy_ = true;
+        start();
+    }
+
+    // Из OnOK/OnError выполненной задачи: запускает следующую
+    void Finish() {
+        if (pending_.empty()) {
+            busy_ = false;
+            return;
+        }
+        std::function<void()> next = std::move(pending_.front());
+        pending_.pop_front();
+        next();
+    }
+
+    // Async метод экземпляра выполняется в пуле или ждет в очереди
+    bool Busy() const { return busy_; }
+
+private:
+    std::deque<std::function<void()>> pending_;
+    bool busy_ = false;
+};
+
+/**
+ * Исключение отмены: бросается CancelToken::ThrowIfCancelled, отклоняет Promise
+ */
+class OperationCancelled : public std::runtime_error {
+public:
+    explicit OperationCancelled(const char* reason) : std::runtime_error(reason) {}
+};
+
+/**
+ * Токен отмены для @CppAsync({ cancellable: true }). Отменяется из JS
+ * (AbortSignal) или по истечении timeoutMs; проверка - одно атомарное чтение
+ * и, если задан дедлайн, чтение steady_clock. Пустой токен никогда не отменяется.
+ */
+class CancelToken {
+public:
+    CancelToken() = default;
+
+    bool Cancelled() const {
+        if (!state_) {
+            return false;
+        }
+        if (state_->cancelled.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if (state_->deadline != Clock::time_point::max() && Clock::now() >= state_->deadline) {
+            state_->cancelled.store(true, std::memory_order_relaxed);
+            state_->expired.store(true, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void ThrowIfCancelled() const {
+        if (Cancelled()) {
+            throw OperationCancelled(state_->expired.load(std::memory_order_relaxed) ? "Deadline exceeded" : "Operation cancelled");
+        }
+    }
+
+    // Главный поток: undefined -> пустой токен; false - значение не __CancelToken
+    static bool FromNapi(const Napi::Value& value, CancelToken& token);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct State {
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> expired{false};
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    std::shared_ptr<State> state_;
+
+    friend class CancelHandle;
+};
+
+/**
+ * JS объект __CancelToken(timeoutMs?): cancel() отменяет все вызовы с этим токеном
+ */
+class CancelHandle : public Napi::ObjectWrap<CancelHandle> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "CancelToken", {
+            InstanceMethod("cancel", &CancelHandle::Cancel),
+        });
+        EnvData::Get(env).CancelConstructor() = Napi::Persistent(ctor);
+        exports.Set("__CancelToken", ctor);
+    }
+
+    CancelHandle(const Napi::CallbackInfo& info) : Napi::ObjectWrap<CancelHandle>(info) {
+        token_.state_ = std::make_shared<CancelToken::State>();
+        if (info.Length() > 0 && info[0].IsNumber()) {
+            const double timeoutMs = info[0].As<Napi::Number>().DoubleValue();
+            if (timeoutMs > 0) {
+                token_.state_->deadline = CancelToken::Clock::now() +
+                    std::chrono::duration_cast<CancelToken::Clock::duration>(std::chrono::duration<double, std::milli>(timeoutMs));
+            }
+        }
+    }
+
+    const CancelToken& Token() const { return token_; }
+
+private:
+    Napi::Value Cancel(const Napi::CallbackInfo& info) {
+        token_.state_->cancelled.store(true, std::memory_order_relaxed);
+        return info.Env().Undefined();
+    }
+
+    CancelToken token_;
+};
+
+inline bool CancelToken::FromNapi(const Napi::Value& value, CancelToken& token) {
+    if (value.IsUndefined() || value.IsNull()) {
+        return true;
+    }
+    Napi::FunctionReference& ctor = EnvData::Get(value.Env()).CancelConstructor();
+    if (!value.IsObject() || ctor.IsEmpty() || !value.As<Napi::Object>().InstanceOf(ctor.Value())) {
+        return false;
+    }
+    token = CancelHandle::Unwrap(value.As<Napi::Object>())->Token();
+    return true;
+}
+
+/**
+ * Поток чанков для @CppStream. Производитель работает в отдельном потоке и
+ * передает чанки через StreamEmitter, потребитель читает их async iterator'ом
+ * (next/return). Очередь ограничена highWaterMark: Emit блокирует производителя,
+ * пока потребитель не заберет чанки.
+ */
+class StreamBase;
+
+void WakeStream(Napi::Env env, Napi::Function, std::nullptr_t*, std::shared_ptr<StreamBase>* stream);
+
+using StreamWakeup = Napi::TypedThreadSafeFunction<std::nullptr_t, std::shared_ptr<StreamBase>, WakeStream>;
+
+class StreamBase : public std::enable_shared_from_this<StreamBase> {
+public:
+    explicit StreamBase(size_t highWaterMark) : capacity_(std::max<size_t>(1, highWaterMark)) {}
+    virtual ~StreamBase() = default;
+
+    // Главный поток, до запуска производителя
+    void Start(Napi::Env env) {
+        wakeup_ = StreamWakeup::New(env, "tscb_stream", 0, 1);
+        // Event loop удерживается только пока JS ждет очередной next()
+        wakeup_.Unref(env);
+    }
+
+    // Главный поток: next() async iterator'а
+    Napi::Value Next(Napi::Env env) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        pending_.push_back(deferred);
+        Drain(env);
+        return deferred.Promise();
+    }
+
+    // Главный поток: return() (break в for await)
+    Napi::Value Return(Napi::Env env) {
+        RequestCancel();
+        Drain(env);
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(IteratorResult(env, env.Undefined(), true));
+        return deferred.Promise();
+    }
+
+    // Любой поток: потребитель больше не читает, производитель получит false из Emit
+    void RequestCancel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_ = true;
+            ClearChunks();
+        }
+        space_.notify_all();
+    }
+
+    bool Cancelled() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cancelled_;
+    }
+
+    // Рабочий поток: производитель завершился (error пустая при успехе)
+    void Finish(std::string error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+            error_ = std::move(error);
+        }
+        Wake();
+        wakeup_.Release();
+    }
+
+    // Главный поток: разрешает ожидающие next() готовыми чанками или концом потока
+    void Drain(Napi::Env env) {
+        wakeScheduled_ = false;
+        while (!pending_.empty()) {
+            Napi::Value value;
+            if (TakeChunk(env, value)) {
+                space_.notify_one();
+                pending_.front().Resolve(IteratorResult(env, value, false));
+                pending_.pop_front();
+                continue;
+            }
+            std::string error;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!done_ && !cancelled_) {
+                    break;
+                }
+                // Ошибка производителя отклоняет только первый next()
+                error.swap(error_);
+            }
+            if (error.empty()) {
+                pending_.front().Resolve(IteratorResult(env, env.Undefined(), true));
+            } else {
+                pending_.front().Reject(Napi::Error::New(env, error).Value());
+            }
+            pending_.pop_front();
+        }
+        const bool waiting = !pending_.empty();
+        if (waiting != refed_) {
+            refed_ = waiting;
+            if (waiting) {
+                wakeup_.Ref(env);
+            } else {
+                wakeup_.Unref(env);
+            }
+        }
+    }
+
+protected:
+    // Рабочий поток: ждет места в очереди; false - чтение отменено
+    bool WaitForSpace(std::unique_lock<std::mutex>& lock) {
+        space_.wait(lock, [this]() { return cancelled_ || QueuedChunks() < capacity_; });
+        return !cancelled_;
+    }
+
+    // Рабочий поток: будит главный поток, не больше одного вызова в очереди
+    void Wake() {
+        if (wakeScheduled_.exchange(true)) {
+            return;
+        }
+        auto* self = new std::shared_ptr<StreamBase>(shared_from_this());
+        if (wakeup_.NonBlockingCall(self) != napi_ok) {
+            delete self;
+        }
+    }
+
+    // Вызываются под mutex_
+    virtual size_t QueuedChunks() const = 0;
+    virtual void ClearChunks() = 0;
+    // Главный поток: забирает и конвертирует первый чанк; false - очередь пуста
+    virtual bool TakeChunk(Napi::Env env, Napi::Value& value) = 0;
+
+    mutable std::mutex mutex_;
+
+private:
+    static Napi::Object IteratorResult(Napi::Env env, Napi::Value value, bool done) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("value", value);
+        result.Set("done", Napi::Boolean::New(env, done));
+        return result;
+    }
+
+    std::condition_variable space_;
+    const size_t capacity_;
+    bool done_ = false;
+    bool cancelled_ = false;
+    std::string error_;
+    std::atomic<bool> wakeScheduled_{false};
+    StreamWakeup wakeup_;
+    std::deque<Napi::Promise::Deferred> pending_;  // только главный поток
+    bool refed_ = false;
+};
+
+inline void WakeStream(Napi::Env env, Napi::Function, std::nullptr_t*, std::shared_ptr<StreamBase>* stream) {
+    if (env != nullptr) {
+        Napi::HandleScope scope(env);
+        (*stream)->Drain(env);
+    }
+    delete stream;
+}
+
+/**
+ * Очередь чанков типа T; Convert превращает чанк в Napi::Value (генерируется для экспорта)
+ */
+template <typename T>
+class Stream : public StreamBase {
+public:
+    using StreamBase::StreamBase;
+
+    // Рабочий поток: false - потребитель отменил чтение
+    bool Push(T chunk) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!WaitForSpace(lock)) {
+                return false;
+            }
+            chunks_.push_back(std::move(chunk));
+        }
+        Wake();
+        return true;
+    }
+
+protected:
+    virtual Napi::Value Convert(Napi::Env env, T& chunk) = 0;
+
+    size_t QueuedChunks() const override { return chunks_.size(); }
+    void ClearChunks() override { chunks_.clear(); }
+
+    bool TakeChunk(Napi::Env env, Napi::Value& value) override {
+        T chunk;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (chunks_.empty()) {
+                return false;
+            }
+            chunk = std::move(chunks_.front());
+            chunks_.pop_front();
+        }
+        value = Convert(env, chunk);
+        return true;
+    }
+
+private:
+    std::deque<T> chunks_;
+};
+
+/**
+ * Интерфейс производителя для функции @CppStream
+ */
+template <typename T>
+class StreamEmitter {
+public:
+    explicit StreamEmitter(Stream<T>& stream) : stream_(stream) {}
+
+    // Блокирует, пока в очереди нет места; false - потребитель прекратил чтение, пора завершаться
+    bool Emit(T chunk) { return stream_.Push(std::move(chunk)); }
+
+    bool Cancelled() const { return stream_.Cancelled(); }
+
+private:
+    Stream<T>& stream_;
+};
+
+/**
+ * JS дескриптор потока: next()/return() async iterator'а
+ */
+class StreamHandle : public Napi::ObjectWrap<StreamHandle> {
+public:
+    static Napi::Object New(Napi::Env env, std::shared_ptr<StreamBase> stream) {
+        Napi::FunctionReference& ctor = EnvData::Get(env).StreamConstructor();
+        if (ctor.IsEmpty()) {
+            ctor = Napi::Persistent(DefineClass(env, "NativeStream", {
+                InstanceMethod("next", &StreamHandle::Next),
+                InstanceMethod("return", &StreamHandle::Return),
+            }));
+        }
+        return ctor.New({ Napi::External<std::shared_ptr<StreamBase>>::New(env, &stream) });
+    }
+
+    StreamHandle(const Napi::CallbackInfo& info) : Napi::ObjectWrap<StreamHandle>(info) {
+        if (info.Length() > 0 && info[0].IsExternal()) {
+            stream_ = *info[0].As<Napi::External<std::shared_ptr<StreamBase>>>().Data();
+        }
+    }
+
+    // Дескриптор собран GC: производитель больше никому не нужен
+    ~StreamHandle() {
+        if (stream_) {
+            stream_->RequestCancel();
+        }
+    }
+
+private:
+    Napi::Value Next(const Napi::CallbackInfo& info) {
+        if (!stream_) {
+            Napi::Error::New(info.Env(), "Invalid stream").ThrowAsJavaScriptException();
+            return info.Env().Null();
+        }
+        return stream_->Next(info.Env());
+    }
+
+    Napi::Value Return(const Napi::CallbackInfo& info) {
+        if (!stream_) {
+            Napi::Error::New(info.Env(), "Invalid stream").ThrowAsJavaScriptException();
+            return info.Env().Null();
+        }
+        return stream_->Return(info.Env());
+    }
+
+    std::shared_ptr<StreamBase> stream_;
+};
+
+/**
+ * Запускает производителя в отдельном потоке и возвращает JS дескриптор.
+ * Отдельный поток, а не пул: производитель может долго ждать потребителя.
+ */
+template <typename T>
+Napi::Object StartStream(Napi::Env env, std::shared_ptr<Stream<T>> stream, std::function<void(StreamEmitter<T>&)> produce) {
+    stream->Start(env);
+    std::thread([stream, produce = std::move(produce)]() {
+        std::string error;
+        try {
+            StreamEmitter<T> emitter(*stream);
+            produce(emitter);
+        } catch (const std::exception& e) {
+            error = e.what();
+        } catch (...) {
+            error = "Unknown error occurred";
+        }
+        stream->Finish(std::move(error));
+    }).detach();
+    return StreamHandle::New(env, stream);
+}
+
+/**
+ * Представление непрерывного буфера (аналог std::span из C++20).
+ * Используется для полей с @CppField({ view: true }): в синхронном вызове данные
+ * остаются в ArrayBuffer JS и действительны только пока жив исходный TypedArray.
+ * Copy() создает представление над собственной копией (вход @CppAsync/@CppStream).
+ */
+template <typename T>
+class ArrayView {
+public:
+    using value_type = T;
+    using iterator = T*;
+
+    ArrayView() = default;
+    ArrayView(T* data, size_t size) : data_(data), size_(size) {}
+    ArrayView(std::vector<T>& vec) : data_(vec.data()), size_(vec.size()) {}
+
+    static ArrayView Copy(const T* data, size_t size) {
+        ArrayView view;
+        if (size > 0) {
+            view.owned_ = std::shared_ptr<T[]>(new T[size]);
+            std::memcpy(view.owned_.get(), data, size * sizeof(T));
+            view.data_ = view.owned_.get();
+            view.size_ = size;
+        }
+        return view;
+    }
+
+    // Байты собственной копии (0 для представления над памятью JS)
+    size_t OwnedBytes() const { return owned_ ? size_ * sizeof(T) : 0; }
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    T& operator[](size_t index) const { return data_[index]; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    std::shared_ptr<T[]> owned_;
+};
+
+/**
+ * Пока объект жив, ViewTypedArray в этом потоке копирует данные, а не ссылается на память JS.
+ * Создается при разборе входа @CppAsync/@CppStream: пока задача выполняется в другом потоке,
+ * JS может заменить поле или отсоединить ArrayBuffer (transfer, postMessage, рост памяти WASM).
+ */
+class OwnedViewScope {
+public:
+    OwnedViewScope() { ++Depth(); }
+    ~OwnedViewScope() { --Depth(); }
+    OwnedViewScope(const OwnedViewScope&) = delete;
+    OwnedViewScope& operator=(const OwnedViewScope&) = delete;
+
+    static bool Active() { return Depth() > 0; }
+
+private:
+    static int& Depth() {
+        thread_local int depth = 0;
+        return depth;
+    }
+};
+
+/**
+ * Соответствие C++ типа элемента типу TypedArray в N-API
+ */
+template <typename T>
+struct TypedArrayTraits;
+
+// Read - метод Napi::Number: целые читаются через Int32Value/Uint32Value и сужаются по модулю,
+// как при записи в TypedArray; static_cast double вне диапазона - неопределенное поведение
+#define TSCB_TYPED_ARRAY_TRAITS(CppType, NapiType, JsName, Read)                \
+    template <>                                                                 \
+    struct TypedArrayTraits<CppType> {                                          \
+        static constexpr napi_typedarray_type type = NapiType;                  \
+        static constexpr const char* name = JsName;                             \
+        static CppType FromValue(const Napi::Value& value) {                    \
+            return static_cast<CppType>(value.As<Napi::Number>().Read());       \
+        }                                                                       \
+    };
+
+TSCB_TYPED_ARRAY_TRAITS(int8_t, napi_int8_array, "Int8Array", Int32Value)
+TSCB_TYPED_ARRAY_TRAITS(uint8_t, napi_uint8_array, "Uint8Array", Uint32Value)
+TSCB_TYPED_ARRAY_TRAITS(int16_t, napi_int16_array, "Int16Array", Int32Value)
+TSCB_TYPED_ARRAY_TRAITS(uint16_t, napi_uint16_array, "Uint16Array", Uint32Value)
+TSCB_TYPED_ARRAY_TRAITS(int32_t, napi_int32_array, "Int32Array", Int32Value)
+TSCB_TYPED_ARRAY_TRAITS(uint32_t, napi_uint32_array, "Uint32Array", Uint32Value)
+TSCB_TYPED_ARRAY_TRAITS(float, napi_float32_array, "Float32Array", FloatValue)
+TSCB_TYPED_ARRAY_TRAITS(double, napi_float64_array, "Float64Array", DoubleValue)
+
+#undef TSCB_TYPED_ARRAY_TRAITS
+
+template <>
+struct TypedArrayTraits<int64_t> {
+    static constexpr napi_typedarray_type type = napi_bigint64_array;
+    static constexpr const char* name = "BigInt64Array";
+    static int64_t FromValue(const Napi::Value& value) {
+        bool lossless = false;
+        int64_t result = value.As<Napi::BigInt>().Int64Value(&lossless);
+        if (!lossless) {
+            throw std::runtime_error("BigInt is out of int64 range");
+        }
+        return result;
+    }
+};
+
+template <>
+struct TypedArrayTraits<uint64_t> {
+    static constexpr napi_typedarray_type type = napi_biguint64_array;
+    static constexpr const char* name = "BigUint64Array";
+    static uint64_t FromValue(const Napi::Value& value) {
+        bool lossless = false;
+        uint64_t result = value.As<Napi::BigInt>().Uint64Value(&lossless);
+        if (!lossless) {
+            throw std::runtime_error("BigInt is out of uint64 range");
+        }
+        return result;
+    }
+};
+
+/**
+ * Приводит число JS к C++ типу без неопределенного поведения static_cast<T>(double):
+ * целые до 32 бит - по модулю, как ToInt32/ToUint32 (NaN и бесконечности дают 0),
+ * 64-битные целые вне диапазона T и NaN - ошибка
+ */
+template <typename T>
+inline T NumberCast(double number) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(number);
+    } else if constexpr (sizeof(T) == 8) {
+        // 2^63 и 2^64 точно представимы в double, сами границы в диапазон не входят
+        constexpr double upper = std::is_signed_v<T> ? 9223372036854775808.0 : 18446744073709551616.0;
+        constexpr double lower = std::is_signed_v<T> ? -9223372036854775808.0 : 0.0;
+        if (!(number >= lower && number < upper)) {
+            throw std::runtime_error(std::is_signed_v<T> ? "Number is out of int64 range" : "Number is out of uint64 range");
+        }
+        return static_cast<T>(number);
+    } else {
+        if (!std::isfinite(number)) {
+            return 0;
+        }
+        double wrapped = std::fmod(std::trunc(number), 4294967296.0);
+        if (wrapped < 0) {
+            wrapped += 4294967296.0;
+        }
+        return static_cast<T>(static_cast<uint32_t>(wrapped));
+    }
+}
+
+/**
+ * Читает i64/u64: число JS (так их возвращает ToNapi) или BigInt без потери точности
+ */
+template <typename T>
+inline T ReadInt64(const Napi::Value& value) {
+    if (value.IsBigInt()) {
+        return TypedArrayTraits<T>::FromValue(value);
+    }
+    return NumberCast<T>(value.As<Napi::Number>().DoubleValue());
+}
+
+/**
+ * Проверяет, что значение является TypedArray с элементами типа T
+ */
+template <typename T>
+inline bool IsTypedArrayOf(const Napi::Value& value) {
+    return value.IsTypedArray() &&
+           value.As<Napi::TypedArray>().TypedArrayType() == TypedArrayTraits<T>::type;
+}
+
+/**
+ * Начиная с этой длины обычный массив JS копируется одним TypedArray.prototype.set:
+ * V8 переносит packed SMI/double массивы целиком, без napi_get_element на каждый элемент
+ */
+constexpr uint32_t kBulkArrayThreshold = 32;
+
+// Проверяет, что все элементы - числа, и копирует массив в target одним set();
+// возвращает индекс первого элемента, который не число, или -1
+constexpr const char* kTypedArraySetScript =
+    "(function (array, target) {"
+    " for (let i = 0; i < array.length; i++) if (typeof array[i] !== 'number') return i;"
+    " target.set(array);"
+    " return -1;"
+    "})";
+
+inline std::runtime_error NumberExpected(uint32_t index) {
+    return std::runtime_error("Expected a number at index " + std::to_string(index));
+}
+
+// Копирует array в TypedArray target (см. kTypedArraySetScript)
+inline void SetTypedArray(const Napi::Array& array, const Napi::Value& target) {
+    Napi::Env env = array.Env();
+    int32_t bad = EnvData::Get(env).Script(env, kTypedArraySetScript).Call({array, target}).As<Napi::Number>().Int32Value();
+    if (bad >= 0) {
+        throw NumberExpected(static_cast<uint32_t>(bad));
+    }
+}
+
+/**
+ * Длинный массив чисел: элементы пишутся прямо в out через внешний ArrayBuffer над его памятью.
+ * Буфер отсоединяется сразу после копирования, поэтому JS не может обратиться к out позже
+ */
+template <typename T, typename Alloc>
+inline void ReadNumberArrayBulk(const Napi::Array& array, uint32_t length, std::vector<T, Alloc>& out) {
+    Napi::Env env = array.Env();
+    out.resize(length);
+    napi_value buffer = nullptr;
+    if (napi_create_external_arraybuffer(env, out.data(), length * sizeof(T), nullptr, nullptr, &buffer) != napi_ok) {
+        // Среды без внешних буферов (V8 sandbox): копия через промежуточный TypedArray
+        Napi::TypedArrayOf<T> staging = Napi::TypedArrayOf<T>::New(env, length);
+        SetTypedArray(array, staging);
+        std::memcpy(out.data(), staging.Data(), length * sizeof(T));
+        return;
+    }
+    struct Detach {
+        napi_env env;
+        napi_value buffer;
+        ~Detach() { napi_detach_arraybuffer(env, buffer); }
+    } detach{env, buffer};
+    SetTypedArray(array, Napi::TypedArrayOf<T>::New(env, length, Napi::ArrayBuffer(env, buffer), 0));
+}
+
+/**
+ * Копирует TypedArray в std::vector<T> одним memcpy.
+ * Обычный JS массив также принимается с одинаковыми правилами при любой длине: каждый элемент
+ * должен быть числом, целые приводятся по модулю (ToInt32/ToUint32), float округляется по правилам JS.
+ * Длинный массив копируется одним set() на стороне V8, короткий - поэлементно.
+ */
+template <typename T, typename Alloc>
+inline void ReadTypedArray(const Napi::Value& value, std::vector<T, Alloc>& out) {
+    if (IsTypedArrayOf<T>(value)) {
+        Napi::TypedArrayOf<T> array = value.As<Napi::TypedArrayOf<T>>();
+        out.resize(array.ElementLength());
+        if (!out.empty()) {
+            std::memcpy(out.data(), array.Data(), out.size() * sizeof(T));
+        }
+        return;
+    }
+    if (value.IsArray()) {
+        Napi::Array array = value.As<Napi::Array>();
+        const uint32_t length = array.Length();
+        // BigInt64Array не принимает числа: 64-битные целые разбираются поэлементно
+        constexpr bool numbers = sizeof(T) < 8 || std::is_floating_point_v<T>;
+        if constexpr (numbers) {
+            if (length >= kBulkArrayThreshold) {
+                ReadNumberArrayBulk(array, length, out);
+                return;
+            }
+        }
+        out.clear();
+        out.reserve(length);
+        for (uint32_t i = 0; i < length; i++) {
+            Napi::Value element = array.Get(i);
+            if (numbers && !element.IsNumber()) {
+                throw NumberExpected(i);
+            }
+            out.push_back(TypedArrayTraits<T>::FromValue(element));
+        }
+        return;
+    }
+    throw std::runtime_error(std::string("Expected ") + TypedArrayTraits<T>::name);
+}
+
+/**
+ * Возвращает представление над памятью TypedArray без копирования
+ */
+template <typename T>
+inline ArrayView<T> ViewTypedArray(const Napi::Value& value) {
+    if (!IsTypedArrayOf<T>(value)) {
+        throw std::runtime_error(std::string("Expected ") + TypedArrayTraits<T>::name + " for zero-copy view");
+    }
+    Napi::TypedArrayOf<T> array = value.As<Napi::TypedArrayOf<T>>();
+    if (OwnedViewScope::Active()) {
+        return ArrayView<T>::Copy(array.Data(), array.ElementLength());
+    }
+    return ArrayView<T>(array.Data(), array.ElementLength());
+}
+
+/**
+ * Читает JS строку прямо в буфер out (std::string или std::pmr::string) без временной std::string
+ */
+template <typename String>
+inline void ReadString(const Napi::Value& value, String& out) {
+    if (!value.IsString()) {
+        throw std::runtime_error("Expected a string");
+    }
+    size_t length = 0;
+    if (napi_get_value_string_utf8(value.Env(), value, nullptr, 0, &length) != napi_ok) {
+        throw std::runtime_error("Failed to read a string");
+    }
+    out.resize(length);
+    // N-API дописывает завершающий ноль: буфер строки вмещает length + 1 байт
+    if (napi_get_value_string_utf8(value.Env(), value, &out[0], length + 1, &length) != napi_ok) {
+        throw std::runtime_error("Failed to read a string");
+    }
+}
+
+template <typename String>
+inline Napi::String NewString(Napi::Env env, const String& value) {
+    return Napi::String::New(env, value.data(), value.size());
+}
+
+/**
+ * Строки @CppField({ encoding: 'latin1' }): один байт на символ без перекодирования UTF-8.
+ * Строка читается кодовыми единицами UTF-16: символ выше U+00FF не обрезается
+ * до младшего байта, а отклоняет значение (latin1 == false).
+ * Возвращает false, если значение не строка.
+ */
+template <typename String>
+inline bool ReadLatin1Units(napi_env env, napi_value value, String& out, bool& latin1) {
+    thread_local std::u16string units;
+    size_t length = 0;
+    if (napi_get_value_string_utf16(env, value, nullptr, 0, &length) != napi_ok) {
+        return false;
+    }
+    units.resize(length);
+    napi_get_value_string_utf16(env, value, &units[0], length + 1, &length);
+    out.resize(length);
+    latin1 = true;
+    for (size_t i = 0; i < length; i++) {
+        if (units[i] > 0xFF) {
+            latin1 = false;
+            break;
+        }
+        out[i] = static_cast<char>(units[i]);
+    }
+    return true;
+}
+
+template <typename String>
+inline void ReadLatin1(const Napi::Value& value, String& out) {
+    bool latin1 = false;
+    if (!ReadLatin1Units(value.Env(), value, out, latin1)) {
+        throw std::runtime_error("Expected a string");
+    }
+    if (!latin1) {
+        throw std::runtime_error("Expected a Latin-1 string");
+    }
+}
+
+inline Napi::String NewLatin1String(Napi::Env env, const char* data, size_t size) {
+    napi_value result;
+    if (napi_create_string_latin1(env, data, size, &result) != napi_ok) {
+        throw Napi::Error::New(env);
+    }
+    return Napi::String(env, result);
+}
+
+template <typename String>
+inline Napi::String NewLatin1String(Napi::Env env, const String& value) {
+    return NewLatin1String(env, value.data(), value.size());
+}
+
+inline bool IsAscii(std::string_view value) {
+    for (char c : value) {
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Таблица интернированных строк процесса для @CppField({ intern: true }).
+ * Записи не удаляются: указатели на них стабильны во всех потоках и Env,
+ * поэтому значения можно держать в async задачах и кэше результатов.
+ * Строки длиннее kMaxLength не интернируются, а после kMaxEntries записей
+ * или kMaxBytes памяти таблицы новые значения не добавляются.
+ */
+class InternTable {
+public:
+    struct Entry {
+        std::string value;
+        uint32_t id;
+        bool ascii;  // JS строка создается как Latin-1, без перекодирования UTF-8
+    };
+
+    static constexpr uint32_t kMaxEntries = 1u << 16;
+    static constexpr size_t kMaxLength = 64;
+    static constexpr size_t kMaxBytes = 4u << 20;
+    static constexpr uint32_t kNoId = static_cast<uint32_t>(-1);
+
+    static InternTable& Instance() {
+        static InternTable table;
+        return table;
+    }
+
+    const Entry* Empty() const { return &entries_.front(); }
+
+    // nullptr - строка слишком длинная или таблица заполнена
+    const Entry* Intern(std::string_view value) {
+        if (value.size() > kMaxLength) {
+            return nullptr;
+        }
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = index_.find(value);
+            if (it != index_.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        return InsertLocked(value);
+    }
+
+private:
+    InternTable() { InsertLocked(std::string_view()); }
+
+    const Entry* InsertLocked(std::string_view value) {
+        auto it = index_.find(value);
+        if (it != index_.end()) {
+            return it->second;
+        }
+        // Запись, ключ индекса и узел хеш-таблицы
+        const size_t bytes = sizeof(Entry) + value.size() + sizeof(std::pair<std::string_view, const Entry*>) + sizeof(void*);
+        if (entries_.size() >= kMaxEntries || bytes_ + bytes > kMaxBytes) {
+            return nullptr;
+        }
+        entries_.push_back(Entry{std::string(value), static_cast<uint32_t>(entries_.size()), IsAscii(value)});
+        const Entry* entry = &entries_.back();
+        index_.emplace(std::string_view(entry->value), entry);
+        bytes_ += bytes;
+        return entry;
+    }
+
+    std::shared_mutex mutex_;
+    std::deque<Entry> entries_;  // deque не перемещает элементы при росте
+    std::unordered_map<std::string_view, const Entry*> index_;
+    size_t bytes_ = 0;
+};
+
+/**
+ * Значение поля @CppField({ intern: true }): ссылка на строку в InternTable.
+ * Равные строки имеют один id, сравнение - по указателю, JS строка создается
+ * один раз на Env. Длинная строка или значение при заполненной таблице хранит
+ * собственную копию (id() == kNoId).
+ */
+class InternedString {
+public:
+    using Entry = InternTable::Entry;
+
+    InternedString() : entry_(InternTable::Instance().Empty()) {}
+    InternedString(std::string_view value) { Assign(value); }
+    InternedString(const char* value) : InternedString(std::string_view(value)) {}
+    InternedString(const std::string& value) : InternedString(std::string_view(value)) {}
+
+    uint32_t id() const { return entry_->id; }
+    std::string_view view() const { return entry_->value; }
+    const std::string& str() const { return entry_->value; }
+    const char* data() const { return entry_->value.data(); }
+    size_t size() const { return entry_->value.size(); }
+    bool empty() const { return entry_->value.empty(); }
+
+    operator std::string_view() const { return view(); }
+    operator const std::string&() const { return str(); }
+
+    bool operator==(const InternedString& other) const {
+        return entry_ == other.entry_ || ((owned_ || other.owned_) && view() == other.view());
+    }
+    bool operator!=(const InternedString& other) const { return !(*this == other); }
+    bool operator==(std::string_view other) const { return view() == other; }
+    bool operator!=(std::string_view other) const { return view() != other; }
+
+    size_t Hash() const { return std::hash<std::string_view>()(view()); }
+    // Память таблицы общая для всех значений, своя - только у копии
+    size_t HeapBytes() const { return owned_ ? owned_->value.capacity() + 1 : 0; }
+
+    Napi::String ToNapi(Napi::Env env) const {
+        if (owned_) {
+            return Napi::String::New(env, data(), size());
+        }
+        Napi::Array strings = EnvData::Get(env).InternedStrings();
+        Napi::Value cached = strings.Get(entry_->id);
+        if (cached.IsString()) {
+            return cached.As<Napi::String>();
+        }
+        Napi::String value = entry_->ascii ? NewLatin1String(env, data(), size()) : Napi::String::New(env, data(), size());
+        strings.Set(entry_->id, value);
+        return value;
+    }
+
+private:
+    void Assign(std::string_view value) {
+        entry_ = InternTable::Instance().Intern(value);
+        if (entry_ == nullptr) {
+            owned_ = std::make_shared<const Entry>(Entry{std::string(value), InternTable::kNoId, false});
+            entry_ = owned_.get();
+        }
+    }
+
+    const Entry* entry_;
+    std::shared_ptr<const Entry> owned_;
+};
+
+inline Napi::String NewString(Napi::Env env, const InternedString& value) {
+    return value.ToNapi(env);
+}
+
+/**
+ * Разбор интернированного поля: строка читается в буфер потока, копия в кучу - только
+ * для нового значения
+ */
+inline void ReadInterned(const Napi::Value& value, InternedString& out) {
+    thread_local std::string buffer;
+    ReadString(value, buffer);
+    out = InternedString(std::string_view(buffer));
+}
+
+/**
+ * Ставит JS TypeError "<path>: expected <what>" без C++ исключения
+ * (разбор входа @CppExport({ noexcept: true })), всегда возвращает false
+ */
+inline bool FieldTypeError(Napi::Env env, const char* path, const char* what) {
+    napi_throw_type_error(env, nullptr, (std::string(path) + ": expected " + what).c_str());
+    return false;
+}
+
+/**
+ * Поле TryFromNapi: тип проверяет сам вызов N-API через статус, без IsX() и исключений.
+ * undefined оставляет значение по умолчанию, при другом типе - FieldTypeError
+ */
+template <typename T>
+inline bool TryReadField(const Napi::Value& value, T& out, const char* path) {
+    if (value.IsUndefined()) {
+        return true;
+    }
+    napi_env env = value.Env();
+    if constexpr (std::is_same_v<T, bool>) {
+        if (napi_get_value_bool(env, value, &out) != napi_ok) {
+            return FieldTypeError(value.Env(), path, "a boolean");
+        }
+    } else if constexpr (std::is_enum_v<T> || std::is_integral_v<T>) {
+        int64_t number = 0;
+        if (napi_get_value_int64(env, value, &number) != napi_ok) {
+            return FieldTypeError(value.Env(), path, "a number");
+        }
+        out = static_cast<T>(number);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        double number = 0;
+        if (napi_get_value_double(env, value, &number) != napi_ok) {
+            return FieldTypeError(value.Env(), path, "a number");
+        }
+        out = static_cast<T>(number);
+    } else {
+        size_t length = 0;
+        if (napi_get_value_string_utf8(env, value, nullptr, 0, &length) != napi_ok) {
+            return FieldTypeError(value.Env(), path, "a string");
+        }
+        out.resize(length);
+        napi_get_value_string_utf8(env, value, &out[0], length + 1, &length);
+    }
+    return true;
+}
+
+inline bool TryReadField(const Napi::Value& value, InternedString& out, const char* path) {
+    if (value.IsUndefined()) {
+        return true;
+    }
+    thread_local std::string buffer;
+    if (!TryReadField(value, buffer, path)) {
+        return false;
+    }
+    out = InternedString(std::string_view(buffer));
+    return true;
+}
+
+template <typename String>
+inline bool TryReadLatin1(const Napi::Value& value, String& out, const char* path) {
+    if (value.IsUndefined()) {
+        return true;
+    }
+    bool latin1 = false;
+    if (!ReadLatin1Units(value.Env(), value, out, latin1)) {
+        return FieldTypeError(value.Env(), path, "a string");
+    }
+    if (!latin1) {
+        return FieldTypeError(value.Env(), path, "a Latin-1 string");
+    }
+    return true;
+}
+
+#if __has_include(<memory_resource>)
+/**
+ * Арена одного вызова для @CppStruct({ arena: true }): строки и векторы входа
+ * выделяются из монотонного буфера и освобождаются разом после ToNapi.
+ * Первые kInlineSize байт не требуют обращения к аллокатору.
+ */
+class CallArena {
+public:
+    static constexpr size_t kInlineSize = 4096;
+
+    CallArena() : resource_(buffer_, sizeof(buffer_)) {}
+    CallArena(const CallArena&) = delete;
+    CallArena& operator=(const CallArena&) = delete;
+
+    std::pmr::memory_resource* Resource() { return &resource_; }
+
+    // Освобождает все выделенное; данные, созданные из арены, должны быть уже уничтожены
+    void Release() { resource_.release(); }
+
+private:
+    alignas(std::max_align_t) unsigned char buffer_[kInlineSize];
+    std::pmr::monotonic_buffer_resource resource_;
+};
+#endif
+
+/**
+ * Создает TypedArray и заполняет его одним memcpy
+ */
+template <typename T>
+inline Napi::TypedArrayOf<T> NewTypedArray(Napi::Env env, const T* data, size_t length) {
+    Napi::TypedArrayOf<T> array = Napi::TypedArrayOf<T>::New(env, length, TypedArrayTraits<T>::type);
+    if (length > 0) {
+        std::memcpy(array.Data(), data, length * sizeof(T));
+    }
+    return array;
+}
+
+/**
+ * TypedArray над SharedArrayBuffer для @CppField({ shared: true }): такой результат
+ * передается в другой worker_thread через postMessage без копирования.
+ * N-API не создает SharedArrayBuffer, поэтому буфер и массив создаются конструкторами JS.
+ */
+template <typename T>
+inline Napi::TypedArrayOf<T> NewSharedTypedArray(Napi::Env env, const T* data, size_t length) {
+    EnvData& envData = EnvData::Get(env);
+    Napi::Object buffer = envData.GlobalConstructor(env, "SharedArrayBuffer")
+        .New({Napi::Number::New(env, static_cast<double>(length * sizeof(T)))});
+    Napi::TypedArrayOf<T> array = envData.GlobalConstructor(env, TypedArrayTraits<T>::name)
+        .New({buffer}).template As<Napi::TypedArrayOf<T>>();
+    if (length > 0) {
+        std::memcpy(array.Data(), data, length * sizeof(T));
+    }
+    return array;
+}
+
+/**
+ * Map на отсортированном векторе пар для @CppField({ container: 'flat_map' }):
+ * поиск - бинарный по непрерывной памяти, обход - в порядке ключей.
+ * В отличие от std::map ключ в value_type не const - не меняйте first у элементов.
+ */
+template <typename K, typename V>
+class FlatMap {
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using size_type = size_t;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    iterator begin() { return items_.begin(); }
+    iterator end() { return items_.end(); }
+    const_iterator begin() const { return items_.begin(); }
+    const_iterator end() const { return items_.end(); }
+    size_t size() const { return items_.size(); }
+    size_t capacity() const { return items_.capacity(); }
+    bool empty() const { return items_.empty(); }
+    void reserve(size_t n) { items_.reserve(n); }
+    void clear() { items_.clear(); }
+
+    iterator lower_bound(const K& key) {
+        return std::lower_bound(items_.begin(), items_.end(), key, KeyLess());
+    }
+    const_iterator lower_bound(const K& key) const {
+        return std::lower_bound(items_.begin(), items_.end(), key, KeyLess());
+    }
+
+    iterator find(const K& key) {
+        iterator it = lower_bound(key);
+        return it != items_.end() && !(key < it->first) ? it : items_.end();
+    }
+    const_iterator find(const K& key) const {
+        const_iterator it = lower_bound(key);
+        return it != items_.end() && !(key < it->first) ? it : items_.end();
+    }
+
+    size_t count(const K& key) const { return find(key) != end() ? 1 : 0; }
+
+    V& at(const K& key) {
+        iterator it = find(key);
+        if (it == items_.end()) {
+            throw std::out_of_range("tscb::FlatMap::at");
+        }
+        return it->second;
+    }
+    const V& at(const K& key) const { return const_cast<FlatMap*>(this)->at(key); }
+
+    V& operator[](const K& key) {
+        iterator it = lower_bound(key);
+        if (it == items_.end() || key < it->first) {
+            it = items_.emplace(it, key, V());
+        }
+        return it->second;
+    }
+
+    std::pair<iterator, bool> insert(value_type item) {
+        iterator it = lower_bound(item.first);
+        if (it != items_.end() && !(item.first < it->first)) {
+            return {it, false};
+        }
+        return {items_.insert(it, std::move(item)), true};
+    }
+
+    size_t erase(const K& key) {
+        iterator it = find(key);
+        if (it == items_.end()) {
+            return 0;
+        }
+        items_.erase(it);
+        return 1;
+    }
+
+    /**
+     * Добавление при разборе без поддержки порядка: после серии вызовов нужен sort_unique().
+     * n вставок - O(n log n) вместо O(n^2) у operator[]
+     */
+    void append_unsorted(K key, V value) { items_.emplace_back(std::move(key), std::move(value)); }
+
+    // Упорядочивает после append_unsorted; из повторяющихся ключей остается последнее значение, как у operator[]
+    void sort_unique() {
+        std::stable_sort(items_.begin(), items_.end(), KeyLess());
+        auto out = items_.begin();
+        for (auto it = items_.begin(); it != items_.end(); ++it) {
+            if (out != items_.begin() && !((out - 1)->first < it->first)) {
+                *(out - 1) = std::move(*it);
+            } else {
+                if (out != it) {
+                    *out = std::move(*it);
+                }
+                ++out;
+            }
+        }
+        items_.erase(out, items_.end());
+    }
+
+    bool operator==(const FlatMap& other) const { return items_ == other.items_; }
+    bool operator!=(const FlatMap& other) const { return items_ != other.items_; }
+
+private:
+    struct KeyLess {
+        bool operator()(const value_type& item, const K& key) const { return item.first < key; }
+        bool operator()(const value_type& a, const value_type& b) const { return a.first < b.first; }
+    };
+
+    std::vector<value_type> items_;
+};
+
+// Map/Set -> плоский массив [k0, v0, k1, v1, ...] (для Set - [v0, v1, ...]) одним вызовом
+// вместо итератора или Map.prototype.forEach с обратным вызовом в C++ на каждый элемент.
+// numeric - Float64Array: C++ читает элементы из памяти без N-API вызова на каждый
+constexpr const char* kFlattenScript =
+    "(function (c, numeric) {"
+    " const n = c instanceof Map ? c.size * 2 : c.size;"
+    " const out = numeric ? new Float64Array(n) : new Array(n);"
+    " let i = 0;"
+    " if (c instanceof Map) c.forEach((v, k) => { out[i++] = k; out[i++] = v; });"
+    " else c.forEach(v => { out[i++] = v; });"
+    " return out;"
+    "})";
+
+// Плоский массив [k0, v0, ...] -> Map: все Map.prototype.set выполняются в JS
+constexpr const char* kMapFromFlatScript =
+    "(function (flat) {"
+    " const m = new Map();"
+    " for (let i = 0; i + 1 < flat.length; i += 2) m.set(flat[i], flat[i + 1]);"
+    " return m;"
+    "})";
+
+/**
+ * Значение - экземпляр глобального конструктора JS name (Map, Set)
+ */
+inline bool IsInstanceOf(const Napi::Value& value, const char* name) {
+    Napi::Env env = value.Env();
+    return value.IsObject() && value.As<Napi::Object>().InstanceOf(EnvData::Get(env).GlobalConstructor(env, name));
+}
+
+/**
+ * Элементы JS Map или Set плоским массивом (см. kFlattenScript)
+ */
+inline Napi::Value FlattenContainer(const Napi::Value& value, bool numeric) {
+    Napi::Env env = value.Env();
+    return EnvData::Get(env).Script(env, kFlattenScript).Call({value, Napi::Boolean::New(env, numeric)});
+}
+
+/**
+ * Set<number> из JS Set: reserve по размеру и чтение из Float64Array
+ */
+template <typename Set>
+inline void ReadNumericSet(const Napi::Value& value, Set& out) {
+    using T = typename Set::value_type;
+    Napi::Float64Array flat = FlattenContainer(value, true).As<Napi::Float64Array>();
+    const double* items = flat.Data();
+    const size_t length = flat.ElementLength();
+    out.reserve(length);
+    for (size_t i = 0; i < length; i++) {
+        out.insert(NumberCast<T>(items[i]));
+    }
+}
+
+/**
+ * Map<number, number> из JS Map: пары читаются из плоского Float64Array
+ */
+template <typename K, typename V, typename... Rest>
+inline void ReadNumericMap(const Napi::Value& value, std::unordered_map<K, V, Rest...>& out) {
+    Napi::Float64Array flat = FlattenContainer(value, true).As<Napi::Float64Array>();
+    const double* items = flat.Data();
+    const size_t length = flat.ElementLength();
+    out.reserve(length / 2);
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        out[NumberCast<K>(items[i])] = NumberCast<V>(items[i + 1]);
+    }
+}
+
+template <typename K, typename V>
+inline void ReadNumericMap(const Napi::Value& value, FlatMap<K, V>& out) {
+    Napi::Float64Array flat = FlattenContainer(value, true).As<Napi::Float64Array>();
+    const double* items = flat.Data();
+    const size_t length = flat.ElementLength();
+    out.reserve(length / 2);
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        out.append_unsorted(NumberCast<K>(items[i]), NumberCast<V>(items[i + 1]));
+    }
+    out.sort_unique();
+}
+
+/**
+ * JS Set из массива элементов: один вызов конструктора
+ */
+inline Napi::Object NewSet(Napi::Env env, const Napi::Value& items) {
+    return EnvData::Get(env).GlobalConstructor(env, "Set").New({items});
+}
+
+/**
+ * JS Set чисел: элементы передаются конструктору Set одним Float64Array
+ */
+template <typename Set>
+inline Napi::Object NewNumericSet(Napi::Env env, const Set& value) {
+    Napi::Float64Array items = Napi::Float64Array::New(env, value.size());
+    double* out = items.Data();
+    for (const auto& item : value) {
+        *out++ = static_cast<double>(item);
+    }
+    return NewSet(env, items);
+}
+
+/**
+ * JS Map из плоского массива пар [k0, v0, ...] (см. kMapFromFlatScript)
+ */
+inline Napi::Object NewMap(Napi::Env env, const Napi::Value& flat) {
+    return EnvData::Get(env).Script(env, kMapFromFlatScript).Call({flat}).As<Napi::Object>();
+}
+
+/**
+ * JS Map<number, number>: пары передаются одним Float64Array
+ */
+template <typename Map>
+inline Napi::Object NewNumericMap(Napi::Env env, const Map& value) {
+    Napi::Float64Array flat = Napi::Float64Array::New(env, value.size() * 2);
+    double* out = flat.Data();
+    for (const auto& pair : value) {
+        *out++ = static_cast<double>(pair.first);
+        *out++ = static_cast<double>(pair.second);
+    }
+    return NewMap(env, flat);
+}
+
+/**
+ * Колонка @CppStruct({ layout: 'columnar' }): TypedArray (или массив) ровно из length
+ * элементов, отсутствующая колонка заполняется нулями
+ */
+template <typename T>
+inline void ReadColumn(const Napi::Value& value, size_t length, std::vector<T>& out, const char* name) {
+    if (value.IsUndefined()) {
+        out.assign(length, T());
+        return;
+    }
+    ReadTypedArray<T>(value, out);
+    if (out.size() != length) {
+        throw std::runtime_error(std::string("column '") + name + "' has " + std::to_string(out.size()) +
+                                 " elements, expected " + std::to_string(length));
+    }
+}
+
+/**
+ * Таблица strings колоночного объекта: каждое уникальное значение передается один раз
+ */
+inline void ReadStringTable(const Napi::Value& value, std::vector<std::string>& out) {
+    out.clear();
+    if (!value.IsArray()) {
+        return;
+    }
+    Napi::Array array = value.As<Napi::Array>();
+    const uint32_t length = array.Length();
+    out.reserve(length);
+    for (uint32_t i = 0; i < length; i++) {
+        out.push_back(array.Get(i).As<Napi::String>().Utf8Value());
+    }
+}
+
+// Индекс необязательной строки без значения (MISSING_COLUMN_STRING в generated_types.ts)
+constexpr uint32_t kMissingColumnString = 0xFFFFFFFFu;
+
+/**
+ * Строковая колонка: Uint32Array индексов в таблице strings
+ */
+inline void ReadStringColumn(const Napi::Value& value, size_t length, const std::vector<std::string>& table,
+                             std::vector<std::string>& out, const char* name) {
+    if (value.IsUndefined()) {
+        out.assign(length, std::string());
+        return;
+    }
+    std::vector<uint32_t> index;
+    ReadColumn<uint32_t>(value, length, index, name);
+    out.clear();
+    out.reserve(length);
+    for (uint32_t id : index) {
+        if (id == kMissingColumnString) {
+            // Необязательное поле без значения: как и при построчном разборе - значение по умолчанию
+            out.emplace_back();
+            continue;
+        }
+        if (id >= table.size()) {
+            throw std::runtime_error(std::string("column '") + name + "' refers to string " + std::to_string(id) +
+                                     " of " + std::to_string(table.size()));
+        }
+        out.push_back(table[id]);
+    }
+}
+
+/**
+ * Собирает таблицу strings при ToNapi колонок: строковая колонка становится
+ * Uint32Array индексов, повторяющиеся значения попадают в таблицу один раз.
+ * Хранит string_view на строки колонок - живет только внутри ToNapi.
+ */
+class StringTable {
+public:
+    Napi::TypedArrayOf<uint32_t> Index(Napi::Env env, const std::vector<std::string>& column) {
+        Napi::TypedArrayOf<uint32_t> index = Napi::TypedArrayOf<uint32_t>::New(env, column.size(), napi_uint32_array);
+        uint32_t* out = index.Data();
+        for (const std::string& value : column) {
+            auto inserted = ids_.emplace(std::string_view(value), static_cast<uint32_t>(values_.size()));
+            if (inserted.second) {
+                values_.push_back(inserted.first->first);
+            }
+            *out++ = inserted.first->second;
+        }
+        return index;
+    }
+
+    Napi::Array ToNapi(Napi::Env env) const {
+        Napi::Array array = Napi::Array::New(env, values_.size());
+        for (size_t i = 0; i < values_.size(); i++) {
+            array.Set(static_cast<uint32_t>(i), Napi::String::New(env, values_[i].data(), values_[i].size()));
+        }
+        return array;
+    }
+
+private:
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    std::vector<std::string_view> values_;
+};
+
+/**
+ * Значение T по умолчанию (с инициализаторами полей), создается один раз.
+ * Присваивание из него сбрасывает объект, сохраняя емкость строк и векторов.
+ */
+template <typename T>
+const T& DefaultValue() {
+    static const T value{};
+    return value;
+}
+
+/**
+ * Свободные объекты для @CppAsync({ recycle }): вход и результат асинхронного вызова
+ * возвращаются сюда после завершения, буферы их строк и векторов переиспользуются.
+ * Общий для всех Napi::Env процесса, поэтому защищен мьютексом; хранит не больше maxFree объектов.
+ */
+template <typename T>
+class ObjectPool {
+public:
+    explicit ObjectPool(size_t maxFree) : maxFree_(maxFree) {}
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    std::unique_ptr<T> Acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                std::unique_ptr<T> item = std::move(free_.back());
+                free_.pop_back();
+                return item;
+            }
+        }
+        return std::make_unique<T>();
+    }
+
+    void Release(std::unique_ptr<T> item) {
+        if (!item) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (free_.size() < maxFree_) {
+            free_.push_back(std::move(item));
+        }
+    }
+
+private:
+    const size_t maxFree_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<T>> free_;
+};
+
+/**
+ * Число частей, на которые делится пакетный асинхронный вызов.
+ * Не больше числа элементов и числа потоков (по умолчанию - аппаратных).
+ */
+inline size_t BatchChunkCount(size_t count, size_t threads = std::thread::hardware_concurrency()) {
+    return std::min(count, std::max<size_t>(1, threads));
+}
+
+/**
+ * Бинарный формат для @CppExport({ transport: 'binary' }).
+ * Little-endian (как на всех платформах Node.js), длины строк и коллекций - uint32.
+ * Числовые поля структуры идут первыми блоком с фиксированными смещениями.
+ */
+class WireReader {
+public:
+    WireReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    // Следующие n байт; проверка границ одна на весь блок
+    const uint8_t* Take(size_t n) {
+        if (n > size_ - pos_) {
+            throw std::runtime_error("Binary payload is truncated");
+        }
+        const uint8_t* p = data_ + pos_;
+        pos_ += n;
+        return p;
+    }
+
+    uint32_t Length() {
+        uint32_t n;
+        std::memcpy(&n, Take(sizeof(n)), sizeof(n));
+        return n;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+class WireWriter {
+public:
+    // Резервирует n байт в конце буфера и возвращает указатель на них
+    uint8_t* Grow(size_t n) {
+        const size_t pos = buffer_.size();
+        buffer_.resize(pos + n);
+        return buffer_.data() + pos;
+    }
+
+    void Length(size_t n) {
+        const uint32_t value = static_cast<uint32_t>(n);
+        std::memcpy(Grow(sizeof(value)), &value, sizeof(value));
+    }
+
+    const std::vector<uint8_t>& Buffer() const { return buffer_; }
+
+private:
+    std::vector<uint8_t> buffer_;
+};
+
+// Объявления до определений: перегрузки для вложенных коллекций видят друг друга
+template <typename T> void WireRead(WireReader& r, T& value);
+template <typename Tr, typename A> void WireRead(WireReader& r, std::basic_string<char, Tr, A>& value);
+template <typename T, typename A> void WireRead(WireReader& r, std::vector<T, A>& value);
+template <typename T> void WireRead(WireReader& r, std::unordered_set<T>& value);
+template <typename K, typename V> void WireRead(WireReader& r, std::unordered_map<K, V>& value);
+template <typename K, typename V> void WireRead(WireReader& r, FlatMap<K, V>& value);
+template <typename T> void WireWrite(WireWriter& w, const T& value);
+template <typename Tr, typename A> void WireWrite(WireWriter& w, const std::basic_string<char, Tr, A>& value);
+template <typename T, typename A> void WireWrite(WireWriter& w, const std::vector<T, A>& value);
+template <typename T> void WireWrite(WireWriter& w, const std::unordered_set<T>& value);
+template <typename K, typename V> void WireWrite(WireWriter& w, const std::unordered_map<K, V>& value);
+template <typename K, typename V> void WireWrite(WireWriter& w, const FlatMap<K, V>& value);
+
+// Числа, bool (1 байт), enum и структуры (<Name>::WireDecode/WireEncode)
+template <typename T>
+void WireRead(WireReader& r, T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        value = *r.Take(1) != 0;
+    } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        std::memcpy(&value, r.Take(sizeof(T)), sizeof(T));
+    } else {
+        value = T::WireDecode(r);
+    }
+}
+
+template <typename Tr, typename A>
+void WireRead(WireReader& r, std::basic_string<char, Tr, A>& value) {
+    const uint32_t n = r.Length();
+    value.assign(reinterpret_cast<const char*>(r.Take(n)), n);
+}
+
+template <typename T, typename A>
+void WireRead(WireReader& r, std::vector<T, A>& value) {
+    const uint32_t n = r.Length();
+    if constexpr ((std::is_arithmetic_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, bool>) {
+        // Массив чисел - одно копирование
+        const uint8_t* data = r.Take(static_cast<size_t>(n) * sizeof(T));
+        value.resize(n);
+        if (n > 0) {
+            std::memcpy(value.data(), data, static_cast<size_t>(n) * sizeof(T));
+        }
+    } else if constexpr (std::is_same_v<T, bool>) {
+        value.clear();
+        value.reserve(n);
+        for (uint32_t i = 0; i < n; i++) {
+            bool item;
+            WireRead(r, item);
+            value.push_back(item);
+        }
+    } else {
+        value.clear();
+        value.reserve(n);
+        for (uint32_t i = 0; i < n; i++) {
+            // Элемент создается аллокатором вектора (важно для std::pmr)
+            value.emplace_back();
+            WireRead(r, value.back());
+        }
+    }
+}
+
+template <typename T>
+void WireRead(WireReader& r, std::unordered_set<T>& value) {
+    const uint32_t n = r.Length();
+    value.clear();
+    value.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+        T item;
+        WireRead(r, item);
+        value.insert(std::move(item));
+    }
+}
+
+template <typename K, typename V>
+void WireRead(WireReader& r, std::unordered_map<K, V>& value) {
+    const uint32_t n = r.Length();
+    value.clear();
+    value.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+        K key;
+        WireRead(r, key);
+        WireRead(r, value[std::move(key)]);
+    }
+}
+
+template <typename K, typename V>
+void WireRead(WireReader& r, FlatMap<K, V>& value) {
+    const uint32_t n = r.Length();
+    value.clear();
+    value.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+        K key;
+        V item;
+        WireRead(r, key);
+        WireRead(r, item);
+        value.append_unsorted(std::move(key), std::move(item));
+    }
+    value.sort_unique();
+}
+
+template <typename T>
+void WireWrite(WireWriter& w, const T& value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        *w.Grow(1) = value ? 1 : 0;
+    } else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        std::memcpy(w.Grow(sizeof(T)), &value, sizeof(T));
+    } else {
+        value.WireEncode(w);
+    }
+}
+
+template <typename Tr, typename A>
+void WireWrite(WireWriter& w, const std::basic_string<char, Tr, A>& value) {
+    w.Length(value.size());
+    if (!value.empty()) {
+        std::memcpy(w.Grow(value.size()), value.data(), value.size());
+    }
+}
+
+template <typename T, typename A>
+void WireWrite(WireWriter& w, const std::vector<T, A>& value) {
+    w.Length(value.size());
+    if constexpr ((std::is_arithmetic_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, bool>) {
+        if (!value.empty()) {
+            std::memcpy(w.Grow(value.size() * sizeof(T)), value.data(), value.size() * sizeof(T));
+        }
+    } else if constexpr (std::is_same_v<T, bool>) {
+        for (bool item : value) {
+            WireWrite(w, item);
+        }
+    } else {
+        for (const auto& item : value) {
+            WireWrite(w, item);
+        }
+    }
+}
+
+template <typename T>
+void WireWrite(WireWriter& w, const std::unordered_set<T>& value) {
+    w.Length(value.size());
+    for (const auto& item : value) {
+        WireWrite(w, item);
+    }
+}
+
+template <typename K, typename V>
+void WireWrite(WireWriter& w, const std::unordered_map<K, V>& value) {
+    w.Length(value.size());
+    for (const auto& pair : value) {
+        WireWrite(w, pair.first);
+        WireWrite(w, pair.second);
+    }
+}
+template <typename K, typename V>
+void WireWrite(WireWriter& w, const FlatMap<K, V>& value) {
+    w.Length(value.size());
+    for (const auto& pair : value) {
+        WireWrite(w, pair.first);
+        WireWrite(w, pair.second);
+    }
+}
+
+/**
+ * Байты бинарного payload из ArrayBuffer или TypedArray (без копирования)
+ */
+inline bool WireBytes(const Napi::Value& value, const uint8_t*& data, size_t& size) {
+    if (value.IsArrayBuffer()) {
+        Napi::ArrayBuffer buffer = value.As<Napi::ArrayBuffer>();
+        data = static_cast<const uint8_t*>(buffer.Data());
+        size = buffer.ByteLength();
+        return true;
+    }
+    if (value.IsTypedArray()) {
+        Napi::TypedArray array = value.As<Napi::TypedArray>();
+        data = static_cast<const uint8_t*>(array.ArrayBuffer().Data()) + array.ByteOffset();
+        size = array.ByteLength();
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Копирует результат WireWriter в новый ArrayBuffer
+ */
+inline Napi::ArrayBuffer NewWireBuffer(Napi::Env env, const WireWriter& w) {
+    const std::vector<uint8_t>& bytes = w.Buffer();
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes.size());
+    if (!bytes.empty()) {
+        std::memcpy(buffer.Data(), bytes.data(), bytes.size());
+    }
+    return buffer;
+}
+
+/**
+ * Хэширование полей структур для кэша результатов @CppExport({ cache }).
+ * <Name>::Hash() комбинирует HashValue всех полей.
+ */
+inline void HashCombine(size_t& seed, size_t hash) {
+    seed ^= hash + static_cast<size_t>(0x9e3779b97f4a7c15ULL) + (seed << 6) + (seed >> 2);
+}
+
+// Перемешивание хэша элемента перед суммированием (для неупорядоченных коллекций)
+inline size_t HashMix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+}
+
+template <typename T> size_t HashValue(const T& value);
+template <typename Tr, typename A> size_t HashValue(const std::basic_string<char, Tr, A>& value);
+template <typename T, typename A> size_t HashValue(const std::vector<T, A>& value);
+template <typename T> size_t HashValue(const std::unordered_set<T>& value);
+template <typename K, typename V> size_t HashValue(const std::unordered_map<K, V>& value);
+template <typename K, typename V> size_t HashValue(const FlatMap<K, V>& value);
+
+// Числа, bool, enum и структуры (<Name>::Hash)
+template <typename T>
+size_t HashValue(const T& value) {
+    if constexpr (std::is_enum_v<T>) {
+        return std::hash<std::underlying_type_t<T>>()(static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return std::hash<T>()(value);
+    } else {
+        return value.Hash();
+    }
+}
+
+template <typename Tr, typename A>
+size_t HashValue(const std::basic_string<char, Tr, A>& value) {
+    return std::hash<std::string_view>()(std::string_view(value.data(), value.size()));
+}
+
+template <typename T, typename A>
+size_t HashValue(const std::vector<T, A>& value) {
+    size_t seed = value.size();
+    for (const auto& item : value) {
+        HashCombine(seed, HashValue(static_cast<const T&>(item)));
+    }
+    return seed;
+}
+
+// Порядок обхода unordered-коллекций не определен: хэш не зависит от порядка
+template <typename T>
+size_t HashValue(const std::unordered_set<T>& value) {
+    size_t sum = 0;
+    for (const auto& item : value) {
+        sum += HashMix(HashValue(item));
+    }
+    size_t seed = value.size();
+    HashCombine(seed, sum);
+    return seed;
+}
+
+template <typename K, typename V>
+size_t HashValue(const std::unordered_map<K, V>& value) {
+    size_t sum = 0;
+    for (const auto& pair : value) {
+        size_t entry = HashValue(pair.first);
+        HashCombine(entry, HashValue(pair.second));
+        sum += HashMix(entry);
+    }
+    size_t seed = value.size();
+    HashCombine(seed, sum);
+    return seed;
+}
+
+// FlatMap упорядочен: пары комбинируются по порядку
+template <typename K, typename V>
+size_t HashValue(const FlatMap<K, V>& value) {
+    size_t seed = value.size();
+    for (const auto& pair : value) {
+        HashCombine(seed, HashValue(pair.first));
+        HashCombine(seed, HashValue(pair.second));
+    }
+    return seed;
+}
+
+template <typename T>
+struct StructHash {
+    size_t operator()(const T& value) const { return value.Hash(); }
+};
+
+/**
+ * Оценка нативной памяти значения вне sizeof(T): буферы строк, векторов и узлы хэш-таблиц.
+ * <Name>::HeapBytes() суммирует HeapBytes всех полей. Для учета внешней памяти (ExternalMemory).
+ */
+template <typename T> size_t HeapBytes(const T& value);
+template <typename Tr, typename A> size_t HeapBytes(const std::basic_string<char, Tr, A>& value);
+template <typename T, typename A> size_t HeapBytes(const std::vector<T, A>& value);
+template <typename A> size_t HeapBytes(const std::vector<bool, A>& value);
+template <typename T> size_t HeapBytes(const std::unordered_set<T>& value);
+template <typename K, typename V> size_t HeapBytes(const std::unordered_map<K, V>& value);
+template <typename K, typename V> size_t HeapBytes(const FlatMap<K, V>& value);
+template <typename T> size_t HeapBytes(const ArrayView<T>& value);
+
+// Числа, bool, enum и структуры (<Name>::HeapBytes)
+template <typename T>
+size_t HeapBytes(const T& value) {
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        return 0;
+    } else {
+        return value.HeapBytes();
+    }
+}
+
+// Короткая строка хранится внутри объекта (SSO) и кучу не занимает
+template <typename Tr, typename A>
+size_t HeapBytes(const std::basic_string<char, Tr, A>& value) {
+    const char* data = value.data();
+    const char* self = reinterpret_cast<const char*>(&value);
+    return data >= self && data < self + sizeof(value) ? 0 : value.capacity() + 1;
+}
+
+template <typename T, typename A>
+size_t HeapBytes(const std::vector<T, A>& value) {
+    size_t bytes = value.capacity() * sizeof(T);
+    if constexpr (!std::is_arithmetic_v<T> && !std::is_enum_v<T>) {
+        for (const auto& item : value) {
+            bytes += HeapBytes(static_cast<const T&>(item));
+        }
+    }
+    return bytes;
+}
+
+template <typename A>
+size_t HeapBytes(const std::vector<bool, A>& value) {
+    return (value.capacity() + 7) / 8;
+}
+
+// Узел хэш-таблицы: значение и служебные указатели, плюс массив корзин
+template <typename T>
+size_t HeapBytes(const std::unordered_set<T>& value) {
+    size_t bytes = value.bucket_count() * sizeof(void*) + value.size() * (sizeof(T) + 2 * sizeof(void*));
+    for (const auto& item : value) {
+        bytes += HeapBytes(item);
+    }
+    return bytes;
+}
+
+template <typename K, typename V>
+size_t HeapBytes(const std::unordered_map<K, V>& value) {
+    using Node = typename std::unordered_map<K, V>::value_type;
+    size_t bytes = value.bucket_count() * sizeof(void*) + value.size() * (sizeof(Node) + 2 * sizeof(void*));
+    for (const auto& pair : value) {
+        bytes += HeapBytes(pair.first) + HeapBytes(pair.second);
+    }
+    return bytes;
+}
+
+template <typename K, typename V>
+size_t HeapBytes(const FlatMap<K, V>& value) {
+    size_t bytes = value.capacity() * sizeof(typename FlatMap<K, V>::value_type);
+    for (const auto& pair : value) {
+        bytes += HeapBytes(pair.first) + HeapBytes(pair.second);
+    }
+    return bytes;
+}
+
+// Память view над ArrayBuffer принадлежит JS и уже учтена V8, копию для async учитываем
+template <typename T>
+size_t HeapBytes(const ArrayView<T>& value) {
+    return value.OwnedBytes();
+}
+
+template <typename T>
+size_t NativeBytes(const T& value) {
+    return sizeof(T) + HeapBytes(value);
+}
+
+/**
+ * LRU результатов чистой функции: ключ - вход, значение - результат в нативной памяти.
+ * Общий для всех Napi::Env процесса, поэтому защищен мьютексом.
+ * ttlMs = 0 - записи не устаревают.
+ */
+template <typename Key, typename Value>
+class ResultCache {
+public:
+    ResultCache(size_t maxEntries, int64_t ttlMs) : maxEntries_(maxEntries), ttl_(ttlMs) {}
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // Копирует результат в value; false - промах или запись устарела
+    bool Get(const Key& key, Value& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = slots_.find(key);
+        if (it == slots_.end()) {
+            return false;
+        }
+        if (ttl_.count() > 0 && std::chrono::steady_clock::now() >= it->second.expires) {
+            lru_.erase(it->second.lru);
+            slots_.erase(it);
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        value = it->second.value;
+        return true;
+    }
+
+    void Put(const Key& key, const Value& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto expires = std::chrono::steady_clock::now() + ttl_;
+        auto it = slots_.find(key);
+        if (it != slots_.end()) {
+            it->second.value = value;
+            it->second.expires = expires;
+            lru_.splice(lru_.begin(), lru_, it->second.lru);
+            return;
+        }
+        it = slots_.emplace(key, Slot{value, expires, {}}).first;
+        // Узлы unordered_map не перемещаются при rehash: указатель на ключ стабилен
+        lru_.push_front(&it->first);
+        it->second.lru = lru_.begin();
+        if (slots_.size() > maxEntries_) {
+            auto victim = slots_.find(*lru_.back());
+            lru_.pop_back();
+            slots_.erase(victim);
+        }
+    }
+
+private:
+    struct Slot {
+        Value value;
+        std::chrono::steady_clock::time_point expires;
+        typename std::list<const Key*>::iterator lru;
+    };
+
+    size_t maxEntries_;
+    std::chrono::milliseconds ttl_;
+    std::unordered_map<Key, Slot, StructHash<Key>> slots_;
+    std::list<const Key*> lru_;  // Начало - последние использованные
+    std::mutex mutex_;
+};
+
+/**
+ * Асинхронные вызовы с кэшем, выполняющиеся сейчас: одинаковые входы ждут одну задачу.
+ * Используется только из потока своего Napi::Env (thread_local в сгенерированном коде).
+ */
+template <typename Key>
+class InFlight {
+public:
+    // Ожидающие вызова с таким входом или nullptr, если задачи нет
+    std::vector<Napi::Promise::Deferred>* Find(const Key& key) {
+        auto it = calls_.find(key);
+        return it == calls_.end() ? nullptr : &it->second;
+    }
+
+    // Регистрирует задачу; указатель на ключ действителен до Finish
+    const Key* Start(const Key& key) {
+        return &calls_.emplace(key, std::vector<Napi::Promise::Deferred>()).first->first;
+    }
+
+    // Снимает задачу и возвращает тех, кто ждал ее результата
+    std::vector<Napi::Promise::Deferred> Finish(const Key* key) {
+        auto it = calls_.find(*key);
+        std::vector<Napi::Promise::Deferred> waiters = std::move(it->second);
+        calls_.erase(it);
+        return waiters;
+    }
+
+private:
+    std::unordered_map<Key, std::vector<Napi::Promise::Deferred>, StructHash<Key>> calls_;
+};
+
+/**
+ * Счетчики горячего пути, включаются define TSCB_PROFILE (binding.gyp "defines").
+ * Каждый поток пишет только в свой блок счетчиков, читатель (__bridgeStats) суммирует блоки.
+ * Без TSCB_PROFILE макросы и Stamp ничего не делают.
+ */
+namespace profile {
+
+enum Phase : size_t {
+    kDecode,     // FromNapi
+    kExecute,    // вызов пользовательской функции
+    kEncode,     // ToNapi
+    kQueueWait,  // ожидание в очереди пула до Execute()
+    kPhaseCount
+};
+
+#ifdef TSCB_PROFILE
+
+inline uint64_t Now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct alignas(64) Counter {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+};
+
+class Registry {
+public:
+    static Registry& Instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    void Configure(const char* const* names, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (names_.empty()) {
+            names_.assign(names, names + count);
+        }
+    }
+
+    void Record(size_t site, Phase phase, uint64_t ns) {
+        Counter& counter = ThreadCounters()[site * kPhaseCount + phase];
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+        counter.totalNs.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max = counter.maxNs.load(std::memory_order_relaxed);
+        while (ns > max && !counter.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    Napi::Object ToNapi(Napi::Env env, bool reset) {
+        static const char* const phaseNames[kPhaseCount] = {"decode", "execute", "encode", "queueWait"};
+        std::lock_guard<std::mutex> lock(mutex_);
+        Napi::Object result = Napi::Object::New(env);
+        for (size_t site = 0; site < names_.size(); site++) {
+            Napi::Object siteStats = Napi::Object::New(env);
+            for (size_t phase = 0; phase < kPhaseCount; phase++) {
+                uint64_t count = 0, total = 0, max = 0;
+                for (const std::unique_ptr<Counter[]>& block : blocks_) {
+                    Counter& counter = block[site * kPhaseCount + phase];
+                    count += reset ? counter.count.exchange(0, std::memory_order_relaxed) : counter.count.load(std::memory_order_relaxed);
+                    total += reset ? counter.totalNs.exchange(0, std::memory_order_relaxed) : counter.totalNs.load(std::memory_order_relaxed);
+                    max = std::max(max, reset ? counter.maxNs.exchange(0, std::memory_order_relaxed) : counter.maxNs.load(std::memory_order_relaxed));
+                }
+                Napi::Object phaseStats = Napi::Object::New(env);
+                phaseStats.Set("count", Napi::Number::New(env, static_cast<double>(count)));
+                phaseStats.Set("totalNs", Napi::Number::New(env, static_cast<double>(total)));
+                phaseStats.Set("maxNs", Napi::Number::New(env, static_cast<double>(max)));
+                phaseStats.Set("avgNs", Napi::Number::New(env, count > 0 ? static_cast<double>(total) / count : 0.0));
+                siteStats.Set(phaseNames[phase], phaseStats);
+            }
+            result.Set(names_[site], siteStats);
+        }
+        return result;
+    }
+
+private:
+    Registry() = default;
+
+    Counter* ThreadCounters() {
+        thread_local Counter* counters = nullptr;
+        if (counters == nullptr) {
+            // Блок регистрируется один раз на поток и живет до конца процесса
+            std::lock_guard<std::mutex> lock(mutex_);
+            blocks_.emplace_back(new Counter[names_.size() * kPhaseCount]);
+            counters = blocks_.back().get();
+        }
+        return counters;
+    }
+
+    std::mutex mutex_;
+    std::vector<const char*> names_;
+    std::vector<std::unique_ptr<Counter[]>> blocks_;
+};
+
+/**
+ * Момент создания объекта, для замера ожидания в очереди
+ */
+struct Stamp {
+    uint64_t value = Now();
+};
+
+inline void Configure(const char* const* names, size_t count) { Registry::Instance().Configure(names, count); }
+inline void RecordWait(size_t site, const Stamp& stamp) { Registry::Instance().Record(site, kQueueWait, Now() - stamp.value); }
+inline Napi::Object StatsToNapi(Napi::Env env, bool reset) { return Registry::Instance().ToNapi(env, reset); }
+
+#define TSCB_PROFILE_START(var) const uint64_t var = ::tscb::profile::Now()
+#define TSCB_PROFILE_STOP(var, site, phase) \
+    ::tscb::profile::Registry::Instance().Record((site), ::tscb::profile::phase, ::tscb::profile::Now() - (var))
+
+#else
+
+struct Stamp {};
+
+inline void Configure(const char* const*, size_t) {}
+inline void RecordWait(size_t, const Stamp&) {}
+inline Napi::Object StatsToNapi(Napi::Env env, bool) { return Napi::Object::New(env); }
+
+#define TSCB_PROFILE_START(var) (void)0
+#define TSCB_PROFILE_STOP(var, site, phase) (void)0
+
+#endif
+
+} // namespace profile
+
+/**
+ * Нативная память, удерживаемая незавершенными вызовами и view, по экспортам (__bridgeMemory).
+ * Счетчики - по тем же местам, что и профилирование (kProfileSiteNames), плюс общий для view.
+ */
+namespace memory {
+
+// Место для памяти ленивых view (<Name>View)
+constexpr size_t kViews = static_cast<size_t>(-1);
+
+struct Gauge {
+    std::atomic<int64_t> bytes{0};
+    std::atomic<int64_t> peakBytes{0};
+};
+
+class Registry {
+public:
+    static Registry& Instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    // Вызывается при регистрации экспортов, до первого вызова
+    void Configure(const char* const* names, size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (names_.empty()) {
+            names_.assign(names, names + count);
+            names_.push_back("views");
+            gauges_.reset(new Gauge[names_.size()]);
+            count_.store(names_.size(), std::memory_order_release);
+        }
+    }
+
+    void Add(size_t site, int64_t delta) {
+        size_t count = count_.load(std::memory_order_acquire);
+        size_t index = site == kViews ? count - 1 : site;
+        if (count == 0 || index >= count) {
+            return;
+        }
+        Gauge& gauge = gauges_[index];
+        int64_t bytes = gauge.bytes.fetch_add(delta, std::memory_order_relaxed) + delta;
+        int64_t peak = gauge.peakBytes.load(std::memory_order_relaxed);
+        while (bytes > peak && !gauge.peakBytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+        }
+    }
+
+    Napi::Object ToNapi(Napi::Env env) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Napi::Object result = Napi::Object::New(env);
+        for (size_t site = 0; site < names_.size(); site++) {
+            Napi::Object siteMemory = Napi::Object::New(env);
+            siteMemory.Set("bytes", Napi::Number::New(env, static_cast<double>(gauges_[site].bytes.load(std::memory_order_relaxed))));
+            siteMemory.Set("peakBytes", Napi::Number::New(env, static_cast<double>(gauges_[site].peakBytes.load(std::memory_order_relaxed))));
+            result.Set(names_[site], siteMemory);
+        }
+        return result;
+    }
+
+private:
+    Registry() = default;
+
+    std::mutex mutex_;
+    std::vector<const char*> names_;
+    std::unique_ptr<Gauge[]> gauges_;
+    std::atomic<size_t> count_{0};
+};
+
+inline void Configure(const char* const* names, size_t count) { Registry::Instance().Configure(names, count); }
+inline Napi::Object ToNapi(Napi::Env env) { return Registry::Instance().ToNapi(env); }
+
+} // namespace memory
+
+/**
+ * Память, которую держит один вызов или view. Hold сообщает ее V8
+ * (AdjustExternalMemory, чтобы GC учитывал нативные буферы) и счетчику экспорта,
+ * Add - только счетчику (можно из рабочего потока), Release возвращает все обратно.
+ * Hold/Release - только в главном потоке. Без Release (окружение уже закрыто)
+ * деструктор исправляет только счетчик.
+ */
+class ExternalMemory {
+public:
+    explicit ExternalMemory(size_t site) : site_(site) {}
+
+    ExternalMemory(const ExternalMemory&) = delete;
+    ExternalMemory& operator=(const ExternalMemory&) = delete;
+
+    ~ExternalMemory() {
+        int64_t total = static_cast<int64_t>(reported_ + added_.load(std::memory_order_relaxed));
+        if (total > 0) {
+            memory::Registry::Instance().Add(site_, -total);
+        }
+    }
+
+    void Hold(Napi::Env env, size_t bytes) {
+        Napi::MemoryManagement::AdjustExternalMemory(env, static_cast<int64_t>(bytes));
+        reported_ += bytes;
+        memory::Registry::Instance().Add(site_, static_cast<int64_t>(bytes));
+    }
+
+    void Add(size_t bytes) {
+        added_.fetch_add(bytes, std::memory_order_relaxed);
+        memory::Registry::Instance().Add(site_, static_cast<int64_t>(bytes));
+    }
+
+    void Release(Napi::Env env) {
+        if (reported_ > 0) {
+            Napi::MemoryManagement::AdjustExternalMemory(env, -static_cast<int64_t>(reported_));
+        }
+        int64_t total = static_cast<int64_t>(reported_ + added_.exchange(0, std::memory_order_relaxed));
+        if (total > 0) {
+            memory::Registry::Instance().Add(site_, -total);
+        }
+        reported_ = 0;
+    }
+
+private:
+    const size_t site_;
+    size_t reported_ = 0;
+    std::atomic<size_t> added_{0};
+};
+
+} // namespace tscb
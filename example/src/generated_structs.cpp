@@ -1,21 +1,58 @@
 #include "generated_structs.hpp"
 
 
+namespace {
+// Индексы кэшированных ключей свойств в tscb::EnvData
+enum PropertyKey : size_t {
+    kKey_name,
+    kKey_value,
+    kKey_numbers,
+    kKey_greeting,
+    kKey_doubled,
+    kKey_squared,
+    kKey_duration,
+    kKey_data,
+    kKey_message,
+    kKey_timestamp,
+    kPropertyKeyCount
+};
+
+const char* const kPropertyNames[] = {
+    "name",
+    "value",
+    "numbers",
+    "greeting",
+    "doubled",
+    "squared",
+    "duration",
+    "data",
+    "message",
+    "timestamp",
+    nullptr
+};
+} // namespace
+
+void InitStructKeys(Napi::Env env) {
+    tscb::EnvData::Get(env).InitKeys(env, kPropertyNames, kPropertyKeyCount);
+}
+
 InputData InputData::FromNapi(const Napi::Object& obj) {
     InputData result;
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());
+    Napi::Value field;
     
     try {
-        if (obj.Has("name")) {
-            result.name = obj.Get("name").As<Napi::String>().Utf8Value();
+        field = obj.Get(tscbEnv.Key(kKey_name));
+        if (!field.IsUndefined()) {
+            result.name = field.As<Napi::String>().Utf8Value();
         }
-        if (obj.Has("value")) {
-            result.value = obj.Get("value").As<Napi::Number>().DoubleValue();
+        field = obj.Get(tscbEnv.Key(kKey_value));
+        if (!field.IsUndefined()) {
+            result.value = field.As<Napi::Number>().DoubleValue();
         }
-        if (obj.Has("numbers") && obj.Get("numbers").IsArray()) {
-            Napi::Array arr = obj.Get("numbers").As<Napi::Array>();
-            for (uint32_t i = 0; i < arr.Length(); i++) {
-                result.numbers.push_back(arr.Get(i).As<Napi::Number>().DoubleValue());
-            }
+        field = obj.Get(tscbEnv.Key(kKey_numbers));
+        if (field.IsArray()) {
+            tscb::ReadTypedArray<double>(field, result.numbers);
         }
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Failed to parse InputData: ") + e.what());
@@ -25,31 +62,41 @@ InputData InputData::FromNapi(const Napi::Object& obj) {
 }
 
 Napi::Object InputData::ToNapi(Napi::Env env) const {
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(env);
     Napi::Object obj = Napi::Object::New(env);
-    obj.Set("name", Napi::String::New(env, name));
+    obj.Set(tscbEnv.Key(kKey_name), Napi::String::New(env, name));
+    obj.Set(tscbEnv.Key(kKey_value), Napi::Number::New(env, value));
     Napi::Array numbersArr = Napi::Array::New(env, numbers.size());
     for (size_t i = 0; i < numbers.size(); i++) {
         numbersArr.Set(i, Napi::Number::New(env, numbers[i]));
     }
-    obj.Set("numbers", numbersArr);
+    obj.Set(tscbEnv.Key(kKey_numbers), numbersArr);
     return obj;
 }
 
+std::size_t InputData::HeapBytes() const {
+    return tscb::HeapBytes(name) +
+        tscb::HeapBytes(value) +
+        tscb::HeapBytes(numbers);
+}
+
 OutputData OutputData::FromNapi(const Napi::Object& obj) {
     OutputData result;
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());
+    Napi::Value field;
     
     try {
-        if (obj.Has("greeting")) {
-            result.greeting = obj.Get("greeting").As<Napi::String>().Utf8Value();
+        field = obj.Get(tscbEnv.Key(kKey_greeting));
+        if (!field.IsUndefined()) {
+            result.greeting = field.As<Napi::String>().Utf8Value();
         }
-        if (obj.Has("doubled")) {
-            result.doubled = obj.Get("doubled").As<Napi::Number>().DoubleValue();
+        field = obj.Get(tscbEnv.Key(kKey_doubled));
+        if (!field.IsUndefined()) {
+            result.doubled = field.As<Napi::Number>().DoubleValue();
         }
-        if (obj.Has("squared") && obj.Get("squared").IsArray()) {
-            Napi::Array arr = obj.Get("squared").As<Napi::Array>();
-            for (uint32_t i = 0; i < arr.Length(); i++) {
-                result.squared.push_back(arr.Get(i).As<Napi::Number>().DoubleValue());
-            }
+        field = obj.Get(tscbEnv.Key(kKey_squared));
+        if (field.IsArray()) {
+            tscb::ReadTypedArray<double>(field, result.squared);
         }
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Failed to parse OutputData: ") + e.what());
@@ -59,25 +106,37 @@ OutputData OutputData::FromNapi(const Napi::Object& obj) {
 }
 
 Napi::Object OutputData::ToNapi(Napi::Env env) const {
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(env);
     Napi::Object obj = Napi::Object::New(env);
-    obj.Set("greeting", Napi::String::New(env, greeting));
+    obj.Set(tscbEnv.Key(kKey_greeting), Napi::String::New(env, greeting));
+    obj.Set(tscbEnv.Key(kKey_doubled), Napi::Number::New(env, doubled));
     Napi::Array squaredArr = Napi::Array::New(env, squared.size());
     for (size_t i = 0; i < squared.size(); i++) {
         squaredArr.Set(i, Napi::Number::New(env, squared[i]));
     }
-    obj.Set("squared", squaredArr);
+    obj.Set(tscbEnv.Key(kKey_squared), squaredArr);
     return obj;
 }
 
+std::size_t OutputData::HeapBytes() const {
+    return tscb::HeapBytes(greeting) +
+        tscb::HeapBytes(doubled) +
+        tscb::HeapBytes(squared);
+}
+
 LongTask LongTask::FromNapi(const Napi::Object& obj) {
     LongTask result;
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());
+    Napi::Value field;
     
     try {
-        if (obj.Has("duration")) {
-            result.duration = obj.Get("duration").As<Napi::Number>().DoubleValue();
+        field = obj.Get(tscbEnv.Key(kKey_duration));
+        if (!field.IsUndefined()) {
+            result.duration = field.As<Napi::Number>().DoubleValue();
         }
-        if (obj.Has("data")) {
-            result.data = obj.Get("data").As<Napi::String>().Utf8Value();
+        field = obj.Get(tscbEnv.Key(kKey_data));
+        if (!field.IsUndefined()) {
+            result.data = field.As<Napi::String>().Utf8Value();
         }
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Failed to parse LongTask: ") + e.what());
@@ -87,23 +146,35 @@ LongTask LongTask::FromNapi(const Napi::Object& obj) {
 }
 
 Napi::Object LongTask::ToNapi(Napi::Env env) const {
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(env);
     Napi::Object obj = Napi::Object::New(env);
-    obj.Set("data", Napi::String::New(env, data));
+    obj.Set(tscbEnv.Key(kKey_duration), Napi::Number::New(env, duration));
+    obj.Set(tscbEnv.Key(kKey_data), Napi::String::New(env, data));
     return obj;
 }
 
+std::size_t LongTask::HeapBytes() const {
+    return tscb::HeapBytes(duration) +
+        tscb::HeapBytes(data);
+}
+
 TaskResult TaskResult::FromNapi(const Napi::Object& obj) {
     TaskResult result;
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());
+    Napi::Value field;
     
     try {
-        if (obj.Has("message")) {
-            result.message = obj.Get("message").As<Napi::String>().Utf8Value();
+        field = obj.Get(tscbEnv.Key(kKey_message));
+        if (!field.IsUndefined()) {
+            result.message = field.As<Napi::String>().Utf8Value();
         }
-        if (obj.Has("duration")) {
-            result.duration = obj.Get("duration").As<Napi::Number>().DoubleValue();
+        field = obj.Get(tscbEnv.Key(kKey_duration));
+        if (!field.IsUndefined()) {
+            result.duration = field.As<Napi::Number>().DoubleValue();
         }
-        if (obj.Has("timestamp")) {
-            result.timestamp = obj.Get("timestamp").As<Napi::Number>().DoubleValue();
+        field = obj.Get(tscbEnv.Key(kKey_timestamp));
+        if (!field.IsUndefined()) {
+            result.timestamp = field.As<Napi::Number>().DoubleValue();
         }
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("Failed to parse TaskResult: ") + e.what());
@@ -113,8 +184,17 @@ TaskResult TaskResult::FromNapi(const Napi::Object& obj) {
 }
 
 Napi::Object TaskResult::ToNapi(Napi::Env env) const {
+    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(env);
     Napi::Object obj = Napi::Object::New(env);
-    obj.Set("message", Napi::String::New(env, message));
+    obj.Set(tscbEnv.Key(kKey_message), Napi::String::New(env, message));
+    obj.Set(tscbEnv.Key(kKey_duration), Napi::Number::New(env, duration));
+    obj.Set(tscbEnv.Key(kKey_timestamp), Napi::Number::New(env, timestamp));
     return obj;
 }
 
+std::size_t TaskResult::HeapBytes() const {
+    return tscb::HeapBytes(message) +
+        tscb::HeapBytes(duration) +
+        tscb::HeapBytes(timestamp);
+}
+
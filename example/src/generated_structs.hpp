@@ -3,6 +3,11 @@
 #include <napi.h>
 #include <string>
 #include <vector>
+#include <unordered_set>
+#include <cstdint>
+#include "generated_runtime.hpp"
+
+
 
 
 struct InputData {
@@ -11,6 +16,7 @@ struct InputData {
     std::vector<double> numbers;
     static InputData FromNapi(const Napi::Object& obj);
     Napi::Object ToNapi(Napi::Env env) const;
+    std::size_t HeapBytes() const;
 };
 
 struct OutputData {
@@ -19,6 +25,7 @@ struct OutputData {
     std::vector<double> squared;
     static OutputData FromNapi(const Napi::Object& obj);
     Napi::Object ToNapi(Napi::Env env) const;
+    std::size_t HeapBytes() const;
 };
 
 struct LongTask {
@@ -26,6 +33,7 @@ struct LongTask {
     std::string data;
     static LongTask FromNapi(const Napi::Object& obj);
     Napi::Object ToNapi(Napi::Env env) const;
+    std::size_t HeapBytes() const;
 };
 
 struct TaskResult {
@@ -34,5 +42,9 @@ struct TaskResult {
     double timestamp;
     static TaskResult FromNapi(const Napi::Object& obj);
     Napi::Object ToNapi(Napi::Env env) const;
+    std::size_t HeapBytes() const;
 };
 
+// Создает кэшированные ключи свойств (вызывается из InitGeneratedAPI)
+void InitStructKeys(Napi::Env env);
+
@@ -45,4 +45,10 @@ export class Solver {
     // Тяжелые вычисления в отдельном потоке
     throw new Error('This method should be implemented in C++');
   }
+
+  @CppAsync({ pool: 'native' })
+  static processHeavyComputationNative(input: InputData): OutputData {
+    // То же вычисление в нативном пуле, для сравнения с пулом libuv в load-test.ts
+    throw new Error('This method should be implemented in C++');
+  }
 }
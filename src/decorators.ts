@@ -13,6 +13,8 @@ const STRUCT_METADATA_KEY = Symbol('CppStruct');
 const EXPORT_METADATA_KEY = Symbol('CppExport');
 const ASYNC_EXPORT_METADATA_KEY = Symbol('CppAsync');
 const FIELD_METADATA_KEY = Symbol('CppField');
+const CLASS_METADATA_KEY = Symbol('CppClass');
+const STREAM_EXPORT_METADATA_KEY = Symbol('CppStream');
 
 /**
  * Интерфейс для описания поля структуры
@@ -29,6 +31,7 @@ export interface FieldInfo {
 export interface StructInfo {
   name: string;
   fields: FieldInfo[];
+  options?: CppStructOptions;
 }
 
 /**
@@ -39,12 +42,109 @@ export interface ExportInfo {
   paramType: string;
   returnType: string;
   isAsync?: boolean;  // Новое поле для асинхронных методов
+  isStream?: boolean;
+  options?: CppAsyncOptions & CppStreamOptions;
+}
+
+/**
+ * Опции декоратора @CppField
+ */
+export interface CppFieldOptions {
+  // Передавать TypedArray без копирования (tscb::ArrayView<T> над памятью JS)
+  view?: boolean;
+  // Результат в TypedArray над SharedArrayBuffer: передается между worker_threads без копирования
+  shared?: boolean;
+  // Контейнер Map поля: 'flat_map' - tscb::FlatMap, отсортированный вектор пар (быстрый поиск и обход)
+  container?: 'flat_map';
+  // Строковое поле - tscb::InternedString: повторяющиеся значения хранятся один раз, JS строка кэшируется
+  intern?: boolean;
+  // 'latin1' - строка читается и создается по байту на символ, без перекодирования UTF-8
+  encoding?: 'latin1';
+}
+
+/**
+ * Опции декоратора @CppExport
+ */
+export interface CppExportOptions {
+  // Сигнатура C++ функции: 'ref' - Out fn(const In&) (по умолчанию),
+  // 'move' - Out fn(In&&), 'out' - void fn(const In&, Out&)
+  signature?: 'ref' | 'move' | 'out';
+  // 'napi' - поля через N-API (по умолчанию), 'binary' - один буфер в бинарном формате
+  transport?: 'napi' | 'binary';
+  // Кэш результатов для чистых функций: true - настройки по умолчанию
+  cache?: boolean | CppCacheOptions;
+  // Только для синхронных вызовов: вход проверяется без исключений (TryFromNapi), C++ функция - noexcept
+  noexcept?: boolean;
+}
+
+/**
+ * Опции кэша результатов @CppExport({ cache })
+ */
+export interface CppCacheOptions {
+  // Наибольшее число результатов в LRU (по умолчанию 256)
+  maxEntries?: number;
+  // Время жизни результата в мс (по умолчанию - без ограничения)
+  ttlMs?: number;
+}
+
+/**
+ * Опции декоратора @CppAsync
+ */
+export interface CppAsyncOptions extends CppExportOptions {
+  // 'uv' - пул libuv (по умолчанию, ограничен UV_THREADPOOL_SIZE), 'native' - собственный пул с work stealing
+  pool?: 'uv' | 'native';
+  // Размер нативного пула (по умолчанию - число аппаратных потоков)
+  poolSize?: number;
+  // Принимать AbortSignal/timeoutMs: C++ функция получает const tscb::CancelToken& последним аргументом
+  cancellable?: boolean;
+  // Объединять вызовы в один пакетный (<name>_batch): true - настройки по умолчанию
+  coalesce?: boolean | CppCoalesceOptions;
+  // Переиспользовать объекты входа и результата между вызовами (строки и векторы сохраняют емкость)
+  recycle?: boolean | CppRecycleOptions;
+}
+
+/**
+ * Опции переиспользования объектов @CppAsync({ recycle })
+ */
+export interface CppRecycleOptions {
+  // Сколько свободных объектов держать в пуле (по умолчанию 64)
+  maxFree?: number;
+}
+
+/**
+ * Опции объединения вызовов @CppAsync({ coalesce })
+ */
+export interface CppCoalesceOptions {
+  // Сколько мс собирать вызовы (по умолчанию 0 - вызовы текущего синхронного участка кода)
+  windowMs?: number;
+  // Наибольшее число входов в пакете: при достижении пакет уходит сразу (по умолчанию 256)
+  maxItems?: number;
+}
+
+/**
+ * Опции декоратора @CppStream
+ */
+export interface CppStreamOptions {
+  // Сколько чанков может ждать потребителя, прежде чем emit.Emit() заблокирует C++ (по умолчанию 16)
+  highWaterMark?: number;
+}
+
+/**
+ * Опции декоратора @CppStruct
+ */
+export interface CppStructOptions {
+  // Возвращать в JS ленивый ObjectWrap-view: поля конвертируются при первом обращении
+  view?: boolean;
+  // Строки и векторы - std::pmr, при разборе входа выделяются из арены вызова (tscb::CallArena)
+  arena?: boolean;
+  // 'columnar' - массивы структуры хранятся колонками <Name>Columns (TypedArray на поле)
+  layout?: 'columnar';
 }
 
 /**
  * Декоратор для пометки класса как C++ структуры
  */
-export function CppStruct(): <T extends { new (...args: any[]): {} }>(constructor: T) => T {
+export function CppStruct(options: CppStructOptions = {}): <T extends { new (...args: any[]): {} }>(constructor: T) => T {
   return function <T extends { new (...args: any[]): {} }>(constructor: T): T {
     // Получаем информацию о полях из reflect-metadata
     const fields: FieldInfo[] = [];
@@ -70,7 +170,8 @@ export function CppStruct(): <T extends { new (...args: any[]): {} }>(constructo
     
     const structInfo: StructInfo = {
       name: constructor.name,
-      fields
+      fields,
+      options
     };
     
     Reflect.defineMetadata(STRUCT_METADATA_KEY, structInfo, constructor);
@@ -78,13 +179,38 @@ export function CppStruct(): <T extends { new (...args: any[]): {} }>(constructo
   };
 }
 
+/**
+ * Декоратор для пометки класса как нативного класса с состоянием.
+ * Экземпляр держит C++ объект между вызовами, нестатические методы с
+ * @CppExport/@CppAsync вызываются на нем.
+ */
+export function CppClass(): <T extends { new (...args: any[]): {} }>(constructor: T) => T {
+  return function <T extends { new (...args: any[]): {} }>(constructor: T): T {
+    const paramTypes = Reflect.getMetadata('design:paramtypes', constructor) || [];
+    Reflect.defineMetadata(CLASS_METADATA_KEY, {
+      name: constructor.name,
+      paramType: paramTypes.length > 0 ? getTypeString(paramTypes[0]) : 'void'
+    }, constructor);
+    return constructor;
+  };
+}
+
+/**
+ * Декоратор для настройки маршалинга поля структуры
+ */
+export function CppField(options: CppFieldOptions = {}): PropertyDecorator {
+  return function (target: Object, propertyKey: string | symbol): void {
+    Reflect.defineMetadata(FIELD_METADATA_KEY, options, target, propertyKey);
+  };
+}
+
 /**
  * Декоратор для пометки метода как экспортируемого в C++
  * Поддерживает современные декораторы TypeScript
  */
-export function CppExport<T = any>(): MethodDecorator {
+export function CppExport<T = any>(options: CppExportOptions = {}): MethodDecorator {
   return function <T>(target: Object, propertyKey: string | symbol, descriptor: TypedPropertyDescriptor<T>): TypedPropertyDescriptor<T> | void {
-    applyExportDecorator(target, propertyKey, descriptor, false);
+    applyExportDecorator(target, propertyKey, descriptor, false, options);
     return descriptor;
   };
 }
@@ -93,9 +219,20 @@ export function CppExport<T = any>(): MethodDecorator {
  * Декоратор для пометки метода как асинхронного экспортируемого в C++
  * Функция будет возвращать Promise и выполняться в отдельном потоке
  */
-export function CppAsync<T = any>(): MethodDecorator {
+export function CppAsync<T = any>(options: CppAsyncOptions = {}): MethodDecorator {
   return function <T>(target: Object, propertyKey: string | symbol, descriptor: TypedPropertyDescriptor<T>): TypedPropertyDescriptor<T> | void {
-    applyExportDecorator(target, propertyKey, descriptor, true);
+    applyExportDecorator(target, propertyKey, descriptor, true, options);
+    return descriptor;
+  };
+}
+
+/**
+ * Декоратор для потокового экспорта: C++ отдает результат чанками через
+ * tscb::StreamEmitter, в TS метод возвращает AsyncIterableIterator чанков
+ */
+export function CppStream<T = any>(options: CppStreamOptions = {}): MethodDecorator {
+  return function <T>(target: Object, propertyKey: string | symbol, descriptor: TypedPropertyDescriptor<T>): TypedPropertyDescriptor<T> | void {
+    applyExportDecorator(target, propertyKey, descriptor, true, options, true);
     return descriptor;
   };
 }
@@ -103,7 +240,7 @@ export function CppAsync<T = any>(): MethodDecorator {
 /**
  * Применяет логику декоратора экспорта
  */
-function applyExportDecorator(target: any, propertyKey: string | symbol, descriptor: any, isAsync: boolean = false): void {
+function applyExportDecorator(target: any, propertyKey: string | symbol, descriptor: any, isAsync: boolean = false, options?: CppAsyncOptions & CppStreamOptions, isStream: boolean = false): void {
   // Получаем типы параметров и возвращаемого значения
   const paramTypes = Reflect.getMetadata('design:paramtypes', target, propertyKey) || [];
   const returnType = Reflect.getMetadata('design:returntype', target, propertyKey);
@@ -112,11 +249,13 @@ function applyExportDecorator(target: any, propertyKey: string | symbol, descrip
     name: propertyKey.toString(),
     paramType: paramTypes.length > 0 ? getTypeString(paramTypes[0]) : 'void',
     returnType: returnType ? getTypeString(returnType) : 'void',
-    isAsync
+    isAsync,
+    isStream,
+    options
   };
   
-  // Для асинхронных функций используем отдельный ключ metadata
-  const metadataKey = isAsync ? ASYNC_EXPORT_METADATA_KEY : EXPORT_METADATA_KEY;
+  // Для асинхронных и потоковых функций используем отдельные ключи metadata
+  const metadataKey = isStream ? STREAM_EXPORT_METADATA_KEY : isAsync ? ASYNC_EXPORT_METADATA_KEY : EXPORT_METADATA_KEY;
   Reflect.defineMetadata(metadataKey, exportInfo, target, propertyKey);
 }
 
@@ -139,6 +278,20 @@ export function getStructInfo(constructor: any): StructInfo | undefined {
   return Reflect.getMetadata(STRUCT_METADATA_KEY, constructor);
 }
 
+/**
+ * Получить информацию о нативном классе (@CppClass)
+ */
+export function getClassInfo(constructor: any): { name: string; paramType: string } | undefined {
+  return Reflect.getMetadata(CLASS_METADATA_KEY, constructor);
+}
+
+/**
+ * Получить опции поля, заданные через @CppField
+ */
+export function getFieldOptions(target: any, propertyKey: string): CppFieldOptions | undefined {
+  return Reflect.getMetadata(FIELD_METADATA_KEY, target, propertyKey);
+}
+
 /**
  * Получить информацию об экспорте из метода
  */
@@ -153,6 +306,13 @@ export function getAsyncExportInfo(target: any, propertyKey: string): ExportInfo
   return Reflect.getMetadata(ASYNC_EXPORT_METADATA_KEY, target, propertyKey);
 }
 
+/**
+ * Получить информацию о потоковом экспорте из метода
+ */
+export function getStreamExportInfo(target: any, propertyKey: string): ExportInfo | undefined {
+  return Reflect.getMetadata(STREAM_EXPORT_METADATA_KEY, target, propertyKey);
+}
+
 /**
  * Получить все экспорты из класса
  */
@@ -175,6 +335,11 @@ export function getAllExports(constructor: any): ExportInfo[] {
     if (asyncExportInfo) {
       exports.push(asyncExportInfo);
     }
+
+    const streamExportInfo = getStreamExportInfo(prototype, propertyName);
+    if (streamExportInfo) {
+      exports.push(streamExportInfo);
+    }
   }
   
   return exports;
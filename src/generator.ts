@@ -1,7 +1,8 @@
-import { Project, ClassDeclaration, MethodDeclaration, PropertyDeclaration, SyntaxKind } from 'ts-morph';
+import { Project, ClassDeclaration, MethodDeclaration, PropertyDeclaration, SyntaxKind, Decorator, Node } from 'ts-morph';
+import * as crypto from 'crypto';
 import * as fs from 'fs';
 import * as path from 'path';
-import { getCppType, getNapiType, getNapiExtractor, isPreciseNumericType } from './numeric-types';
+import { getCppType, getNapiType, getNapiExtractor, isPreciseNumericType, isTypedArrayType, getTypedArrayElementType, getPreciseArrayType } from './numeric-types';
 
 /**
  * Информация об enum'е, извлеченная из AST
@@ -27,6 +28,13 @@ export interface ParsedField {
   setElementType?: string;   // Тип элементов Set
   mapKeyType?: string;       // Тип ключа Map
   mapValueType?: string;     // Тип значения Map
+  isTypedArray?: boolean;    // Поле типа Float64Array, Int32Array и т.д.
+  typedArrayElementType?: string; // C++ тип элемента TypedArray
+  isView?: boolean;          // @CppField({ view: true }) - без копирования, tscb::ArrayView<T>
+  isShared?: boolean;        // @CppField({ shared: true }) - ToNapi создает TypedArray над SharedArrayBuffer
+  isFlatMap?: boolean;       // @CppField({ container: 'flat_map' }) - tscb::FlatMap (отсортированный вектор пар)
+  isInterned?: boolean;      // @CppField({ intern: true }) - tscb::InternedString, JS строка кэшируется на Env
+  isLatin1?: boolean;        // @CppField({ encoding: 'latin1' }) - строка без перекодирования UTF-8
 }
 
 /**
@@ -35,6 +43,9 @@ export interface ParsedField {
 export interface ParsedStruct {
   name: string;
   fields: ParsedField[];
+  isView?: boolean;  // @CppStruct({ view: true }) - ToNapi возвращает ленивый ObjectWrap (<Name>View)
+  isArena?: boolean; // @CppStruct({ arena: true }) - строки и векторы std::pmr, вход разбирается в арену вызова
+  isColumnar?: boolean; // @CppStruct({ layout: 'columnar' }) - поля <Name>[] становятся колонками <Name>Columns
 }
 
 /**
@@ -49,6 +60,48 @@ export interface ParsedExport {
   isStatic: boolean;
   isAsync: boolean;  // Новое поле для асинхронных методов
   parameters: { name: string; type: string }[];
+  pool?: 'uv' | 'native';  // Где выполняется @CppAsync: пул libuv (по умолчанию) или нативный пул
+  poolSize?: number;       // Желаемый размер нативного пула
+  cancellable?: boolean;   // @CppAsync({ cancellable: true }): последний аргумент - const tscb::CancelToken&
+  signature?: ExportSignature;
+  selfType?: string;       // Для методов @CppClass: C++ класс, передаваемый первым аргументом (Self& self)
+  transport?: 'napi' | 'binary';  // 'binary' - вход и результат передаются одним буфером (<name>_wire)
+  isStream?: boolean;      // @CppStream: returnType - тип чанка, результат отдается через tscb::StreamEmitter
+  highWaterMark?: number;  // Сколько чанков может ждать потребителя до блокировки производителя
+  cache?: { maxEntries: number; ttlMs: number };  // @CppExport({ cache }): LRU результатов, ttlMs = 0 - без срока
+  noexcept?: boolean;      // @CppExport({ noexcept: true }): вход через TryFromNapi, C++ функция объявлена noexcept
+  coalesce?: { windowMs: number; maxItems: number };  // @CppAsync({ coalesce }): вызовы окна уходят одним <name>_batch
+  recycle?: { maxFree: number };  // @CppAsync({ recycle }): вход и результат задачи берутся из tscb::ObjectPool
+}
+
+/**
+ * Нативный класс с состоянием (@CppClass), извлеченный из AST
+ */
+export interface ParsedClass {
+  name: string;
+  constructorParamType: string;  // 'void', если конструктор без параметров
+  methods: ParsedExport[];       // Нестатические методы с @CppExport/@CppAsync
+}
+
+/**
+ * Сигнатура C++ функции экспорта:
+ * 'ref'  - Out fn(const In&) (по умолчанию)
+ * 'move' - Out fn(In&&), вход передается перемещением
+ * 'out'  - void fn(const In&, Out&), результат пишется в заранее созданный объект
+ */
+export type ExportSignature = 'ref' | 'move' | 'out';
+
+/**
+ * Опции, извлеченные из литерала объекта в аргументе декоратора
+ */
+export type DecoratorOptions = { [key: string]: any };
+
+/**
+ * Опции генерации C++ кода
+ */
+export interface GenerateOptions {
+  // Каждая структура в своих generated_struct_<Name>.hpp/.cpp, список исходников - в generated_sources.gypi
+  splitStructs?: boolean;
 }
 
 /**
@@ -58,6 +111,7 @@ export interface ParseResult {
   structs: ParsedStruct[];
   exports: ParsedExport[];
   enums: ParsedEnum[];  // Добавляем enum'ы
+  classes: ParsedClass[];
 }
 
 /**
@@ -65,6 +119,24 @@ export interface ParseResult {
  */
 export class CppGenerator {
   private project: Project;
+  // Структуры с @CppStruct({ view: true }), результаты которых конвертируются в ленивые view
+  private viewStructNames = new Set<string>();
+  // Структуры, для которых генерируется бинарный кодек (WireDecode/WireEncode)
+  private wireStructNames = new Set<string>();
+  // Структуры с @CppStruct({ arena: true }): std::pmr поля и FromNapi(obj, alloc)
+  private arenaStructNames = new Set<string>();
+  // Структуры с Hash()/operator== для ключей кэша результатов
+  private hashStructNames = new Set<string>();
+  // Структуры с @CppStruct({ layout: 'columnar' }): массивы хранятся в <Name>Columns
+  private columnarStructNames = new Set<string>();
+  // Структуры с TryFromNapi для @CppExport({ noexcept: true })
+  private tryDecodeStructNames = new Set<string>();
+  // Структуры с FromNapi(obj, result) для разбора в переиспользуемый объект (@CppAsync({ recycle }))
+  private recycleStructNames = new Set<string>();
+  // GenerateOptions.splitStructs текущей генерации
+  private splitStructs = false;
+  // Файлы, записанные и пропущенные без изменений с последнего takeWriteStats()
+  private writeStats = { written: [] as string[], unchanged: [] as string[] };
 
   constructor(tsConfigPath?: string) {
     this.project = new Project({
@@ -80,9 +152,13 @@ export class CppGenerator {
     const structs: ParsedStruct[] = [];
     const exports: ParsedExport[] = [];
     const enums: ParsedEnum[] = [];
+    const classes: ParsedClass[] = [];
 
     for (const filePath of filePaths) {
-      const sourceFile = this.project.addSourceFileAtPath(filePath);
+      // Повторный разбор (--watch) перечитывает файл в уже созданном проекте
+      const existing = this.project.getSourceFile(filePath);
+      existing?.refreshFromFileSystemSync();
+      const sourceFile = existing || this.project.addSourceFileAtPath(filePath);
       
       // Ищем классы с декоратором @CppStruct
       const classes = sourceFile.getClasses();
@@ -94,7 +170,14 @@ export class CppGenerator {
         }
 
         const exportInfos = this.parseExports(classDecl);
-        exports.push(...exportInfos);
+        const classInfo = this.parseClass(classDecl, exportInfos.filter(e => !e.isStatic));
+        if (classInfo) {
+          classes.push(classInfo);
+          // Статические методы @CppClass остаются обычными экспортами
+          exports.push(...exportInfos.filter(e => e.isStatic));
+        } else {
+          exports.push(...exportInfos);
+        }
       }
 
       // Ищем enum'ы, которые используются в структурах
@@ -107,7 +190,13 @@ export class CppGenerator {
       }
     }
 
-    return { structs, exports, enums };
+    this.validateTransports(exports, structs);
+    this.validateCaches(exports, structs);
+    this.validateNoexcept([...exports, ...classes.flatMap(cls => cls.methods)], structs, enums);
+    this.validateCoalesce([...exports, ...classes.flatMap(cls => cls.methods)]);
+    this.validateRecycle([...exports, ...classes.flatMap(cls => cls.methods)], structs);
+
+    return { structs, exports, enums, classes };
   }
 
   /**
@@ -134,10 +223,128 @@ export class CppGenerator {
       }
     }
 
+    const options = this.parseDecoratorOptions(this.findDecorator(decorators, 'CppStruct'));
+    const name = classDecl.getName() || 'UnnamedStruct';
+    let isArena = options.arena === true;
+    if (isArena && options.view === true) {
+      // View живет дольше вызова, арена освобождается сразу после него
+      console.warn(`⚠️  ${name}: arena is not supported for view structs, using std containers`);
+      isArena = false;
+    }
+    let isColumnar = options.layout === 'columnar';
+    const columnarProblem = isColumnar ? this.columnarProblem(fields) : '';
+    if (columnarProblem) {
+      console.warn(`⚠️  ${name}: layout 'columnar' is not supported (${columnarProblem}), using arrays of structs`);
+      isColumnar = false;
+    }
+
     return {
-      name: classDecl.getName() || 'UnnamedStruct',
-      fields
+      name,
+      fields,
+      isView: options.view === true,
+      isArena,
+      isColumnar
+    };
+  }
+
+  /**
+   * Почему структура не может храниться колонками (пустая строка - может):
+   * поддерживаются числа (кроме 64-битных целых), boolean и строки
+   */
+  private columnarProblem(fields: ParsedField[]): string {
+    if (fields.length === 0) {
+      return 'no fields';
+    }
+    for (const field of fields) {
+      if (field.name === 'length' || field.name === 'strings') {
+        return `field '${field.name}' clashes with the columns object`;
+      }
+      if (!this.columnTypedArray(field) && field.type !== 'std::string') {
+        return `field '${field.name}' is not a number, boolean or string`;
+      }
+      if (field.isInterned || field.isLatin1) {
+        return `string column '${field.name}' is already deduplicated through the strings table`;
+      }
+    }
+    return '';
+  }
+
+  /**
+   * Конструктор TypedArray колонки скалярного числового или boolean поля; undefined - не колонка TypedArray
+   */
+  private columnTypedArray(field: ParsedField): string | undefined {
+    if (field.isArray || field.isSet || field.isMap || field.isTypedArray) {
+      return undefined;
+    }
+    const typedArrays: { [cppType: string]: string } = {
+      'bool': 'Uint8Array', 'int8_t': 'Int8Array', 'uint8_t': 'Uint8Array', 'int16_t': 'Int16Array', 'uint16_t': 'Uint16Array',
+      'int': 'Int32Array', 'int32_t': 'Int32Array', 'uint32_t': 'Uint32Array', 'float': 'Float32Array', 'double': 'Float64Array'
     };
+    return typedArrays[this.fieldCppType(field)];
+  }
+
+  /**
+   * C++ тип элемента колонки: bool хранится как uint8_t (непрерывно, в отличие от std::vector<bool>)
+   */
+  private columnElementType(field: ParsedField): string {
+    const cppType = this.fieldCppType(field);
+    return cppType === 'bool' ? 'uint8_t' : cppType;
+  }
+
+  /**
+   * Имя колоночной структуры, если поле - массив @CppStruct({ layout: 'columnar' })
+   */
+  private columnarElement(field: ParsedField): string | undefined {
+    return field.isArray && field.arrayElementType && this.columnarStructNames.has(field.arrayElementType)
+      ? field.arrayElementType : undefined;
+  }
+
+  /**
+   * Парсит класс с декоратором @CppClass: конструктор и методы экземпляра
+   */
+  private parseClass(classDecl: ClassDeclaration, methods: ParsedExport[]): ParsedClass | null {
+    const decorators = classDecl.getDecorators();
+    if (!this.findDecorator(decorators, 'CppClass')) {
+      return null;
+    }
+
+    const name = classDecl.getName() || 'UnnamedClass';
+    const ctor = classDecl.getConstructors()[0];
+    const ctorParams = ctor ? ctor.getParameters() : [];
+    const constructorParamType = ctorParams.length > 0
+      ? this.mapTypeScriptToCpp(ctorParams[0].getTypeNode()?.getText() || 'void')
+      : 'void';
+
+    methods = methods.filter(method => {
+      if (method.isStream) {
+        console.warn(`⚠️  ${name}.${method.methodName}: @CppStream is not supported for class methods yet, skipping`);
+      }
+      return !method.isStream;
+    });
+
+    for (const method of methods) {
+      method.name = `${name}_${method.methodName}`;
+      method.selfType = name;
+      if (method.pool === 'native') {
+        console.warn(`⚠️  ${method.name}: pool 'native' is not supported for class methods yet, using the libuv pool`);
+        method.pool = undefined;
+        method.poolSize = undefined;
+      }
+      if (method.transport === 'binary') {
+        console.warn(`⚠️  ${method.name}: transport 'binary' is not supported for class methods yet, using 'napi'`);
+        method.transport = undefined;
+      }
+      if (method.cache) {
+        console.warn(`⚠️  ${method.name}: cache is not supported for class methods, the result depends on the object state`);
+        method.cache = undefined;
+      }
+      if (method.signature === 'out' && method.returnType === 'void') {
+        console.warn(`⚠️  ${method.name}: signature 'out' requires a return type, using 'ref'`);
+        method.signature = undefined;
+      }
+    }
+
+    return { name, constructorParamType, methods };
   }
 
   /**
@@ -152,8 +359,8 @@ export class CppGenerator {
       return null;
     }
 
-    const typeText = typeNode.getText();
-    const isArray = typeText.includes('[]') || typeText.startsWith('Array<');
+    let typeText = typeNode.getText();
+    let isArray = typeText.includes('[]') || typeText.startsWith('Array<');
     const isSet = typeText.startsWith('Set<') && typeText.endsWith('>');
     const isMap = typeText.startsWith('Map<') && typeText.endsWith('>');
     
@@ -178,6 +385,14 @@ export class CppGenerator {
       baseType = `${keyType},${valueType}`; // Сохраняем для совместимости
     }
 
+    // Массив уточняемого числового типа (u8[], Array<f32>) - TypedArray: одно копирование вместо поэлементной конвертации
+    const preciseArrayType = isArray ? getPreciseArrayType(baseType.trim()) : undefined;
+    if (preciseArrayType) {
+      typeText = preciseArrayType;
+      baseType = preciseArrayType;
+      isArray = false;
+    }
+
     // Предупреждение о зарезервированных словах
     if (this.isReservedCppKeyword(name)) {
       console.warn(`⚠️  Field '${name}' is a C++ reserved keyword and will be renamed to '${name}_' in generated code`);
@@ -186,6 +401,31 @@ export class CppGenerator {
     const initializer = prop.getInitializer();
     const defaultValue = initializer ? initializer.getText() : undefined;
 
+    const fieldOptions = this.parseDecoratorOptions(this.findDecorator(prop.getDecorators(), 'CppField'));
+    const isTypedArray = isTypedArrayType(typeText);
+    const isView = isTypedArray && fieldOptions.view === true;
+    if (fieldOptions.view === true && !isTypedArray) {
+      console.warn(`⚠️  Field '${name}': view mode requires a TypedArray type (e.g. Float64Array), got '${typeText}'`);
+    }
+    const isShared = isTypedArray && fieldOptions.shared === true;
+    if (fieldOptions.shared === true && !isTypedArray) {
+      console.warn(`⚠️  Field '${name}': shared mode requires a TypedArray type (e.g. Float64Array), got '${typeText}'`);
+    }
+    const isFlatMap = isMap && fieldOptions.container === 'flat_map';
+    if (fieldOptions.container !== undefined && !isFlatMap) {
+      console.warn(`⚠️  Field '${name}': container '${fieldOptions.container}' is not supported for '${typeText}' (only 'flat_map' for Map fields)`);
+    }
+    const isPlainString = !isArray && !isSet && !isMap && !isTypedArray && this.mapTypeScriptToCpp(baseType) === 'std::string';
+    const isInterned = isPlainString && fieldOptions.intern === true;
+    if (fieldOptions.intern === true && !isPlainString) {
+      console.warn(`⚠️  Field '${name}': intern requires a string field, got '${typeText}'`);
+    }
+    const isLatin1 = isPlainString && !isInterned && fieldOptions.encoding === 'latin1';
+    if (fieldOptions.encoding !== undefined && !isLatin1) {
+      const reason = isInterned ? 'interned ASCII strings are already created as Latin-1' : `only 'latin1' for string fields`;
+      console.warn(`⚠️  Field '${name}': encoding '${fieldOptions.encoding}' is not supported for '${typeText}' (${reason})`);
+    }
+
     return {
       name,
       type: this.mapTypeScriptToCpp(baseType),
@@ -198,12 +438,85 @@ export class CppGenerator {
       arrayElementType: isArray ? this.mapTypeScriptToCpp(baseType) : undefined,
       setElementType: isSet ? this.mapTypeScriptToCpp(baseType) : undefined,
       mapKeyType,
-      mapValueType
+      mapValueType,
+      isTypedArray,
+      typedArrayElementType: isTypedArray ? getTypedArrayElementType(typeText) : undefined,
+      isView,
+      isShared,
+      isFlatMap,
+      isInterned,
+      isLatin1
     };
   }
 
   /**
-   * Парсит методы с декоратором @CppExport или @CppAsync
+   * Ищет декоратор по имени
+   */
+  private findDecorator(decorators: Decorator[], name: string): Decorator | undefined {
+    return decorators.find(d => d.getName() === name || d.getFullText().includes(`@${name}`));
+  }
+
+  /**
+   * Извлекает опции из первого аргумента декоратора: @CppField({ view: true })
+   */
+  private parseDecoratorOptions(decorator: Decorator | undefined): DecoratorOptions {
+    if (!decorator) {
+      return {};
+    }
+    const [arg] = decorator.getArguments();
+    if (!arg || !Node.isObjectLiteralExpression(arg)) {
+      return {};
+    }
+    return this.parseLiteralValue(arg);
+  }
+
+  /**
+   * Преобразует литерал из AST в JS значение (объекты, массивы, строки, числа, boolean)
+   */
+  private parseLiteralValue(node: Node): any {
+    if (Node.isObjectLiteralExpression(node)) {
+      const result: DecoratorOptions = {};
+      for (const prop of node.getProperties()) {
+        if (Node.isPropertyAssignment(prop)) {
+          const key = prop.getName().replace(/^['"]|['"]$/g, '');
+          const initializer = prop.getInitializer();
+          result[key] = initializer ? this.parseLiteralValue(initializer) : undefined;
+        }
+      }
+      return result;
+    }
+    if (Node.isArrayLiteralExpression(node)) {
+      return node.getElements().map(e => this.parseLiteralValue(e));
+    }
+    if (Node.isStringLiteral(node) || Node.isNoSubstitutionTemplateLiteral(node)) {
+      return node.getLiteralValue();
+    }
+    if (Node.isNumericLiteral(node)) {
+      return node.getLiteralValue();
+    }
+    if (node.getKind() === SyntaxKind.TrueKeyword) {
+      return true;
+    }
+    if (node.getKind() === SyntaxKind.FalseKeyword) {
+      return false;
+    }
+    // Отрицательные числа и выражения вида 1024 * 1024
+    const text = node.getText();
+    if (/^[-+*\/\d\s._()]+$/.test(text)) {
+      try {
+        const value = Number(Function(`return (${text});`)());
+        if (Number.isFinite(value)) {
+          return value;
+        }
+      } catch {
+        // не числовое выражение - возвращаем как текст
+      }
+    }
+    return text;
+  }
+
+  /**
+   * Парсит методы с декоратором @CppExport, @CppAsync или @CppStream
    */
   private parseExports(classDecl: ClassDeclaration): ParsedExport[] {
     const exports: ParsedExport[] = [];
@@ -220,9 +533,26 @@ export class CppGenerator {
         d.getName() === 'CppAsync' || 
         d.getFullText().includes('@CppAsync')
       );
+      const streamDecorator = this.findDecorator(decorators, 'CppStream');
 
-      if (hasCppExport || hasCppAsync) {
+      if (streamDecorator) {
+        const exportInfo = this.parseExportMethod(method, className, true);
+        if (exportInfo) {
+          this.applyStreamOptions(exportInfo, this.parseDecoratorOptions(streamDecorator));
+          exports.push(exportInfo);
+        }
+      } else if (hasCppExport || hasCppAsync) {
         const exportInfo = this.parseExportMethod(method, className, hasCppAsync);
+        const options = this.parseDecoratorOptions(this.findDecorator(decorators, hasCppAsync ? 'CppAsync' : 'CppExport'));
+        if (exportInfo) {
+          this.applySignatureOption(exportInfo, options);
+          this.applyTransportOption(exportInfo, options);
+          this.applyCacheOption(exportInfo, options);
+          this.applyNoexceptOption(exportInfo, options);
+        }
+        if (exportInfo && hasCppAsync) {
+          this.applyAsyncOptions(exportInfo, options);
+        }
         if (exportInfo) {
           exports.push(exportInfo);
         }
@@ -233,701 +563,3686 @@ export class CppGenerator {
   }
 
   /**
-   * Парсит экспортируемый метод
+   * Применяет опцию { signature } из @CppExport/@CppAsync
    */
-  private parseExportMethod(method: MethodDeclaration, className: string, isAsync: boolean = false): ParsedExport | null {
-    const methodName = method.getName();
-    const parameters = method.getParameters();
-    const returnType = method.getReturnTypeNode();
-    const isStatic = method.isStatic();
-
-    // Собираем информацию о параметрах
-    const paramList: { name: string; type: string }[] = [];
-    for (const param of parameters) {
-      const paramName = param.getName();
-      const paramTypeText = param.getTypeNode()?.getText() || 'any';
-      const cppType = this.mapTypeScriptToCpp(paramTypeText);
-      paramList.push({ name: paramName, type: cppType });
+  private applySignatureOption(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    if (options.signature === undefined) {
+      return;
+    }
+    if (options.signature === 'ref' || options.signature === 'move' || options.signature === 'out') {
+      exportInfo.signature = options.signature;
+    } else {
+      console.warn(`⚠️  ${exportInfo.name}: unknown signature '${options.signature}', expected 'ref', 'move' or 'out'`);
     }
-
-    // Пока поддерживаем только один параметр
-    const paramType = parameters.length > 0 
-      ? this.mapTypeScriptToCpp(parameters[0].getTypeNode()?.getText() || 'void')
-      : 'void';
-
-    const returnTypeStr = returnType 
-      ? this.mapTypeScriptToCpp(returnType.getText())
-      : 'void';
-
-    // Для static методов имя функции: ClassName_methodName
-    const name = isStatic ? `${className}_${methodName}` : methodName;
-
-    return {
-      name,
-      className,
-      methodName,
-      paramType,
-      returnType: returnTypeStr,
-      isStatic,
-      isAsync,
-      parameters: paramList
-    };
   }
 
   /**
-   * Маппинг TypeScript типов в C++ типы
+   * Применяет опцию { transport } из @CppExport/@CppAsync
    */
-  private mapTypeScriptToCpp(tsType: string): string {
-    // Используем новую систему уточняемых типов
-    const mappedType = getCppType(tsType);
-    
-    // Если это не базовый тип, возможно это enum или struct
-    if (mappedType === tsType) {
-      const typeMap: { [key: string]: string } = {
-        'number': 'int',  // по умолчанию для совместимости
-        'void': 'void'
-      };
-      return typeMap[tsType] || tsType; // Возвращаем as-is для enum'ов и struct'ов
+  private applyTransportOption(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    if (options.transport === undefined) {
+      return;
+    }
+    if (options.transport === 'napi' || options.transport === 'binary') {
+      exportInfo.transport = options.transport;
+    } else {
+      console.warn(`⚠️  ${exportInfo.name}: unknown transport '${options.transport}', expected 'napi' or 'binary'`);
     }
-    
-    return mappedType;
   }
 
   /**
-   * Проверяет, является ли идентификатор зарезервированным словом C++
+   * Применяет опцию { noexcept } из @CppExport
    */
-  private isReservedCppKeyword(name: string): boolean {
-    const cppKeywords = [
-      'auto', 'break', 'case', 'char', 'const', 'continue', 'default', 'do',
-      'double', 'else', 'enum', 'extern', 'float', 'for', 'goto', 'if',
-      'inline', 'int', 'long', 'register', 'restrict', 'return', 'short',
-      'signed', 'sizeof', 'static', 'struct', 'switch', 'typedef', 'union',
-      'unsigned', 'void', 'volatile', 'while', 'bool', 'catch', 'class',
-      'const_cast', 'delete', 'dynamic_cast', 'explicit', 'export', 'false',
-      'friend', 'mutable', 'namespace', 'new', 'operator', 'private',
-      'protected', 'public', 'reinterpret_cast', 'static_cast', 'template',
-      'this', 'throw', 'true', 'try', 'typeid', 'typename', 'using',
-      'virtual', 'wchar_t'
-    ];
-    
-    return cppKeywords.includes(name.toLowerCase());
+  private applyNoexceptOption(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    if (options.noexcept === undefined) {
+      return;
+    }
+    if (typeof options.noexcept !== 'boolean') {
+      console.warn(`⚠️  ${exportInfo.name}: noexcept must be true or false`);
+      return;
+    }
+    exportInfo.noexcept = options.noexcept;
   }
 
   /**
-   * Преобразует имя поля, если оно конфликтует с C++ ключевыми словами
+   * Применяет опцию { cache: true | { maxEntries, ttlMs } } из @CppExport/@CppAsync
    */
-  private sanitizeFieldName(name: string): string {
-    if (this.isReservedCppKeyword(name)) {
-      return name + '_'; // добавляем подчеркивание
+  private applyCacheOption(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    const cache = options.cache;
+    if (cache === undefined || cache === false) {
+      return;
     }
-    return name;
+    if (cache !== true && (typeof cache !== 'object' || Array.isArray(cache))) {
+      console.warn(`⚠️  ${exportInfo.name}: cache must be true or { maxEntries, ttlMs }`);
+      return;
+    }
+    const settings = { maxEntries: 256, ttlMs: 0 };
+    if (cache !== true && cache.maxEntries !== undefined) {
+      if (Number.isInteger(cache.maxEntries) && cache.maxEntries > 0) {
+        settings.maxEntries = cache.maxEntries;
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: cache.maxEntries must be a positive integer`);
+      }
+    }
+    if (cache !== true && cache.ttlMs !== undefined) {
+      if (typeof cache.ttlMs === 'number' && cache.ttlMs > 0) {
+        settings.ttlMs = Math.ceil(cache.ttlMs);
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: cache.ttlMs must be a positive number`);
+      }
+    }
+    exportInfo.cache = settings;
   }
 
   /**
-   * Преобразует C++ тип в TypeScript тип для генерации
+   * Отключает cache там, где результат нельзя переиспользовать по значению входа
    */
-  private cppTypeToTSType(cppType: string): string {
-    const typeMap: { [key: string]: string } = {
-      'int8_t': 'i8',
-      'uint8_t': 'u8',
-      'int16_t': 'i16',
-      'uint16_t': 'u16',
-      'int32_t': 'i32',
-      'u32': 'u32',
-      'int64_t': 'i64',
-      'uint64_t': 'u64',
-      'float': 'f32',
-      'double': 'f64',
-      'bool': 'boolean',
-      'std::string': 'string'
-    };
-    return typeMap[cppType] || cppType;
+  private validateCaches(exports: ParsedExport[], structs: ParsedStruct[]): void {
+    for (const exp of exports) {
+      if (!exp.cache) {
+        continue;
+      }
+      let reason = '';
+      if (!structs.some(s => s.name === exp.paramType)) {
+        reason = 'input must be a @CppStruct';
+      } else if (this.hasViewFields(exp.paramType, structs)) {
+        reason = 'view fields do not own their data';
+      } else if (exp.returnType === 'void') {
+        reason = 'there is no result';
+      } else if (exp.cancellable) {
+        reason = 'a shared call cannot be cancelled by a single caller';
+      }
+      if (reason) {
+        console.warn(`⚠️  ${exp.name}: cache is not supported (${reason}), disabling it`);
+        exp.cache = undefined;
+      }
+    }
   }
 
   /**
-   * Парсит enum из TypeScript
+   * Отключает noexcept там, где вход нельзя разобрать без исключений
    */
-  private parseEnum(enumDecl: any): ParsedEnum | null {
-    const name = enumDecl.getName();
-    const values: { name: string; value: number }[] = [];
-
-    const members = enumDecl.getMembers();
-    for (const member of members) {
-      const memberName = member.getName();
-      const initializer = member.getInitializer();
-      
-      let value = 0;
-      if (initializer && initializer.getKind() === SyntaxKind.NumericLiteral) {
-        value = parseInt(initializer.getText(), 10);
-      } else {
-        // Если значение не указано, используем автоинкремент
-        value = values.length;
+  private validateNoexcept(exports: ParsedExport[], structs: ParsedStruct[], enums: ParsedEnum[]): void {
+    for (const exp of exports) {
+      if (!exp.noexcept) {
+        continue;
+      }
+      let reason = '';
+      if (exp.isAsync) {
+        reason = 'only sync @CppExport calls run without exceptions';
+      } else if (exp.paramType !== 'void') {
+        reason = structs.some(s => s.name === exp.paramType)
+          ? this.tryDecodeProblem(exp.paramType, structs, enums)
+          : 'input must be a @CppStruct';
+      }
+      if (reason) {
+        console.warn(`⚠️  ${exp.name}: noexcept is not supported (${reason}), using exceptions`);
+        exp.noexcept = undefined;
       }
-
-      values.push({ name: memberName, value });
     }
-
-    return { name, values };
   }
 
   /**
-   * Проверяет, используется ли enum в структурах
+   * Отключает coalesce там, где вызовы нельзя объединить в один <name>_batch
    */
-  private isEnumUsedInStructs(enumName: string, structs: ParsedStruct[]): boolean {
-    for (const struct of structs) {
-      for (const field of struct.fields) {
-        if (field.tsType === enumName) {
-          return true;
-        }
+  private validateCoalesce(exports: ParsedExport[]): void {
+    for (const exp of exports) {
+      if (!exp.coalesce) {
+        continue;
+      }
+      let reason = '';
+      if (exp.selfType) {
+        reason = 'native class methods have no batch call';
+      } else if (!this.hasBatch(exp)) {
+        reason = 'void signatures have no batch call';
+      } else if (exp.cancellable) {
+        reason = 'each caller has its own cancel token';
+      } else if (exp.transport === 'binary') {
+        reason = 'binary calls have no batch variant';
+      } else if (exp.cache) {
+        reason = 'batch calls bypass the result cache';
+      }
+      if (reason) {
+        console.warn(`⚠️  ${exp.name}: coalesce is not supported (${reason}), calling one by one`);
+        exp.coalesce = undefined;
       }
     }
-    return false;
-  }
-
-  private isEnumType(typeName: string, enums: ParsedEnum[]): boolean {
-    return enums.some(e => e.name === typeName);
   }
 
   /**
-   * Проверяет, является ли тип структурой (не enum и не базовый тип)
+   * Отключает recycle там, где вход нельзя разобрать в переиспользуемый объект
    */
-  private isStructType(typeName: string, enums: ParsedEnum[]): boolean {
-    // Простая эвристика: если это не базовые типы, не enum и не стандартные типы
-    const basicTypes = [
-      'int', 'double', 'float', 'bool', 'std::string', 
-      'uint32_t', 'int32_t', 'int8_t', 'uint8_t', 'int16_t', 'uint16_t', 'int64_t', 'uint64_t',
-      'size_t', 'char', 'unsigned char', 'short', 'unsigned short', 'long', 'unsigned long'
-    ];
-    return !basicTypes.includes(typeName) && !this.isEnumType(typeName, enums) && !typeName.startsWith('std::vector');
+  private validateRecycle(exports: ParsedExport[], structs: ParsedStruct[]): void {
+    for (const exp of exports) {
+      if (!exp.recycle) {
+        continue;
+      }
+      const input = structs.find(s => s.name === exp.paramType);
+      let reason = '';
+      if (exp.isStream) {
+        reason = 'stream jobs are not pooled';
+      } else if (!input) {
+        reason = 'input must be a @CppStruct';
+      } else if (input.isArena) {
+        reason = 'arena inputs are already released in one step';
+      } else if (exp.cache) {
+        reason = 'cached calls keep a pointer to the input';
+      }
+      if (reason) {
+        console.warn(`⚠️  ${exp.name}: recycle is not supported (${reason}), allocating per call`);
+        exp.recycle = undefined;
+      }
+    }
   }
 
   /**
-   * Генерирует C++ код из результатов парсинга
+   * Структуры с FromNapi(obj, result): входы экспортов с recycle и их вложенные (не arena) структуры
    */
-  public generateCppCode(parseResult: ParseResult, outputDir: string): void {
-    this.generateStructsHeader(parseResult.structs, parseResult.enums, outputDir);
-    this.generateStructsImpl(parseResult.structs, parseResult.enums, outputDir);
-    this.generateApiWrapper(parseResult.exports, outputDir);
-    this.generateImplementationTemplate(parseResult.exports, outputDir);
+  private collectRecycleStructs(exports: ParsedExport[], structs: ParsedStruct[]): Set<string> {
+    const names = new Set<string>();
+    const visit = (name: string) => {
+      const struct = structs.find(s => s.name === name);
+      if (!struct || struct.isArena || names.has(name)) {
+        return;
+      }
+      names.add(name);
+      struct.fields.filter(field => !field.isArray && !field.isSet && !field.isMap).forEach(field => visit(field.type));
+    };
+    exports.filter(exp => exp.recycle).forEach(exp => visit(exp.paramType));
+    return names;
   }
 
   /**
-   * Генерирует заголовочный файл структур
+   * Почему структуру нельзя разобрать TryFromNapi (пустая строка - можно):
+   * поддерживаются числа (кроме 64-битных целых), boolean, строки, enum и такие же вложенные структуры
    */
-  private generateStructsHeader(structs: ParsedStruct[], enums: ParsedEnum[], outputDir: string): void {
-    const template = fs.readFileSync(
-      path.join(__dirname, 'templates', 'structs.hpp.template'), 
-      'utf-8'
-    );
-
-    // Генерируем enum'ы
-    let enumDeclarations = '';
-    for (const enumInfo of enums) {
-      enumDeclarations += `\nenum class ${enumInfo.name} : uint32_t {\n`;
-      for (const value of enumInfo.values) {
-        enumDeclarations += `    ${value.name} = ${value.value},\n`;
-      }
-      enumDeclarations += `};\n`;
+  private tryDecodeProblem(structName: string, structs: ParsedStruct[], enums: ParsedEnum[], visited: Set<string> = new Set()): string {
+    const struct = structs.find(s => s.name === structName);
+    if (!struct || visited.has(structName)) {
+      return '';
     }
-
-    let structDeclarations = '';
-    
-    for (const struct of structs) {
-      structDeclarations += `\nstruct ${struct.name} {\n`;
-      
-      // Поля
-      for (const field of struct.fields) {
-        const cppType = getCppType(field.tsType); // Всегда используем getCppType для полного типа
-        const sanitizedName = this.sanitizeFieldName(field.name);
-        let defaultInit = '';
-        if ((field as any).defaultValue) {
-          let defaultValue = (field as any).defaultValue;
-          // Для enum типов заменяем . на :: для правильного C++ синтаксиса
-          const isEnumType = enums.some(e => e.name === cppType);
-          if (isEnumType) {
-            defaultValue = defaultValue.replace('.', '::');
-          }
-          defaultInit = ` = ${defaultValue}`;
+    visited.add(structName);
+    if (struct.isView || struct.isArena) {
+      return `${structName} is a ${struct.isView ? 'view' : 'arena'} struct`;
+    }
+    for (const field of struct.fields) {
+      const where = `${structName}.${field.name}`;
+      if (field.isArray || field.isSet || field.isMap || field.isTypedArray) {
+        return `${where} is a container`;
+      }
+      if (field.type === 'int64_t' || field.type === 'uint64_t') {
+        return `${where} is a 64-bit integer`;
+      }
+      if (this.isStructType(field.type, enums)) {
+        const nested = this.tryDecodeProblem(field.type, structs, enums, visited);
+        if (nested) {
+          return nested;
         }
-        structDeclarations += `    ${cppType} ${sanitizedName}${defaultInit};\n`;
       }
-      
-      // Методы
-      structDeclarations += `    static ${struct.name} FromNapi(const Napi::Object& obj);\n`;
-      structDeclarations += `    Napi::Object ToNapi(Napi::Env env) const;\n`;
-      structDeclarations += `};\n`;
     }
+    return '';
+  }
 
-    const output = template
-      .replace('{{ENUM_DECLARATIONS}}', enumDeclarations)
-      .replace('{{STRUCT_DECLARATIONS}}', structDeclarations);
-    
-    fs.writeFileSync(path.join(outputDir, 'generated_structs.hpp'), output);
+  /**
+   * Структуры с TryFromNapi: входы экспортов с noexcept и вложенные в них структуры
+   */
+  private collectTryDecodeStructs(exports: ParsedExport[], structs: ParsedStruct[]): Set<string> {
+    const names = new Set<string>();
+    const visit = (name: string) => {
+      const struct = structs.find(s => s.name === name);
+      if (!struct || names.has(name)) {
+        return;
+      }
+      names.add(name);
+      struct.fields.forEach(field => visit(field.type));
+    };
+    exports.filter(exp => exp.noexcept).forEach(exp => visit(exp.paramType));
+    return names;
   }
 
   /**
-   * Генерирует реализацию структур
+   * Структуры с Hash()/operator== для ключей кэша: все структуры без полей-представлений,
+   * если хотя бы один экспорт использует cache
    */
-  private generateStructsImpl(structs: ParsedStruct[], enums: ParsedEnum[], outputDir: string): void {
-    const template = fs.readFileSync(
-      path.join(__dirname, 'templates', 'structs.cpp.template'), 
-      'utf-8'
-    );
+  private collectHashStructs(parseResult: ParseResult): Set<string> {
+    if (!parseResult.exports.some(exp => exp.cache)) {
+      return new Set();
+    }
+    return new Set(parseResult.structs
+      .filter(s => !this.hasViewFields(s.name, parseResult.structs))
+      .map(s => s.name));
+  }
 
-    let implementations = '';
-    
-    for (const struct of structs) {
-      // FromNapi метод
-      implementations += `\n${struct.name} ${struct.name}::FromNapi(const Napi::Object& obj) {\n`;
-      implementations += `    ${struct.name} result;\n`;
-      implementations += `    \n`;
-      implementations += `    try {\n`;
-      
-      for (const field of struct.fields) {
-        const sanitizedName = this.sanitizeFieldName(field.name);
-        
-        if (field.isArray) {
-          implementations += `        if (obj.Has("${field.name}") && obj.Get("${field.name}").IsArray()) {\n`;
-          implementations += `            Napi::Array arr = obj.Get("${field.name}").As<Napi::Array>();\n`;
-          implementations += `            for (uint32_t i = 0; i < arr.Length(); i++) {\n`;
-          
-          // Проверяем тип элементов массива
-          const arrayElementType = field.arrayElementType || field.type.replace('std::vector<', '').replace('>', '');
-          
-          if (arrayElementType === 'std::string') {
-            implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::String>().Utf8Value());\n`;
-          } else if (this.isStructType(arrayElementType, enums)) {
-            // Массив структур
-            implementations += `                result.${sanitizedName}.push_back(${arrayElementType}::FromNapi(arr.Get(i).As<Napi::Object>()));\n`;
-          } else if (isPreciseNumericType(field.tsType?.replace('[]', '') || '')) {
-            // Массив семантических числовых типов  
-            const cppType = getCppType(field.tsType?.replace('[]', '') || '');
-            implementations += `                result.${sanitizedName}.push_back(static_cast<${cppType}>(arr.Get(i).As<Napi::Number>().Uint32Value()));\n`;
-          } else if (arrayElementType === 'int' || arrayElementType.includes('int')) {
-            implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::Number>().Int32Value());\n`;
-          } else if (arrayElementType === 'bool') {
-            implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::Boolean>().Value());\n`;
-          } else {
-            // По умолчанию для чисел
-            implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::Number>().DoubleValue());\n`;
-          }
-          
-          implementations += `            }\n`;
-          implementations += `        }\n`;
-        } else if (field.isSet) {
-          implementations += `        if (obj.Has("${field.name}") && obj.Get("${field.name}").IsArray()) {\n`;
-          implementations += `            Napi::Array arr = obj.Get("${field.name}").As<Napi::Array>();\n`;
-          implementations += `            for (uint32_t i = 0; i < arr.Length(); i++) {\n`;
-          
-          // Проверяем тип элементов Set
-          const setElementType = field.setElementType || field.type.replace('std::unordered_set<', '').replace('>', '');
-          
-          if (setElementType === 'std::string') {
-            implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::String>().Utf8Value());\n`;
-          } else if (this.isStructType(setElementType, enums)) {
-            // Set структур
-            implementations += `                result.${sanitizedName}.insert(${setElementType}::FromNapi(arr.Get(i).As<Napi::Object>()));\n`;
-          } else if (isPreciseNumericType(field.tsType)) {
-            // Set семантических числовых типов  
-            const cppType = getCppType(field.tsType);
-            implementations += `                result.${sanitizedName}.insert(static_cast<${cppType}>(arr.Get(i).As<Napi::Number>().Uint32Value()));\n`;
-          } else if (setElementType === 'int' || setElementType.includes('int')) {
-            implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::Number>().Int32Value());\n`;
-          } else if (setElementType === 'bool') {
-            implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::Boolean>().Value());\n`;
-          } else {
-            // По умолчанию для чисел
-            implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::Number>().DoubleValue());\n`;
-          }
-          
-          implementations += `            }\n`;
-          implementations += `        }\n`;
-        } else if (field.isMap) {
-          implementations += `        if (obj.Has("${field.name}") && obj.Get("${field.name}").IsObject()) {\n`;
-          implementations += `            Napi::Object mapObj = obj.Get("${field.name}").As<Napi::Object>();\n`;
-          implementations += `            Napi::Array keys = mapObj.GetPropertyNames();\n`;
-          implementations += `            for (uint32_t i = 0; i < keys.Length(); i++) {\n`;
-          implementations += `                Napi::Value key = keys.Get(i);\n`;
-          implementations += `                Napi::Value value = mapObj.Get(key);\n`;
-          
-          // Обработка ключа
-          const keyType = field.mapKeyType || 'std::string';
-          let keyExtraction = '';
-          if (keyType === 'std::string') {
-            keyExtraction = 'key.As<Napi::String>().Utf8Value()';
-          } else if (keyType === 'int' || keyType.includes('int')) {
-            keyExtraction = 'key.As<Napi::Number>().Int32Value()';
-          } else if (isPreciseNumericType(field.tsType?.split(',')[0]?.trim() || '')) {
-            const cppKeyType = getCppType(field.tsType?.split(',')[0]?.trim() || '');
-            keyExtraction = `static_cast<${cppKeyType}>(key.As<Napi::Number>().Uint32Value())`;
-          } else {
-            keyExtraction = 'key.As<Napi::Number>().DoubleValue()';
-          }
-          
-          // Обработка значения
-          const valueType = field.mapValueType || 'double';
-          let valueExtraction = '';
-          if (valueType === 'std::string') {
-            valueExtraction = 'value.As<Napi::String>().Utf8Value()';
-          } else if (this.isStructType(valueType, enums)) {
-            valueExtraction = `${valueType}::FromNapi(value.As<Napi::Object>())`;
-          } else if (valueType === 'int' || valueType.includes('int')) {
-            valueExtraction = 'value.As<Napi::Number>().Int32Value()';
-          } else if (valueType === 'bool') {
-            valueExtraction = 'value.As<Napi::Boolean>().Value()';
-          } else if (isPreciseNumericType(field.tsType?.split(',')[1]?.trim() || '')) {
-            const cppValueType = getCppType(field.tsType?.split(',')[1]?.trim() || '');
-            valueExtraction = `static_cast<${cppValueType}>(value.As<Napi::Number>().Uint32Value())`;
-          } else {
-            valueExtraction = 'value.As<Napi::Number>().DoubleValue()';
-          }
-          
-          implementations += `                result.${sanitizedName}[${keyExtraction}] = ${valueExtraction};\n`;
-          implementations += `            }\n`;
-          implementations += `        }\n`;
-        } else {
-          implementations += `        if (obj.Has("${field.name}")) {\n`;
-          
-          // Проверяем, является ли это структурой или enum
-          if (this.isStructType(field.type, enums)) {
-            implementations += `            result.${sanitizedName} = ${field.type}::FromNapi(obj.Get("${field.name}").As<Napi::Object>());\n`;
-          } else if (this.isEnumType(field.type, enums)) {
-            // Для enum типов конвертируем из числа
-            implementations += `            result.${sanitizedName} = static_cast<${field.type}>(obj.Get("${field.name}").As<Napi::Number>().Int32Value());\n`;
-          } else {
-            // Используем функции из numeric-types для правильной генерации
-            const extractor = getNapiExtractor(field.tsType);
-            if (extractor !== '.As<Napi::Value>()') {
-              // Это известный тип, используем правильный экстрактор
-              if (isPreciseNumericType(field.tsType)) {
-                // Для семантических типов нужно кастовать к правильному C++ типу
-                const cppType = getCppType(field.tsType);
-                implementations += `            result.${sanitizedName} = static_cast<${cppType}>(obj.Get("${field.name}")${extractor});\n`;
-              } else {
-                implementations += `            result.${sanitizedName} = obj.Get("${field.name}")${extractor};\n`;
-              }
-            } else {
-              // Fallback для неизвестных типов
-              if (field.type === 'std::string') {
-                implementations += `            result.${sanitizedName} = obj.Get("${field.name}").As<Napi::String>().Utf8Value();\n`;
-              } else if (field.type === 'int') {
-                implementations += `            result.${sanitizedName} = obj.Get("${field.name}").As<Napi::Number>().Int32Value();\n`;
-              } else if (field.type === 'bool') {
-                implementations += `            result.${sanitizedName} = obj.Get("${field.name}").As<Napi::Boolean>().Value();\n`;
-              }
-            }
-          }
-          
-          implementations += `        }\n`;
-        }
+  /**
+   * Отключает transport: 'binary' там, где бинарный формат неприменим
+   */
+  private validateTransports(exports: ParsedExport[], structs: ParsedStruct[]): void {
+    for (const exp of exports) {
+      if (exp.transport !== 'binary') {
+        continue;
       }
-      
-      implementations += `    } catch (const std::exception& e) {\n`;
-      implementations += `        throw std::runtime_error(std::string("Failed to parse ${struct.name}: ") + e.what());\n`;
-      implementations += `    }\n`;
-      implementations += `    \n`;
-      implementations += `    return result;\n`;
-      implementations += `}\n`;
-
-      // ToNapi метод
-      implementations += `\nNapi::Object ${struct.name}::ToNapi(Napi::Env env) const {\n`;
-      implementations += `    Napi::Object obj = Napi::Object::New(env);\n`;
-      
-      for (const field of struct.fields) {
-        const sanitizedName = this.sanitizeFieldName(field.name);
-        
-        if (field.isArray) {
-          // Создаем уникальное имя для каждого массива
-          const arrayVarName = `${sanitizedName}Arr`;
-          implementations += `    Napi::Array ${arrayVarName} = Napi::Array::New(env, ${sanitizedName}.size());\n`;
-          implementations += `    for (size_t i = 0; i < ${sanitizedName}.size(); i++) {\n`;
-          
-          // Проверяем тип элементов массива
-          const arrayElementType = field.arrayElementType || field.type.replace('std::vector<', '').replace('>', '');
-          
-          if (arrayElementType === 'std::string') {
-            implementations += `        ${arrayVarName}.Set(i, Napi::String::New(env, ${sanitizedName}[i]));\n`;
-          } else if (this.isStructType(arrayElementType, enums)) {
-            // Массив структур
-            implementations += `        ${arrayVarName}.Set(i, ${sanitizedName}[i].ToNapi(env));\n`;
-          } else {
-            // Числовые типы
-            implementations += `        ${arrayVarName}.Set(i, Napi::Number::New(env, ${sanitizedName}[i]));\n`;
-          }
-          
-          implementations += `    }\n`;
-          implementations += `    obj.Set("${field.name}", ${arrayVarName});\n`;
-        } else if (field.isSet) {
-          // Создаем уникальное имя для каждого Set
-          const setVarName = `${sanitizedName}Arr`;
-          implementations += `    Napi::Array ${setVarName} = Napi::Array::New(env, ${sanitizedName}.size());\n`;
-          implementations += `    size_t ${setVarName}Index = 0;\n`;
-          implementations += `    for (const auto& item : ${sanitizedName}) {\n`;
-          
-          // Проверяем тип элементов Set
-          const setElementType = field.setElementType || field.type.replace('std::unordered_set<', '').replace('>', '');
-          
-          if (setElementType === 'std::string') {
-            implementations += `        ${setVarName}.Set(${setVarName}Index++, Napi::String::New(env, item));\n`;
-          } else if (this.isStructType(setElementType, enums)) {
-            // Set структур
-            implementations += `        ${setVarName}.Set(${setVarName}Index++, item.ToNapi(env));\n`;
-          } else {
-            // Числовые типы
-            implementations += `        ${setVarName}.Set(${setVarName}Index++, Napi::Number::New(env, item));\n`;
-          }
-          
-          implementations += `    }\n`;
-          implementations += `    obj.Set("${field.name}", ${setVarName});\n`;
-        } else if (field.isMap) {
-          // Создаем объект для Map
-          const mapVarName = `${sanitizedName}Obj`;
-          implementations += `    Napi::Object ${mapVarName} = Napi::Object::New(env);\n`;
-          implementations += `    for (const auto& pair : ${sanitizedName}) {\n`;
-          
-          // Обработка ключа
-          const keyType = field.mapKeyType || 'std::string';
-          let keyConversion = '';
-          if (keyType === 'std::string') {
-            keyConversion = 'Napi::String::New(env, pair.first)';
-          } else {
-            keyConversion = 'Napi::Number::New(env, pair.first)';
-          }
-          
-          // Обработка значения
-          const valueType = field.mapValueType || 'double';
-          let valueConversion = '';
-          if (valueType === 'std::string') {
-            valueConversion = 'Napi::String::New(env, pair.second)';
-          } else if (this.isStructType(valueType, enums)) {
-            valueConversion = 'pair.second.ToNapi(env)';
-          } else {
-            valueConversion = 'Napi::Number::New(env, pair.second)';
-          }
-          
-          implementations += `        ${mapVarName}.Set(${keyConversion}, ${valueConversion});\n`;
-          implementations += `    }\n`;
-          implementations += `    obj.Set("${field.name}", ${mapVarName});\n`;
-        } else {
-          // Проверяем, является ли это структурой или enum
-          if (this.isStructType(field.type, enums)) {
-            implementations += `    obj.Set("${field.name}", ${sanitizedName}.ToNapi(env));\n`;
-          } else if (this.isEnumType(field.type, enums)) {
-            // Для enum типов конвертируем в число
-            implementations += `    obj.Set("${field.name}", Napi::Number::New(env, static_cast<int>(${sanitizedName})));\n`;
-          } else {
-            // Используем функции из numeric-types для правильной генерации
-            if (isPreciseNumericType(field.tsType)) {
-              // Для семантических типов нужно кастовать к правильному типу для N-API
-              implementations += `    obj.Set("${field.name}", Napi::Number::New(env, static_cast<double>(${sanitizedName})));\n`;
-            } else if (field.type === 'std::string') {
-              implementations += `    obj.Set("${field.name}", Napi::String::New(env, ${sanitizedName}));\n`;
-            } else if (field.type === 'int') {
-              implementations += `    obj.Set("${field.name}", Napi::Number::New(env, ${sanitizedName}));\n`;
-            } else if (field.type === 'bool') {
-              implementations += `    obj.Set("${field.name}", Napi::Boolean::New(env, ${sanitizedName}));\n`;
-            }
-          }
-        }
+      const resultStruct = structs.find(s => s.name === exp.returnType);
+      let reason = '';
+      if (!structs.some(s => s.name === exp.paramType)) {
+        reason = 'input must be a @CppStruct';
+      } else if (this.hasViewFields(exp.paramType, structs) || this.hasViewFields(exp.returnType, structs)) {
+        reason = 'view fields point into JS memory';
+      } else if (this.hasColumnarFields(exp.paramType, structs) || this.hasColumnarFields(exp.returnType, structs)) {
+        reason = 'columnar fields are passed as TypedArrays';
+      } else if (this.hasEncodedStrings(exp.paramType, structs) || this.hasEncodedStrings(exp.returnType, structs)) {
+        reason = 'interned and latin1 strings are converted through N-API';
+      } else if (resultStruct && resultStruct.isView) {
+        reason = 'the result is a lazy view';
+      } else if (exp.returnType === 'void') {
+        reason = 'there is no result';
+      }
+      if (reason) {
+        console.warn(`⚠️  ${exp.name}: transport 'binary' is not supported (${reason}), using 'napi'`);
+        exp.transport = undefined;
+      } else if (exp.pool === 'native') {
+        console.warn(`⚠️  ${exp.name}: binary calls run on the libuv pool, not the native pool`);
       }
-      
-      implementations += `    return obj;\n`;
-      implementations += `}\n`;
     }
+  }
 
-    const output = template.replace('{{STRUCT_IMPLEMENTATIONS}}', implementations);
-    
-    fs.writeFileSync(path.join(outputDir, 'generated_structs.cpp'), output);
+  /**
+   * Структуры с бинарным кодеком: все структуры без полей-представлений и колонок,
+   * если хотя бы один экспорт использует transport: 'binary'
+   */
+  private collectWireStructs(parseResult: ParseResult): Set<string> {
+    if (!parseResult.exports.some(exp => exp.transport === 'binary')) {
+      return new Set();
+    }
+    return new Set(parseResult.structs
+      .filter(s => !this.hasViewFields(s.name, parseResult.structs) && !this.hasColumnarFields(s.name, parseResult.structs) &&
+        !this.hasEncodedStrings(s.name, parseResult.structs))
+      .map(s => s.name));
   }
 
   /**
-   * Генерирует API wrapper
+   * Применяет опции @CppStream({ highWaterMark }). Тип чанка берется из типа
+   * результата; обертка AsyncIterable<T>/AsyncIterableIterator<T>/AsyncGenerator<T> снимается.
    */
-  private generateApiWrapper(exports: ParsedExport[], outputDir: string): void {
-    // Генерируем .cpp файл
-    const cppTemplate = fs.readFileSync(
-      path.join(__dirname, 'templates', 'api.cpp.template'), 
-      'utf-8'
-    );
+  private applyStreamOptions(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    exportInfo.isStream = true;
+    exportInfo.highWaterMark = 16;
+    const wrapped = exportInfo.returnType.match(/^Async(?:Iterable|IterableIterator|Generator)<\s*([^,>]+(?:<[^>]*>)?)/);
+    if (wrapped) {
+      exportInfo.returnType = this.mapTypeScriptToCpp(wrapped[1].trim());
+    }
+    if (exportInfo.returnType === 'void') {
+      console.warn(`⚠️  ${exportInfo.name}: @CppStream needs a chunk type as the return type`);
+    }
+    if (options.highWaterMark !== undefined) {
+      if (Number.isInteger(options.highWaterMark) && options.highWaterMark > 0) {
+        exportInfo.highWaterMark = options.highWaterMark;
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: highWaterMark must be a positive integer`);
+      }
+    }
+  }
 
-    // Генерируем .h файл
-    const hppTemplate = fs.readFileSync(
-      path.join(__dirname, 'templates', 'api.hpp.template'), 
-      'utf-8'
-    );
+  /**
+   * Применяет опции @CppAsync({ pool, poolSize, cancellable })
+   */
+  private applyAsyncOptions(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    if (options.pool !== undefined) {
+      if (options.pool === 'native' || options.pool === 'uv') {
+        exportInfo.pool = options.pool;
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: unknown pool '${options.pool}', expected 'uv' or 'native'`);
+      }
+    }
+    if (options.poolSize !== undefined) {
+      if (Number.isInteger(options.poolSize) && options.poolSize > 0) {
+        exportInfo.poolSize = options.poolSize;
+        // Размер пула имеет смысл только для нативного пула
+        exportInfo.pool = exportInfo.pool || 'native';
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: poolSize must be a positive integer`);
+      }
+    }
+    if (options.cancellable !== undefined) {
+      exportInfo.cancellable = options.cancellable === true;
+    }
+    this.applyCoalesceOption(exportInfo, options);
+    this.applyRecycleOption(exportInfo, options);
+  }
 
-    let externDeclarations = '';
-    let wrapperFunctions = '';
-    let exportRegistrations = '';
+  /**
+   * Применяет опцию { recycle: true | { maxFree } } из @CppAsync
+   */
+  private applyRecycleOption(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    const recycle = options.recycle;
+    if (recycle === undefined || recycle === false) {
+      return;
+    }
+    if (recycle !== true && (typeof recycle !== 'object' || Array.isArray(recycle))) {
+      console.warn(`⚠️  ${exportInfo.name}: recycle must be true or { maxFree }`);
+      return;
+    }
+    const settings = { maxFree: 64 };
+    if (recycle !== true && recycle.maxFree !== undefined) {
+      if (Number.isInteger(recycle.maxFree) && recycle.maxFree > 0) {
+        settings.maxFree = recycle.maxFree;
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: recycle.maxFree must be a positive integer`);
+      }
+    }
+    exportInfo.recycle = settings;
+  }
 
-    for (const exp of exports) {
-      // Extern объявления
-      externDeclarations += `extern ${exp.returnType} ${exp.name}(const ${exp.paramType}& param);\n`;
-      
-      if (exp.isAsync) {
-        // Генерируем AsyncWorker для асинхронных функций
-        wrapperFunctions += this.generateAsyncWrapper(exp);
+  /**
+   * Применяет опцию { coalesce: true | { windowMs, maxItems } } из @CppAsync
+   */
+  private applyCoalesceOption(exportInfo: ParsedExport, options: DecoratorOptions): void {
+    const coalesce = options.coalesce;
+    if (coalesce === undefined || coalesce === false) {
+      return;
+    }
+    if (coalesce !== true && (typeof coalesce !== 'object' || Array.isArray(coalesce))) {
+      console.warn(`⚠️  ${exportInfo.name}: coalesce must be true or { windowMs, maxItems }`);
+      return;
+    }
+    const settings = { windowMs: 0, maxItems: 256 };
+    if (coalesce !== true && coalesce.windowMs !== undefined) {
+      if (typeof coalesce.windowMs === 'number' && coalesce.windowMs >= 0) {
+        settings.windowMs = coalesce.windowMs;
       } else {
-        // Обычные синхронные wrapper функции
-        wrapperFunctions += this.generateSyncWrapper(exp);
+        console.warn(`⚠️  ${exportInfo.name}: coalesce.windowMs must be a non-negative number`);
+      }
+    }
+    if (coalesce !== true && coalesce.maxItems !== undefined) {
+      if (Number.isInteger(coalesce.maxItems) && coalesce.maxItems > 0) {
+        settings.maxItems = coalesce.maxItems;
+      } else {
+        console.warn(`⚠️  ${exportInfo.name}: coalesce.maxItems must be a positive integer`);
       }
-      
-      // Регистрация экспортов
-      exportRegistrations += `    exports.Set("${exp.name}", Napi::Function::New(env, ${exp.name}_wrapper));\n`;
     }
+    exportInfo.coalesce = settings;
+  }
 
-    // Генерируем .cpp файл
-    let cppOutput = cppTemplate
-      .replace('{{EXTERN_DECLARATIONS}}', externDeclarations)
-      .replace('{{WRAPPER_FUNCTIONS}}', wrapperFunctions)
-      .replace('{{EXPORT_REGISTRATIONS}}', exportRegistrations);
+  /**
+   * Парсит экспортируемый метод
+   */
+  private parseExportMethod(method: MethodDeclaration, className: string, isAsync: boolean = false): ParsedExport | null {
+    const methodName = method.getName();
+    const parameters = method.getParameters();
+    const returnType = method.getReturnTypeNode();
+    const isStatic = method.isStatic();
+
+    // Собираем информацию о параметрах
+    const paramList: { name: string; type: string }[] = [];
+    for (const param of parameters) {
+      const paramName = param.getName();
+      const paramTypeText = param.getTypeNode()?.getText() || 'any';
+      const cppType = this.mapTypeScriptToCpp(paramTypeText);
+      paramList.push({ name: paramName, type: cppType });
+    }
+
+    // Пока поддерживаем только один параметр
+    const paramType = parameters.length > 0 
+      ? this.mapTypeScriptToCpp(parameters[0].getTypeNode()?.getText() || 'void')
+      : 'void';
+
+    const returnTypeStr = returnType 
+      ? this.mapTypeScriptToCpp(returnType.getText())
+      : 'void';
+
+    // Для static методов имя функции: ClassName_methodName
+    const name = isStatic ? `${className}_${methodName}` : methodName;
+
+    return {
+      name,
+      className,
+      methodName,
+      paramType,
+      returnType: returnTypeStr,
+      isStatic,
+      isAsync,
+      parameters: paramList
+    };
+  }
+
+  /**
+   * Маппинг TypeScript типов в C++ типы
+   */
+  private mapTypeScriptToCpp(tsType: string): string {
+    // Используем новую систему уточняемых типов
+    const mappedType = getCppType(tsType);
+    
+    // Если это не базовый тип, возможно это enum или struct
+    if (mappedType === tsType) {
+      const typeMap: { [key: string]: string } = {
+        'number': 'int',  // по умолчанию для совместимости
+        'void': 'void'
+      };
+      return typeMap[tsType] || tsType; // Возвращаем as-is для enum'ов и struct'ов
+    }
+    
+    return mappedType;
+  }
 
-    fs.writeFileSync(path.join(outputDir, 'generated_api.cpp'), cppOutput);
+  /**
+   * Проверяет, является ли идентификатор зарезервированным словом C++
+   */
+  private isReservedCppKeyword(name: string): boolean {
+    const cppKeywords = [
+      'auto', 'break', 'case', 'char', 'const', 'continue', 'default', 'do',
+      'double', 'else', 'enum', 'extern', 'float', 'for', 'goto', 'if',
+      'inline', 'int', 'long', 'register', 'restrict', 'return', 'short',
+      'signed', 'sizeof', 'static', 'struct', 'switch', 'typedef', 'union',
+      'unsigned', 'void', 'volatile', 'while', 'bool', 'catch', 'class',
+      'const_cast', 'delete', 'dynamic_cast', 'explicit', 'export', 'false',
+      'friend', 'mutable', 'namespace', 'new', 'operator', 'private',
+      'protected', 'public', 'reinterpret_cast', 'static_cast', 'template',
+      'this', 'throw', 'true', 'try', 'typeid', 'typename', 'using',
+      'virtual', 'wchar_t'
+    ];
+    
+    return cppKeywords.includes(name.toLowerCase());
+  }
+
+  /**
+   * Преобразует имя поля, если оно конфликтует с C++ ключевыми словами
+   */
+  private sanitizeFieldName(name: string): string {
+    if (this.isReservedCppKeyword(name)) {
+      return name + '_'; // добавляем подчеркивание
+    }
+    return name;
+  }
+
+  /**
+   * Преобразует C++ тип в TypeScript тип для генерации
+   */
+  private cppTypeToTSType(cppType: string): string {
+    const typeMap: { [key: string]: string } = {
+      'int8_t': 'i8',
+      'uint8_t': 'u8',
+      'int16_t': 'i16',
+      'uint16_t': 'u16',
+      'int32_t': 'i32',
+      'uint32_t': 'u32',
+      'int64_t': 'i64',
+      'uint64_t': 'u64',
+      'float': 'f32',
+      'double': 'f64',
+      'bool': 'boolean',
+      'std::string': 'string'
+    };
+    return typeMap[cppType] || cppType;
+  }
+
+  /**
+   * Парсит enum из TypeScript
+   */
+  private parseEnum(enumDecl: any): ParsedEnum | null {
+    const name = enumDecl.getName();
+    const values: { name: string; value: number }[] = [];
+
+    const members = enumDecl.getMembers();
+    for (const member of members) {
+      const memberName = member.getName();
+      const initializer = member.getInitializer();
+      
+      let value = 0;
+      if (initializer && initializer.getKind() === SyntaxKind.NumericLiteral) {
+        value = parseInt(initializer.getText(), 10);
+      } else {
+        // Если значение не указано, используем автоинкремент
+        value = values.length;
+      }
+
+      values.push({ name: memberName, value });
+    }
+
+    return { name, values };
+  }
+
+  /**
+   * Проверяет, используется ли enum в структурах
+   */
+  private isEnumUsedInStructs(enumName: string, structs: ParsedStruct[]): boolean {
+    for (const struct of structs) {
+      for (const field of struct.fields) {
+        if (field.tsType === enumName) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  private isEnumType(typeName: string, enums: ParsedEnum[]): boolean {
+    return enums.some(e => e.name === typeName);
+  }
+
+  /**
+   * Проверяет, является ли тип структурой (не enum и не базовый тип)
+   */
+  private isStructType(typeName: string, enums: ParsedEnum[]): boolean {
+    // Простая эвристика: если это не базовые типы, не enum и не стандартные типы
+    const basicTypes = [
+      'int', 'double', 'float', 'bool', 'std::string', 
+      'uint32_t', 'int32_t', 'int8_t', 'uint8_t', 'int16_t', 'uint16_t', 'int64_t', 'uint64_t',
+      'size_t', 'char', 'unsigned char', 'short', 'unsigned short', 'long', 'unsigned long'
+    ];
+    return !basicTypes.includes(typeName) && !this.isEnumType(typeName, enums) && !typeName.startsWith('std::vector');
+  }
+
+  /**
+   * Генерирует C++ код из результатов парсинга
+   */
+  public generateCppCode(parseResult: ParseResult, outputDir: string, options: GenerateOptions = {}): void {
+    this.wireStructNames = this.collectWireStructs(parseResult);
+    this.arenaStructNames = new Set(parseResult.structs.filter(s => s.isArena).map(s => s.name));
+    this.hashStructNames = this.collectHashStructs(parseResult);
+    this.columnarStructNames = new Set(parseResult.structs.filter(s => s.isColumnar).map(s => s.name));
+    this.tryDecodeStructNames = this.collectTryDecodeStructs(
+      [...parseResult.exports, ...parseResult.classes.flatMap(cls => cls.methods)], parseResult.structs);
+    this.recycleStructNames = this.collectRecycleStructs(
+      [...parseResult.exports, ...parseResult.classes.flatMap(cls => cls.methods)], parseResult.structs);
+    this.splitStructs = !!options.splitStructs;
+    this.generateRuntimeHeader(outputDir);
+    this.generateStructsHeader(parseResult.structs, parseResult.enums, outputDir);
+    this.generateStructsImpl(parseResult.structs, parseResult.enums, outputDir);
+    this.generateApiWrapper(parseResult.exports, parseResult.classes, parseResult.structs, outputDir);
+    this.generateImplementationTemplate(parseResult.exports, parseResult.classes, outputDir);
+    if (this.splitStructs) {
+      this.generateSourcesGypi(parseResult.structs, outputDir);
+    }
+    this.removeStaleStructFiles(parseResult.structs, outputDir);
+  }
+
+  /**
+   * Исходники привязок для binding.gyp: "includes": ["src/generated_sources.gypi"] в цели
+   * подхватывает файлы структур без ручного списка (пути - относительно .gypi)
+   */
+  private generateSourcesGypi(structs: ParsedStruct[], outputDir: string): void {
+    const sources = ['generated_structs.cpp', ...structs.map(s => this.structFileName(s.name, 'cpp')), 'generated_api.cpp'];
+    let content = `# Генерируется автоматически ts-cpp-bridge, НЕ ИЗМЕНЯЙТЕ\n`;
+    content += `{\n  "sources": [\n${sources.map(file => `    "${file}"`).join(',\n')}\n  ]\n}\n`;
+    this.writeOutput(path.join(outputDir, 'generated_sources.gypi'), content);
+  }
+
+  /**
+   * Удаляет файлы splitStructs, оставшиеся от удаленных структур или от прошлой генерации
+   * с раздельными файлами
+   */
+  private removeStaleStructFiles(structs: ParsedStruct[], outputDir: string): void {
+    const keep = new Set<string>();
+    if (this.splitStructs) {
+      ['generated_enums.hpp', 'generated_property_keys.hpp', 'generated_sources.gypi'].forEach(file => keep.add(file));
+      for (const struct of structs) {
+        keep.add(this.structFileName(struct.name, 'hpp'));
+        keep.add(this.structFileName(struct.name, 'cpp'));
+      }
+    }
+    const generated = /^(generated_struct_\w+\.(hpp|cpp)|generated_enums\.hpp|generated_property_keys\.hpp|generated_sources\.gypi)$/;
+    for (const file of fs.readdirSync(outputDir)) {
+      if (generated.test(file) && !keep.has(file)) {
+        fs.unlinkSync(path.join(outputDir, file));
+      }
+    }
+  }
+
+  /**
+   * Возвращает списки записанных и пропущенных (содержимое не изменилось) файлов
+   * с предыдущего вызова
+   */
+  public takeWriteStats(): { written: string[]; unchanged: string[] } {
+    const stats = this.writeStats;
+    this.writeStats = { written: [], unchanged: [] };
+    return stats;
+  }
+
+  /**
+   * Генерирует addon для микробенчмарка привязок (ts-cpp-bridge bench).
+   * Реализации функций заменяются пустыми, отдельные экспорты __bench_* замеряют
+   * FromNapi, вызов и ToNapi в нативном цикле, а bench.js - полный вызов из JS.
+   */
+  public generateBenchmark(parseResult: ParseResult, outputDir: string, options: { sizes: number[]; iterations: number }): void {
+    const srcDir = path.join(outputDir, 'src');
+    fs.mkdirSync(srcDir, { recursive: true });
+
+    // Потоковые экспорты не меряются: их время определяет потребитель.
+    // Кэш отключен: замер должен проходить через маршалинг, а не через попадания в LRU
+    parseResult = {
+      ...parseResult,
+      exports: parseResult.exports.filter(exp => !exp.isStream).map(exp => ({ ...exp, cache: undefined }))
+    };
+
+    this.wireStructNames = this.collectWireStructs(parseResult);
+    this.arenaStructNames = new Set(parseResult.structs.filter(s => s.isArena).map(s => s.name));
+    this.hashStructNames = this.collectHashStructs(parseResult);
+    this.columnarStructNames = new Set(parseResult.structs.filter(s => s.isColumnar).map(s => s.name));
+    this.tryDecodeStructNames = this.collectTryDecodeStructs(parseResult.exports, parseResult.structs);
+    this.recycleStructNames = this.collectRecycleStructs(parseResult.exports, parseResult.structs);
+    this.splitStructs = false;
+    this.generateRuntimeHeader(srcDir);
+    this.generateStructsHeader(parseResult.structs, parseResult.enums, srcDir);
+    this.generateStructsImpl(parseResult.structs, parseResult.enums, srcDir);
+    this.generateApiWrapper(parseResult.exports, [], parseResult.structs, srcDir, 'InitBenchAPI');
+    this.generateBenchNoop(parseResult.exports, srcDir);
+    this.generateBenchApi(parseResult, srcDir);
+
+    this.writeOutput(
+      path.join(outputDir, 'binding.gyp'),
+      fs.readFileSync(path.join(__dirname, 'templates', 'bench.binding.gyp.template'), 'utf-8')
+    );
+
+    const schema = this.generateBenchSchema(parseResult);
+    const script = fs.readFileSync(path.join(__dirname, 'templates', 'bench.js.template'), 'utf-8')
+      .replace('{{SCHEMA}}', JSON.stringify(schema, null, 2))
+      .replace('{{SIZES}}', JSON.stringify(options.sizes))
+      .replace('{{ITERATIONS}}', String(options.iterations));
+    this.writeOutput(path.join(outputDir, 'bench.js'), script);
+  }
+
+  /**
+   * Пустые реализации экспортов для бенчмарка
+   */
+  private generateBenchNoop(exports: ParsedExport[], outputDir: string): void {
+    let content = '// Пустые реализации для бенчмарка (генерируется автоматически, НЕ ИЗМЕНЯЙТЕ)\n';
+    content += '#include "generated_structs.hpp"\n';
+    for (const exp of exports) {
+      content += `\n${this.functionSignature(exp, 'input')} {\n`;
+      if (exp.signature !== 'out') {
+        content += `    return ${exp.returnType}();\n`;
+      }
+      content += `}\n`;
+    }
+    this.writeOutput(path.join(outputDir, 'bench_noop.cpp'), content);
+  }
+
+  /**
+   * Нативные экспорты __bench_decode_X / __bench_encode_X / __bench_call_X.
+   * Каждый принимает (payload, iterations) и возвращает нс на итерацию.
+   */
+  private generateBenchApi(parseResult: ParseResult, outputDir: string): void {
+    let content = '// Нативные замеры для бенчмарка (генерируется автоматически, НЕ ИЗМЕНЯЙТЕ)\n';
+    content += '#include <napi.h>\n';
+    content += '#include <algorithm>\n';
+    content += '#include <chrono>\n';
+    content += '#include "generated_api.h"\n\n';
+    content += 'namespace {\n\n';
+    content += 'using BenchClock = std::chrono::steady_clock;\n\n';
+    content += 'double NsPerIteration(BenchClock::time_point start, uint32_t iterations) {\n';
+    content += '    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start);\n';
+    content += '    return static_cast<double>(elapsed.count()) / iterations;\n';
+    content += '}\n\n';
+    content += 'bool BenchArgs(const Napi::CallbackInfo& info, uint32_t& iterations) {\n';
+    content += '    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsNumber()) {\n';
+    content += '        Napi::TypeError::New(info.Env(), "Expected (payload, iterations)").ThrowAsJavaScriptException();\n';
+    content += '        return false;\n';
+    content += '    }\n';
+    content += '    iterations = std::max<uint32_t>(1, info[1].As<Napi::Number>().Uint32Value());\n';
+    content += '    return true;\n';
+    content += '}\n';
+
+    let registrations = '';
+    for (const struct of parseResult.structs) {
+      content += `\nNapi::Value Bench_decode_${struct.name}(const Napi::CallbackInfo& info) {\n`;
+      content += `    uint32_t iterations = 0;\n`;
+      content += `    if (!BenchArgs(info, iterations)) {\n`;
+      content += `        return info.Env().Null();\n`;
+      content += `    }\n`;
+      content += `    Napi::Object payload = info[0].As<Napi::Object>();\n`;
+      content += `    const auto start = BenchClock::now();\n`;
+      content += `    for (uint32_t i = 0; i < iterations; i++) {\n`;
+      content += `        Napi::HandleScope scope(info.Env());\n`;
+      content += `        ${struct.name} value = ${struct.name}::FromNapi(payload);\n`;
+      content += `        (void)value;\n`;
+      content += `    }\n`;
+      content += `    return Napi::Number::New(info.Env(), NsPerIteration(start, iterations));\n`;
+      content += `}\n`;
+
+      content += `\nNapi::Value Bench_encode_${struct.name}(const Napi::CallbackInfo& info) {\n`;
+      content += `    uint32_t iterations = 0;\n`;
+      content += `    if (!BenchArgs(info, iterations)) {\n`;
+      content += `        return info.Env().Null();\n`;
+      content += `    }\n`;
+      content += `    const ${struct.name} value = ${struct.name}::FromNapi(info[0].As<Napi::Object>());\n`;
+      content += `    const auto start = BenchClock::now();\n`;
+      content += `    for (uint32_t i = 0; i < iterations; i++) {\n`;
+      content += `        Napi::HandleScope scope(info.Env());\n`;
+      content += `        value.ToNapi(info.Env());\n`;
+      content += `    }\n`;
+      content += `    return Napi::Number::New(info.Env(), NsPerIteration(start, iterations));\n`;
+      content += `}\n`;
+
+      registrations += `    exports.Set("__bench_decode_${struct.name}", Napi::Function::New(env, Bench_decode_${struct.name}));\n`;
+      registrations += `    exports.Set("__bench_encode_${struct.name}", Napi::Function::New(env, Bench_encode_${struct.name}));\n`;
+    }
+
+    for (const exp of parseResult.exports) {
+      content += `\nNapi::Value Bench_call_${exp.name}(const Napi::CallbackInfo& info) {\n`;
+      content += `    uint32_t iterations = 0;\n`;
+      content += `    if (!BenchArgs(info, iterations)) {\n`;
+      content += `        return info.Env().Null();\n`;
+      content += `    }\n`;
+      if (exp.paramType !== 'void') {
+        content += `    const ${exp.paramType} input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>());\n`;
+      }
+      if (exp.cancellable) {
+        // Пустой токен: отмена не запрашивается, замеряется только вызов
+        content += `    const tscb::CancelToken cancel;\n`;
+      }
+      content += `    const auto start = BenchClock::now();\n`;
+      content += `    for (uint32_t i = 0; i < iterations; i++) {\n`;
+      if (exp.signature === 'move' && exp.paramType !== 'void') {
+        // Вызов забирает вход, поэтому в замер входит копирование входа
+        content += `        ${exp.paramType} copy = input;\n`;
+        content += this.indent(this.callStatement(exp, 'copy', 'result', true, 'self', 'cancel'), 8);
+      } else {
+        content += this.indent(this.callStatement(exp, 'input', 'result', true, 'self', 'cancel'), 8);
+      }
+      if (exp.returnType !== 'void') {
+        content += `        (void)result;\n`;
+      }
+      content += `    }\n`;
+      content += `    return Napi::Number::New(info.Env(), NsPerIteration(start, iterations));\n`;
+      content += `}\n`;
+
+      registrations += `    exports.Set("__bench_call_${exp.name}", Napi::Function::New(env, Bench_call_${exp.name}));\n`;
+    }
+
+    content += '\n} // namespace\n\n';
+    content += 'Napi::Object InitBenchAPI(Napi::Env env, Napi::Object exports) {\n';
+    content += registrations;
+    content += '    return exports;\n';
+    content += '}\n';
+
+    this.writeOutput(path.join(outputDir, 'bench_api.cpp'), content);
+  }
+
+  /**
+   * Описание структур для построения синтетических данных в bench.js
+   */
+  private generateBenchSchema(parseResult: ParseResult): { structs: { [name: string]: any[] }; exports: any[] } {
+    const structNames = new Set(parseResult.structs.map(s => s.name));
+    const kindOf = (cppType: string | undefined): string => {
+      const type = (cppType || '').trim();
+      if (structNames.has(type)) return `struct:${type}`;
+      if (type === 'std::string') return 'string';
+      if (type === 'bool') return 'boolean';
+      return 'number';
+    };
+
+    const structs: { [name: string]: any[] } = {};
+    for (const struct of parseResult.structs) {
+      structs[struct.name] = struct.fields.map(field => {
+        if (field.isTypedArray) {
+          return { name: field.name, container: 'typed', ctor: field.tsType };
+        }
+        if (field.isArray) {
+          return { name: field.name, container: 'array', element: kindOf(field.arrayElementType) };
+        }
+        if (field.isSet) {
+          return { name: field.name, container: 'set', element: kindOf(field.setElementType) };
+        }
+        if (field.isMap) {
+          return { name: field.name, container: 'map', key: kindOf(field.mapKeyType), value: kindOf(field.mapValueType) };
+        }
+        return { name: field.name, kind: kindOf(field.type) };
+      });
+    }
+
+    const exports = parseResult.exports.map(exp => ({
+      name: exp.name,
+      async: exp.isAsync,
+      param: exp.paramType,
+      result: exp.returnType,
+      resultStruct: structNames.has(exp.returnType)
+    }));
+
+    return { structs, exports };
+  }
+
+  /**
+   * Записывает сгенерированный файл, только если sha256 содержимого отличается от файла на диске.
+   * Неизмененные файлы сохраняют mtime, и node-gyp не пересобирает зависящие от них объекты
+   */
+  private writeOutput(filePath: string, content: string): boolean {
+    const hash = (data: string | Buffer) => crypto.createHash('sha256').update(data).digest('hex');
+    if (fs.existsSync(filePath) && hash(fs.readFileSync(filePath)) === hash(content)) {
+      this.writeStats.unchanged.push(filePath);
+      return false;
+    }
+    fs.writeFileSync(filePath, content);
+    this.writeStats.written.push(filePath);
+    return true;
+  }
+
+  /**
+   * Копирует вспомогательный runtime (generated_runtime.hpp)
+   */
+  private generateRuntimeHeader(outputDir: string): void {
+    const template = fs.readFileSync(
+      path.join(__dirname, 'templates', 'runtime.hpp.template'),
+      'utf-8'
+    );
+
+    this.writeOutput(path.join(outputDir, 'generated_runtime.hpp'), template);
+  }
+
+  /**
+   * C++ тип поля в объявлении структуры
+   */
+  private fieldCppType(field: ParsedField): string {
+    if (field.isView) {
+      return `tscb::ArrayView<${field.typedArrayElementType}>`;
+    }
+    if (field.isFlatMap) {
+      return getCppType(field.tsType).replace(/^std::unordered_map</, 'tscb::FlatMap<');
+    }
+    if (field.isInterned) {
+      return 'tscb::InternedString';
+    }
+    const columnar = this.columnarElement(field);
+    if (columnar) {
+      return `${columnar}Columns`;
+    }
+    return getCppType(field.tsType); // Всегда используем getCppType для полного типа
+  }
+
+  /**
+   * Массив чисел (number[]), который можно разобрать через tscb::ReadTypedArray
+   */
+  private isBulkNumberArray(field: ParsedField): boolean {
+    return field.isArray && (field.arrayElementType === 'double' || field.arrayElementType === 'float');
+  }
+
+  /**
+   * Числовой C++ тип (не bool, не enum): элементы Set/Map передаются через Float64Array
+   */
+  private isNumberCppType(cppType: string): boolean {
+    return cppType !== 'bool' && this.wireScalar(cppType, []) !== null;
+  }
+
+  /**
+   * Тип поля в объявлении структуры: для arena-структур строки и векторы - std::pmr
+   */
+  private fieldDeclType(field: ParsedField, arena: boolean): string {
+    const cppType = this.fieldCppType(field);
+    if (!arena || !(cppType === 'std::string' || cppType.startsWith('std::vector<'))) {
+      return cppType;
+    }
+    return cppType.replace(/std::vector</g, 'std::pmr::vector<').replace(/std::string/g, 'std::pmr::string');
+  }
+
+  /**
+   * Поле arena-структуры, которое конструируется с аллокатором (pmr контейнер или вложенная arena-структура)
+   */
+  private isAllocatorField(field: ParsedField, arena: boolean): boolean {
+    return arena && (this.fieldDeclType(field, true).startsWith('std::pmr::') ||
+      (!field.isArray && !field.isSet && !field.isMap && this.arenaStructNames.has(field.type)));
+  }
+
+  /**
+   * Проверяет, содержит ли структура (включая вложенные) поля-представления над памятью JS
+   */
+  private hasViewFields(structName: string, structs: ParsedStruct[]): boolean {
+    return this.hasFieldDeep(structName, structs, field => !!field.isView);
+  }
+
+  /**
+   * Проверяет, содержит ли структура (включая вложенные) массивы колоночных структур
+   */
+  private hasColumnarFields(structName: string, structs: ParsedStruct[]): boolean {
+    return this.hasFieldDeep(structName, structs,
+      field => field.isArray && structs.some(s => s.name === field.arrayElementType && s.isColumnar));
+  }
+
+  /**
+   * Проверяет, содержит ли структура (включая вложенные) строки intern или encoding: 'latin1'
+   */
+  private hasEncodedStrings(structName: string, structs: ParsedStruct[]): boolean {
+    return this.hasFieldDeep(structName, structs, field => !!(field.isInterned || field.isLatin1));
+  }
+
+  /**
+   * Есть ли в структуре или вложенных в нее структурах поле, удовлетворяющее predicate
+   */
+  private hasFieldDeep(structName: string, structs: ParsedStruct[], predicate: (field: ParsedField) => boolean,
+                       visited: Set<string> = new Set()): boolean {
+    const struct = structs.find(s => s.name === structName);
+    if (!struct || visited.has(structName)) {
+      return false;
+    }
+    visited.add(structName);
+    return struct.fields.some(field => {
+      if (predicate(field)) {
+        return true;
+      }
+      const nested = field.arrayElementType || field.setElementType || field.mapValueType || field.type;
+      return this.hasFieldDeep(nested, structs, predicate, visited);
+    });
+  }
+
+  /**
+   * Генерирует заголовочный файл структур
+   */
+  private generateStructsHeader(structs: ParsedStruct[], enums: ParsedEnum[], outputDir: string): void {
+    const template = fs.readFileSync(
+      path.join(__dirname, 'templates', 'structs.hpp.template'), 
+      'utf-8'
+    );
+
+    // Генерируем enum'ы
+    let enumDeclarations = '';
+    for (const enumInfo of enums) {
+      enumDeclarations += `\nenum class ${enumInfo.name} : uint32_t {\n`;
+      for (const value of enumInfo.values) {
+        enumDeclarations += `    ${value.name} = ${value.value},\n`;
+      }
+      enumDeclarations += `};\n`;
+    }
+
+    if (this.splitStructs) {
+      this.generateSplitStructHeaders(template, structs, enums, enumDeclarations, outputDir);
+      return;
+    }
+
+    let structDeclarations = '';
+    for (const struct of structs) {
+      structDeclarations += this.generateStructDeclaration(struct, enums);
+    }
+
+    for (const struct of structs.filter(s => s.isView)) {
+      structDeclarations += this.generateViewClassDeclaration(struct, enums);
+    }
+
+    structDeclarations += this.generateStructInitDeclarations(structs);
+
+    const output = template
+      .replace('{{ENUM_DECLARATIONS}}', enumDeclarations)
+      .replace('{{STRUCT_DECLARATIONS}}', structDeclarations);
+    
+    this.writeOutput(path.join(outputDir, 'generated_structs.hpp'), output);
+  }
+
+  /**
+   * Объявление структуры: поля и методы маршалинга
+   */
+  private generateStructDeclaration(struct: ParsedStruct, enums: ParsedEnum[]): string {
+    let declaration = `\nstruct ${struct.name} {\n`;
+    
+    // Поля
+    for (const field of struct.fields) {
+      const cppType = this.fieldDeclType(field, !!struct.isArena);
+      const sanitizedName = this.sanitizeFieldName(field.name);
+      let defaultInit = '';
+      if ((field as any).defaultValue) {
+        let defaultValue = (field as any).defaultValue;
+        // Для enum типов заменяем . на :: для правильного C++ синтаксиса
+        const isEnumType = enums.some(e => e.name === cppType);
+        if (isEnumType) {
+          defaultValue = defaultValue.replace('.', '::');
+        }
+        defaultInit = ` = ${defaultValue}`;
+      }
+      declaration += `    ${cppType} ${sanitizedName}${defaultInit};\n`;
+    }
+    
+    // Методы
+    if (struct.isArena) {
+      // Allocator-aware: std::pmr контейнеры передают аллокатор вложенным структурам
+      declaration += `\n    using allocator_type = std::pmr::polymorphic_allocator<char>;\n`;
+      declaration += `    ${struct.name}() = default;\n`;
+      declaration += `    explicit ${struct.name}(const allocator_type& alloc);\n`;
+      declaration += `    ${struct.name}(const ${struct.name}& other, const allocator_type& alloc);\n`;
+      declaration += `    ${struct.name}(${struct.name}&& other, const allocator_type& alloc);\n`;
+      declaration += `    ${struct.name}(const ${struct.name}&) = default;\n`;
+      declaration += `    ${struct.name}(${struct.name}&&) = default;\n`;
+      declaration += `    ${struct.name}& operator=(const ${struct.name}&) = default;\n`;
+      declaration += `    ${struct.name}& operator=(${struct.name}&&) = default;\n\n`;
+      declaration += `    // alloc - арена вызова (tscb::CallArena) или ресурс по умолчанию\n`;
+      declaration += `    static ${struct.name} FromNapi(const Napi::Object& obj, const allocator_type& alloc = {});\n`;
+    } else {
+      declaration += `    static ${struct.name} FromNapi(const Napi::Object& obj);\n`;
+    }
+    if (this.recycleStructNames.has(struct.name)) {
+      // Разбор в существующий объект для @CppAsync({ recycle }): буферы полей переиспользуются
+      declaration += `    static void FromNapi(const Napi::Object& obj, ${struct.name}& result);\n`;
+    }
+    if (this.tryDecodeStructNames.has(struct.name)) {
+      // Разбор без исключений для @CppExport({ noexcept: true }): false - брошен JS TypeError
+      declaration += `    static bool TryFromNapi(const Napi::Value& value, ${struct.name}& out);\n`;
+    }
+    declaration += `    Napi::Object ToNapi(Napi::Env env) const;\n`;
+    if (struct.isView) {
+      // ToNapi возвращает ${struct.name}View, ToObject - обычный объект со всеми полями
+      declaration += `    Napi::Object ToObject(Napi::Env env) const;\n`;
+    }
+    if (this.wireStructNames.has(struct.name)) {
+      // Бинарный формат для transport: 'binary'
+      declaration += `    static ${struct.name} WireDecode(tscb::WireReader& r);\n`;
+      declaration += `    void WireEncode(tscb::WireWriter& w) const;\n`;
+    }
+    if (this.hashStructNames.has(struct.name)) {
+      // Ключ кэша результатов @CppExport({ cache })
+      declaration += `    std::size_t Hash() const;\n`;
+      declaration += `    bool operator==(const ${struct.name}& other) const;\n`;
+    }
+    // Нативная память полей вне sizeof: учет внешней памяти (tscb::ExternalMemory)
+    declaration += `    std::size_t HeapBytes() const;\n`;
+    declaration += `};\n`;
+    if (struct.isColumnar) {
+      declaration += this.generateColumnsDeclaration(struct);
+    }
+    return declaration;
+  }
+
+  /**
+   * Объявление <Name>Columns для @CppStruct({ layout: 'columnar' }): непрерывный вектор на каждое поле
+   */
+  private generateColumnsDeclaration(struct: ParsedStruct): string {
+    const name = `${struct.name}Columns`;
+    let declaration = `
+// Массив ${struct.name} колонками: bool хранится как uint8_t, строки - std::string
+`;
+    declaration += `struct ${name} {
+`;
+    for (const field of struct.fields) {
+      declaration += `    std::vector<${this.columnElementType(field)}> ${this.sanitizeFieldName(field.name)};
+`;
+    }
+    const first = this.sanitizeFieldName(struct.fields[0].name);
+    declaration += `
+    size_t size() const { return ${first}.size(); }
+`;
+    declaration += `    bool empty() const { return ${first}.empty(); }
+`;
+    declaration += `    void reserve(size_t n);
+`;
+    declaration += `    void resize(size_t n);
+`;
+    declaration += `    void clear();
+`;
+    declaration += `    void push_back(const ${struct.name}& row);
+`;
+    declaration += `    ${struct.name} row(size_t i) const;
+
+`;
+    declaration += `    // Массив объектов ${struct.name} или колоночный объект { length, <поле>: TypedArray, strings }
+`;
+    declaration += `    static ${name} FromNapi(const Napi::Value& value);
+`;
+    declaration += `    Napi::Object ToNapi(Napi::Env env) const;
+`;
+    if (this.hashStructNames.has(struct.name)) {
+      declaration += `    std::size_t Hash() const;
+`;
+      declaration += `    bool operator==(const ${name}& other) const;
+`;
+    }
+    declaration += `    std::size_t HeapBytes() const;
+`;
+    declaration += `};
+`;
+    return declaration;
+  }
+
+  /**
+   * Методы <Name>Columns: работа со строками и маршалинг колонок одним TypedArray на поле
+   */
+  private generateColumnsImpl(struct: ParsedStruct): string {
+    const name = `${struct.name}Columns`;
+    const columns = struct.fields.map(field => ({
+      key: this.propertyKeyConstant(field.name),
+      member: this.sanitizeFieldName(field.name),
+      label: field.name,
+      type: this.columnElementType(field),
+      isString: field.type === 'std::string',
+      isBool: this.fieldCppType(field) === 'bool'
+    }));
+    const hasStrings = columns.some(c => c.isString);
+    const each = (line: (c: typeof columns[0]) => string) => columns.map(c => `    ${line(c)}\n`).join('');
+
+    let code = `\nvoid ${name}::reserve(size_t n) {\n${each(c => `${c.member}.reserve(n);`)}}\n`;
+    code += `\nvoid ${name}::resize(size_t n) {\n${each(c => `${c.member}.resize(n);`)}}\n`;
+    code += `\nvoid ${name}::clear() {\n${each(c => `${c.member}.clear();`)}}\n`;
+    code += `\nvoid ${name}::push_back(const ${struct.name}& row) {\n`;
+    code += each(c => c.isString ? `${c.member}.emplace_back(row.${c.member}.data(), row.${c.member}.size());`
+      : c.isBool ? `${c.member}.push_back(row.${c.member} ? 1 : 0);` : `${c.member}.push_back(row.${c.member});`);
+    code += `}\n`;
+    code += `\n${struct.name} ${name}::row(size_t i) const {\n`;
+    code += `    ${struct.name} result;\n`;
+    code += each(c => c.isString ? `result.${c.member}.assign(${c.member}[i].data(), ${c.member}[i].size());`
+      : c.isBool ? `result.${c.member} = ${c.member}[i] != 0;` : `result.${c.member} = ${c.member}[i];`);
+    code += `    return result;\n`;
+    code += `}\n`;
+
+    code += `\n${name} ${name}::FromNapi(const Napi::Value& value) {\n`;
+    code += `    ${name} result;\n`;
+    code += `    try {\n`;
+    code += `        if (value.IsArray()) {\n`;
+    code += `            // Массив объектов: каждый разбирается ${struct.name}::FromNapi и раскладывается по колонкам\n`;
+    code += `            Napi::Array arr = value.As<Napi::Array>();\n`;
+    code += `            const uint32_t length = arr.Length();\n`;
+    code += `            result.reserve(length);\n`;
+    code += `            for (uint32_t i = 0; i < length; i++) {\n`;
+    code += `                result.push_back(${struct.name}::FromNapi(arr.Get(i).As<Napi::Object>()));\n`;
+    code += `            }\n`;
+    code += `            return result;\n`;
+    code += `        }\n`;
+    code += `        Napi::Object obj = value.As<Napi::Object>();\n`;
+    code += `        const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());\n`;
+    code += `        const size_t length = static_cast<size_t>(obj.Get(tscbEnv.Key(${this.propertyKeyConstant('length')})).As<Napi::Number>().Int64Value());\n`;
+    if (hasStrings) {
+      code += `        std::vector<std::string> strings;\n`;
+      code += `        tscb::ReadStringTable(obj.Get(tscbEnv.Key(${this.propertyKeyConstant('strings')})), strings);\n`;
+    }
+    for (const c of columns) {
+      const column = `obj.Get(tscbEnv.Key(${c.key}))`;
+      code += c.isString
+        ? `        tscb::ReadStringColumn(${column}, length, strings, result.${c.member}, "${c.label}");\n`
+        : `        tscb::ReadColumn<${c.type}>(${column}, length, result.${c.member}, "${c.label}");\n`;
+    }
+    code += `    } catch (const std::exception& e) {\n`;
+    code += `        throw std::runtime_error(std::string("Failed to parse ${name}: ") + e.what());\n`;
+    code += `    }\n`;
+    code += `    return result;\n`;
+    code += `}\n`;
+
+    code += `\nNapi::Object ${name}::ToNapi(Napi::Env env) const {\n`;
+    code += `    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(env);\n`;
+    code += `    Napi::Object obj = Napi::Object::New(env);\n`;
+    if (hasStrings) {
+      code += `    tscb::StringTable strings;\n`;
+    }
+    code += `    obj.Set(tscbEnv.Key(${this.propertyKeyConstant('length')}), Napi::Number::New(env, static_cast<double>(size())));\n`;
+    for (const c of columns) {
+      const value = c.isString ? `strings.Index(env, ${c.member})` : `tscb::NewTypedArray<${c.type}>(env, ${c.member}.data(), ${c.member}.size())`;
+      code += `    obj.Set(tscbEnv.Key(${c.key}), ${value});\n`;
+    }
+    if (hasStrings) {
+      code += `    obj.Set(tscbEnv.Key(${this.propertyKeyConstant('strings')}), strings.ToNapi(env));\n`;
+    } else {
+      code += `    obj.Set(tscbEnv.Key(${this.propertyKeyConstant('strings')}), Napi::Array::New(env));\n`;
+    }
+    code += `    return obj;\n`;
+    code += `}\n`;
+
+    if (this.hashStructNames.has(struct.name)) {
+      // Члены колонок называются как поля структуры: колонки хешируются и сравниваются целиком
+      code += this.generateHashFunctions({ ...struct, name });
+    }
+    code += this.generateHeapBytes({ ...struct, name });
+    return code;
+  }
+
+  /**
+   * Объявления функций инициализации ключей свойств и view
+   */
+  private generateStructInitDeclarations(structs: ParsedStruct[]): string {
+    let code = `\n// Создает кэшированные ключи свойств (вызывается из InitGeneratedAPI)\n`;
+    code += `void InitStructKeys(Napi::Env env);\n`;
+    if (structs.some(s => s.isView)) {
+      code += `\n// Регистрирует классы ленивых view (вызывается из InitGeneratedAPI)\n`;
+      code += `void InitStructViews(Napi::Env env);\n`;
+    }
+    return code;
+  }
+
+  /**
+   * Раздельная генерация (splitStructs): generated_enums.hpp, заголовок на каждую структуру,
+   * подключающий только ее зависимости, и generated_structs.hpp, подключающий все
+   */
+  private generateSplitStructHeaders(template: string, structs: ParsedStruct[], enums: ParsedEnum[], enumDeclarations: string, outputDir: string): void {
+    this.writeOutput(path.join(outputDir, 'generated_enums.hpp'), `#pragma once\n\n#include <cstdint>\n${enumDeclarations}`);
+
+    for (const struct of structs) {
+      const includes = ['generated_enums.hpp', ...this.structDependencies(struct, structs).map(dep => this.structFileName(dep, 'hpp'))];
+      let declaration = this.generateStructDeclaration(struct, enums);
+      if (struct.isView) {
+        declaration += this.generateViewClassDeclaration(struct, enums);
+      }
+      const output = template
+        .replace('{{ENUM_DECLARATIONS}}', includes.map(file => `#include "${file}"`).join('\n'))
+        .replace('{{STRUCT_DECLARATIONS}}', declaration);
+      this.writeOutput(path.join(outputDir, this.structFileName(struct.name, 'hpp')), output);
+    }
+
+    const includes = ['generated_enums.hpp', ...structs.map(s => this.structFileName(s.name, 'hpp'))];
+    const output = template
+      .replace('{{ENUM_DECLARATIONS}}', includes.map(file => `#include "${file}"`).join('\n'))
+      .replace('{{STRUCT_DECLARATIONS}}', this.generateStructInitDeclarations(structs));
+    this.writeOutput(path.join(outputDir, 'generated_structs.hpp'), output);
+  }
+
+  /**
+   * Структуры, на которые ссылаются поля struct (без нее самой)
+   */
+  private structDependencies(struct: ParsedStruct, structs: ParsedStruct[]): string[] {
+    const names = new Set(structs.map(s => s.name));
+    const deps = new Set<string>();
+    for (const field of struct.fields) {
+      const declared = this.fieldDeclType(field, !!struct.isArena).match(/\w+/g) || [];
+      for (const name of [...declared, this.columnarElement(field) || '']) {
+        if (names.has(name) && name !== struct.name) {
+          deps.add(name);
+        }
+      }
+    }
+    return [...deps];
+  }
+
+  /**
+   * Имя файла структуры при splitStructs
+   */
+  private structFileName(structName: string, ext: 'hpp' | 'cpp'): string {
+    return `generated_struct_${structName}.${ext}`;
+  }
+
+  /**
+   * Имя константы кэшированного ключа свойства
+   */
+  private propertyKeyConstant(fieldName: string): string {
+    return `kKey_${fieldName}`;
+  }
+
+  /**
+   * Генерирует таблицу имен свойств всех структур и InitStructKeys().
+   * Ключи создаются один раз на Napi::Env и переиспользуются в FromNapi/ToNapi.
+   * withEnum = false - enum PropertyKey вынесен в generated_property_keys.hpp (splitStructs)
+   */
+  private generatePropertyKeys(structs: ParsedStruct[], withEnum: boolean = true): string {
+    const names = this.propertyKeyNames(structs);
+
+    let code = `\nnamespace {\n`;
+    if (withEnum) {
+      code += this.generatePropertyKeyEnum(names);
+      code += `\n`;
+    }
+    code += `const char* const kPropertyNames[] = {\n`;
+    for (const name of names) {
+      code += `    "${name}",\n`;
+    }
+    code += `    nullptr\n`;
+    code += `};\n`;
+    code += `} // namespace\n\n`;
+    code += `void InitStructKeys(Napi::Env env) {\n`;
+    code += `    tscb::EnvData::Get(env).InitKeys(env, kPropertyNames, kPropertyKeyCount);\n`;
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * Индексы ключей свойств, общие для единиц трансляции структур (splitStructs)
+   */
+  private generatePropertyKeysHeader(structs: ParsedStruct[]): string {
+    return `#pragma once\n\n#include <cstddef>\n\n` + this.generatePropertyKeyEnum(this.propertyKeyNames(structs));
+  }
+
+  /**
+   * Уникальные имена полей всех структур в порядке объявления
+   */
+  private propertyKeyNames(structs: ParsedStruct[]): string[] {
+    const names: string[] = [];
+    for (const struct of structs) {
+      for (const field of struct.fields) {
+        if (!names.includes(field.name)) {
+          names.push(field.name);
+        }
+      }
+    }
+    if (structs.some(s => s.isColumnar)) {
+      // Служебные свойства колоночного объекта <Name>Columns
+      names.push(...['length', 'strings'].filter(name => !names.includes(name)));
+    }
+    return names;
+  }
+
+  /**
+   * enum PropertyKey: индекс ключа каждого имени и kPropertyKeyCount
+   */
+  private generatePropertyKeyEnum(names: string[]): string {
+    let code = `// Индексы кэшированных ключей свойств в tscb::EnvData\n`;
+    code += `enum PropertyKey : size_t {\n`;
+    for (const name of names) {
+      code += `    ${this.propertyKeyConstant(name)},\n`;
+    }
+    code += `    kPropertyKeyCount\n`;
+    code += `};\n`;
+    return code;
+  }
+
+  /**
+   * Генерирует реализацию структур
+   */
+  private generateStructsImpl(structs: ParsedStruct[], enums: ParsedEnum[], outputDir: string): void {
+    const template = fs.readFileSync(
+      path.join(__dirname, 'templates', 'structs.cpp.template'), 
+      'utf-8'
+    );
+
+    if (this.splitStructs) {
+      // Структура в своей единице трансляции: правка одной @CppStruct пересобирает только ее файл
+      this.writeOutput(path.join(outputDir, 'generated_property_keys.hpp'), this.generatePropertyKeysHeader(structs));
+      for (const struct of structs) {
+        const content = `#include "${this.structFileName(struct.name, 'hpp')}"\n#include "generated_property_keys.hpp"\n` +
+          this.generateStructImpl(struct, enums);
+        this.writeOutput(path.join(outputDir, this.structFileName(struct.name, 'cpp')), content);
+      }
+    }
+
+    let implementations = this.splitStructs ? `#include "generated_property_keys.hpp"\n` : '';
+    implementations += this.generatePropertyKeys(structs, !this.splitStructs);
+    if (!this.splitStructs) {
+      for (const struct of structs) {
+        implementations += this.generateStructImpl(struct, enums);
+      }
+    }
+
+    implementations += this.generateViewClasses(structs, enums);
+
+    const output = template.replace('{{STRUCT_IMPLEMENTATIONS}}', implementations);
+    
+    this.writeOutput(path.join(outputDir, 'generated_structs.cpp'), output);
+  }
+
+  /**
+   * FromNapi структуры; into - вариант FromNapi(obj, result) для переиспользуемых объектов:
+   * строки читаются в существующий буфер, вложенные структуры разбираются на месте
+   */
+  private generateFromNapi(struct: ParsedStruct, enums: ParsedEnum[], into: boolean): string {
+    let implementations = '';
+    const arena = !!struct.isArena;
+    if (into) {
+      // Разбор в переиспользуемый объект (@CppAsync({ recycle })): сброс присваиванием сохраняет емкость
+      implementations += `\nvoid ${struct.name}::FromNapi(const Napi::Object& obj, ${struct.name}& result) {\n`;
+    } else if (arena) {
+      implementations += `\n${struct.name} ${struct.name}::FromNapi(const Napi::Object& obj, const allocator_type& alloc) {\n`;
+    } else {
+      implementations += `\n${struct.name} ${struct.name}::FromNapi(const Napi::Object& obj) {\n`;
+    }
+    if (struct.isView) {
+      // Ранее возвращенный view: значение уже в C++, поля не разбираем
+      implementations += `    if (${struct.name}View* view = ${struct.name}View::TryUnwrap(obj)) {\n`;
+      implementations += into ? `        result = view->Value();\n        return;\n` : `        return view->Value();\n`;
+      implementations += `    }\n`;
+    }
+    if (into) {
+      implementations += `    result = tscb::DefaultValue<${struct.name}>();\n`;
+    } else {
+      implementations += arena ? `    ${struct.name} result(alloc);\n` : `    ${struct.name} result;\n`;
+    }
+    if (struct.fields.length > 0) {
+      implementations += `    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());\n`;
+      implementations += `    Napi::Value field;\n`;
+    }
+    implementations += `    \n`;
+    implementations += `    try {\n`;
+    
+    for (const field of struct.fields) {
+      const sanitizedName = this.sanitizeFieldName(field.name);
+      // Один Get по кэшированному ключу вместо Has + Get
+      implementations += `        field = obj.Get(tscbEnv.Key(${this.propertyKeyConstant(field.name)}));\n`;
+      
+      const columnar = this.columnarElement(field);
+      if (columnar) {
+        // Массив объектов или колоночный объект { length, <поле>: TypedArray, strings }
+        implementations += `        if (!field.IsUndefined()) {\n`;
+        implementations += `            result.${sanitizedName} = ${columnar}Columns::FromNapi(field);\n`;
+        implementations += `        }\n`;
+      } else if (field.isTypedArray) {
+        // TypedArray: одно копирование через memcpy или представление без копирования
+        implementations += `        if (!field.IsUndefined()) {\n`;
+        if (field.isView) {
+          implementations += `            result.${sanitizedName} = tscb::ViewTypedArray<${field.typedArrayElementType}>(field);\n`;
+        } else {
+          implementations += `            tscb::ReadTypedArray<${field.typedArrayElementType}>(field, result.${sanitizedName});\n`;
+        }
+        implementations += `        }\n`;
+      } else if (field.isArray && this.isBulkNumberArray(field)) {
+        // number[]: длинный массив копируется одним TypedArray.prototype.set, короткий - поэлементно
+        implementations += `        if (field.IsArray()) {\n`;
+        implementations += `            tscb::ReadTypedArray<${field.arrayElementType}>(field, result.${sanitizedName});\n`;
+        implementations += `        }\n`;
+      } else if (field.isArray) {
+        implementations += `        if (field.IsArray()) {\n`;
+        implementations += `            Napi::Array arr = field.As<Napi::Array>();\n`;
+        implementations += `            const uint32_t length = arr.Length();\n`;
+        implementations += `            result.${sanitizedName}.reserve(length);\n`;
+        implementations += `            for (uint32_t i = 0; i < length; i++) {\n`;
+        
+        // Проверяем тип элементов массива
+        const arrayElementType = field.arrayElementType || field.type.replace('std::vector<', '').replace('>', '');
+        
+        if (arrayElementType === 'std::string' && arena) {
+          // Строка создается аллокатором вектора и заполняется без временной std::string
+          implementations += `                result.${sanitizedName}.emplace_back();\n`;
+          implementations += `                tscb::ReadString(arr.Get(i), result.${sanitizedName}.back());\n`;
+        } else if (arena && this.arenaStructNames.has(arrayElementType)) {
+          implementations += `                result.${sanitizedName}.push_back(${arrayElementType}::FromNapi(arr.Get(i).As<Napi::Object>(), alloc));\n`;
+        } else if (arrayElementType === 'std::string') {
+          implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::String>().Utf8Value());\n`;
+        } else if (this.isStructType(arrayElementType, enums)) {
+          // Массив структур
+          implementations += `                result.${sanitizedName}.push_back(${arrayElementType}::FromNapi(arr.Get(i).As<Napi::Object>()));\n`;
+        } else if (isPreciseNumericType(this.containerElementTypes(field.tsType)[0])) {
+          // Массив семантических числовых типов
+          implementations += `                result.${sanitizedName}.push_back(${this.preciseNumberRead(this.containerElementTypes(field.tsType)[0], 'arr.Get(i)')});\n`;
+        } else if (arrayElementType === 'int' || arrayElementType.includes('int')) {
+          implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::Number>().Int32Value());\n`;
+        } else if (arrayElementType === 'bool') {
+          implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::Boolean>().Value());\n`;
+        } else {
+          // По умолчанию для чисел
+          implementations += `                result.${sanitizedName}.push_back(arr.Get(i).As<Napi::Number>().DoubleValue());\n`;
+        }
+        
+        implementations += `            }\n`;
+        implementations += `        }\n`;
+      } else if (field.isSet) {
+        // Проверяем тип элементов Set
+        const setElementType = field.setElementType || field.type.replace('std::unordered_set<', '').replace('>', '');
+        const numeric = this.isNumberCppType(setElementType);
+        
+        if (numeric) {
+          implementations += `        if (field.IsArray()) {\n`;
+          implementations += `            Napi::Array arr = field.As<Napi::Array>();\n`;
+        } else {
+          // JS Set приходит одним плоским массивом элементов
+          implementations += `        if (field.IsArray() || tscb::IsInstanceOf(field, "Set")) {\n`;
+          implementations += `            Napi::Array arr = field.IsArray() ? field.As<Napi::Array>() : tscb::FlattenContainer(field, false).As<Napi::Array>();\n`;
+        }
+        implementations += `            const uint32_t length = arr.Length();\n`;
+        implementations += `            result.${sanitizedName}.reserve(length);\n`;
+        implementations += `            for (uint32_t i = 0; i < length; i++) {\n`;
+        
+        if (setElementType === 'std::string') {
+          implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::String>().Utf8Value());\n`;
+        } else if (this.isStructType(setElementType, enums)) {
+          // Set структур
+          implementations += `                result.${sanitizedName}.insert(${setElementType}::FromNapi(arr.Get(i).As<Napi::Object>()));\n`;
+        } else if (isPreciseNumericType(this.containerElementTypes(field.tsType)[0])) {
+          // Set семантических числовых типов
+          implementations += `                result.${sanitizedName}.insert(${this.preciseNumberRead(this.containerElementTypes(field.tsType)[0], 'arr.Get(i)')});\n`;
+        } else if (setElementType === 'int' || setElementType.includes('int')) {
+          implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::Number>().Int32Value());\n`;
+        } else if (setElementType === 'bool') {
+          implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::Boolean>().Value());\n`;
+        } else {
+          // По умолчанию для чисел
+          implementations += `                result.${sanitizedName}.insert(arr.Get(i).As<Napi::Number>().DoubleValue());\n`;
+        }
+        
+        implementations += `            }\n`;
+        if (numeric) {
+          // JS Set чисел: reserve по size и чтение из Float64Array без N-API вызова на элемент
+          implementations += `        } else if (tscb::IsInstanceOf(field, "Set")) {\n`;
+          implementations += `            tscb::ReadNumericSet(field, result.${sanitizedName});\n`;
+        }
+        implementations += `        }\n`;
+      } else if (field.isMap) {
+        const target = `result.${sanitizedName}`;
+        // Обработка ключа: ключи обычного объекта - строки, ключи JS Map - сами значения
+        const keyType = field.mapKeyType || 'std::string';
+        const [keyTsType = '', valueTsType = ''] = this.containerElementTypes(field.tsType);
+        const keyExtraction = (number: string): string => {
+          if (keyType === 'std::string') {
+            return 'key.As<Napi::String>().Utf8Value()';
+          } else if (isPreciseNumericType(keyTsType)) {
+            return this.preciseNumberRead(keyTsType, number);
+          } else if (keyType === 'int' || keyType.includes('int')) {
+            return `${number}.Int32Value()`;
+          }
+          return `${number}.DoubleValue()`;
+        };
+        
+        // Обработка значения
+        const valueType = field.mapValueType || 'double';
+        let valueExtraction = '';
+        if (valueType === 'std::string') {
+          valueExtraction = 'value.As<Napi::String>().Utf8Value()';
+        } else if (this.isStructType(valueType, enums)) {
+          valueExtraction = `${valueType}::FromNapi(value.As<Napi::Object>())`;
+        } else if (isPreciseNumericType(valueTsType)) {
+          valueExtraction = this.preciseNumberRead(valueTsType, 'value');
+        } else if (valueType === 'int' || valueType.includes('int')) {
+          valueExtraction = 'value.As<Napi::Number>().Int32Value()';
+        } else if (valueType === 'bool') {
+          valueExtraction = 'value.As<Napi::Boolean>().Value()';
+        } else {
+          valueExtraction = 'value.As<Napi::Number>().DoubleValue()';
+        }
+        // flat_map заполняется без сортировки и упорядочивается один раз
+        const assign = (key: string) => field.isFlatMap
+          ? `                ${target}.append_unsorted(${key}, ${valueExtraction});\n`
+          : `                ${target}[${key}] = ${valueExtraction};\n`;
+        
+        implementations += `        if (tscb::IsInstanceOf(field, "Map")) {\n`;
+        if (this.isNumberCppType(keyType) && this.isNumberCppType(valueType)) {
+          // Map<number, number>: пары одним Float64Array
+          implementations += `            tscb::ReadNumericMap(field, ${target});\n`;
+        } else {
+          implementations += `            Napi::Array entries = tscb::FlattenContainer(field, false).As<Napi::Array>();\n`;
+          implementations += `            const uint32_t length = entries.Length();\n`;
+          implementations += `            ${target}.reserve(length / 2);\n`;
+          implementations += `            for (uint32_t i = 0; i + 1 < length; i += 2) {\n`;
+          implementations += `                Napi::Value key = entries.Get(i);\n`;
+          implementations += `                Napi::Value value = entries.Get(i + 1);\n`;
+          implementations += assign(keyExtraction('key.As<Napi::Number>()'));
+          implementations += `            }\n`;
+          if (field.isFlatMap) {
+            implementations += `            ${target}.sort_unique();\n`;
+          }
+        }
+        implementations += `        } else if (field.IsObject()) {\n`;
+        implementations += `            Napi::Object mapObj = field.As<Napi::Object>();\n`;
+        implementations += `            Napi::Array keys = mapObj.GetPropertyNames();\n`;
+        implementations += `            const uint32_t length = keys.Length();\n`;
+        implementations += `            ${target}.reserve(length);\n`;
+        implementations += `            for (uint32_t i = 0; i < length; i++) {\n`;
+        implementations += `                Napi::Value key = keys.Get(i);\n`;
+        implementations += `                Napi::Value value = mapObj.Get(key);\n`;
+        implementations += assign(keyExtraction('key.ToNumber()'));
+        implementations += `            }\n`;
+        if (field.isFlatMap) {
+          implementations += `            ${target}.sort_unique();\n`;
+        }
+        implementations += `        }\n`;
+      } else {
+        implementations += `        if (!field.IsUndefined()) {\n`;
+        
+        // Проверяем, является ли это структурой или enum
+        if (field.isInterned) {
+          implementations += `            tscb::ReadInterned(field, result.${sanitizedName});\n`;
+        } else if (field.isLatin1) {
+          implementations += `            tscb::ReadLatin1(field, result.${sanitizedName});\n`;
+        } else if ((arena || into) && field.type === 'std::string') {
+          implementations += `            tscb::ReadString(field, result.${sanitizedName});\n`;
+        } else if (arena && this.arenaStructNames.has(field.type)) {
+          implementations += `            result.${sanitizedName} = ${field.type}::FromNapi(field.As<Napi::Object>(), alloc);\n`;
+        } else if (into && this.recycleStructNames.has(field.type)) {
+          implementations += `            ${field.type}::FromNapi(field.As<Napi::Object>(), result.${sanitizedName});\n`;
+        } else if (this.isStructType(field.type, enums)) {
+          implementations += `            result.${sanitizedName} = ${field.type}::FromNapi(field.As<Napi::Object>());\n`;
+        } else if (this.isEnumType(field.type, enums)) {
+          // Для enum типов конвертируем из числа
+          implementations += `            result.${sanitizedName} = static_cast<${field.type}>(field.As<Napi::Number>().Int32Value());\n`;
+        } else {
+          // Используем функции из numeric-types для правильной генерации
+          const extractor = getNapiExtractor(field.tsType);
+          if (extractor !== '.As<Napi::Value>()') {
+            // Это известный тип, используем правильный экстрактор
+            if (isPreciseNumericType(field.tsType)) {
+              // Для семантических типов нужно кастовать к правильному C++ типу;
+              // i64/u64 ToNapi отдает числом, на входе принимаем и число, и BigInt
+              implementations += `            result.${sanitizedName} = ${this.preciseNumberRead(field.tsType, 'field')};\n`;
+            } else {
+              implementations += `            result.${sanitizedName} = field${extractor};\n`;
+            }
+          } else {
+            // Fallback для неизвестных типов
+            if (field.type === 'std::string') {
+              implementations += `            result.${sanitizedName} = field.As<Napi::String>().Utf8Value();\n`;
+            } else if (field.type === 'int') {
+              implementations += `            result.${sanitizedName} = field.As<Napi::Number>().Int32Value();\n`;
+            } else if (field.type === 'bool') {
+              implementations += `            result.${sanitizedName} = field.As<Napi::Boolean>().Value();\n`;
+            }
+          }
+        }
+        
+        implementations += `        }\n`;
+      }
+    }
+    
+    implementations += `    } catch (const std::exception& e) {\n`;
+    implementations += `        throw std::runtime_error(std::string("Failed to parse ${struct.name}: ") + e.what());\n`;
+    implementations += `    }\n`;
+    if (!into) {
+      implementations += `    \n`;
+      implementations += `    return result;\n`;
+    }
+    implementations += `}\n`;
+    return implementations;
+  }
+
+  /**
+   * FromNapi/ToNapi структуры, бинарный кодек и Hash() при необходимости
+   */
+  private generateStructImpl(struct: ParsedStruct, enums: ParsedEnum[]): string {
+    let implementations = '';
+    const arena = !!struct.isArena;
+    if (arena) {
+      implementations += this.generateArenaConstructors(struct);
+    }
+
+    // FromNapi метод
+    implementations += this.generateFromNapi(struct, enums, false);
+    if (this.recycleStructNames.has(struct.name)) {
+      implementations += this.generateFromNapi(struct, enums, true);
+    }
+
+    // ToNapi метод (для view-структур полная конвертация называется ToObject)
+    if (struct.isView) {
+      implementations += `\nNapi::Object ${struct.name}::ToNapi(Napi::Env env) const {\n`;
+      implementations += `    return ${struct.name}View::New(env, *this);\n`;
+      implementations += `}\n`;
+    }
+    implementations += `\nNapi::Object ${struct.name}::${struct.isView ? 'ToObject' : 'ToNapi'}(Napi::Env env) const {\n`;
+    if (struct.fields.length > 0) {
+      implementations += `    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(env);\n`;
+    }
+    implementations += `    Napi::Object obj = Napi::Object::New(env);\n`;
+    
+    for (const field of struct.fields) {
+      const sanitizedName = this.sanitizeFieldName(field.name);
+      const encoded = this.encodeField(field, enums, sanitizedName, sanitizedName, arena);
+      implementations += encoded.code;
+      if (encoded.value) {
+        implementations += `    obj.Set(tscbEnv.Key(${this.propertyKeyConstant(field.name)}), ${encoded.value});\n`;
+      }
+    }
+    
+    implementations += `    return obj;\n`;
+    implementations += `}\n`;
+
+    if (this.wireStructNames.has(struct.name)) {
+      implementations += this.generateWireCodec(struct, enums);
+    }
+    if (this.hashStructNames.has(struct.name)) {
+      implementations += this.generateHashFunctions(struct);
+    }
+    implementations += this.generateHeapBytes(struct);
+    if (struct.isColumnar) {
+      implementations += this.generateColumnsImpl(struct);
+    }
+    if (this.tryDecodeStructNames.has(struct.name)) {
+      implementations += this.generateTryFromNapi(struct, enums);
+    }
+    return implementations;
+  }
+
+  /**
+   * Чтение уточняемого числа: целые до 32 бит приводятся по модулю, как ToInt32/ToUint32 в JS,
+   * i64/u64 читает tscb::ReadInt64 с проверкой диапазона
+   */
+  private preciseNumberRead(tsType: string, value: string): string {
+    if (tsType === 'i64' || tsType === 'u64') {
+      return `tscb::ReadInt64<${getCppType(tsType)}>(${value})`;
+    }
+    return `static_cast<${getCppType(tsType)}>(${value}${getNapiExtractor(tsType)})`;
+  }
+
+  /**
+   * TS типы элементов контейнера: i64[] -> [i64], Set<u8> -> [u8], Map<string, u8> -> [string, u8]
+   */
+  private containerElementTypes(tsType: string): string[] {
+    const inner = tsType.endsWith('[]') ? tsType.slice(0, -2) : tsType.replace(/^(?:Array|Set|Map)<(.*)>$/, '$1');
+    return inner.split(',').map(type => type.trim());
+  }
+
+  /**
+   * TryFromNapi: проверки типов вместо As<...> и исключений; undefined оставляет значение по умолчанию
+   */
+  private generateTryFromNapi(struct: ParsedStruct, enums: ParsedEnum[]): string {
+    let code = `\nbool ${struct.name}::TryFromNapi(const Napi::Value& value, ${struct.name}& out) {\n`;
+    code += `    if (!value.IsObject()) {\n`;
+    code += `        return tscb::FieldTypeError(value.Env(), "${struct.name}", "an object");\n`;
+    code += `    }\n`;
+    if (struct.fields.length > 0) {
+      code += `    Napi::Object obj = value.As<Napi::Object>();\n`;
+      code += `    const tscb::EnvData& tscbEnv = tscb::EnvData::Get(obj.Env());\n`;
+      code += `    Napi::Value field;\n`;
+    }
+    for (const field of struct.fields) {
+      const member = `out.${this.sanitizeFieldName(field.name)}`;
+      code += `    field = obj.Get(tscbEnv.Key(${this.propertyKeyConstant(field.name)}));\n`;
+      if (this.isStructType(field.type, enums)) {
+        code += `    if (!field.IsUndefined() && !${field.type}::TryFromNapi(field, ${member})) {\n`;
+      } else if (field.isLatin1) {
+        code += `    if (!tscb::TryReadLatin1(field, ${member}, "${struct.name}.${field.name}")) {\n`;
+      } else {
+        code += `    if (!tscb::TryReadField(field, ${member}, "${struct.name}.${field.name}")) {\n`;
+      }
+      code += `        return false;\n`;
+      code += `    }\n`;
+    }
+    code += `    return true;\n`;
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * Конструкторы arena-структуры с аллокатором: pmr поля и вложенные arena-структуры
+   * получают alloc, остальные поля копируются или перемещаются как обычно
+   */
+  private generateArenaConstructors(struct: ParsedStruct): string {
+    const fields = struct.fields.map(field => ({ name: this.sanitizeFieldName(field.name), alloc: this.isAllocatorField(field, true) }));
+    const allocInits = fields.filter(f => f.alloc).map(f => `${f.name}(alloc)`);
+    const copyInits = fields.map(f => f.alloc ? `${f.name}(other.${f.name}, alloc)` : `${f.name}(other.${f.name})`);
+    const moveInits = fields.map(f => f.alloc ? `${f.name}(std::move(other.${f.name}), alloc)` : `${f.name}(std::move(other.${f.name}))`);
+    const list = (inits: string[]) => inits.length > 0 ? `\n    : ${inits.join(',\n      ')} ` : ' ';
+    let code = `\n${struct.name}::${struct.name}(const allocator_type& alloc)${list(allocInits)}{\n`;
+    code += allocInits.length > 0 ? `}\n` : `    (void)alloc;\n}\n`;
+    code += `\n${struct.name}::${struct.name}(const ${struct.name}& other, const allocator_type& alloc)${list(copyInits)}{\n`;
+    code += allocInits.length > 0 ? `}\n` : `    (void)alloc;\n}\n`;
+    code += `\n${struct.name}::${struct.name}(${struct.name}&& other, const allocator_type& alloc)${list(moveInits)}{\n`;
+    code += allocInits.length > 0 ? `}\n` : `    (void)alloc;\n}\n`;
+    return code;
+  }
+
+  /**
+   * Метод TS кодека (WireWriter/WireReader) и размер для числового C++ типа; null - не число
+   */
+  private wireScalar(cppType: string, enums: ParsedEnum[]): { method: string; size: number } | null {
+    const scalars: { [key: string]: { method: string; size: number } } = {
+      'bool': { method: 'bool', size: 1 },
+      'int8_t': { method: 'i8', size: 1 },
+      'uint8_t': { method: 'u8', size: 1 },
+      'int16_t': { method: 'i16', size: 2 },
+      'uint16_t': { method: 'u16', size: 2 },
+      'int': { method: 'i32', size: 4 },
+      'int32_t': { method: 'i32', size: 4 },
+      'uint32_t': { method: 'u32', size: 4 },
+      'float': { method: 'f32', size: 4 },
+      'int64_t': { method: 'i64', size: 8 },
+      'uint64_t': { method: 'u64', size: 8 },
+      'double': { method: 'f64', size: 8 }
+    };
+    if (scalars[cppType]) {
+      return scalars[cppType];
+    }
+    // enum class : uint32_t
+    return this.isEnumType(cppType, enums) ? { method: 'u32', size: 4 } : null;
+  }
+
+  /**
+   * Генерирует <Name>::WireDecode/WireEncode: числовые поля - блок с фиксированными
+   * смещениями и одной проверкой границ, остальные - по порядку через tscb::WireRead/WireWrite
+   */
+  private generateWireCodec(struct: ParsedStruct, enums: ParsedEnum[]): string {
+    const fixed: { member: string; offset: number; isBool: boolean }[] = [];
+    const variable: string[] = [];
+    let fixedSize = 0;
+    for (const field of struct.fields) {
+      const member = this.sanitizeFieldName(field.name);
+      const scalar = field.isTypedArray ? null : this.wireScalar(this.fieldCppType(field), enums);
+      if (scalar) {
+        fixed.push({ member, offset: fixedSize, isBool: scalar.method === 'bool' });
+        fixedSize += scalar.size;
+      } else {
+        variable.push(member);
+      }
+    }
+
+    let code = `\n${struct.name} ${struct.name}::WireDecode(tscb::WireReader& r) {\n`;
+    code += `    ${struct.name} result;\n`;
+    if (fixedSize > 0) {
+      code += `    const uint8_t* fixed = r.Take(${fixedSize});\n`;
+      for (const f of fixed) {
+        code += f.isBool
+          ? `    result.${f.member} = fixed[${f.offset}] != 0;\n`
+          : `    std::memcpy(&result.${f.member}, fixed + ${f.offset}, sizeof(result.${f.member}));\n`;
+      }
+    }
+    for (const member of variable) {
+      code += `    tscb::WireRead(r, result.${member});\n`;
+    }
+    code += `    return result;\n`;
+    code += `}\n`;
+
+    code += `\nvoid ${struct.name}::WireEncode(tscb::WireWriter& w) const {\n`;
+    if (fixedSize > 0) {
+      code += `    uint8_t* fixed = w.Grow(${fixedSize});\n`;
+      for (const f of fixed) {
+        code += f.isBool
+          ? `    fixed[${f.offset}] = ${f.member} ? 1 : 0;\n`
+          : `    std::memcpy(fixed + ${f.offset}, &${f.member}, sizeof(${f.member}));\n`;
+      }
+    }
+    for (const member of variable) {
+      code += `    tscb::WireWrite(w, ${member});\n`;
+    }
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * HeapBytes() по всем полям: память строк, векторов и коллекций вне sizeof структуры
+   */
+  private generateHeapBytes(struct: ParsedStruct): string {
+    const members = struct.fields.map(field => this.sanitizeFieldName(field.name));
+    let code = `\nstd::size_t ${struct.name}::HeapBytes() const {\n`;
+    code += members.length > 0
+      ? `    return ${members.map(m => `tscb::HeapBytes(${m})`).join(' +\n        ')};\n`
+      : `    return 0;\n`;
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * Hash() и operator== по всем полям: ключ кэша результатов
+   */
+  private generateHashFunctions(struct: ParsedStruct): string {
+    const members = struct.fields.map(field => this.sanitizeFieldName(field.name));
+    let code = `\nstd::size_t ${struct.name}::Hash() const {\n`;
+    code += `    std::size_t seed = 0;\n`;
+    for (const member of members) {
+      code += `    tscb::HashCombine(seed, tscb::HashValue(${member}));\n`;
+    }
+    code += `    return seed;\n`;
+    code += `}\n`;
+
+    code += `\nbool ${struct.name}::operator==(const ${struct.name}& other) const {\n`;
+    code += members.length > 0
+      ? `    return ${members.map(m => `${m} == other.${m}`).join(' &&\n        ')};\n`
+      : `    return true;\n`;
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * Объявление класса ленивого view для @CppStruct({ view: true })
+   */
+  private generateViewClassDeclaration(struct: ParsedStruct, enums: ParsedEnum[]): string {
+    const view = `${struct.name}View`;
+    let code = `\n// Ленивое представление ${struct.name}: значение остается в C++,\n`;
+    code += `// поле конвертируется в JS при первом обращении\n`;
+    code += `class ${view} : public Napi::ObjectWrap<${view}> {\n`;
+    code += `public:\n`;
+    code += `    static void Init(Napi::Env env);\n`;
+    code += `    static Napi::Object New(Napi::Env env, ${struct.name} value);\n`;
+    code += `    static ${view}* TryUnwrap(const Napi::Object& obj);\n`;
+    code += `    explicit ${view}(const Napi::CallbackInfo& info);\n`;
+    code += `    ~${view}() override;\n`;
+    code += `    const ${struct.name}& Value() const { return value_; }\n`;
+    code += `\n`;
+    code += `private:\n`;
+    for (const field of struct.fields) {
+      code += `    Napi::Value Get_${this.sanitizeFieldName(field.name)}(const Napi::CallbackInfo& info);\n`;
+    }
+    code += `    Napi::Value ToJSON(const Napi::CallbackInfo& info);\n`;
+    code += `\n`;
+    code += `    ${struct.name} value_;\n`;
+    // Размер value_, сообщенный V8: память освобождается вместе с JS объектом
+    code += `    tscb::ExternalMemory memory_{tscb::memory::kViews};\n`;
+    const cached = struct.fields.filter(f => this.isObjectValuedField(f, enums));
+    if (cached.length > 0) {
+      // Объектные поля кэшируются, чтобы view.items === view.items
+      code += `    Napi::ObjectReference cache_[${cached.length}];\n`;
+      // Объектное поле отдано в JS и могло быть изменено: Value() больше не совпадает с объектом
+      code += `    bool exposed_ = false;\n`;
+    }
+    code += `};\n`;
+    return code;
+  }
+
+  /**
+   * Поле конвертируется в JS объект (массив, Map, TypedArray, структура)
+   */
+  private isObjectValuedField(field: ParsedField, enums: ParsedEnum[]): boolean {
+    return !!(field.isTypedArray || field.isArray || field.isSet || field.isMap) || this.isStructType(field.type, enums);
+  }
+
+  /**
+   * Реализации классов ленивых view и InitStructViews()
+   */
+  private generateViewClasses(structs: ParsedStruct[], enums: ParsedEnum[]): string {
+    const views = structs.filter(s => s.isView);
+    if (views.length === 0) {
+      return '';
+    }
+
+    let code = `\nnamespace {\n`;
+    code += `// Индексы конструкторов view в tscb::EnvData\n`;
+    code += `enum ViewClass : size_t {\n`;
+    for (const struct of views) {
+      code += `    kView_${struct.name},\n`;
+    }
+    code += `};\n`;
+    code += `} // namespace\n`;
+
+    for (const struct of views) {
+      const view = `${struct.name}View`;
+      const objectFields = struct.fields.filter(f => this.isObjectValuedField(f, enums));
+
+      code += `\nvoid ${view}::Init(Napi::Env env) {\n`;
+      code += `    Napi::Function ctor = DefineClass(env, "${view}", {\n`;
+      for (const field of struct.fields) {
+        code += `        InstanceAccessor("${field.name}", &${view}::Get_${this.sanitizeFieldName(field.name)}, nullptr, napi_enumerable),\n`;
+      }
+      code += `        InstanceMethod("toJSON", &${view}::ToJSON),\n`;
+      code += `    });\n`;
+      code += `    tscb::EnvData::Get(env).SetConstructor(kView_${struct.name}, ctor);\n`;
+      code += `}\n`;
+
+      code += `\nNapi::Object ${view}::New(Napi::Env env, ${struct.name} value) {\n`;
+      code += `    Napi::Object obj = tscb::EnvData::Get(env).Constructor(kView_${struct.name}).New({});\n`;
+      code += `    ${view}* self = Unwrap(obj);\n`;
+      code += `    self->value_ = std::move(value);\n`;
+      code += `    self->memory_.Hold(env, tscb::NativeBytes(self->value_));\n`;
+      code += `    return obj;\n`;
+      code += `}\n`;
+
+      code += `\n${view}* ${view}::TryUnwrap(const Napi::Object& obj) {\n`;
+      code += `    Napi::Function ctor = tscb::EnvData::Get(obj.Env()).Constructor(kView_${struct.name});\n`;
+      if (objectFields.length > 0) {
+        // После выдачи массивов и структур view разбирается как обычный объект
+        code += `    if (!obj.InstanceOf(ctor)) {\n`;
+        code += `        return nullptr;\n`;
+        code += `    }\n`;
+        code += `    ${view}* view = Unwrap(obj);\n`;
+        code += `    return view->exposed_ ? nullptr : view;\n`;
+      } else {
+        code += `    return obj.InstanceOf(ctor) ? Unwrap(obj) : nullptr;\n`;
+      }
+      code += `}\n`;
+
+      code += `\n${view}::${view}(const Napi::CallbackInfo& info) : Napi::ObjectWrap<${view}>(info) {}\n`;
+
+      code += `\n${view}::~${view}() {\n`;
+      code += `    memory_.Release(Env());\n`;
+      code += `}\n`;
+
+      for (const field of struct.fields) {
+        const sanitizedName = this.sanitizeFieldName(field.name);
+        const encoded = this.encodeField(field, enums, `value_.${sanitizedName}`, sanitizedName);
+        const cacheIndex = objectFields.indexOf(field);
+        code += `\nNapi::Value ${view}::Get_${sanitizedName}(const Napi::CallbackInfo& info) {\n`;
+        code += `    Napi::Env env = info.Env();\n`;
+        if (!encoded.value) {
+          code += `    return env.Undefined();\n`;
+          code += `}\n`;
+          continue;
+        }
+        if (cacheIndex >= 0) {
+          code += `    if (!cache_[${cacheIndex}].IsEmpty()) {\n`;
+          code += `        return cache_[${cacheIndex}].Value();\n`;
+          code += `    }\n`;
+        }
+        code += encoded.code;
+        if (cacheIndex >= 0) {
+          code += `    Napi::Object value = ${encoded.value};\n`;
+          code += `    cache_[${cacheIndex}] = Napi::Persistent(value);\n`;
+          code += `    exposed_ = true;\n`;
+          code += `    return value;\n`;
+        } else {
+          code += `    return ${encoded.value};\n`;
+        }
+        code += `}\n`;
+      }
+
+      code += `\nNapi::Value ${view}::ToJSON(const Napi::CallbackInfo& info) {\n`;
+      code += `    return value_.ToObject(info.Env());\n`;
+      code += `}\n`;
+    }
+
+    code += `\nvoid InitStructViews(Napi::Env env) {\n`;
+    for (const struct of views) {
+      code += `    ${struct.name}View::Init(env);\n`;
+    }
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * Код конвертации поля структуры в Napi::Value для ToNapi и ленивых view.
+   * member - выражение доступа к полю, code - подготовительные операторы,
+   * value - итоговое выражение (пустое, если тип не поддерживается).
+   */
+  private encodeField(field: ParsedField, enums: ParsedEnum[], member: string, varName: string, arena: boolean = false): { code: string; value: string } {
+    let code = '';
+    let value = '';
+    // std::pmr::string не приводится к std::string: создаем строку из data()/size()
+    const newString = (expr: string) => arena ? `tscb::NewString(env, ${expr})` : `Napi::String::New(env, ${expr})`;
+    if (this.columnarElement(field)) {
+      value = `${member}.ToNapi(env)`;
+    } else if (field.isTypedArray) {
+      const factory = field.isShared ? 'NewSharedTypedArray' : 'NewTypedArray';
+      value = `tscb::${factory}<${field.typedArrayElementType}>(env, ${member}.data(), ${member}.size())`;
+    } else if (field.isArray) {
+      // Создаем уникальное имя для каждого массива
+      const arrayVarName = `${varName}Arr`;
+      code += `    Napi::Array ${arrayVarName} = Napi::Array::New(env, ${member}.size());\n`;
+      code += `    for (size_t i = 0; i < ${member}.size(); i++) {\n`;
+      
+      // Проверяем тип элементов массива
+      const arrayElementType = field.arrayElementType || field.type.replace('std::vector<', '').replace('>', '');
+      
+      if (arrayElementType === 'std::string') {
+        code += `        ${arrayVarName}.Set(i, ${newString(`${member}[i]`)});\n`;
+      } else if (this.isStructType(arrayElementType, enums)) {
+        // Массив структур
+        code += `        ${arrayVarName}.Set(i, ${member}[i].ToNapi(env));\n`;
+      } else {
+        // Числовые типы
+        code += `        ${arrayVarName}.Set(i, Napi::Number::New(env, ${member}[i]));\n`;
+      }
+      
+      code += `    }\n`;
+      value = arrayVarName;
+    } else if (field.isSet) {
+      // Проверяем тип элементов Set
+      const setElementType = field.setElementType || field.type.replace('std::unordered_set<', '').replace('>', '');
+      
+      if (this.isNumberCppType(setElementType)) {
+        // Числа передаются конструктору Set одним Float64Array
+        value = `tscb::NewNumericSet(env, ${member})`;
+      } else {
+        // Создаем уникальное имя для каждого Set
+        const setVarName = `${varName}Arr`;
+        code += `    Napi::Array ${setVarName} = Napi::Array::New(env, ${member}.size());\n`;
+        code += `    size_t ${setVarName}Index = 0;\n`;
+        code += `    for (const auto& item : ${member}) {\n`;
+        
+        if (setElementType === 'std::string') {
+          code += `        ${setVarName}.Set(${setVarName}Index++, Napi::String::New(env, item));\n`;
+        } else if (this.isStructType(setElementType, enums)) {
+          // Set структур
+          code += `        ${setVarName}.Set(${setVarName}Index++, item.ToNapi(env));\n`;
+        } else if (setElementType === 'bool') {
+          code += `        ${setVarName}.Set(${setVarName}Index++, Napi::Boolean::New(env, item));\n`;
+        } else {
+          code += `        ${setVarName}.Set(${setVarName}Index++, Napi::Number::New(env, static_cast<double>(item)));\n`;
+        }
+        
+        code += `    }\n`;
+        value = `tscb::NewSet(env, ${setVarName})`;
+      }
+    } else if (field.isMap) {
+      const keyType = field.mapKeyType || 'std::string';
+      const valueType = field.mapValueType || 'double';
+      
+      if (this.isNumberCppType(keyType) && this.isNumberCppType(valueType)) {
+        // Map<number, number>: пары одним Float64Array
+        value = `tscb::NewNumericMap(env, ${member})`;
+      } else {
+        // Пары плоским массивом [k0, v0, ...], Map собирается в JS одним вызовом
+        const mapVarName = `${varName}Entries`;
+        code += `    Napi::Array ${mapVarName} = Napi::Array::New(env, ${member}.size() * 2);\n`;
+        code += `    uint32_t ${mapVarName}Index = 0;\n`;
+        code += `    for (const auto& pair : ${member}) {\n`;
+        
+        // Обработка ключа
+        let keyConversion = '';
+        if (keyType === 'std::string') {
+          keyConversion = 'Napi::String::New(env, pair.first)';
+        } else {
+          keyConversion = 'Napi::Number::New(env, pair.first)';
+        }
+        
+        // Обработка значения
+        let valueConversion = '';
+        if (valueType === 'std::string') {
+          valueConversion = 'Napi::String::New(env, pair.second)';
+        } else if (this.isStructType(valueType, enums)) {
+          valueConversion = 'pair.second.ToNapi(env)';
+        } else if (valueType === 'bool') {
+          valueConversion = 'Napi::Boolean::New(env, pair.second)';
+        } else {
+          valueConversion = 'Napi::Number::New(env, pair.second)';
+        }
+        
+        code += `        ${mapVarName}.Set(${mapVarName}Index++, ${keyConversion});\n`;
+        code += `        ${mapVarName}.Set(${mapVarName}Index++, ${valueConversion});\n`;
+        code += `    }\n`;
+        value = `tscb::NewMap(env, ${mapVarName})`;
+      }
+    } else {
+      // Проверяем, является ли это структурой или enum
+      if (this.isStructType(field.type, enums)) {
+        value = `${member}.ToNapi(env)`;
+      } else if (this.isEnumType(field.type, enums)) {
+        // Для enum типов конвертируем в число
+        value = `Napi::Number::New(env, static_cast<int>(${member}))`;
+      } else {
+        // Используем функции из numeric-types для правильной генерации
+        if (isPreciseNumericType(field.tsType)) {
+          // Для семантических типов нужно кастовать к правильному типу для N-API
+          value = `Napi::Number::New(env, static_cast<double>(${member}))`;
+        } else if (field.isInterned) {
+          value = `${member}.ToNapi(env)`;
+        } else if (field.isLatin1) {
+          value = `tscb::NewLatin1String(env, ${member})`;
+        } else if (field.type === 'std::string') {
+          value = newString(member);
+        } else if (field.type === 'int') {
+          value = `Napi::Number::New(env, ${member})`;
+        } else if (field.type === 'bool') {
+          value = `Napi::Boolean::New(env, ${member})`;
+        } else if (field.type === 'double' || field.type === 'float') {
+          value = `Napi::Number::New(env, ${member})`;
+        }
+      }
+    }
+
+    return { code, value };
+  }
+
+  /**
+   * Генерирует API wrapper
+   */
+  private generateApiWrapper(exports: ParsedExport[], classes: ParsedClass[], structs: ParsedStruct[], outputDir: string, extraInit?: string): void {
+    // Генерируем .cpp файл
+    const cppTemplate = fs.readFileSync(
+      path.join(__dirname, 'templates', 'api.cpp.template'), 
+      'utf-8'
+    );
+
+    // Генерируем .h файл
+    const hppTemplate = fs.readFileSync(
+      path.join(__dirname, 'templates', 'api.hpp.template'), 
+      'utf-8'
+    );
+
+    this.viewStructNames = new Set(structs.filter(s => s.isView).map(s => s.name));
+
+    let externDeclarations = '';
+    let wrapperFunctions = this.generateProfileSites(exports, classes);
+    let exportRegistrations = '    InitStructKeys(env);\n';
+    if (this.viewStructNames.size > 0) {
+      exportRegistrations += '    InitStructViews(env);\n';
+    }
+    exportRegistrations += '    tscb::profile::Configure(kProfileSiteNames, kProfileSiteCount);\n';
+    exportRegistrations += '    tscb::memory::Configure(kProfileSiteNames, kProfileSiteCount);\n';
+    // Функции экспортов создаются при первом обращении к свойству (tscb::DefineLazyExports)
+    const lazyExports: string[] = [];
+    const lazyExport = (name: string, callback: string) => lazyExports.push(`    { "${name}", ${callback} },\n`);
+
+    for (const exp of exports) {
+      // Extern объявления
+      externDeclarations += `extern ${this.functionSignature(exp, 'param')};\n`;
+      
+      if (exp.isStream) {
+        // Потоковый экспорт: без пакетного и бинарного вариантов
+        wrapperFunctions += this.generateStreamWrapper(exp, this.hasViewFields(exp.paramType, structs));
+        lazyExport(exp.name, `${exp.name}_wrapper`);
+        continue;
+      }
+
+      if (exp.isAsync) {
+        // Генерируем AsyncWorker для асинхронных функций
+        const ownViews = this.hasViewFields(exp.paramType, structs);
+        wrapperFunctions += exp.pool === 'native'
+          ? this.generatePoolWrapper(exp, ownViews)
+          : this.generateAsyncWrapper(exp, ownViews);
+      } else {
+        // Обычные синхронные wrapper функции
+        wrapperFunctions += this.generateSyncWrapper(exp);
+      }
+      
+      // Пакетный вариант: N входов за один переход JS → C++
+      if (this.hasBatch(exp)) {
+        wrapperFunctions += exp.isAsync
+          ? this.generateAsyncBatchWrapper(exp, this.hasViewFields(exp.paramType, structs))
+          : this.generateSyncBatchWrapper(exp);
+      }
+      
+      // Регистрация экспортов
+      lazyExport(exp.name, `${exp.name}_wrapper`);
+      if (this.hasBatch(exp)) {
+        lazyExport(`${exp.name}_batch`, `${exp.name}_batch_wrapper`);
+      }
+
+      // coalesce: пакет с результатом на каждый элемент, ошибка одного входа не задевает остальные
+      if (exp.isAsync && exp.coalesce) {
+        wrapperFunctions += this.generateAsyncBatchWrapper(exp, this.hasViewFields(exp.paramType, structs), true);
+        lazyExport(`${exp.name}_settle`, `${exp.name}_settle_wrapper`);
+      }
+
+      // Бинарный транспорт: вход и результат одним буфером
+      if (exp.transport === 'binary') {
+        wrapperFunctions += exp.isAsync ? this.generateAsyncWireWrapper(exp) : this.generateSyncWireWrapper(exp);
+        lazyExport(`${exp.name}_wire`, `${exp.name}_wire_wrapper`);
+      }
+
+      // Скалярный вход: поля структуры позиционными аргументами
+      const flatStruct = this.flatArgsStruct(exp, structs);
+      if (flatStruct) {
+        wrapperFunctions += this.generateFlatWrapper(exp, flatStruct);
+        lazyExport(`${exp.name}_flat`, `${exp.name}_flat_wrapper`);
+      }
+    }
+
+    // Нативные классы с состоянием (@CppClass)
+    for (const cls of classes) {
+      externDeclarations += `class ${cls.name};\n`;
+      externDeclarations += `extern ${this.classFactorySignature(cls, 'param')};\n`;
+      for (const method of cls.methods) {
+        externDeclarations += `extern ${this.functionSignature(method, 'param')};\n`;
+        wrapperFunctions += method.isAsync
+          ? this.generateAsyncWrapper(method, this.hasViewFields(method.paramType, structs))
+          : this.generateSyncWrapper(method);
+      }
+      wrapperFunctions += this.generateClassWrapper(cls);
+      exportRegistrations += `    ${cls.name}_Wrap::Init(env, exports);\n`;
+    }
+
+    // Токены отмены для @CppAsync({ cancellable: true })
+    if ([...exports, ...classes.flatMap(cls => cls.methods)].some(exp => exp.cancellable)) {
+      exportRegistrations += `    tscb::CancelHandle::Init(env, exports);\n`;
+    }
+
+    // Размер нативного пула: наибольший из заданных в @CppAsync({ poolSize })
+    const poolSize = Math.max(0, ...exports.map(e => e.poolSize || 0));
+    if (poolSize > 0) {
+      exportRegistrations += `    tscb::ThreadPool::Instance().Configure(${poolSize});\n`;
+    }
+    wrapperFunctions += this.generateInitPoolWrapper();
+    wrapperFunctions += this.generateBridgeStatsWrapper();
+    lazyExport('__bridgeStats', 'BridgeStats_wrapper');
+    lazyExport('__bridgeMemory', 'BridgeMemory_wrapper');
+    lazyExport('__initPool', 'InitPool_wrapper');
+    wrapperFunctions += `\n// Экспорты модуля: функция создается при первом обращении к свойству\n`;
+    wrapperFunctions += `static const tscb::LazyExport kLazyExports[] = {\n${lazyExports.join('')}};\n`;
+    exportRegistrations += `    tscb::DefineLazyExports(exports, kLazyExports, ${lazyExports.length});\n`;
+
+    // Дополнительные экспорты из другой единицы трансляции (например, бенчмарк)
+    if (extraInit) {
+      wrapperFunctions += `\nNapi::Object ${extraInit}(Napi::Env env, Napi::Object exports);\n`;
+      exportRegistrations += `    ${extraInit}(env, exports);\n`;
+    }
+
+    // Генерируем .cpp файл
+    let cppOutput = cppTemplate
+      .replace('{{EXTERN_DECLARATIONS}}', externDeclarations)
+      .replace('{{WRAPPER_FUNCTIONS}}', wrapperFunctions)
+      .replace('{{EXPORT_REGISTRATIONS}}', exportRegistrations);
+
+    this.writeOutput(path.join(outputDir, 'generated_api.cpp'), cppOutput);
+
+    // Генерируем .h файл
+    let hppOutput = hppTemplate
+      .replace('{{EXTERN_DECLARATIONS}}', externDeclarations);
+
+    this.writeOutput(path.join(outputDir, 'generated_api.h'), hppOutput);
+  }
+
+  /**
+   * Объявление C++ функции экспорта с учетом опции signature
+   */
+  private functionSignature(exp: ParsedExport, paramName: string): string {
+    // Методы @CppClass получают объект состояния первым аргументом
+    const params = exp.selfType ? [`${exp.selfType}& self`] : [];
+    if (exp.paramType !== 'void') {
+      params.push(exp.signature === 'move'
+        ? `${exp.paramType}&& ${paramName}`
+        : `const ${exp.paramType}& ${paramName}`);
+    }
+    if (exp.isStream) {
+      params.push(`tscb::StreamEmitter<${exp.returnType}>& emit`);
+      return `void ${exp.name}(${params.join(', ')})`;
+    }
+    if (exp.signature === 'out') {
+      params.push(`${exp.returnType}& result`);
+    }
+    if (exp.cancellable) {
+      params.push('const tscb::CancelToken& cancel');
+    }
+    const spec = exp.noexcept ? ' noexcept' : '';
+    if (exp.signature === 'out') {
+      return `void ${exp.name}(${params.join(', ')})${spec}`;
+    }
+    return `${exp.returnType} ${exp.name}(${params.join(', ')})${spec}`;
+  }
+
+  /**
+   * Строка вызова C++ функции экспорта: результат записывается в resultExpr.
+   * При declare результат объявляется как локальная переменная.
+   */
+  private callStatement(exp: ParsedExport, inputExpr: string, resultExpr: string, declare: boolean = false, selfExpr: string = 'self', cancelExpr: string = 'cancel_'): string {
+    const decl = declare ? `${exp.returnType} ` : '';
+    const args = exp.selfType ? [selfExpr] : [];
+    if (exp.paramType !== 'void') {
+      args.push(exp.signature === 'move' ? `std::move(${inputExpr})` : inputExpr);
+    }
+    if (exp.signature === 'out') {
+      args.push(resultExpr);
+    }
+    if (exp.cancellable) {
+      args.push(cancelExpr);
+    }
+    if (exp.signature === 'out') {
+      const call = `${exp.name}(${args.join(', ')});`;
+      return declare ? `${decl}${resultExpr};\n${call}` : call;
+    }
+    if (exp.returnType === 'void') {
+      return `${exp.name}(${args.join(', ')});`;
+    }
+    return `${decl}${resultExpr} = ${exp.name}(${args.join(', ')});`;
+  }
+
+  /**
+   * Кэш результатов экспорта с @CppExport({ cache }): LRU общий для процесса,
+   * таблица выполняющихся асинхронных вызовов - своя у потока каждого Napi::Env
+   */
+  private generateCacheAccessors(exp: ParsedExport): string {
+    const cache = exp.cache!;
+    let code = `\ntscb::ResultCache<${exp.paramType}, ${exp.returnType}>& ${exp.name}_cache() {\n`;
+    code += `    static tscb::ResultCache<${exp.paramType}, ${exp.returnType}> cache(${cache.maxEntries}, ${cache.ttlMs});\n`;
+    code += `    return cache;\n`;
+    code += `}\n`;
+    if (exp.isAsync) {
+      code += `\ntscb::InFlight<${exp.paramType}>& ${exp.name}_inflight() {\n`;
+      code += `    thread_local tscb::InFlight<${exp.paramType}> inflight;\n`;
+      code += `    return inflight;\n`;
+      code += `}\n`;
+    }
+    return code;
+  }
+
+  /**
+   * Поиск в кэше перед постановкой асинхронной задачи: попадание разрешает Promise сразу,
+   * вызов с тем же входом, который уже выполняется, добавляет Promise к его ожидающим.
+   * Иначе объявляет key - ключ новой задачи в таблице выполняющихся.
+   */
+  private cacheLookup(exp: ParsedExport): string {
+    let code = `    // Кэш результатов: попадание не доходит до пула, одинаковые входы ждут одну задачу\n`;
+    code += `    {\n`;
+    code += `        ${exp.returnType} cached{};\n`;
+    code += `        if (${exp.name}_cache().Get(input, cached)) {\n`;
+    code += `            Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);\n`;
+    code += `            deferred.Resolve(${this.resultToNapi(exp.returnType, 'cached', 'env')});\n`;
+    code += `            return deferred.Promise();\n`;
+    code += `        }\n`;
+    code += `    }\n`;
+    code += `    if (std::vector<Napi::Promise::Deferred>* waiters = ${exp.name}_inflight().Find(input)) {\n`;
+    code += `        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);\n`;
+    code += `        waiters->push_back(deferred);\n`;
+    code += `        return deferred.Promise();\n`;
+    code += `    }\n`;
+    code += `    const ${exp.paramType}* key = ${exp.name}_inflight().Start(input);\n`;
+    code += `    \n`;
+    return code;
+  }
+
+  /**
+   * Завершение асинхронной задачи с кэшем: результат сохраняется в LRU,
+   * каждый ожидающий получает собственный JS объект
+   */
+  private cacheResolve(exp: ParsedExport, resultExpr: string, envExpr: string, spaces: number): string {
+    const pad = ' '.repeat(spaces);
+    // Результат view перемещается в первый view, ожидающим передаются копии
+    const value = this.viewStructNames.has(exp.returnType) ? `${exp.returnType}(${resultExpr})` : resultExpr;
+    let code = `${pad}${exp.name}_cache().Put(*key_, ${resultExpr});\n`;
+    code += `${pad}for (Napi::Promise::Deferred& waiter : ${exp.name}_inflight().Finish(key_)) {\n`;
+    code += `${pad}    waiter.Resolve(${this.resultToNapi(exp.returnType, value, envExpr)});\n`;
+    code += `${pad}}\n`;
+    return code;
+  }
+
+  /**
+   * Ошибка асинхронной задачи с кэшем передается всем ожидающим
+   */
+  private cacheReject(exp: ParsedExport, errorExpr: string, spaces: number): string {
+    const pad = ' '.repeat(spaces);
+    let code = `${pad}for (Napi::Promise::Deferred& waiter : ${exp.name}_inflight().Finish(key_)) {\n`;
+    code += `${pad}    waiter.Reject(${errorExpr});\n`;
+    code += `${pad}}\n`;
+    return code;
+  }
+
+  /**
+   * Вход разбирается в арену вызова: arena-структура и статический экспорт
+   * (методы @CppClass часто сохраняют вход в объекте, арену для них не используем)
+   */
+  private usesArena(exp: ParsedExport): boolean {
+    return !exp.selfType && this.arenaStructNames.has(exp.paramType);
+  }
+
+  /**
+   * Вход и результат задачи @CppAsync({ recycle }) и пул, в который они возвращаются
+   */
+  private generateRecycleSlot(exp: ParsedExport): string {
+    const slot = `${exp.name}_Slot`;
+    let code = `\n// Вход и результат ${exp.name}, переиспользуемые между вызовами\n`;
+    code += `struct ${slot} {\n`;
+    code += `    ${exp.paramType} input;\n`;
+    if (exp.returnType !== 'void') {
+      code += `    ${exp.returnType} result;\n`;
+    }
+    code += `};\n`;
+    code += `\ntscb::ObjectPool<${slot}>& ${exp.name}_pool() {\n`;
+    code += `    static tscb::ObjectPool<${slot}> pool(${exp.recycle!.maxFree});\n`;
+    code += `    return pool;\n`;
+    code += `}\n`;
+    return code;
+  }
+
+  /**
+   * Члены задачи с recycle: input_/result_ ссылаются на объект из пула
+   */
+  private recycledMembers(exp: ParsedExport): string {
+    let code = `    std::unique_ptr<${exp.name}_Slot> slot_;\n`;
+    code += `    ${exp.paramType}& input_ = slot_->input;\n`;
+    if (exp.returnType !== 'void') {
+      code += `    ${exp.returnType}& result_ = slot_->result;\n`;
+    }
+    return code;
+  }
+
+  /**
+   * Сброс результата из пула перед вызовом 'out': функция получает пустой Out с сохраненной емкостью
+   */
+  private recycledResultReset(exp: ParsedExport, resultExpr: string, spaces: number): string {
+    if (!exp.recycle || exp.returnType === 'void' || exp.signature !== 'out') {
+      return '';
+    }
+    return `${' '.repeat(spaces)}${resultExpr} = tscb::DefaultValue<${exp.returnType}>();\n`;
+  }
+
+  /**
+   * Разбор входа в объект из пула (@CppAsync({ recycle })): буферы прошлого вызова переиспользуются
+   */
+  private recycledInputDecode(exp: ParsedExport, site: string, ownViews: boolean): string {
+    let code = `    std::unique_ptr<${exp.name}_Slot> slot = ${exp.name}_pool().Acquire();\n`;
+    code += `    try {\n`;
+    code += this.ownedViewScope(ownViews, 8);
+    code += this.profiled(`        ${exp.paramType}::FromNapi(info[0].As<Napi::Object>(), slot->input);\n`, site, 'kDecode', 8);
+    code += `    } catch (const std::exception& e) {\n`;
+    code += `        ${exp.name}_pool().Release(std::move(slot));\n`;
+    code += `        Napi::TypeError::New(env, std::string("Failed to parse input: ") + e.what()).ThrowAsJavaScriptException();\n`;
+    code += `        return env.Null();\n`;
+    code += `    }\n`;
+    code += `    \n`;
+    return code;
+  }
+
+  /**
+   * Разбор входа асинхронного вызова в главном потоке; для arena-структур
+   * вход создается в арене, которая затем передается задаче
+   */
+  private arenaInputDecode(exp: ParsedExport, site: string, ownViews: boolean): string {
+    const arena = this.usesArena(exp);
+    let code = '';
+    if (arena) {
+      code += `    auto arena = std::make_unique<tscb::CallArena>();\n`;
+      code += `    ${exp.paramType} input(arena->Resource());\n`;
+    } else {
+      code += `    ${exp.paramType} input;\n`;
+    }
+    code += `    try {\n`;
+    code += this.ownedViewScope(ownViews, 8);
+    code += this.profiled(`        input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>()${arena ? ', arena->Resource()' : ''});\n`, site, 'kDecode', 8);
+    code += `    } catch (const std::exception& e) {\n`;
+    code += `        Napi::TypeError::New(env, std::string("Failed to parse input: ") + e.what()).ThrowAsJavaScriptException();\n`;
+    code += `        return env.Null();\n`;
+    code += `    }\n`;
+    code += `    \n`;
+    return code;
+  }
+
+  /**
+   * Чтение токена отмены (второй аргумент) для @CppAsync({ cancellable: true })
+   */
+  private cancelTokenDecode(): string {
+    let code = `    tscb::CancelToken cancel;\n`;
+    code += `    if (!tscb::CancelToken::FromNapi(info[1], cancel)) {\n`;
+    code += `        Napi::TypeError::New(env, "Expected a CancelToken").ThrowAsJavaScriptException();\n`;
+    code += `        return env.Null();\n`;
+    code += `    }\n`;
+    code += `    \n`;
+    return code;
+  }
+
+  /**
+   * Вызов C++ функции с проверкой токена до и после: задача, отмененная в очереди,
+   * не запускается, а результат отмененной задачи не возвращается
+   */
+  private cancellableCall(exp: ParsedExport, call: string, cancelExpr: string, spaces: number): string {
+    if (!exp.cancellable) {
+      return call;
+    }
+    const pad = ' '.repeat(spaces);
+    return `${pad}${cancelExpr}.ThrowIfCancelled();\n${call}${pad}${cancelExpr}.ThrowIfCancelled();\n`;
+  }
+
+  /**
+   * Добавляет отступ к каждой строке (для многострочных фрагментов)
+   */
+  private indent(code: string, spaces: number): string {
+    const pad = ' '.repeat(spaces);
+    return code.split('\n').map(line => pad + line).join('\n') + '\n';
+  }
+
+  /**
+   * Имя константы точки профилирования (TSCB_PROFILE) для экспорта
+   */
+  private profileSite(name: string): string {
+    return `kSite_${name}`;
+  }
+
+  /**
+   * Оборачивает фрагмент кода замером фазы (TSCB_PROFILE_START/STOP).
+   * Без define TSCB_PROFILE макросы раскрываются в пустые выражения.
+   */
+  private profiled(code: string, site: string, phase: string, spaces: number): string {
+    const pad = ' '.repeat(spaces);
+    const start = `${phase.slice(1, 2).toLowerCase()}${phase.slice(2)}Start`;
+    return `${pad}TSCB_PROFILE_START(${start});\n${code}${pad}TSCB_PROFILE_STOP(${start}, ${site}, ${phase});\n`;
+  }
+
+  /**
+   * Выражение конвертации результата C++ функции в Napi::Value
+   */
+  private resultToNapi(returnType: string, valueExpr: string, envExpr: string): string {
+    // Проверяем, является ли возвращаемый тип примитивным
+    const primitiveTypes = ['int', 'double', 'float', 'bool', 'int8_t', 'uint8_t', 'int16_t', 'uint16_t', 'int32_t', 'uint32_t', 'int64_t', 'uint64_t'];
+    if (primitiveTypes.includes(returnType)) {
+      // Для примитивных типов используем соответствующие Napi конструкторы
+      if (returnType === 'bool') {
+        return `Napi::Boolean::New(${envExpr}, ${valueExpr})`;
+      } else if (returnType === 'int64_t' || returnType === 'uint64_t') {
+        return `Napi::BigInt::New(${envExpr}, ${valueExpr})`;
+      }
+      return `Napi::Number::New(${envExpr}, static_cast<double>(${valueExpr}))`;
+    }
+    // Результат view-структуры перемещается в ленивый view без копирования
+    if (this.viewStructNames.has(returnType)) {
+      return `${returnType}View::New(${envExpr}, std::move(${valueExpr}))`;
+    }
+    // Для структур используем ToNapi метод
+    return `${valueExpr}.ToNapi(${envExpr})`;
+  }
+
+  /**
+   * Генерирует wrapper для @CppStream: вход конвертируется в главном потоке,
+   * производитель запускается через tscb::StartStream, в JS возвращается
+   * дескриптор с next()/return()
+   */
+  private generateStreamWrapper(exp: ParsedExport, ownViews: boolean = false): string {
+    const site = this.profileSite(exp.name);
+    const stream = `${exp.name}_Stream`;
+    const chunk = exp.returnType;
+    let wrapper = `\nclass ${stream} : public tscb::Stream<${chunk}> {\n`;
+    wrapper += `public:\n`;
+    wrapper += `    using tscb::Stream<${chunk}>::Stream;\n\n`;
+    wrapper += `protected:\n`;
+    wrapper += `    Napi::Value Convert(Napi::Env env, ${chunk}& chunk) override {\n`;
+    wrapper += this.profiled(`        Napi::Value output = ${this.resultToNapi(chunk, 'chunk', 'env')};\n`, site, 'kEncode', 8);
+    wrapper += `        return output;\n`;
+    wrapper += `    }\n`;
+    wrapper += `};\n`;
+
+    wrapper += `\nNapi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    if (exp.paramType !== 'void') {
+      wrapper += `    if (info.Length() < 1 || !info[0].IsObject()) {\n`;
+      wrapper += `        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+      wrapper += `    \n`;
+    }
+    wrapper += `    try {\n`;
+    const args: string[] = [];
+    if (exp.paramType !== 'void') {
+      wrapper += this.ownedViewScope(ownViews, 8);
+      wrapper += this.profiled(`        ${exp.paramType} input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>());\n`, site, 'kDecode', 8);
+      args.push(exp.signature === 'move' ? 'std::move(input)' : 'input');
+    }
+    args.push('emit');
+    const capture = exp.paramType !== 'void' ? 'input = std::move(input)' : '';
+    const mutableSpec = exp.signature === 'move' && exp.paramType !== 'void' ? ' mutable' : '';
+    wrapper += `        auto stream = std::make_shared<${stream}>(${exp.highWaterMark || 16});\n`;
+    wrapper += `        return tscb::StartStream<${chunk}>(env, stream, [${capture}](tscb::StreamEmitter<${chunk}>& emit)${mutableSpec} {\n`;
+    wrapper += this.profiled(`            ${exp.name}(${args.join(', ')});\n`, site, 'kExecute', 12);
+    wrapper += `        });\n`;
+    wrapper += `    } catch (const std::exception& e) {\n`;
+    wrapper += `        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n`;
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Генерирует синхронный wrapper для функции
+   */
+  private generateSyncWrapper(exp: ParsedExport): string {
+    if (exp.noexcept) {
+      return this.generateNoexceptWrapper(exp);
+    }
+    const site = this.profileSite(exp.name);
+    const selfParam = exp.selfType ? `, ${exp.selfType}& self` : '';
+    let wrapper = exp.cache ? this.generateCacheAccessors(exp) : '';
+    wrapper += `\nNapi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info${selfParam}) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    if (exp.paramType !== 'void') {
+      wrapper += `    if (info.Length() < 1 || !info[0].IsObject()) {\n`;
+      wrapper += `        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+      wrapper += `    \n`;
+    }
+    wrapper += `    try {\n`;
+    if (this.usesArena(exp)) {
+      // Арена освобождается при выходе из блока, после ToNapi
+      wrapper += `        tscb::CallArena arena;\n`;
+      wrapper += this.profiled(`        ${exp.paramType} input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>(), arena.Resource());\n`, site, 'kDecode', 8);
+    } else if (exp.paramType !== 'void') {
+      wrapper += this.profiled(`        ${exp.paramType} input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>());\n`, site, 'kDecode', 8);
+    }
+    wrapper += this.syncCallAndEncode(exp, 8);
+    wrapper += `    } catch (const std::exception& e) {\n`;
+    wrapper += `        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n`;
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Вход задачи в другом потоке: поля-представления копируются при разборе (tscb::OwnedViewScope)
+   */
+  private ownedViewScope(ownViews: boolean, spaces: number): string {
+    return ownViews ? `${' '.repeat(spaces)}tscb::OwnedViewScope ownViews;\n` : '';
+  }
+
+  /**
+   * Синхронный wrapper для @CppExport({ noexcept: true }): без try/catch, вход разбирается
+   * TryFromNapi, ошибка типа возвращается в JS как TypeError без C++ исключения
+   */
+  private generateNoexceptWrapper(exp: ParsedExport): string {
+    const site = this.profileSite(exp.name);
+    const selfParam = exp.selfType ? `, ${exp.selfType}& self` : '';
+    let wrapper = exp.cache ? this.generateCacheAccessors(exp) : '';
+    wrapper += `\nNapi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info${selfParam}) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    if (exp.paramType !== 'void') {
+      wrapper += `    ${exp.paramType} input;\n`;
+      wrapper += this.profiled(`    const bool decoded = ${exp.paramType}::TryFromNapi(info[0], input);\n`, site, 'kDecode', 4);
+      wrapper += `    if (!decoded) {\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+    }
+    wrapper += this.syncCallAndEncode(exp, 4);
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Вызов C++ функции синхронного wrapper'а (через кэш, если он включен) и конвертация результата
+   */
+  private syncCallAndEncode(exp: ParsedExport, spaces: number): string {
+    const site = this.profileSite(exp.name);
+    const pad = ' '.repeat(spaces);
+    let code = '';
+    if (exp.cache) {
+      code += `${pad}${exp.returnType} result{};\n`;
+      code += `${pad}if (!${exp.name}_cache().Get(input, result)) {\n`;
+      if (exp.signature === 'move') {
+        // Вход перемещается в функцию, ключ кэша копируется заранее
+        code += `${pad}    const ${exp.paramType} key = input;\n`;
+      }
+      code += this.profiled(this.indent(this.callStatement(exp, 'input', 'result'), spaces + 4), site, 'kExecute', spaces + 4);
+      code += `${pad}    ${exp.name}_cache().Put(${exp.signature === 'move' ? 'key' : 'input'}, result);\n`;
+      code += `${pad}}\n`;
+    } else {
+      code += this.profiled(this.indent(this.callStatement(exp, 'input', 'result', true), spaces), site, 'kExecute', spaces);
+    }
+    if (exp.returnType === 'void') {
+      code += `${pad}return env.Undefined();\n`;
+    } else {
+      code += this.profiled(`${pad}Napi::Value output = ${this.resultToNapi(exp.returnType, 'result', 'env')};\n`, site, 'kEncode', spaces);
+      code += `${pad}return output;\n`;
+    }
+    return code;
+  }
+
+  /**
+   * Вход синхронного экспорта, который передается позиционными аргументами (<name>_flat):
+   * структура только из чисел (кроме 64-битных целых), boolean и TypedArray
+   */
+  private flatArgsStruct(exp: ParsedExport, structs: ParsedStruct[]): ParsedStruct | undefined {
+    if (exp.isAsync || exp.isStream || exp.selfType) {
+      return undefined;
+    }
+    const struct = structs.find(s => s.name === exp.paramType);
+    if (!struct || struct.isView || struct.isArena || struct.fields.length === 0) {
+      return undefined;
+    }
+    const flat = struct.fields.every(field => {
+      if (field.isTypedArray) {
+        return true;
+      }
+      const cppType = this.fieldCppType(field);
+      return !field.isArray && !field.isSet && !field.isMap && cppType !== 'int64_t' && cppType !== 'uint64_t' &&
+        this.wireScalar(cppType, []) !== null;
+    });
+    return flat ? struct : undefined;
+  }
+
+  /**
+   * Wrapper <name>_flat: поля входа приходят позиционными аргументами, так что разбор -
+   * по одному вызову N-API на аргумент вместо Get по ключу для каждого поля объекта
+   */
+  private generateFlatWrapper(exp: ParsedExport, struct: ParsedStruct): string {
+    const site = this.profileSite(exp.name);
+    let wrapper = `\nNapi::Value ${exp.name}_flat_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    wrapper += `    ${exp.paramType} input;\n`;
+    wrapper += `    TSCB_PROFILE_START(decodeStart);\n`;
+    const scalars = struct.fields.map((field, index) => ({ field, index })).filter(arg => !arg.field.isTypedArray);
+    const typed = struct.fields.map((field, index) => ({ field, index })).filter(arg => arg.field.isTypedArray);
+    if (scalars.length > 0) {
+      const reads = scalars.map(arg =>
+        `tscb::TryReadField(info[${arg.index}], input.${this.sanitizeFieldName(arg.field.name)}, "${struct.name}.${arg.field.name}")`);
+      wrapper += `    const bool decoded = ${reads.join(' &&\n        ')};\n`;
+      wrapper += `    if (!decoded) {\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+    }
+    for (const { field, index } of typed) {
+      const member = `input.${this.sanitizeFieldName(field.name)}`;
+      const element = field.typedArrayElementType;
+      if (field.isView) {
+        wrapper += `    if (tscb::IsTypedArrayOf<${element}>(info[${index}])) {\n`;
+        wrapper += `        ${member} = tscb::ViewTypedArray<${element}>(info[${index}]);\n`;
+        wrapper += `    } else if (!info[${index}].IsUndefined()) {\n`;
+        wrapper += `        tscb::FieldTypeError(env, "${struct.name}.${field.name}", tscb::TypedArrayTraits<${element}>::name);\n`;
+        wrapper += `        return env.Null();\n`;
+        wrapper += `    }\n`;
+      } else {
+        // Кроме TypedArray принимается и массив чисел: разбор может бросить исключение
+        wrapper += `    if (!info[${index}].IsUndefined()) {\n`;
+        wrapper += `        try {\n`;
+        wrapper += `            tscb::ReadTypedArray<${element}>(info[${index}], ${member});\n`;
+        wrapper += `        } catch (const std::exception& e) {\n`;
+        wrapper += `            Napi::TypeError::New(env, std::string("Failed to parse ${struct.name}.${field.name}: ") + e.what()).ThrowAsJavaScriptException();\n`;
+        wrapper += `            return env.Null();\n`;
+        wrapper += `        }\n`;
+        wrapper += `    }\n`;
+      }
+    }
+    wrapper += `    TSCB_PROFILE_STOP(decodeStart, ${site}, kDecode);\n`;
+    if (exp.noexcept) {
+      wrapper += this.syncCallAndEncode(exp, 4);
+    } else {
+      wrapper += `    try {\n`;
+      wrapper += this.syncCallAndEncode(exp, 8);
+      wrapper += `    } catch (const std::exception& e) {\n`;
+      wrapper += `        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+    }
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Генерирует асинхронный wrapper для функции с Promise
+   */
+  private generateAsyncWrapper(exp: ParsedExport, ownViews: boolean = false): string {
+    const site = this.profileSite(exp.name);
+    let wrapper = '';
+    
+    if (exp.cache) {
+      wrapper += this.generateCacheAccessors(exp);
+    }
+    if (exp.recycle) {
+      wrapper += this.generateRecycleSlot(exp);
+    }
+
+    // Генерируем AsyncWorker класс
+    wrapper += `\n// AsyncWorker class for ${exp.name}\n`;
+    const hasInput = exp.paramType !== 'void';
+    const hasResult = exp.returnType !== 'void';
+    const ctorParams = ['Napi::Env env'];
+    const ctorInits = ['Napi::AsyncWorker(env)', 'deferred_(Napi::Promise::Deferred::New(env))'];
+    if (exp.selfType) {
+      // Worker разделяет владение объектом состояния: он живет до завершения задачи
+      ctorParams.push(`std::shared_ptr<${exp.selfType}> self`);
+      ctorInits.push('self_(std::move(self))');
+      // Вызовы одного экземпляра выполняются по очереди (tscb::InstanceQueue)
+      ctorParams.push('std::shared_ptr<tscb::InstanceQueue> queue');
+      ctorInits.push('queue_(std::move(queue))');
+    }
+    const arena = this.usesArena(exp);
+    if (arena) {
+      // Арена принадлежит worker и освобождается после OnOK
+      ctorParams.push('std::unique_ptr<tscb::CallArena> arena');
+      ctorInits.push('arena_(std::move(arena))');
+    }
+    if (exp.recycle) {
+      ctorParams.push(`std::unique_ptr<${exp.name}_Slot> slot`);
+      ctorInits.push('slot_(std::move(slot))');
+    } else if (hasInput) {
+      ctorParams.push(`${exp.paramType}&& input`);
+      ctorInits.push('input_(std::move(input))');
+    }
+    if (exp.cancellable) {
+      ctorParams.push('tscb::CancelToken cancel');
+      ctorInits.push('cancel_(std::move(cancel))');
+    }
+    if (exp.cache) {
+      ctorParams.push(`const ${exp.paramType}* key`);
+      ctorInits.push('key_(key)');
+    }
+    wrapper += `class ${exp.name}_AsyncWorker : public Napi::AsyncWorker {\n`;
+    wrapper += `public:\n`;
+    wrapper += `    ${exp.name}_AsyncWorker(${ctorParams.join(', ')})\n`;
+    if (hasInput) {
+      // Вход живет в нативной памяти до OnOK/OnError: сообщаем его размер V8
+      wrapper += `        : ${ctorInits.join(', ')} {\n`;
+      wrapper += `        memory_.Hold(env, tscb::NativeBytes(input_));\n`;
+      wrapper += `    }\n`;
+    } else {
+      wrapper += `        : ${ctorInits.join(', ')} {}\n`;
+    }
+    if (exp.recycle) {
+      // Worker удаляется в главном потоке после OnOK/OnError: вход и результат возвращаются в пул
+      wrapper += `    ~${exp.name}_AsyncWorker() {\n`;
+      wrapper += `        ${exp.name}_pool().Release(std::move(slot_));\n`;
+      wrapper += `    }\n\n`;
+    } else {
+      wrapper += `    ~${exp.name}_AsyncWorker() {}\n\n`;
+    }
+    wrapper += `    Napi::Promise Promise() const { return deferred_.Promise(); }\n\n`;
+    
+    wrapper += `    void Execute() override {\n`;
+    wrapper += `        tscb::profile::RecordWait(${site}, queued_);\n`;
+    wrapper += `        try {\n`;
+    wrapper += this.recycledResultReset(exp, 'result_', 12);
+    wrapper += this.cancellableCall(exp, this.profiled(this.indent(this.callStatement(exp, 'input_', 'result_', false, '*self_'), 12), site, 'kExecute', 12), 'cancel_', 12);
+    if (hasResult) {
+      wrapper += `            memory_.Add(tscb::NativeBytes(result_));\n`;
+    }
+    wrapper += `        } catch (const std::exception& e) {\n`;
+    wrapper += `            SetError(e.what());\n`;
+    wrapper += `        } catch (...) {\n`;
+    wrapper += `            SetError("Unknown error occurred");\n`;
+    wrapper += `        }\n`;
+    wrapper += `    }\n\n`;
+    
+    wrapper += `    void OnOK() override {\n`;
+    wrapper += `        Napi::HandleScope scope(Env());\n`;
+    wrapper += `        memory_.Release(Env());\n`;
+    if (exp.selfType) {
+      wrapper += `        queue_->Finish();\n`;
+    }
+    if (exp.cache) {
+      wrapper += this.cacheResolve(exp, 'result_', 'Env()', 8);
+    }
+    if (hasResult) {
+      wrapper += this.profiled(`        Napi::Value output = ${this.resultToNapi(exp.returnType, 'result_', 'Env()')};\n`, site, 'kEncode', 8);
+      wrapper += `        deferred_.Resolve(output);\n`;
+    } else {
+      wrapper += `        deferred_.Resolve(Env().Undefined());\n`;
+    }
+    wrapper += `    }\n\n`;
+    
+    wrapper += `    void OnError(const Napi::Error& error) override {\n`;
+    wrapper += `        Napi::HandleScope scope(Env());\n`;
+    wrapper += `        memory_.Release(Env());\n`;
+    if (exp.selfType) {
+      wrapper += `        queue_->Finish();\n`;
+    }
+    if (exp.cache) {
+      wrapper += this.cacheReject(exp, 'error.Value()', 8);
+    }
+    wrapper += `        deferred_.Reject(error.Value());\n`;
+    wrapper += `    }\n\n`;
+    
+    wrapper += `private:\n`;
+    wrapper += `    Napi::Promise::Deferred deferred_;\n`;
+    wrapper += `    tscb::ExternalMemory memory_{${site}};\n`;
+    if (exp.selfType) {
+      wrapper += `    std::shared_ptr<${exp.selfType}> self_;\n`;
+      wrapper += `    std::shared_ptr<tscb::InstanceQueue> queue_;\n`;
+    }
+    if (arena) {
+      // Объявлена до input_: уничтожается после него
+      wrapper += `    std::unique_ptr<tscb::CallArena> arena_;\n`;
+    }
+    if (exp.recycle) {
+      wrapper += this.recycledMembers(exp);
+    } else {
+      if (hasInput) {
+        wrapper += `    ${exp.paramType} input_;\n`;
+      }
+      if (hasResult) {
+        wrapper += `    ${exp.returnType} result_;\n`;
+      }
+    }
+    if (exp.cancellable) {
+      wrapper += `    tscb::CancelToken cancel_;\n`;
+    }
+    if (exp.cache) {
+      // Ключ в таблице выполняющихся вызовов (${exp.name}_inflight)
+      wrapper += `    const ${exp.paramType}* key_;\n`;
+    }
+    wrapper += `    tscb::profile::Stamp queued_;\n`;
+    wrapper += `};\n\n`;
+    
+    // Генерируем wrapper функцию
+    const selfParam = exp.selfType ? `, std::shared_ptr<${exp.selfType}> self, std::shared_ptr<tscb::InstanceQueue> queue` : '';
+    wrapper += `Napi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info${selfParam}) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    if (hasInput) {
+      wrapper += `    if (info.Length() < 1 || !info[0].IsObject()) {\n`;
+      wrapper += `        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+      wrapper += `    \n`;
+      wrapper += exp.recycle ? this.recycledInputDecode(exp, site, ownViews) : this.arenaInputDecode(exp, site, ownViews);
+    }
+    const inputArg = exp.recycle ? 'std::move(slot)' : 'std::move(input)';
+    const workerArgs = ['env', ...(exp.selfType ? ['std::move(self)', 'queue'] : []), ...(arena ? ['std::move(arena)'] : []), ...(hasInput ? [inputArg] : [])];
+    if (exp.cancellable) {
+      wrapper += this.cancelTokenDecode();
+      workerArgs.push('std::move(cancel)');
+    }
+    if (exp.cache) {
+      wrapper += this.cacheLookup(exp);
+      workerArgs.push('key');
+    }
+    wrapper += `    // Worker сам владеет Deferred и разрешает Promise в OnOK/OnError\n`;
+    wrapper += `    ${exp.name}_AsyncWorker* worker = new ${exp.name}_AsyncWorker(${workerArgs.join(', ')});\n`;
+    wrapper += `    Napi::Promise promise = worker->Promise();\n`;
+    if (exp.selfType) {
+      wrapper += `    queue->Start([worker]() { worker->Queue(); });\n`;
+    } else {
+      wrapper += `    worker->Queue();\n`;
+    }
+    wrapper += `    \n`;
+    wrapper += `    return promise;\n`;
+    wrapper += `}\n`;
+    
+    return wrapper;
+  }
+
+  /**
+   * Пакетный вариант <name>_batch есть только у экспортов с входом и результатом
+   */
+  private hasBatch(exp: ParsedExport): boolean {
+    return !exp.isStream && exp.paramType !== 'void' && exp.returnType !== 'void';
+  }
+
+  /**
+   * Объявление фабрики C++ объекта для @CppClass: std::shared_ptr<Name> Name_new(...)
+   */
+  private classFactorySignature(cls: ParsedClass, paramName: string): string {
+    const param = cls.constructorParamType === 'void' ? '' : `const ${cls.constructorParamType}& ${paramName}`;
+    return `std::shared_ptr<${cls.name}> ${cls.name}_new(${param})`;
+  }
+
+  /**
+   * Генерирует Napi::ObjectWrap для @CppClass. Экземпляр владеет C++ объектом
+   * через shared_ptr, методы делегируют в <Name>_<method>_wrapper.
+   */
+  private generateClassWrapper(cls: ParsedClass): string {
+    const wrap = `${cls.name}_Wrap`;
+    let wrapper = `\n// Нативный класс ${cls.name} (@CppClass): C++ объект живет между вызовами\n`;
+    wrapper += `class ${wrap} : public Napi::ObjectWrap<${wrap}> {\n`;
+    wrapper += `public:\n`;
+    wrapper += `    static void Init(Napi::Env env, Napi::Object exports) {\n`;
+    wrapper += `        Napi::Function ctor = DefineClass(env, "${cls.name}", {\n`;
+    for (const method of cls.methods) {
+      wrapper += `            InstanceMethod("${method.methodName}", &${wrap}::Call_${method.methodName}),\n`;
+    }
+    wrapper += `            InstanceMethod("dispose", &${wrap}::Dispose),\n`;
+    wrapper += `        });\n`;
+    wrapper += `        exports.Set("${cls.name}", ctor);\n`;
+    wrapper += `    }\n\n`;
+
+    wrapper += `    ${wrap}(const Napi::CallbackInfo& info) : Napi::ObjectWrap<${wrap}>(info) {\n`;
+    wrapper += `        Napi::Env env = info.Env();\n`;
+    if (cls.constructorParamType !== 'void') {
+      wrapper += `        if (info.Length() < 1 || !info[0].IsObject()) {\n`;
+      wrapper += `            Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+      wrapper += `            return;\n`;
+      wrapper += `        }\n`;
+    }
+    wrapper += `        try {\n`;
+    if (cls.constructorParamType !== 'void') {
+      wrapper += `            self_ = ${cls.name}_new(${cls.constructorParamType}::FromNapi(info[0].As<Napi::Object>()));\n`;
+    } else {
+      wrapper += `            self_ = ${cls.name}_new();\n`;
+    }
+    wrapper += `        } catch (const std::exception& e) {\n`;
+    wrapper += `            Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();\n`;
+    wrapper += `            return;\n`;
+    wrapper += `        }\n`;
+    wrapper += `        if (!self_) {\n`;
+    wrapper += `            Napi::Error::New(env, "${cls.name}_new returned null").ThrowAsJavaScriptException();\n`;
+    wrapper += `        }\n`;
+    wrapper += `    }\n\n`;
+
+    wrapper += `private:\n`;
+    const hasAsync = cls.methods.some(method => method.isAsync);
+    for (const method of cls.methods) {
+      wrapper += `    Napi::Value Call_${method.methodName}(const Napi::CallbackInfo& info) {\n`;
+      wrapper += `        if (!self_) {\n`;
+      wrapper += `            return Disposed(info.Env());\n`;
+      wrapper += `        }\n`;
+      if (method.isAsync) {
+        wrapper += `        return ${method.name}_wrapper(info, self_, queue_);\n`;
+      } else if (hasAsync) {
+        // Синхронный вызов нельзя поставить в очередь, а ждать async метод в главном потоке нельзя
+        wrapper += `        if (queue_->Busy()) {\n`;
+        wrapper += `            Napi::Error::New(info.Env(), "${cls.name} instance busy: an async method is still running").ThrowAsJavaScriptException();\n`;
+        wrapper += `            return info.Env().Null();\n`;
+        wrapper += `        }\n`;
+        wrapper += `        return ${method.name}_wrapper(info, *self_);\n`;
+      } else {
+        wrapper += `        return ${method.name}_wrapper(info, *self_);\n`;
+      }
+      wrapper += `    }\n\n`;
+    }
+
+    wrapper += `    // Освобождает C++ объект, не дожидаясь GC; незавершенные async вызовы держат свою ссылку\n`;
+    wrapper += `    Napi::Value Dispose(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `        self_.reset();\n`;
+    wrapper += `        return info.Env().Undefined();\n`;
+    wrapper += `    }\n\n`;
+
+    wrapper += `    static Napi::Value Disposed(Napi::Env env) {\n`;
+    wrapper += `        Napi::Error::New(env, "${cls.name} has been disposed").ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n\n`;
+
+    wrapper += `    std::shared_ptr<${cls.name}> self_;\n`;
+    if (hasAsync) {
+      wrapper += `    std::shared_ptr<tscb::InstanceQueue> queue_ = std::make_shared<tscb::InstanceQueue>();\n`;
+    }
+    wrapper += `};\n`;
+    return wrapper;
+  }
+
+  /**
+   * Проверка аргумента <name>_wire: ArrayBuffer или TypedArray с бинарным payload
+   */
+  private wirePayloadCheck(): string {
+    let code = `    const uint8_t* data = nullptr;\n`;
+    code += `    size_t size = 0;\n`;
+    code += `    if (info.Length() < 1 || !tscb::WireBytes(info[0], data, size)) {\n`;
+    code += `        Napi::TypeError::New(env, "Expected an ArrayBuffer or Uint8Array").ThrowAsJavaScriptException();\n`;
+    code += `        return env.Null();\n`;
+    code += `    }\n`;
+    return code;
+  }
+
+  /**
+   * Генерирует <name>_wire для синхронного экспорта: вход читается прямо из буфера JS,
+   * результат возвращается новым ArrayBuffer
+   */
+  private generateSyncWireWrapper(exp: ParsedExport): string {
+    const site = this.profileSite(`${exp.name}_wire`);
+    let wrapper = `\nNapi::Value ${exp.name}_wire_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    wrapper += this.wirePayloadCheck();
+    wrapper += `    \n`;
+    wrapper += `    try {\n`;
+    wrapper += this.profiled(`        tscb::WireReader reader(data, size);\n        ${exp.paramType} input = ${exp.paramType}::WireDecode(reader);\n`, site, 'kDecode', 8);
+    wrapper += this.profiled(this.indent(this.callStatement(exp, 'input', 'result', true), 8), site, 'kExecute', 8);
+    wrapper += this.profiled(`        tscb::WireWriter writer;\n        tscb::WireWrite(writer, result);\n        Napi::Value output = tscb::NewWireBuffer(env, writer);\n`, site, 'kEncode', 8);
+    wrapper += `        return output;\n`;
+    wrapper += `    } catch (const std::exception& e) {\n`;
+    wrapper += `        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n`;
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Генерирует <name>_wire для @CppAsync: в главном потоке payload только копируется,
+   * разбор, вызов и запись результата выполняются в Execute()
+   */
+  private generateAsyncWireWrapper(exp: ParsedExport): string {
+    const site = this.profileSite(`${exp.name}_wire`);
+    let wrapper = `\n// AsyncWorker для бинарного транспорта ${exp.name}\n`;
+    wrapper += `class ${exp.name}_WireWorker : public Napi::AsyncWorker {\n`;
+    wrapper += `public:\n`;
+    if (exp.cancellable) {
+      wrapper += `    ${exp.name}_WireWorker(Napi::Env env, const uint8_t* data, size_t size, tscb::CancelToken cancel)\n`;
+      wrapper += `        : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)), payload_(data, data + size), cancel_(std::move(cancel)) {}\n\n`;
+    } else {
+      wrapper += `    ${exp.name}_WireWorker(Napi::Env env, const uint8_t* data, size_t size)\n`;
+      wrapper += `        : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)), payload_(data, data + size) {}\n\n`;
+    }
+    wrapper += `    Napi::Promise Promise() const { return deferred_.Promise(); }\n\n`;
+    wrapper += `    void Execute() override {\n`;
+    wrapper += `        tscb::profile::RecordWait(${site}, queued_);\n`;
+    wrapper += `        try {\n`;
+    wrapper += this.profiled(`            tscb::WireReader reader(payload_.data(), payload_.size());\n            ${exp.paramType} input = ${exp.paramType}::WireDecode(reader);\n`, site, 'kDecode', 12);
+    wrapper += this.cancellableCall(exp, this.profiled(this.indent(this.callStatement(exp, 'input', 'result', true), 12), site, 'kExecute', 12), 'cancel_', 12);
+    wrapper += this.profiled(`            tscb::WireWrite(output_, result);\n`, site, 'kEncode', 12);
+    wrapper += `        } catch (const std::exception& e) {\n`;
+    wrapper += `            SetError(e.what());\n`;
+    wrapper += `        } catch (...) {\n`;
+    wrapper += `            SetError("Unknown error occurred");\n`;
+    wrapper += `        }\n`;
+    wrapper += `    }\n\n`;
+    wrapper += `    void OnOK() override {\n`;
+    wrapper += `        Napi::HandleScope scope(Env());\n`;
+    wrapper += `        deferred_.Resolve(tscb::NewWireBuffer(Env(), output_));\n`;
+    wrapper += `    }\n\n`;
+    wrapper += `    void OnError(const Napi::Error& error) override {\n`;
+    wrapper += `        Napi::HandleScope scope(Env());\n`;
+    wrapper += `        deferred_.Reject(error.Value());\n`;
+    wrapper += `    }\n\n`;
+    wrapper += `private:\n`;
+    wrapper += `    Napi::Promise::Deferred deferred_;\n`;
+    wrapper += `    std::vector<uint8_t> payload_;\n`;
+    wrapper += `    tscb::WireWriter output_;\n`;
+    if (exp.cancellable) {
+      wrapper += `    tscb::CancelToken cancel_;\n`;
+    }
+    wrapper += `    tscb::profile::Stamp queued_;\n`;
+    wrapper += `};\n\n`;
+
+    wrapper += `Napi::Value ${exp.name}_wire_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    wrapper += this.wirePayloadCheck();
+    wrapper += `    \n`;
+    if (exp.cancellable) {
+      wrapper += this.cancelTokenDecode();
+      wrapper += `    ${exp.name}_WireWorker* worker = new ${exp.name}_WireWorker(env, data, size, std::move(cancel));\n`;
+    } else {
+      wrapper += `    ${exp.name}_WireWorker* worker = new ${exp.name}_WireWorker(env, data, size);\n`;
+    }
+    wrapper += `    Napi::Promise promise = worker->Promise();\n`;
+    wrapper += `    worker->Queue();\n`;
+    wrapper += `    \n`;
+    wrapper += `    return promise;\n`;
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Точки профилирования: по одной на экспорт и на его пакетный вариант
+   */
+  private generateProfileSites(exports: ParsedExport[], classes: ParsedClass[] = []): string {
+    const names = [
+      ...exports.flatMap(exp => exp.isStream
+        ? [exp.name]
+        : [exp.name, ...(this.hasBatch(exp) ? [`${exp.name}_batch`] : []), ...(exp.transport === 'binary' ? [`${exp.name}_wire`] : [])]),
+      ...classes.flatMap(cls => cls.methods.map(method => method.name))
+    ];
+    let code = `\n// Точки профилирования (используются при define TSCB_PROFILE)\n`;
+    code += `namespace {\n`;
+    code += `enum ProfileSite : size_t {\n`;
+    for (const name of names) {
+      code += `    ${this.profileSite(name)},\n`;
+    }
+    code += `    kProfileSiteCount\n`;
+    code += `};\n\n`;
+    code += `const char* const kProfileSiteNames[] = {\n`;
+    for (const name of names) {
+      code += `    "${name}",\n`;
+    }
+    code += `    nullptr\n`;
+    code += `};\n`;
+    code += `} // namespace\n`;
+    return code;
+  }
+
+  /**
+   * Генерирует __bridgeStats(reset?): счетчики TSCB_PROFILE по экспортам и фазам, и __bridgeMemory()
+   */
+  private generateBridgeStatsWrapper(): string {
+    let wrapper = `\nNapi::Value BridgeStats_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    const bool reset = info.Length() > 0 && info[0].ToBoolean().Value();\n`;
+    wrapper += `    return tscb::profile::StatsToNapi(info.Env(), reset);\n`;
+    wrapper += `}\n`;
+
+    // __bridgeMemory(): текущая и пиковая нативная память по экспортам (tscb::ExternalMemory)
+    wrapper += `\nNapi::Value BridgeMemory_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    return tscb::memory::ToNapi(info.Env());\n`;
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Генерирует __initPool(size): задает размер нативного пула до первой задачи
+   */
+  private generateInitPoolWrapper(): string {
+    let wrapper = `\nNapi::Value InitPool_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    wrapper += `    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 0) {\n`;
+    wrapper += `        Napi::TypeError::New(env, "Expected a non-negative pool size").ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n`;
+    wrapper += `    \n`;
+    wrapper += `    const size_t size = static_cast<size_t>(info[0].As<Napi::Number>().Uint32Value());\n`;
+    wrapper += `    if (!tscb::ThreadPool::Instance().Configure(size)) {\n`;
+    wrapper += `        Napi::Error::New(env, "Thread pool is already running with a different size").ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n`;
+    wrapper += `    return env.Undefined();\n`;
+    wrapper += `}\n`;
+    return wrapper;
+  }
+
+  /**
+   * Генерирует асинхронный wrapper, выполняющий функцию в нативном пуле (tscb::ThreadPool).
+   * Результат возвращается в главный поток через ThreadSafeFunction.
+   */
+  private generatePoolWrapper(exp: ParsedExport, ownViews: boolean = false): string {
+    const site = this.profileSite(exp.name);
+    let wrapper = '';
+
+    if (exp.cache) {
+      wrapper += this.generateCacheAccessors(exp);
+    }
+    if (exp.recycle) {
+      wrapper += this.generateRecycleSlot(exp);
+    }
+
+    wrapper += `\n// Задача нативного пула для ${exp.name}\n`;
+    wrapper += `class ${exp.name}_PoolJob : public tscb::PoolJob {\n`;
+    wrapper += `public:\n`;
+    const arena = this.usesArena(exp);
+    const inputParam = exp.recycle ? `std::unique_ptr<${exp.name}_Slot> slot` : `${exp.paramType}&& input`;
+    const inputInit = exp.recycle ? 'slot_(std::move(slot))' : 'input_(std::move(input))';
+    const ctorParams = ['Napi::Env env', ...(arena ? ['std::unique_ptr<tscb::CallArena> arena'] : []), inputParam];
+    const ctorInits = ['deferred_(Napi::Promise::Deferred::New(env))', ...(arena ? ['arena_(std::move(arena))'] : []), inputInit];
+    if (exp.cancellable) {
+      ctorParams.push('tscb::CancelToken cancel');
+      ctorInits.push('cancel_(std::move(cancel))');
+    }
+    if (exp.cache) {
+      ctorParams.push(`const ${exp.paramType}* key`);
+      ctorInits.push('key_(key)');
+    }
+    wrapper += `    ${exp.name}_PoolJob(${ctorParams.join(', ')})\n`;
+    wrapper += `        : ${ctorInits.join(', ')} {\n`;
+    wrapper += `        memory_.Hold(env, tscb::NativeBytes(input_));\n`;
+    wrapper += `    }\n`;
+    if (exp.recycle) {
+      // Задача удаляется в главном потоке (CompletePoolJob): вход и результат возвращаются в пул
+      wrapper += `    ~${exp.name}_PoolJob() override {\n`;
+      wrapper += `        ${exp.name}_pool().Release(std::move(slot_));\n`;
+      wrapper += `    }\n`;
+    }
+    wrapper += `    Napi::Promise Promise() const { return deferred_.Promise(); }\n\n`;
+
+    wrapper += `    void Execute() override {\n`;
+    wrapper += `        tscb::profile::RecordWait(${site}, queued_);\n`;
+    wrapper += `        try {\n`;
+    wrapper += this.recycledResultReset(exp, 'result_', 12);
+    wrapper += this.cancellableCall(exp, this.profiled(this.indent(this.callStatement(exp, 'input_', 'result_'), 12), site, 'kExecute', 12), 'cancel_', 12);
+    wrapper += `            memory_.Add(tscb::NativeBytes(result_));\n`;
+    wrapper += `        } catch (const std::exception& e) {\n`;
+    wrapper += `            error_ = e.what();\n`;
+    wrapper += `            failed_ = true;\n`;
+    wrapper += `        } catch (...) {\n`;
+    wrapper += `            error_ = "Unknown error occurred";\n`;
+    wrapper += `            failed_ = true;\n`;
+    wrapper += `        }\n`;
+    wrapper += `    }\n\n`;
+
+    wrapper += `    void Complete(Napi::Env env) override {\n`;
+    wrapper += `        memory_.Release(env);\n`;
+    wrapper += `        if (failed_) {\n`;
+    if (exp.cache) {
+      wrapper += `            Napi::Value error = Napi::Error::New(env, error_).Value();\n`;
+      wrapper += this.cacheReject(exp, 'error', 12);
+      wrapper += `            deferred_.Reject(error);\n`;
+    } else {
+      wrapper += `            deferred_.Reject(Napi::Error::New(env, error_).Value());\n`;
+    }
+    wrapper += `            return;\n`;
+    wrapper += `        }\n`;
+    if (exp.cache) {
+      wrapper += this.cacheResolve(exp, 'result_', 'env', 8);
+    }
+    wrapper += this.profiled(`        Napi::Value output = ${this.resultToNapi(exp.returnType, 'result_', 'env')};\n`, site, 'kEncode', 8);
+    wrapper += `        deferred_.Resolve(output);\n`;
+    wrapper += `    }\n\n`;
+
+    wrapper += `private:\n`;
+    wrapper += `    Napi::Promise::Deferred deferred_;\n`;
+    wrapper += `    tscb::ExternalMemory memory_{${site}};\n`;
+    if (arena) {
+      wrapper += `    std::unique_ptr<tscb::CallArena> arena_;\n`;
+    }
+    if (exp.recycle) {
+      wrapper += this.recycledMembers(exp);
+    } else {
+      wrapper += `    ${exp.paramType} input_;\n`;
+      wrapper += `    ${exp.returnType} result_;\n`;
+    }
+    if (exp.cancellable) {
+      wrapper += `    tscb::CancelToken cancel_;\n`;
+    }
+    if (exp.cache) {
+      wrapper += `    const ${exp.paramType}* key_;\n`;
+    }
+    wrapper += `    std::string error_;\n`;
+    wrapper += `    bool failed_ = false;\n`;
+    wrapper += `    tscb::profile::Stamp queued_;\n`;
+    wrapper += `};\n\n`;
 
-    // Генерируем .h файл
-    let hppOutput = hppTemplate
-      .replace('{{EXTERN_DECLARATIONS}}', externDeclarations);
+    wrapper += `Napi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info) {\n`;
+    wrapper += `    Napi::Env env = info.Env();\n`;
+    wrapper += `    \n`;
+    wrapper += `    if (info.Length() < 1 || !info[0].IsObject()) {\n`;
+    wrapper += `        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+    wrapper += `        return env.Null();\n`;
+    wrapper += `    }\n`;
+    wrapper += `    \n`;
+    wrapper += exp.recycle ? this.recycledInputDecode(exp, site, ownViews) : this.arenaInputDecode(exp, site, ownViews);
+    const jobArgs = ['env', ...(arena ? ['std::move(arena)'] : []), exp.recycle ? 'std::move(slot)' : 'std::move(input)'];
+    if (exp.cancellable) {
+      wrapper += this.cancelTokenDecode();
+      jobArgs.push('std::move(cancel)');
+    }
+    if (exp.cache) {
+      wrapper += this.cacheLookup(exp);
+      jobArgs.push('key');
+    }
+    wrapper += `    ${exp.name}_PoolJob* job = new ${exp.name}_PoolJob(${jobArgs.join(', ')});\n`;
+    wrapper += `    Napi::Promise promise = job->Promise();\n`;
+    wrapper += `    tscb::QueueJob(env, job);\n`;
+    wrapper += `    \n`;
+    wrapper += `    return promise;\n`;
+    wrapper += `}\n`;
 
-    fs.writeFileSync(path.join(outputDir, 'generated_api.h'), hppOutput);
+    return wrapper;
   }
 
   /**
-   * Генерирует синхронный wrapper для функции
+   * Генерирует синхронный пакетный wrapper: массив входов → массив результатов
    */
-  private generateSyncWrapper(exp: ParsedExport): string {
-    let wrapper = `\nNapi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info) {\n`;
+  private generateSyncBatchWrapper(exp: ParsedExport): string {
+    const site = this.profileSite(`${exp.name}_batch`);
+    let wrapper = `\nNapi::Value ${exp.name}_batch_wrapper(const Napi::CallbackInfo& info) {\n`;
     wrapper += `    Napi::Env env = info.Env();\n`;
     wrapper += `    \n`;
-    wrapper += `    if (info.Length() < 1 || !info[0].IsObject()) {\n`;
-    wrapper += `        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+    wrapper += `    if (info.Length() < 1 || !info[0].IsArray()) {\n`;
+    wrapper += `        Napi::TypeError::New(env, "Expected an array").ThrowAsJavaScriptException();\n`;
     wrapper += `        return env.Null();\n`;
     wrapper += `    }\n`;
     wrapper += `    \n`;
+    wrapper += `    Napi::Array inputs = info[0].As<Napi::Array>();\n`;
+    wrapper += `    const uint32_t count = inputs.Length();\n`;
+    wrapper += `    Napi::Array outputs = Napi::Array::New(env, count);\n`;
+    wrapper += `    uint32_t i = 0;\n`;
+    const arena = this.usesArena(exp);
+    if (arena) {
+      wrapper += `    tscb::CallArena arena;\n`;
+    }
     wrapper += `    try {\n`;
-    wrapper += `        ${exp.paramType} input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>());\n`;
-    wrapper += `        ${exp.returnType} result = ${exp.name}(input);\n`;
-    
-    // Проверяем, является ли возвращаемый тип примитивным
-    const primitiveTypes = ['int', 'double', 'float', 'bool', 'int8_t', 'uint8_t', 'int16_t', 'uint16_t', 'int32_t', 'uint32_t', 'int64_t', 'uint64_t'];
-    if (primitiveTypes.includes(exp.returnType)) {
-      // Для примитивных типов используем соответствующие Napi конструкторы
-      if (exp.returnType === 'bool') {
-        wrapper += `        return Napi::Boolean::New(env, result);\n`;
-      } else if (exp.returnType === 'int64_t' || exp.returnType === 'uint64_t') {
-        wrapper += `        return Napi::BigInt::New(env, result);\n`;
-      } else {
-        wrapper += `        return Napi::Number::New(env, static_cast<double>(result));\n`;
-      }
-    } else {
-      // Для структур используем ToNapi метод
-      wrapper += `        return result.ToNapi(env);\n`;
+    wrapper += `        for (; i < count; i++) {\n`;
+    wrapper += `            // Отдельный scope на элемент, чтобы не копить handles на весь пакет\n`;
+    wrapper += `            Napi::HandleScope scope(env);\n`;
+    if (arena) {
+      wrapper += `            // Вход предыдущего элемента уже уничтожен: арена переиспользуется\n`;
+      wrapper += `            arena.Release();\n`;
     }
-    
+    wrapper += `            Napi::Value item = inputs.Get(i);\n`;
+    wrapper += `            if (!item.IsObject()) {\n`;
+    wrapper += `                throw std::runtime_error("Expected an object");\n`;
+    wrapper += `            }\n`;
+    wrapper += this.profiled(`            ${exp.paramType} input = ${exp.paramType}::FromNapi(item.As<Napi::Object>()${arena ? ', arena.Resource()' : ''});\n`, site, 'kDecode', 12);
+    wrapper += this.profiled(this.indent(this.callStatement(exp, 'input', 'result', true), 12), site, 'kExecute', 12);
+    wrapper += this.profiled(`            outputs.Set(i, ${this.resultToNapi(exp.returnType, 'result', 'env')});\n`, site, 'kEncode', 12);
+    wrapper += `        }\n`;
     wrapper += `    } catch (const std::exception& e) {\n`;
-    wrapper += `        Napi::Error::New(env, e.what()).ThrowAsJavaScriptException();\n`;
+    wrapper += `        Napi::Error::New(env, "Batch item " + std::to_string(i) + ": " + e.what()).ThrowAsJavaScriptException();\n`;
     wrapper += `        return env.Null();\n`;
     wrapper += `    }\n`;
+    wrapper += `    return outputs;\n`;
     wrapper += `}\n`;
     return wrapper;
   }
 
   /**
-   * Генерирует асинхронный wrapper для функции с Promise
+   * Генерирует асинхронный пакетный wrapper.
+   * Пакет делится на диапазоны по числу потоков, на каждый диапазон один AsyncWorker
+   * (или задача нативного пула);
+   * Promise разрешается, когда завершится последний из них.
    */
-  private generateAsyncWrapper(exp: ParsedExport): string {
+  private generateAsyncBatchWrapper(exp: ParsedExport, ownViews: boolean = false, settle: boolean = false): string {
+    // settle: <name>_settle для coalesce - ошибка входа отклоняет только его элемент,
+    // Promise разрешается массивом PromiseSettledResult
+    const kind = settle ? 'Settle' : 'Batch';
+    const entry = settle ? `${exp.name}_settle` : `${exp.name}_batch`;
+    const state = `${exp.name}_${kind}State`;
+    const worker = `${exp.name}_${kind}Worker`;
+    const site = this.profileSite(`${exp.name}_batch`);
     let wrapper = '';
-    
-    // Генерируем AsyncWorker класс
-    wrapper += `\n// AsyncWorker class for ${exp.name}\n`;
-    wrapper += `class ${exp.name}_AsyncWorker : public Napi::AsyncWorker {\n`;
+
+    wrapper += `\n// Общее состояние пакетного вызова ${settle ? entry : exp.name}\n`;
+    wrapper += `struct ${state} {\n`;
+    wrapper += `    explicit ${state}(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}\n`;
+    wrapper += `    Napi::Promise::Deferred deferred;\n`;
+    wrapper += `    tscb::ExternalMemory memory{${site}};\n`;
+    if (this.usesArena(exp)) {
+      // Общая арена пакета, объявлена до inputs: уничтожается после них
+      wrapper += `    tscb::CallArena arena;\n`;
+    }
+    wrapper += `    std::vector<${exp.paramType}> inputs;\n`;
+    wrapper += `    std::vector<${exp.returnType}> results;\n`;
+    if (exp.cancellable) {
+      wrapper += `    tscb::CancelToken cancel;\n`;
+    }
+    wrapper += `    size_t pending = 0;\n`;
+    wrapper += `    std::string error;\n`;
+    if (settle) {
+      // uint8_t, а не vector<bool>: workers пишут в соседние элементы параллельно
+      wrapper += `    std::vector<uint8_t> failed;\n`;
+      wrapper += `    std::vector<std::string> errors;\n`;
+    }
+    wrapper += `};\n\n`;
+
+    const nativePool = exp.pool === 'native';
+    const base = nativePool ? 'tscb::PoolJob' : 'Napi::AsyncWorker';
+    wrapper += `class ${worker} : public ${base} {\n`;
     wrapper += `public:\n`;
-    wrapper += `    ${exp.name}_AsyncWorker(Napi::Function& callback, const ${exp.paramType}& input)\n`;
-    wrapper += `        : Napi::AsyncWorker(callback), input_(input) {}\n`;
-    wrapper += `    ~${exp.name}_AsyncWorker() {}\n\n`;
-    
+    if (nativePool) {
+      wrapper += `    ${worker}(std::shared_ptr<${state}> state, size_t begin, size_t end)\n`;
+      wrapper += `        : state_(std::move(state)), begin_(begin), end_(end) {}\n\n`;
+    } else {
+      wrapper += `    ${worker}(Napi::Env env, std::shared_ptr<${state}> state, size_t begin, size_t end)\n`;
+      wrapper += `        : Napi::AsyncWorker(env), state_(std::move(state)), begin_(begin), end_(end) {}\n\n`;
+    }
+
     wrapper += `    void Execute() override {\n`;
+    wrapper += `        tscb::profile::RecordWait(${site}, queued_);\n`;
+    wrapper += `        // Каждый worker пишет только в свой диапазон results\n`;
     wrapper += `        try {\n`;
-    wrapper += `            result_ = ${exp.name}(input_);\n`;
+    wrapper += `            TSCB_PROFILE_START(executeStart);\n`;
+    wrapper += `            for (size_t i = begin_; i < end_; i++) {\n`;
+    let call = '';
+    if (exp.cancellable) {
+      call += `state_->cancel.ThrowIfCancelled();\n`;
+    }
+    call += this.callStatement(exp, 'state_->inputs[i]', 'state_->results[i]', false, 'self', 'state_->cancel');
+    if (settle) {
+      wrapper += `                if (state_->failed[i]) {\n`;
+      wrapper += `                    continue;\n`;
+      wrapper += `                }\n`;
+      wrapper += `                try {\n`;
+      wrapper += this.indent(call, 20);
+      wrapper += `                } catch (const std::exception& e) {\n`;
+      wrapper += `                    state_->failed[i] = 1;\n`;
+      wrapper += `                    state_->errors[i] = e.what();\n`;
+      wrapper += `                } catch (...) {\n`;
+      wrapper += `                    state_->failed[i] = 1;\n`;
+      wrapper += `                    state_->errors[i] = "Unknown error occurred";\n`;
+      wrapper += `                }\n`;
+    } else {
+      wrapper += this.indent(call, 16);
+    }
+    wrapper += `            }\n`;
+    wrapper += `            size_t resultBytes = 0;\n`;
+    wrapper += `            for (size_t i = begin_; i < end_; i++) {\n`;
+    wrapper += `                resultBytes += tscb::HeapBytes(state_->results[i]);\n`;
+    wrapper += `            }\n`;
+    wrapper += `            state_->memory.Add(resultBytes);\n`;
+    if (exp.cancellable) {
+      wrapper += `            state_->cancel.ThrowIfCancelled();\n`;
+    }
+    wrapper += `            TSCB_PROFILE_STOP(executeStart, ${site}, kExecute);\n`;
     wrapper += `        } catch (const std::exception& e) {\n`;
-    wrapper += `            SetError(e.what());\n`;
+    wrapper += nativePool ? `            error_ = e.what();\n` : `            SetError(e.what());\n`;
     wrapper += `        } catch (...) {\n`;
-    wrapper += `            SetError("Unknown error occurred");\n`;
+    wrapper += nativePool ? `            error_ = "Unknown error occurred";\n` : `            SetError("Unknown error occurred");\n`;
     wrapper += `        }\n`;
     wrapper += `    }\n\n`;
-    
-    wrapper += `    void OnOK() override {\n`;
-    wrapper += `        Napi::HandleScope scope(Env());\n`;
-    
-    // Проверяем, является ли возвращаемый тип примитивным
-    const primitiveTypes = ['int', 'double', 'float', 'bool', 'int8_t', 'uint8_t', 'int16_t', 'uint16_t', 'int32_t', 'uint32_t', 'int64_t', 'uint64_t'];
-    if (primitiveTypes.includes(exp.returnType)) {
-      // Для примитивных типов используем соответствующие Napi конструкторы
-      if (exp.returnType === 'bool') {
-        wrapper += `        Callback().Call({Env().Null(), Napi::Boolean::New(Env(), result_)});\n`;
-      } else if (exp.returnType === 'int64_t' || exp.returnType === 'uint64_t') {
-        wrapper += `        Callback().Call({Env().Null(), Napi::BigInt::New(Env(), result_)});\n`;
-      } else {
-        wrapper += `        Callback().Call({Env().Null(), Napi::Number::New(Env(), static_cast<double>(result_))};\n`;
-      }
+
+    if (nativePool) {
+      wrapper += `    void Complete(Napi::Env env) override {\n`;
+      wrapper += `        if (!error_.empty() && state_->error.empty()) {\n`;
+      wrapper += `            state_->error = error_;\n`;
+      wrapper += `        }\n`;
+      wrapper += `        Finish(env);\n`;
+      wrapper += `    }\n\n`;
     } else {
-      // Для структур используем ToNapi метод
-      wrapper += `        Callback().Call({Env().Null(), result_.ToNapi(Env())});\n`;
+      wrapper += `    void OnOK() override {\n`;
+      wrapper += `        Finish(Env());\n`;
+      wrapper += `    }\n\n`;
+
+      wrapper += `    void OnError(const Napi::Error& error) override {\n`;
+      wrapper += `        if (state_->error.empty()) {\n`;
+      wrapper += `            state_->error = error.Message();\n`;
+      wrapper += `        }\n`;
+      wrapper += `        Finish(Env());\n`;
+      wrapper += `    }\n\n`;
     }
-    
-    wrapper += `    }\n\n`;
-    
-    wrapper += `    void OnError(const Napi::Error& error) override {\n`;
-    wrapper += `        Napi::HandleScope scope(Env());\n`;
-    wrapper += `        Callback().Call({error.Value(), Env().Undefined()});\n`;
-    wrapper += `    }\n\n`;
-    
+
     wrapper += `private:\n`;
-    wrapper += `    ${exp.paramType} input_;\n`;
-    wrapper += `    ${exp.returnType} result_;\n`;
+    wrapper += `    // Завершение выполняется в главном потоке, поэтому счетчик не атомарный\n`;
+    wrapper += `    void Finish(Napi::Env env) {\n`;
+    wrapper += `        if (--state_->pending > 0) {\n`;
+    wrapper += `            return;\n`;
+    wrapper += `        }\n`;
+    wrapper += `        Napi::HandleScope scope(env);\n`;
+    wrapper += `        state_->memory.Release(env);\n`;
+    wrapper += `        if (!state_->error.empty()) {\n`;
+    wrapper += `            state_->deferred.Reject(Napi::Error::New(env, state_->error).Value());\n`;
+    wrapper += `            return;\n`;
+    wrapper += `        }\n`;
+    wrapper += `        TSCB_PROFILE_START(encodeStart);\n`;
+    wrapper += `        const size_t count = state_->results.size();\n`;
+    wrapper += `        Napi::Array outputs = Napi::Array::New(env, count);\n`;
+    wrapper += `        for (size_t i = 0; i < count; i++) {\n`;
+    if (settle) {
+      wrapper += `            Napi::Object outcome = Napi::Object::New(env);\n`;
+      wrapper += `            if (state_->failed[i]) {\n`;
+      wrapper += `                outcome.Set("status", "rejected");\n`;
+      wrapper += `                outcome.Set("reason", Napi::Error::New(env, state_->errors[i]).Value());\n`;
+      wrapper += `            } else {\n`;
+      wrapper += `                outcome.Set("status", "fulfilled");\n`;
+      wrapper += `                outcome.Set("value", ${this.resultToNapi(exp.returnType, 'state_->results[i]', 'env')});\n`;
+      wrapper += `            }\n`;
+      wrapper += `            outputs.Set(static_cast<uint32_t>(i), outcome);\n`;
+    } else {
+      wrapper += `            outputs.Set(static_cast<uint32_t>(i), ${this.resultToNapi(exp.returnType, 'state_->results[i]', 'env')});\n`;
+    }
+    wrapper += `        }\n`;
+    wrapper += `        TSCB_PROFILE_STOP(encodeStart, ${site}, kEncode);\n`;
+    wrapper += `        state_->deferred.Resolve(outputs);\n`;
+    wrapper += `    }\n\n`;
+    wrapper += `    std::shared_ptr<${state}> state_;\n`;
+    wrapper += `    size_t begin_;\n`;
+    wrapper += `    size_t end_;\n`;
+    wrapper += `    tscb::profile::Stamp queued_;\n`;
+    if (nativePool) {
+      wrapper += `    std::string error_;\n`;
+    }
     wrapper += `};\n\n`;
-    
-    // Генерируем wrapper функцию
-    wrapper += `Napi::Value ${exp.name}_wrapper(const Napi::CallbackInfo& info) {\n`;
+
+    wrapper += `Napi::Value ${entry}_wrapper(const Napi::CallbackInfo& info) {\n`;
     wrapper += `    Napi::Env env = info.Env();\n`;
     wrapper += `    \n`;
-    wrapper += `    if (info.Length() < 1 || !info[0].IsObject()) {\n`;
-    wrapper += `        Napi::TypeError::New(env, "Expected an object").ThrowAsJavaScriptException();\n`;
+    wrapper += `    if (info.Length() < 1 || !info[0].IsArray()) {\n`;
+    wrapper += `        Napi::TypeError::New(env, "Expected an array").ThrowAsJavaScriptException();\n`;
     wrapper += `        return env.Null();\n`;
     wrapper += `    }\n`;
     wrapper += `    \n`;
-    wrapper += `    ${exp.paramType} input;\n`;
-    wrapper += `    try {\n`;
-    wrapper += `        input = ${exp.paramType}::FromNapi(info[0].As<Napi::Object>());\n`;
-    wrapper += `    } catch (const std::exception& e) {\n`;
-    wrapper += `        Napi::TypeError::New(env, std::string("Failed to parse input: ") + e.what()).ThrowAsJavaScriptException();\n`;
-    wrapper += `        return env.Null();\n`;
-    wrapper += `    }\n`;
+    if (exp.cancellable) {
+      wrapper += this.cancelTokenDecode();
+    }
+    wrapper += `    Napi::Array items = info[0].As<Napi::Array>();\n`;
+    wrapper += `    const uint32_t count = items.Length();\n`;
+    wrapper += `    auto state = std::make_shared<${state}>(env);\n`;
+    if (exp.cancellable) {
+      wrapper += `    state->cancel = std::move(cancel);\n`;
+    }
     wrapper += `    \n`;
-    wrapper += `    // Создаем Promise\n`;
-    wrapper += `    auto deferred = Napi::Promise::Deferred::New(env);\n`;
+    wrapper += `    // Разбор входов возможен только в главном потоке\n`;
+    wrapper += `    state->inputs.reserve(count);\n`;
+    const decoded = `${exp.paramType}::FromNapi(item.As<Napi::Object>()${this.usesArena(exp) ? ', state->arena.Resource()' : ''})`;
+    if (settle) {
+      wrapper += `    state->failed.assign(count, 0);\n`;
+      wrapper += `    state->errors.resize(count);\n`;
+      wrapper += this.ownedViewScope(ownViews, 4);
+      wrapper += `    TSCB_PROFILE_START(decodeStart);\n`;
+      wrapper += `    for (uint32_t i = 0; i < count; i++) {\n`;
+      wrapper += `        Napi::HandleScope scope(env);\n`;
+      wrapper += `        Napi::Value item = items.Get(i);\n`;
+      wrapper += `        try {\n`;
+      wrapper += `            if (!item.IsObject()) {\n`;
+      wrapper += `                throw std::runtime_error("Expected an object");\n`;
+      wrapper += `            }\n`;
+      wrapper += `            state->inputs.push_back(${decoded});\n`;
+      wrapper += `        } catch (const std::exception& e) {\n`;
+      wrapper += `            // Элемент не выполняется, его место в inputs занимает пустой вход\n`;
+      wrapper += `            state->inputs.emplace_back(${this.usesArena(exp) ? 'state->arena.Resource()' : ''});\n`;
+      wrapper += `            state->failed[i] = 1;\n`;
+      wrapper += `            state->errors[i] = std::string("Failed to parse input: ") + e.what();\n`;
+      wrapper += `        }\n`;
+      wrapper += `    }\n`;
+      wrapper += `    TSCB_PROFILE_STOP(decodeStart, ${site}, kDecode);\n`;
+    } else {
+      wrapper += `    uint32_t i = 0;\n`;
+      wrapper += `    try {\n`;
+      wrapper += this.ownedViewScope(ownViews, 8);
+      wrapper += `        TSCB_PROFILE_START(decodeStart);\n`;
+      wrapper += `        for (; i < count; i++) {\n`;
+      wrapper += `            Napi::HandleScope scope(env);\n`;
+      wrapper += `            Napi::Value item = items.Get(i);\n`;
+      wrapper += `            if (!item.IsObject()) {\n`;
+      wrapper += `                throw std::runtime_error("Expected an object");\n`;
+      wrapper += `            }\n`;
+      wrapper += `            state->inputs.push_back(${decoded});\n`;
+      wrapper += `        }\n`;
+      wrapper += `        TSCB_PROFILE_STOP(decodeStart, ${site}, kDecode);\n`;
+      wrapper += `    } catch (const std::exception& e) {\n`;
+      wrapper += `        Napi::TypeError::New(env, "Failed to parse batch item " + std::to_string(i) + ": " + e.what()).ThrowAsJavaScriptException();\n`;
+      wrapper += `        return env.Null();\n`;
+      wrapper += `    }\n`;
+    }
     wrapper += `    \n`;
-    wrapper += `    // Создаем callback функцию для Promise\n`;
-    wrapper += `    auto callback = Napi::Function::New(env, [deferred](const Napi::CallbackInfo& info) {\n`;
-    wrapper += `        Napi::Env env = info.Env();\n`;
-    wrapper += `        if (info.Length() > 0 && !info[0].IsNull()) {\n`;
-    wrapper += `            // Ошибка\n`;
-    wrapper += `            deferred.Reject(info[0]);\n`;
-    wrapper += `        } else if (info.Length() > 1) {\n`;
-    wrapper += `            // Успех\n`;
-    wrapper += `            deferred.Resolve(info[1]);\n`;
-    wrapper += `        } else {\n`;
-    wrapper += `            deferred.Reject(Napi::Error::New(env, "Invalid callback arguments").Value());\n`;
-    wrapper += `        }\n`;
-    wrapper += `        return env.Undefined();\n`;
-    wrapper += `    });\n`;
+    wrapper += `    Napi::Promise promise = state->deferred.Promise();\n`;
+    wrapper += `    if (count == 0) {\n`;
+    wrapper += `        state->deferred.Resolve(Napi::Array::New(env, 0));\n`;
+    wrapper += `        return promise;\n`;
+    wrapper += `    }\n`;
+    wrapper += `    state->results.resize(count);\n`;
+    wrapper += `    state->memory.Hold(env, tscb::NativeBytes(state->inputs) + tscb::NativeBytes(state->results));\n`;
     wrapper += `    \n`;
-    wrapper += `    // Запускаем AsyncWorker\n`;
-    wrapper += `    ${exp.name}_AsyncWorker* worker = new ${exp.name}_AsyncWorker(callback, input);\n`;
-    wrapper += `    worker->Queue();\n`;
+    if (nativePool) {
+      wrapper += `    // Делим пакет на непрерывные диапазоны, по одной задаче на поток нативного пула\n`;
+      wrapper += `    const size_t chunks = tscb::BatchChunkCount(count, tscb::ThreadPool::Instance().Size());\n`;
+    } else {
+      wrapper += `    // Делим пакет на непрерывные диапазоны, по одному AsyncWorker на поток\n`;
+      wrapper += `    const size_t chunks = tscb::BatchChunkCount(count);\n`;
+    }
+    wrapper += `    state->pending = chunks;\n`;
+    wrapper += `    for (size_t chunk = 0; chunk < chunks; chunk++) {\n`;
+    wrapper += `        const size_t begin = count * chunk / chunks;\n`;
+    wrapper += `        const size_t end = count * (chunk + 1) / chunks;\n`;
+    if (nativePool) {
+      wrapper += `        tscb::QueueJob(env, new ${worker}(state, begin, end));\n`;
+    } else {
+      wrapper += `        (new ${worker}(env, state, begin, end))->Queue();\n`;
+    }
+    wrapper += `    }\n`;
     wrapper += `    \n`;
-    wrapper += `    return deferred.Promise();\n`;
+    wrapper += `    return promise;\n`;
     wrapper += `}\n`;
-    
+
     return wrapper;
   }
 
@@ -952,7 +4267,7 @@ export class CppGenerator {
   /**
    * Генерирует шаблон файла с реализациями пользователя
    */
-  private generateImplementationTemplate(exports: ParsedExport[], outputDir: string): void {
+  private generateImplementationTemplate(exports: ParsedExport[], classes: ParsedClass[], outputDir: string): void {
     // Записываем в cpp/src/implementation.cpp (на уровень выше generated)
     const implPath = path.join(path.dirname(outputDir), 'implementation.cpp');
     
@@ -972,14 +4287,57 @@ export class CppGenerator {
     let exampleImplementations = '';
     
     for (const exp of exports) {
-      externComments += `// ${exp.returnType} ${exp.name}(const ${exp.paramType}& param);\n`;
+      externComments += `// ${this.functionSignature(exp, 'param')};\n`;
       
       // Создаем пример реализации
-      exampleImplementations += `\n${exp.returnType} ${exp.name}(const ${exp.paramType}& input) {\n`;
-      exampleImplementations += `    ${exp.returnType} result;\n`;
-      exampleImplementations += `    // TODO: Реализуйте логику здесь\n`;
-      exampleImplementations += `    return result;\n`;
+      exampleImplementations += `\n${this.functionSignature(exp, 'input')} {\n`;
+      if (exp.cancellable) {
+        exampleImplementations += `    // В длинных циклах вызывайте cancel.ThrowIfCancelled()\n`;
+      }
+      if (exp.isStream) {
+        exampleImplementations += `    // TODO: Реализуйте логику здесь; Emit ждет, пока потребитель заберет чанки,\n`;
+        exampleImplementations += `    // и возвращает false, если чтение прекращено\n`;
+        exampleImplementations += `    ${exp.returnType} chunk{};\n`;
+        exampleImplementations += `    if (!emit.Emit(std::move(chunk))) {\n`;
+        exampleImplementations += `        return;\n`;
+        exampleImplementations += `    }\n`;
+      } else if (exp.signature === 'out') {
+        exampleImplementations += `    // TODO: Реализуйте логику здесь, заполните result\n`;
+      } else {
+        exampleImplementations += `    ${exp.returnType} result;\n`;
+        exampleImplementations += `    // TODO: Реализуйте логику здесь\n`;
+        exampleImplementations += `    return result;\n`;
+      }
+      exampleImplementations += `}\n`;
+    }
+
+    for (const cls of classes) {
+      externComments += `// ${this.classFactorySignature(cls, 'param')};\n`;
+      exampleImplementations += `\n// Состояние ${cls.name}: хранится в C++ между вызовами методов\n`;
+      exampleImplementations += `class ${cls.name} {\n`;
+      exampleImplementations += `public:\n`;
+      exampleImplementations += `    // TODO: Добавьте поля состояния\n`;
+      exampleImplementations += `};\n`;
+      exampleImplementations += `\n${this.classFactorySignature(cls, 'config')} {\n`;
+      exampleImplementations += `    return std::make_shared<${cls.name}>();\n`;
       exampleImplementations += `}\n`;
+      for (const method of cls.methods) {
+        externComments += `// ${this.functionSignature(method, 'param')};\n`;
+        exampleImplementations += `\n${this.functionSignature(method, 'input')} {\n`;
+        if (method.cancellable) {
+          exampleImplementations += `    // В длинных циклах вызывайте cancel.ThrowIfCancelled()\n`;
+        }
+        if (method.signature === 'out') {
+          exampleImplementations += `    // TODO: Реализуйте логику здесь, заполните result\n`;
+        } else if (method.returnType === 'void') {
+          exampleImplementations += `    // TODO: Реализуйте логику здесь\n`;
+        } else {
+          exampleImplementations += `    ${method.returnType} result;\n`;
+          exampleImplementations += `    // TODO: Реализуйте логику здесь\n`;
+          exampleImplementations += `    return result;\n`;
+        }
+        exampleImplementations += `}\n`;
+      }
     }
 
     const output = template
@@ -1018,9 +4376,11 @@ export class CppGenerator {
     
     for (const struct of parseResult.structs) {
       for (const field of struct.fields) {
-        // Используем оригинальный TypeScript тип field.tsType
-        if (['i8', 'u8', 'i16', 'u16', 'i32', 'u32', 'i64', 'u64', 'f32', 'f64'].includes(field.tsType)) {
-          usedSemanticTypes.add(field.tsType);
+        // Используем оригинальный TypeScript тип field.tsType, включая i64[], Set<f32> и Map<string, u8>
+        for (const type of field.tsType.match(/\b[iuf](?:8|16|32|64)\b/g) || []) {
+          if (isPreciseNumericType(type)) {
+            usedSemanticTypes.add(type);
+          }
         }
       }
     }
@@ -1057,9 +4417,104 @@ export class CppGenerator {
         content += `  ${field.name}: ${tsType};\n`;
       }
       content += '}\n\n';
+      if (struct.isView) {
+        content += `// Ленивое представление ${struct.name}, возвращаемое из C++: поля только для чтения\n`;
+        content += `export type ${struct.name}View = Readonly<${struct.name}> & { toJSON(): ${struct.name} };\n\n`;
+      }
+      if (struct.isColumnar) {
+        content += this.generateColumnsTypes(struct);
+      }
+    }
+
+    if (parseResult.structs.some(s => s.isColumnar && s.fields.some(f => f.type === 'std::string'))) {
+      content += '// Индекс отсутствующего значения необязательной строковой колонки (C++ читает пустую строку)\n';
+      content += 'const MISSING_COLUMN_STRING = 0xFFFFFFFF;\n\n';
+      content += '// Индекс строки в таблице strings колоночного объекта\n';
+      content += 'function internColumnString(strings: string[], ids: Map<string, number>, value: string | undefined): number {\n';
+      content += '  if (value === undefined) {\n';
+      content += '    return MISSING_COLUMN_STRING;\n';
+      content += '  }\n';
+      content += '  let id = ids.get(value);\n';
+      content += '  if (id === undefined) {\n';
+      content += '    id = strings.length;\n';
+      content += '    ids.set(value, id);\n';
+      content += '    strings.push(value);\n';
+      content += '  }\n';
+      content += '  return id;\n';
+      content += '}\n\n';
+    }
+
+    this.writeOutput(path.join(outputDir, 'generated_types.ts'), content);
+  }
+
+  /**
+   * <Name>Columns в TS: TypedArray на каждое поле (строки - Uint32Array индексов в strings)
+   * и create/from/row для перехода между колонками и массивом объектов
+   */
+  private generateColumnsTypes(struct: ParsedStruct): string {
+    const name = `${struct.name}Columns`;
+    const columns = struct.fields.map(field => ({
+      name: field.name,
+      typed: this.columnTypedArray(field) || 'Uint32Array',
+      isString: field.type === 'std::string',
+      isBool: this.fieldCppType(field) === 'bool',
+      isOptional: field.isOptional,
+      // Отсутствующая строка - индекс MISSING_COLUMN_STRING, число - 0
+      fallback: field.isOptional && field.type !== 'std::string' ? ' ?? 0' : ''
+    }));
+    const hasStrings = columns.some(c => c.isString);
+
+    let content = `// Массив ${struct.name} колонками: length строк, TypedArray на поле, строки - индексы в strings\n`;
+    content += `export interface ${name} {\n`;
+    content += '  length: number;\n';
+    for (const c of columns) {
+      content += `  ${c.name}: ${c.typed};\n`;
     }
+    content += '  strings: string[];\n';
+    content += '}\n\n';
 
-    fs.writeFileSync(path.join(outputDir, 'generated_types.ts'), content);
+    content += `export const ${name} = {\n`;
+    content += '  // length строк со значениями по умолчанию\n';
+    content += `  create(length: number): ${name} {\n`;
+    content += '    return {\n';
+    content += '      length,\n';
+    for (const c of columns) {
+      content += `      ${c.name}: new ${c.typed}(length),\n`;
+    }
+    content += `      strings: ${hasStrings ? `['']` : '[]'}\n`;
+    content += '    };\n';
+    content += '  },\n\n';
+    content += '  // Раскладывает массив объектов по колонкам\n';
+    content += `  from(rows: ${struct.name}[]): ${name} {\n`;
+    content += `    const columns = ${name}.create(rows.length);\n`;
+    if (hasStrings) {
+      content += `    const ids = new Map<string, number>([['', 0]]);\n`;
+    }
+    content += '    for (let i = 0; i < rows.length; i++) {\n';
+    content += '      const row = rows[i];\n';
+    for (const c of columns) {
+      const value = `row.${c.name}${c.fallback}`;
+      const assigned = c.isString ? `internColumnString(columns.strings, ids, ${value})`
+        : c.isBool ? `row.${c.name} ? 1 : 0` : value;
+      content += `      columns.${c.name}[i] = ${assigned};\n`;
+    }
+    content += '    }\n';
+    content += '    return columns;\n';
+    content += '  },\n\n';
+    content += '  // Строка i как объект\n';
+    content += `  row(columns: ${name}, i: number): ${struct.name} {\n`;
+    content += '    return {\n';
+    content += columns.map(c => {
+      const value = c.isString && c.isOptional
+        ? `columns.${c.name}[i] === MISSING_COLUMN_STRING ? undefined : columns.strings[columns.${c.name}[i]]`
+        : c.isString ? `columns.strings[columns.${c.name}[i]]`
+        : c.isBool ? `columns.${c.name}[i] !== 0` : `columns.${c.name}[i]`;
+      return `      ${c.name}: ${value}`;
+    }).join(',\n') + '\n';
+    content += '    };\n';
+    content += '  }\n';
+    content += '};\n\n';
+    return content;
   }
 
   /**
@@ -1070,8 +4525,9 @@ export class CppGenerator {
     
     // Собираем семантические типы для импорта
     const usedSemanticTypes = new Set<string>();
+    const nativeMethods = parseResult.classes.flatMap(cls => cls.methods);
     
-    for (const exp of parseResult.exports) {
+    for (const exp of [...parseResult.exports, ...nativeMethods]) {
       // Проверяем типы в параметрах и возвращаемом значении
       const paramTSType = this.cppTypeToTSType(exp.paramType);
       const returnTSType = this.cppTypeToTSType(exp.returnType);
@@ -1093,7 +4549,7 @@ export class CppGenerator {
     }
     
     // Импорт сгенерированных типов
-    const structNames = parseResult.structs.map(s => s.name);
+    const structNames = parseResult.structs.flatMap(s => s.isView ? [s.name, `${s.name}View`] : [s.name]);
     if (structNames.length > 0) {
       content += `import { ${structNames.join(', ')} } from './generated_types';\n`;
     }
@@ -1105,48 +4561,161 @@ export class CppGenerator {
     // Декларация для require
     content += 'declare const require: any;\n\n';
 
+    // Счетчики TSCB_PROFILE (пустой объект, если addon собран без define TSCB_PROFILE)
+    content += 'export interface BridgePhaseStats {\n';
+    content += '  count: number;\n';
+    content += '  totalNs: number;\n';
+    content += '  maxNs: number;\n';
+    content += '  avgNs: number;\n';
+    content += '}\n\n';
+    content += 'export interface BridgeCallStats {\n';
+    content += '  decode: BridgePhaseStats;\n';
+    content += '  execute: BridgePhaseStats;\n';
+    content += '  encode: BridgePhaseStats;\n';
+    content += '  queueWait: BridgePhaseStats;\n';
+    content += '}\n\n';
+    content += 'export type BridgeStats = { [exportName: string]: BridgeCallStats };\n\n';
+
+    // Нативная память незавершенных вызовов по экспортам, "views" - ленивые view
+    content += 'export interface BridgeMemoryGauge {\n';
+    content += '  bytes: number;\n';
+    content += '  peakBytes: number;\n';
+    content += '}\n\n';
+    content += 'export type BridgeMemory = { [exportName: string]: BridgeMemoryGauge };\n\n';
+
+    // Токен отмены для @CppAsync({ cancellable: true })
+    const hasCancellable = [...parseResult.exports, ...nativeMethods].some(exp => exp.cancellable);
+    if (hasCancellable) {
+      content += 'export interface CancelTokenNative {\n';
+      content += '  cancel(): void;\n';
+      content += '}\n\n';
+    }
+
+    // Экземпляры нативных классов (@CppClass)
+    for (const cls of parseResult.classes) {
+      content += `export interface ${cls.name}Native {\n`;
+      for (const method of cls.methods) {
+        content += `  ${method.methodName}${this.methodTSSignature(method, parseResult.structs, 'native')};\n`;
+      }
+      content += '  dispose(): void;\n';
+      content += '}\n\n';
+    }
+
+    // Дескриптор потока @CppStream: протокол async iterator без Symbol.asyncIterator
+    const hasStreams = parseResult.exports.some(exp => exp.isStream);
+    if (hasStreams) {
+      content += 'export interface NativeStream<T> {\n';
+      content += '  next(): Promise<IteratorResult<T, undefined>>;\n';
+      content += '  return(): Promise<IteratorResult<T, undefined>>;\n';
+      content += '}\n\n';
+    }
+
     // Определяем интерфейс addon с правильными именами функций
     content += 'interface AddonExports {\n';
+    // Имена свойств addon для ленивой загрузки
+    const exportNames: string[] = [];
+    const member = (name: string, type: string) => {
+      exportNames.push(name);
+      content += `  ${name}: ${type};\n`;
+    };
     for (const exp of parseResult.exports) {
       const paramType = this.cppTypeToTSType(exp.paramType);
-      const returnType = this.cppTypeToTSType(exp.returnType);
+      const returnType = this.resultTSType(exp.returnType, parseResult.structs);
       
-      if (exp.isAsync) {
-        content += `  ${exp.name}: (input: ${paramType}) => Promise<${returnType}>;\n`;
+      if (exp.isStream) {
+        const params = exp.paramType === 'void' ? '' : `input: ${paramType}`;
+        member(exp.name, `(${params}) => NativeStream<${returnType}>`);
+      } else if (exp.isAsync) {
+        const cancel = exp.cancellable ? ', cancel?: CancelTokenNative' : '';
+        member(exp.name, `(input: ${paramType}${cancel}) => Promise<${returnType}>`);
+        if (this.hasBatch(exp)) {
+          member(`${exp.name}_batch`, `(inputs: ${paramType}[]${cancel}) => Promise<${returnType}[]>`);
+        }
+        if (exp.coalesce) {
+          member(`${exp.name}_settle`, `(inputs: ${paramType}[]) => Promise<PromiseSettledResult<${returnType}>[]>`);
+        }
       } else {
-        content += `  ${exp.name}: (input: ${paramType}) => ${returnType};\n`;
+        member(exp.name, `(input: ${paramType}) => ${returnType}`);
+        if (this.hasBatch(exp)) {
+          member(`${exp.name}_batch`, `(inputs: ${paramType}[]) => ${returnType}[]`);
+        }
       }
+      if (exp.transport === 'binary') {
+        const wireResult = exp.isAsync ? 'Promise<ArrayBuffer>' : 'ArrayBuffer';
+        const cancel = exp.cancellable ? ', cancel?: CancelTokenNative' : '';
+        member(`${exp.name}_wire`, `(payload: ArrayBuffer | Uint8Array${cancel}) => ${wireResult}`);
+      }
+      const flatStruct = this.flatArgsStruct(exp, parseResult.structs);
+      if (flatStruct) {
+        const params = flatStruct.fields.map(field => {
+          const type = field.isTypedArray ? field.tsType : this.fieldCppType(field) === 'bool' ? 'boolean' : 'number';
+          return `${field.name}: ${type}${field.isOptional ? ' | undefined' : ''}`;
+        });
+        member(`${exp.name}_flat`, `(${params.join(', ')}) => ${returnType}`);
+      }
+    }
+    for (const cls of parseResult.classes) {
+      const ctorParams = cls.constructorParamType === 'void' ? '' : `config: ${this.cppTypeToTSType(cls.constructorParamType)}`;
+      member(cls.name, `new (${ctorParams}) => ${cls.name}Native`);
+    }
+    if (hasCancellable) {
+      member('__CancelToken', 'new (timeoutMs?: number) => CancelTokenNative');
     }
+    member('__initPool', '(size: number) => void');
+    member('__bridgeStats', '(reset?: boolean) => BridgeStats');
+    member('__bridgeMemory', '() => BridgeMemory');
     content += '}\n\n';
 
-    // Загрузка addon
-    content += 'let addon: AddonExports;\n\n';
-    content += 'try {\n';
-    content += '  // Пробуем разные пути для поддержки ts-node и обычного node\n';
-    content += '  let addonPath;\n';
+    // Загрузка addon: require выполняется при первом обращении к экспорту, а не при импорте
+    content += 'let native: AddonExports | undefined;\n\n';
+    content += '/**\n';
+    content += ' * Загружает нативный addon (повторные вызовы возвращают тот же объект).\n';
+    content += ' * Вызывается автоматически при первом обращении к экспорту; явный вызов переносит загрузку на старт.\n';
+    content += ' */\n';
+    content += 'export function loadAddon(): AddonExports {\n';
+    content += '  if (native !== undefined) {\n';
+    content += '    return native;\n';
+    content += '  }\n';
     content += '  try {\n';
-    content += '    addonPath = require.resolve(\'../../../build/Release/addon.node\');\n';
-    content += '    addon = require(addonPath);\n';
-    content += '  } catch (e1) {\n';
+    content += '    // Пробуем разные пути для поддержки ts-node и обычного node\n';
+    content += '    let addonPath;\n';
     content += '    try {\n';
-    content += '      addonPath = require.resolve(\'../../build/Release/addon.node\');\n';
-    content += '      addon = require(addonPath);\n';
-    content += '    } catch (e2) {\n';
+    content += '      addonPath = require.resolve(\'../../../build/Release/addon.node\');\n';
+    content += '    } catch (e1) {\n';
     content += '      try {\n';
-    content += '        addonPath = require.resolve(\'../build/Release/addon.node\');\n';
-    content += '        addon = require(addonPath);\n';
-    content += '      } catch (e3) {\n';
-    content += '        addonPath = require.resolve(\'./build/Release/addon.node\');\n';
-    content += '        addon = require(addonPath);\n';
+    content += '        addonPath = require.resolve(\'../../build/Release/addon.node\');\n';
+    content += '      } catch (e2) {\n';
+    content += '        try {\n';
+    content += '          addonPath = require.resolve(\'../build/Release/addon.node\');\n';
+    content += '        } catch (e3) {\n';
+    content += '          addonPath = require.resolve(\'./build/Release/addon.node\');\n';
+    content += '        }\n';
     content += '      }\n';
     content += '    }\n';
+    content += '    native = require(addonPath) as AddonExports;\n';
+    content += '  } catch (e) {\n';
+    content += '    throw new Error(\'Native addon not found. Run npm run build first.\');\n';
     content += '  }\n';
-    content += '} catch (e) {\n';
-    content += '  throw new Error(\'Native addon not found. Run npm run build first.\');\n';
+    content += '  return native;\n';
+    content += '}\n\n';
+
+    // Getter свойства загружает addon и заменяет себя значением: дальше вызовы идут напрямую
+    content += 'const addon = {} as AddonExports;\n';
+    content += `const exportNames: (keyof AddonExports)[] = [${exportNames.map(name => `'${name}'`).join(', ')}];\n`;
+    content += 'for (const name of exportNames) {\n';
+    content += '  Object.defineProperty(addon, name, {\n';
+    content += '    configurable: true,\n';
+    content += '    enumerable: true,\n';
+    content += '    get() {\n';
+    content += '      const value = loadAddon()[name];\n';
+    content += '      Object.defineProperty(addon, name, { value, enumerable: true });\n';
+    content += '      return value;\n';
+    content += '    },\n';
+    content += '  });\n';
     content += '}\n\n';
     content += 'export default addon;\n';
 
-    fs.writeFileSync(path.join(outputDir, 'generated_addon.ts'), content);
+    this.writeOutput(path.join(outputDir, 'generated_addon.ts'), content);
 
     // Создаем также API файл с удобными классами
     this.generateAPIFile(parseResult, outputDir);
@@ -1160,8 +4729,9 @@ export class CppGenerator {
     
     // Собираем семантические типы для импорта
     const usedSemanticTypes = new Set<string>();
+    const nativeMethods = parseResult.classes.flatMap(cls => cls.methods);
     
-    for (const exp of parseResult.exports) {
+    for (const exp of [...parseResult.exports, ...nativeMethods]) {
       // Проверяем типы в параметрах и возвращаемом значении
       const paramTSType = this.cppTypeToTSType(exp.paramType);
       const returnTSType = this.cppTypeToTSType(exp.returnType);
@@ -1183,14 +4753,128 @@ export class CppGenerator {
     }
     
     // Импорт сгенерированных типов
-    const structNames = parseResult.structs.map(s => s.name);
+    const structNames = parseResult.structs.flatMap(s => s.isView ? [s.name, `${s.name}View`] : [s.name]);
     if (structNames.length > 0) {
       content += `import { ${structNames.join(', ')} } from './generated_types';\n`;
     }
-    content += `import addon from './generated_addon';\n\n`;
+    const nativeTypes = parseResult.classes.map(cls => `${cls.name}Native`);
+    const hasStreams = parseResult.exports.some(exp => exp.isStream);
+    if (hasStreams) {
+      nativeTypes.push('NativeStream');
+    }
+    const hasCancellable = [...parseResult.exports, ...nativeMethods].some(exp => exp.cancellable);
+    if (hasCancellable) {
+      nativeTypes.push('CancelTokenNative');
+    }
+    content += `import addon, { ${['BridgeStats', 'BridgeMemory', ...nativeTypes].join(', ')} } from './generated_addon';\n`;
+    const wireStructs = this.collectWireStructs(parseResult);
+    if (wireStructs.size > 0) {
+      content += `import * as wire from './generated_wire';\n`;
+      this.generateWireFile(parseResult, wireStructs, outputDir);
+    }
+    content += '\n';
+
+    if (hasStreams) {
+      content += '// Дескриптор потока как AsyncIterableIterator (for await, break вызывает return())\n';
+      content += 'function streamIterator<T>(stream: NativeStream<T>): AsyncIterableIterator<T> {\n';
+      content += '  return {\n';
+      content += '    next: () => stream.next(),\n';
+      content += '    return: () => stream.return(),\n';
+      content += '    [Symbol.asyncIterator]() { return this; }\n';
+      content += '  } as AsyncIterableIterator<T>;\n';
+      content += '}\n\n';
+    }
+
+    if (hasCancellable) {
+      content += 'export interface CallOptions {\n';
+      content += '  signal?: AbortSignal;  // отмена: задача снимается из очереди, C++ видит cancel.Cancelled()\n';
+      content += '  timeoutMs?: number;    // дедлайн от момента вызова, включая ожидание в очереди\n';
+      content += '}\n\n';
+      content += '// Создает нативный токен для вызова; при отмене через signal Promise отклоняется с signal.reason\n';
+      content += 'function withCancel<T>(options: CallOptions, call: (cancel?: CancelTokenNative) => Promise<T>): Promise<T> {\n';
+      content += '  const { signal, timeoutMs } = options;\n';
+      content += '  if (!signal && timeoutMs === undefined) {\n';
+      content += '    return call();\n';
+      content += '  }\n';
+      content += '  if (signal?.aborted) {\n';
+      content += '    return Promise.reject(signal.reason);\n';
+      content += '  }\n';
+      content += '  const token = new addon.__CancelToken(timeoutMs);\n';
+      content += '  if (!signal) {\n';
+      content += '    return call(token);\n';
+      content += '  }\n';
+      content += '  const abort = () => token.cancel();\n';
+      content += '  signal.addEventListener(\'abort\', abort, { once: true });\n';
+      content += '  return call(token)\n';
+      content += '    .catch(error => { throw signal.aborted ? signal.reason : error; })\n';
+      content += '    .finally(() => signal.removeEventListener(\'abort\', abort));\n';
+      content += '}\n\n';
+    }
+
+    if (parseResult.exports.some(exp => exp.coalesce)) {
+      content += '// Объединяет вызовы @CppAsync({ coalesce }) в один <name>_batch: одна задача пула\n';
+      content += '// и одно завершение в главном потоке на все входы, накопленные за окно\n';
+      content += 'class Coalescer<I, O> {\n';
+      content += '  private inputs: I[] = [];\n';
+      content += '  private waiters: { resolve: (result: O) => void; reject: (error: unknown) => void }[] = [];\n';
+      content += '  private timer: ReturnType<typeof setTimeout> | undefined;\n';
+      content += '  private scheduled = false;\n\n';
+      content += '  constructor(\n';
+      content += '    private readonly runBatch: (inputs: I[]) => Promise<PromiseSettledResult<O>[]>,\n';
+      content += '    private readonly windowMs: number,\n';
+      content += '    private readonly maxItems: number\n';
+      content += '  ) {}\n\n';
+      content += '  call(input: I): Promise<O> {\n';
+      content += '    return new Promise<O>((resolve, reject) => {\n';
+      content += '      this.inputs.push(input);\n';
+      content += '      this.waiters.push({ resolve, reject });\n';
+      content += '      if (this.inputs.length >= this.maxItems) {\n';
+      content += '        this.flush();\n';
+      content += '      } else if (!this.scheduled) {\n';
+      content += '        // windowMs = 0: собираются вызовы текущего синхронного участка (например, Promise.all)\n';
+      content += '        this.scheduled = true;\n';
+      content += '        if (this.windowMs > 0) {\n';
+      content += '          this.timer = setTimeout(() => this.flush(), this.windowMs);\n';
+      content += '        } else {\n';
+      content += '          queueMicrotask(() => this.flush());\n';
+      content += '        }\n';
+      content += '      }\n';
+      content += '    });\n';
+      content += '  }\n\n';
+      content += '  private flush(): void {\n';
+      content += '    if (this.timer !== undefined) {\n';
+      content += '      clearTimeout(this.timer);\n';
+      content += '      this.timer = undefined;\n';
+      content += '    }\n';
+      content += '    this.scheduled = false;\n';
+      content += '    const inputs = this.inputs;\n';
+      content += '    const waiters = this.waiters;\n';
+      content += '    if (inputs.length === 0) {\n';
+      content += '      return;\n';
+      content += '    }\n';
+      content += '    this.inputs = [];\n';
+      content += '    this.waiters = [];\n';
+      content += '    // <name>_settle сообщает исход каждого входа: ошибка доходит только до своего вызова.\n';
+      content += '    // Исключение самого вызова (в том числе синхронное) отклоняет весь пакет - ни один вход не выполнялся\n';
+      content += '    Promise.resolve().then(() => this.runBatch(inputs)).then(\n';
+      content += '      outcomes => outcomes.forEach((outcome, i) => {\n';
+      content += '        if (outcome.status === \'fulfilled\') {\n';
+      content += '          waiters[i].resolve(outcome.value);\n';
+      content += '        } else {\n';
+      content += '          waiters[i].reject(outcome.reason);\n';
+      content += '        }\n';
+      content += '      }),\n';
+      content += '      error => waiters.forEach(waiter => waiter.reject(error))\n';
+      content += '    );\n';
+      content += '  }\n';
+      content += '}\n\n';
+    }
 
     // Группируем экспорты по классам
     const classMethods = new Map<string, ParsedExport[]>();
+    for (const cls of parseResult.classes) {
+      classMethods.set(cls.name, []);
+    }
     
     for (const exp of parseResult.exports) {
       if (exp.className) {
@@ -1204,23 +4888,295 @@ export class CppGenerator {
     // Генерируем классы с статическими методами
     for (const [className, methods] of classMethods) {
       content += `export class ${className} {\n`;
+      const nativeClass = parseResult.classes.find(cls => cls.name === className);
+      if (nativeClass) {
+        content += this.generateNativeClassMembers(nativeClass, parseResult.structs);
+      }
       for (const method of methods) {
         const paramType = this.cppTypeToTSType(method.paramType);
-        const returnType = this.cppTypeToTSType(method.returnType);
+        const returnType = this.resultTSType(method.returnType, parseResult.structs);
         
-        if (method.isAsync) {
+        if (method.isStream) {
+          // Чанки приходят по мере готовности; медленный потребитель притормаживает C++
+          const params = method.paramType === 'void' ? '' : `input: ${paramType}`;
+          const args = method.paramType === 'void' ? '' : 'input';
+          content += `  static ${method.methodName}(${params}): AsyncIterableIterator<${returnType}> {\n`;
+          content += `    return streamIterator(addon.${method.name}(${args}));\n`;
+          content += `  }\n\n`;
+          continue;
+        }
+
+        const flatStruct = this.flatArgsStruct(method, parseResult.structs);
+        if (method.transport === 'binary') {
+          // Вход кодируется в один буфер, результат декодируется из ArrayBuffer
+          const encoded = `wire.encode(input, wire.write${method.paramType})`;
+          const reader = parseResult.structs.some(s => s.name === method.returnType)
+            ? `wire.read${method.returnType}`
+            : `r => ${this.wireReadTS(method.returnType, parseResult.enums, 'wire.')}`;
+          if (method.cancellable) {
+            content += `  static async ${method.methodName}(input: ${paramType}, options: CallOptions = {}): Promise<${returnType}> {\n`;
+            content += `    return wire.decode(await withCancel(options, cancel => addon.${method.name}_wire(${encoded}, cancel)), ${reader});\n`;
+          } else if (method.isAsync) {
+            content += `  static async ${method.methodName}(input: ${paramType}): Promise<${returnType}> {\n`;
+            content += `    return wire.decode(await addon.${method.name}_wire(${encoded}), ${reader});\n`;
+          } else {
+            content += `  static ${method.methodName}(input: ${paramType}): ${returnType} {\n`;
+            content += `    return wire.decode(addon.${method.name}_wire(${encoded}), ${reader});\n`;
+          }
+        } else if (method.cancellable) {
+          content += `  static async ${method.methodName}(input: ${paramType}, options: CallOptions = {}): Promise<${returnType}> {\n`;
+          content += `    return withCancel(options, cancel => addon.${method.name}(input, cancel));\n`;
+        } else if (method.coalesce) {
+          const queue = `${method.methodName}Coalescer`;
+          content += `  private static readonly ${queue} = new Coalescer<${paramType}, ${returnType}>(\n`;
+          content += `    inputs => addon.${method.name}_settle(inputs), ${method.coalesce.windowMs}, ${method.coalesce.maxItems});\n\n`;
+          content += `  static async ${method.methodName}(input: ${paramType}): Promise<${returnType}> {\n`;
+          content += `    return ${className}.${queue}.call(input);\n`;
+        } else if (method.isAsync) {
           content += `  static async ${method.methodName}(input: ${paramType}): Promise<${returnType}> {\n`;
           content += `    return addon.${method.name}(input);\n`;
+        } else if (flatStruct) {
+          // Поля читаются в JS и передаются позиционно: C++ не обращается к свойствам объекта
+          const args = flatStruct.fields.map(field => `input.${field.name}`);
+          content += `  static ${method.methodName}(input: ${paramType}): ${returnType} {\n`;
+          content += `    return addon.${method.name}_flat(${args.join(', ')});\n`;
         } else {
           content += `  static ${method.methodName}(input: ${paramType}): ${returnType} {\n`;
           content += `    return addon.${method.name}(input);\n`;
         }
         content += `  }\n\n`;
+
+        // Пакетный вызов: один переход в C++ на весь массив входов
+        if (!this.hasBatch(method)) {
+          continue;
+        }
+        if (method.cancellable) {
+          content += `  static async ${method.methodName}Batch(inputs: ${paramType}[], options: CallOptions = {}): Promise<${returnType}[]> {\n`;
+          content += `    return withCancel(options, cancel => addon.${method.name}_batch(inputs, cancel));\n`;
+          content += `  }\n\n`;
+          continue;
+        }
+        if (method.isAsync) {
+          content += `  static async ${method.methodName}Batch(inputs: ${paramType}[]): Promise<${returnType}[]> {\n`;
+        } else {
+          content += `  static ${method.methodName}Batch(inputs: ${paramType}[]): ${returnType}[] {\n`;
+        }
+        content += `    return addon.${method.name}_batch(inputs);\n`;
+        content += `  }\n\n`;
       }
       content += '}\n\n';
     }
 
-    fs.writeFileSync(path.join(outputDir, 'generated_api.ts'), content);
+    content += '/**\n';
+    content += ' * Задает размер нативного пула для @CppAsync({ pool: \'native\' }).\n';
+    content += ' * Вызывать до первого асинхронного вызова; 0 - по числу аппаратных потоков.\n';
+    content += ' */\n';
+    content += 'export function initThreadPool(size: number): void {\n';
+    content += '  addon.__initPool(size);\n';
+    content += '}\n';
+    content += '\n';
+    content += '/**\n';
+    content += ' * Счетчики горячего пути по экспортам: decode/execute/encode/queueWait.\n';
+    content += ' * Заполняются только в сборке с define TSCB_PROFILE; reset обнуляет счетчики.\n';
+    content += ' */\n';
+    content += 'export function bridgeStats(reset: boolean = false): BridgeStats {\n';
+    content += '  return addon.__bridgeStats(reset);\n';
+    content += '}\n';
+    content += '\n';
+    content += '/**\n';
+    content += ' * Байты, которые держит нативная сторона: входы и результаты незавершенных\n';
+    content += ' * async вызовов по экспортам и ленивые view. peakBytes - максимум с запуска.\n';
+    content += ' */\n';
+    content += 'export function bridgeMemory(): BridgeMemory {\n';
+    content += '  return addon.__bridgeMemory();\n';
+    content += '}\n';
+
+    this.writeOutput(path.join(outputDir, 'generated_api.ts'), content);
+  }
+
+  /**
+   * Разбирает аргументы шаблона C++ типа верхнего уровня: "K, std::vector<V>" -> ["K", "std::vector<V>"]
+   */
+  private splitTemplateArgs(args: string): string[] {
+    const result: string[] = [];
+    let depth = 0;
+    let start = 0;
+    for (let i = 0; i < args.length; i++) {
+      if (args[i] === '<') depth++;
+      else if (args[i] === '>') depth--;
+      else if (args[i] === ',' && depth === 0) {
+        result.push(args.slice(start, i).trim());
+        start = i + 1;
+      }
+    }
+    result.push(args.slice(start).trim());
+    return result;
+  }
+
+  /**
+   * Вложенный тип C++ контейнера: ['std::vector', 'T'] и т.п.; null - не контейнер
+   */
+  private wireContainer(cppType: string): { kind: 'vector' | 'set' | 'map'; args: string[] } | null {
+    const match = cppType.match(/^(?:std::|tscb::)(vector|unordered_set|unordered_map|FlatMap)<(.*)>$/);
+    if (!match) {
+      return null;
+    }
+    const kind = match[1] === 'vector' ? 'vector' : match[1] === 'unordered_set' ? 'set' : 'map';
+    return { kind, args: this.splitTemplateArgs(match[2]) };
+  }
+
+  /**
+   * TS выражение записи значения C++ типа в WireWriter w
+   */
+  private wireWriteTS(cppType: string, expr: string, enums: ParsedEnum[]): string {
+    const scalar = this.wireScalar(cppType, enums);
+    if (scalar) {
+      return `w.${scalar.method}(${expr})`;
+    }
+    if (cppType === 'std::string') {
+      return `w.string(${expr})`;
+    }
+    const container = this.wireContainer(cppType);
+    if (container && container.kind === 'map') {
+      const [keyType, valueType] = container.args;
+      const key = keyType === 'std::string' ? 'String(key)' : 'Number(key)';
+      return `w.map(${expr}, key => ${this.wireWriteTS(keyType, key, enums)}, item => ${this.wireWriteTS(valueType, 'item', enums)})`;
+    }
+    if (container) {
+      return `w.array(${expr}, item => ${this.wireWriteTS(container.args[0], 'item', enums)})`;
+    }
+    return `write${cppType}(w, ${expr})`;
+  }
+
+  /**
+   * TS выражение чтения значения C++ типа из WireReader r
+   */
+  private wireReadTS(cppType: string, enums: ParsedEnum[], prefix: string = ''): string {
+    const scalar = this.wireScalar(cppType, enums);
+    if (scalar) {
+      return `r.${scalar.method}()`;
+    }
+    if (cppType === 'std::string') {
+      return 'r.string()';
+    }
+    const container = this.wireContainer(cppType);
+    if (container && container.kind === 'map') {
+      const [keyType, valueType] = container.args;
+      return `r.map(() => ${this.wireReadTS(keyType, enums, prefix)}, () => ${this.wireReadTS(valueType, enums, prefix)})`;
+    }
+    if (container) {
+      return `r.${container.kind === 'set' ? 'set' : 'array'}(() => ${this.wireReadTS(container.args[0], enums, prefix)})`;
+    }
+    return `${prefix}read${cppType}(r)`;
+  }
+
+  /**
+   * Генерирует generated_wire.ts: WireWriter/WireReader и кодеки структур для transport: 'binary'.
+   * Порядок полей совпадает с <Name>::WireDecode/WireEncode: сначала числовые, затем остальные.
+   */
+  private generateWireFile(parseResult: ParseResult, wireStructs: Set<string>, outputDir: string): void {
+    const structs = parseResult.structs.filter(s => wireStructs.has(s.name));
+    let content = fs.readFileSync(path.join(__dirname, 'templates', 'wire.ts.template'), 'utf-8');
+    if (structs.length > 0) {
+      content = `import { ${structs.map(s => s.name).join(', ')} } from './generated_types';\n\n` + content;
+    }
+    content = '// Бинарный формат transport: \'binary\' (генерируется автоматически, НЕ ИЗМЕНЯЙТЕ)\n\n' + content;
+
+    for (const struct of structs) {
+      const isScalar = (field: ParsedField) => !field.isTypedArray && this.wireScalar(this.fieldCppType(field), parseResult.enums) !== null;
+      const ordered = [...struct.fields.filter(isScalar), ...struct.fields.filter(f => !isScalar(f))];
+
+      content += `\nexport function write${struct.name}(w: WireWriter, v: ${struct.name}): void {\n`;
+      for (const field of ordered) {
+        const value = `v.${field.name}`;
+        const cppType = this.fieldCppType(field);
+        const container = this.wireContainer(cppType);
+        // Отсутствующие поля передаются значениями по умолчанию, как в FromNapi
+        if (field.isTypedArray) {
+          content += `  w.typed(${value});\n`;
+        } else if (cppType === 'bool') {
+          content += `  w.bool(${value});\n`;
+        } else if (this.wireScalar(cppType, parseResult.enums)) {
+          content += `  ${this.wireWriteTS(cppType, `${value} ?? 0`, parseResult.enums)};\n`;
+        } else if (cppType === 'std::string') {
+          content += `  w.string(${value} ?? '');\n`;
+        } else if (container) {
+          content += `  ${this.wireWriteTS(cppType, `${value} ?? ${container.kind === 'map' ? '{}' : '[]'}`, parseResult.enums)};\n`;
+        } else {
+          content += `  ${this.wireWriteTS(cppType, `${value} ?? ({} as ${cppType})`, parseResult.enums)};\n`;
+        }
+      }
+      content += `}\n`;
+
+      content += `\nexport function read${struct.name}(r: WireReader): ${struct.name} {\n`;
+      for (const field of ordered) {
+        const read = field.isTypedArray
+          ? `r.${field.isShared ? 'shared' : 'typed'}(${field.tsType})`
+          : this.wireReadTS(this.fieldCppType(field), parseResult.enums);
+        content += `  const f_${field.name} = ${read};\n`;
+      }
+      content += `  return {\n`;
+      for (const field of struct.fields) {
+        content += `    ${field.name}: f_${field.name},\n`;
+      }
+      content += `  };\n`;
+      content += `}\n`;
+    }
+
+    this.writeOutput(path.join(outputDir, 'generated_wire.ts'), content);
+  }
+
+  /**
+   * Конструктор и методы экземпляра TS класса, делегирующие в нативный объект @CppClass
+   */
+  private generateNativeClassMembers(cls: ParsedClass, structs: ParsedStruct[]): string {
+    const hasConfig = cls.constructorParamType !== 'void';
+    let content = `  private readonly native: ${cls.name}Native;\n\n`;
+    content += `  constructor(${hasConfig ? `config: ${this.cppTypeToTSType(cls.constructorParamType)}` : ''}) {\n`;
+    content += `    this.native = new addon.${cls.name}(${hasConfig ? 'config' : ''});\n`;
+    content += `  }\n\n`;
+    for (const method of cls.methods) {
+      const hasInput = method.paramType !== 'void';
+      content += `  ${method.methodName}${this.methodTSSignature(method, structs, 'options')} {\n`;
+      if (method.cancellable) {
+        content += `    return withCancel(options, cancel => this.native.${method.methodName}(${hasInput ? 'input' : 'undefined'}, cancel));\n`;
+      } else {
+        content += `    return this.native.${method.methodName}(${hasInput ? 'input' : ''});\n`;
+      }
+      content += `  }\n\n`;
+    }
+    content += `  /** Освобождает C++ объект, не дожидаясь сборки мусора */\n`;
+    content += `  dispose(): void {\n`;
+    content += `    this.native.dispose();\n`;
+    content += `  }\n\n`;
+    return content;
+  }
+
+  /**
+   * Параметры и тип результата метода @CppClass: "(input: In): Out".
+   * Для cancellable: 'native' - токен вторым аргументом, 'options' - CallOptions.
+   */
+  private methodTSSignature(method: ParsedExport, structs: ParsedStruct[], cancel: 'native' | 'options'): string {
+    const params = method.paramType === 'void' ? [] : [`input: ${this.cppTypeToTSType(method.paramType)}`];
+    if (method.cancellable && cancel === 'native') {
+      // Токен всегда вторым аргументом (info[1] в C++ wrapper)
+      if (params.length === 0) {
+        params.push('input?: undefined');
+      }
+      params.push('cancel?: CancelTokenNative');
+    } else if (method.cancellable) {
+      params.push('options: CallOptions = {}');
+    }
+    const result = this.resultTSType(method.returnType, structs);
+    return `(${params.join(', ')}): ${method.isAsync ? `Promise<${result}>` : result}`;
+  }
+
+  /**
+   * TypeScript тип результата: для @CppStruct({ view: true }) - ленивый <Name>View
+   */
+  private resultTSType(cppType: string, structs: ParsedStruct[]): string {
+    const struct = structs.find(s => s.name === cppType);
+    return struct && struct.isView ? `${struct.name}View` : this.cppTypeToTSType(cppType);
   }
 
   /**
@@ -1230,8 +5186,11 @@ export class CppGenerator {
     // Используем оригинальный TS тип напрямую
     let baseType = field.tsType;
     
-    // Не добавляем [] если тип уже содержит []
-    if (field.isArray && !baseType.endsWith('[]')) {
+    if (field.isArray && structs.some(s => s.name === field.arrayElementType && s.isColumnar)) {
+      // Массив колоночной структуры передается как <Name>Columns
+      baseType = `${field.arrayElementType}Columns`;
+    } else if (field.isArray && !baseType.endsWith('[]')) {
+      // Не добавляем [] если тип уже содержит []
       baseType += '[]';
     }
     
@@ -1,4 +1,5 @@
 // Основная точка входа для ts-cpp-bridge
 export * from './decorators';
 export * from './numeric-types';
-export * from './generator';
\ No newline at end of file
+export * from './generator';
+export * from './prebuild';
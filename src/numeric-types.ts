@@ -34,6 +34,33 @@ export const TypeMapping = {
   'f64': 'double'
 } as const;
 
+// Маппинг TypedArray типов на C++ типы элементов
+export const TypedArrayMapping = {
+  'Int8Array': 'int8_t',
+  'Uint8Array': 'uint8_t',
+  'Int16Array': 'int16_t',
+  'Uint16Array': 'uint16_t',
+  'Int32Array': 'int32_t',
+  'Uint32Array': 'uint32_t',
+  'Float32Array': 'float',
+  'Float64Array': 'double',
+  'BigInt64Array': 'int64_t',
+  'BigUint64Array': 'uint64_t'
+} as const;
+
+// Массивы уточняемых типов, которые передаются как TypedArray (u8[] -> Uint8Array).
+// i64/u64 не входят: их элементы - обычные числа JS, а не BigInt
+export const PreciseArrayMapping = {
+  'i8': 'Int8Array',
+  'u8': 'Uint8Array',
+  'i16': 'Int16Array',
+  'u16': 'Uint16Array',
+  'i32': 'Int32Array',
+  'u32': 'Uint32Array',
+  'f32': 'Float32Array',
+  'f64': 'Float64Array'
+} as const;
+
 // Маппинг для Node.js N-API типов
 export const NapiTypeMapping = {
   'string': 'String',
@@ -62,8 +89,8 @@ export const NapiExtractorMapping = {
   'u16': '.As<Napi::Number>().Uint32Value()',
   'i32': '.As<Napi::Number>().Int32Value()',
   'u32': '.As<Napi::Number>().Uint32Value()',
-  'i64': '.As<Napi::BigInt>().Int64Value()',
-  'u64': '.As<Napi::BigInt>().Uint64Value()',
+  'i64': '.As<Napi::Number>().Int64Value()',
+  'u64': '.As<Napi::Number>().Int64Value()',
   'f32': '.As<Napi::Number>().FloatValue()',
   'f64': '.As<Napi::Number>().DoubleValue()'
 } as const;
@@ -95,6 +122,11 @@ export function getCppType(tsType: string): string {
     return `std::vector<${cppInnerType}>`;
   }
   
+  // Обработка TypedArray типов (Float64Array -> std::vector<double>)
+  if (isTypedArrayType(tsType)) {
+    return `std::vector<${getTypedArrayElementType(tsType)}>`;
+  }
+  
   // Обработка массивов типа Type[]
   if (tsType.endsWith('[]')) {
     const innerType = tsType.slice(0, -2); // Убираем []
@@ -125,3 +157,24 @@ export function getNapiExtractor(tsType: string): string {
 export function isPreciseNumericType(tsType: string): boolean {
   return ['i8', 'u8', 'i16', 'u16', 'i32', 'u32', 'i64', 'u64', 'f32', 'f64'].includes(tsType);
 }
+
+/**
+ * Проверить, является ли тип TypedArray (Float64Array, Int32Array и т.д.)
+ */
+export function isTypedArrayType(tsType: string): boolean {
+  return Object.prototype.hasOwnProperty.call(TypedArrayMapping, tsType);
+}
+
+/**
+ * Получить C++ тип элемента TypedArray
+ */
+export function getTypedArrayElementType(tsType: string): string | undefined {
+  return TypedArrayMapping[tsType as keyof typeof TypedArrayMapping];
+}
+
+/**
+ * Получить TypedArray для массива уточняемого числового типа (u8 -> Uint8Array)
+ */
+export function getPreciseArrayType(elementType: string): string | undefined {
+  return PreciseArrayMapping[elementType as keyof typeof PreciseArrayMapping];
+}
@@ -0,0 +1,173 @@
+import * as crypto from 'crypto';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { execSync } from 'child_process';
+
+/**
+ * Опции сборки addon через кэш бинарников (ts-cpp-bridge build)
+ */
+export interface CachedBuildOptions {
+  // Каталог с binding.gyp
+  projectDir: string;
+  // Каталог кэша (по умолчанию $TSCB_CACHE_DIR или ~/.cache/ts-cpp-bridge)
+  cacheDir?: string;
+  // Команда сборки при промахе кэша
+  buildCommand?: string;
+}
+
+export interface CachedBuildResult {
+  key: string;
+  hit: boolean;
+  files: string[];
+}
+
+// Исходники, от которых зависит бинарник: все, что может попасть в node-gyp сборку
+const SOURCE_EXTENSIONS = new Set(['.c', '.cc', '.cpp', '.cxx', '.h', '.hh', '.hpp', '.hxx', '.gyp', '.gypi']);
+const SKIPPED_DIRS = new Set(['build', 'node_modules', 'dist', '.git']);
+// Без npx: он скачивает node-gyp из реестра, если его нет в node_modules
+const DEFAULT_BUILD_COMMAND = 'node-gyp rebuild';
+// Переменные окружения, которые меняют флаги компилятора или цель node-gyp
+const BUILD_ENV = [
+  'CC', 'CXX', 'CFLAGS', 'CXXFLAGS', 'CPPFLAGS', 'LDFLAGS',
+  'npm_config_arch', 'npm_config_target', 'npm_config_target_arch', 'npm_config_runtime',
+  'npm_config_disturl', 'npm_config_nodedir', 'npm_config_debug',
+];
+
+function collectSources(dir: string, root: string, result: string[]): void {
+  for (const entry of fs.readdirSync(dir, { withFileTypes: true })) {
+    const fullPath = path.join(dir, entry.name);
+    if (entry.isDirectory()) {
+      if (!SKIPPED_DIRS.has(entry.name) && !entry.name.startsWith('.')) {
+        collectSources(fullPath, root, result);
+      }
+    } else if (entry.isFile() && SOURCE_EXTENSIONS.has(path.extname(entry.name))) {
+      result.push(path.relative(root, fullPath));
+    }
+  }
+}
+
+function hashFiles(hash: crypto.Hash, root: string, files: string[]): void {
+  for (const file of files) {
+    // Пути в POSIX-виде: ключ не зависит от разделителя каталогов
+    hash.update(file.split(path.sep).join('/') + '\0');
+    hash.update(fs.readFileSync(path.join(root, file)));
+    hash.update('\0');
+  }
+}
+
+/**
+ * Конфигурация node-gyp, в каталог которой попадает бинарник: Debug при --debug/-d
+ * в команде или npm_config_debug, иначе Release
+ */
+export function buildConfiguration(buildCommand: string = DEFAULT_BUILD_COMMAND): 'Debug' | 'Release' {
+  const debugFlag = buildCommand.split(/\s+/).some(arg => arg === '--debug' || arg === '-d');
+  const debugEnv = process.env.npm_config_debug === 'true';
+  return debugFlag || debugEnv ? 'Debug' : 'Release';
+}
+
+/**
+ * Ключ кэша: sha256 от путей и содержимого исходников проекта, заголовков
+ * node-addon-api, команды сборки и ее конфигурации, переменных окружения
+ * компилятора (BUILD_ENV), платформы, архитектуры и версии N-API. Тот же набор
+ * generated_* и implementation.cpp с той же сборкой дает тот же ключ без компиляции.
+ */
+export function computeBuildKey(projectDir: string, buildCommand: string = DEFAULT_BUILD_COMMAND): string {
+  const root = path.resolve(projectDir);
+  const files: string[] = [];
+  collectSources(root, root, files);
+  files.sort();
+
+  const hash = crypto.createHash('sha256');
+  hash.update(`${process.platform}-${process.arch}-napi${process.versions.napi}\0`);
+  hash.update(`${buildConfiguration(buildCommand)}\0${buildCommand}\0`);
+  for (const name of BUILD_ENV) {
+    hash.update(`${name}=${process.env[name] ?? ''}\0`);
+  }
+  hashFiles(hash, root, files);
+
+  // node-addon-api подключается из node_modules проекта: версия и заголовки влияют на бинарник
+  let addonApiDir = '';
+  try {
+    addonApiDir = path.dirname(require.resolve('node-addon-api/package.json', { paths: [root] }));
+  } catch (error) {
+    // Нет в node_modules: сборка все равно упадет на #include <napi.h>
+  }
+  if (addonApiDir) {
+    const headers = fs.readdirSync(addonApiDir).filter(file => file.endsWith('.h')).sort();
+    hash.update(`node-addon-api@${JSON.parse(fs.readFileSync(path.join(addonApiDir, 'package.json'), 'utf-8')).version}\0`);
+    hashFiles(hash, addonApiDir, headers);
+  } else {
+    hash.update('node-addon-api@none\0');
+  }
+  return hash.digest('hex');
+}
+
+/**
+ * Окружение команды сборки: в конец PATH добавляется node-gyp, поставляемый с npm текущего node.
+ * npm скрипты и npx добавляют его сами, а при прямом запуске CLI `node-gyp rebuild`
+ * иначе требовал бы глобальной установки
+ */
+export function buildCommandEnv(): NodeJS.ProcessEnv {
+  const nodeDir = path.dirname(process.execPath);
+  const npmBin = [
+    path.join(nodeDir, '..', 'lib', 'node_modules', 'npm', 'bin', 'node-gyp-bin'),
+    path.join(nodeDir, 'node_modules', 'npm', 'bin', 'node-gyp-bin'),
+  ].find(dir => fs.existsSync(dir));
+  if (!npmBin) {
+    return process.env;
+  }
+  // На Windows переменная может называться Path
+  const pathKey = Object.keys(process.env).find(name => name.toUpperCase() === 'PATH') || 'PATH';
+  const current = process.env[pathKey];
+  return { ...process.env, [pathKey]: current ? `${current}${path.delimiter}${npmBin}` : npmBin };
+}
+
+export function defaultCacheDir(): string {
+  return process.env.TSCB_CACHE_DIR || path.join(os.homedir(), '.cache', 'ts-cpp-bridge');
+}
+
+function listBinaries(dir: string): string[] {
+  return fs.existsSync(dir) ? fs.readdirSync(dir).filter(file => file.endsWith('.node')) : [];
+}
+
+/**
+ * Собирает addon с кэшем по содержимому: при совпадении ключа build/<Release|Debug>/*.node
+ * копируются из кэша без компиляции, иначе выполняется сборка и результат сохраняется
+ */
+export function cachedBuild(options: CachedBuildOptions): CachedBuildResult {
+  const projectDir = path.resolve(options.projectDir);
+  const buildCommand = options.buildCommand || DEFAULT_BUILD_COMMAND;
+  const outputDir = path.join(projectDir, 'build', buildConfiguration(buildCommand));
+  const key = computeBuildKey(projectDir, buildCommand);
+  const entryDir = path.join(options.cacheDir || defaultCacheDir(), key);
+
+  const cached = listBinaries(entryDir);
+  if (cached.length > 0) {
+    fs.mkdirSync(outputDir, { recursive: true });
+    for (const file of cached) {
+      fs.copyFileSync(path.join(entryDir, file), path.join(outputDir, file));
+    }
+    return { key, hit: true, files: cached };
+  }
+
+  execSync(buildCommand, { cwd: projectDir, stdio: 'inherit', env: buildCommandEnv() });
+  const built = listBinaries(outputDir);
+  if (built.length === 0) {
+    throw new Error(`No .node files found in ${outputDir} after build`);
+  }
+
+  // Запись во временный каталог и rename: параллельная сборка не увидит неполную запись
+  const tmpDir = `${entryDir}.tmp-${process.pid}`;
+  fs.mkdirSync(tmpDir, { recursive: true });
+  for (const file of built) {
+    fs.copyFileSync(path.join(outputDir, file), path.join(tmpDir, file));
+  }
+  try {
+    fs.renameSync(tmpDir, entryDir);
+  } catch (error) {
+    // Ключ уже записан другим процессом с тем же содержимым
+    fs.rmSync(tmpDir, { recursive: true, force: true });
+  }
+  return { key, hit: false, files: built };
+}
@@ -0,0 +1,1319 @@
+// Тесты генератора: по схеме генерируется addon и проверяется
+// - checkOption: наличие ожидаемого кода и синтаксис C++ (g++ -fsyntax-only);
+// - checkAddon: addon собирается с реализацией на C++ и вызывается из JS
+//   через сгенерированные generated_api.ts/generated_addon.ts.
+//
+// Запуск: npm test (собирает dist/ и запускает node tests/test.js).
+// Заголовки N-API берутся из node-addon-api (devDependency) и include/node текущего Node.js
+// или кэша node-gyp; TSCB_TEST_INCLUDE (каталоги через path.delimiter) задает их вручную.
+// Без компилятора ($CXX или g++) проверки C++ пропускаются, без заголовков - падают.
+
+const test = require('node:test');
+const assert = require('node:assert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { spawnSync } = require('child_process');
+const { once } = require('events');
+const { CppGenerator } = require('../dist/generator');
+
+const field = (name, tsType, type, extra = {}) =>
+  ({ name, type, tsType, isArray: false, isSet: false, isMap: false, isOptional: false, ...extra });
+const array = (name, tsType, element) => field(name, `${tsType}[]`, `std::vector<${element}>`, { isArray: true, arrayElementType: element });
+const typedArray = (name, tsType, element, extra = {}) =>
+  field(name, tsType, `std::vector<${element}>`, { isTypedArray: true, typedArrayElementType: element, ...extra });
+const exported = (className, methodName, paramType, returnType, extra = {}) => ({
+  name: `${className}_${methodName}`, className, methodName, paramType, returnType,
+  isStatic: true, isAsync: false, parameters: paramType === 'void' ? [] : [{ name: 'input', type: paramType }], ...extra
+});
+
+const INPUT = { name: 'InputData', fields: [field('name', 'string', 'std::string'), field('value', 'number', 'double'), array('numbers', 'number', 'double')] };
+const OUTPUT = { name: 'OutputData', fields: [field('greeting', 'string', 'std::string'), array('squared', 'number', 'double')] };
+
+function schema(structs, exports, classes = []) {
+  return { structs: [INPUT, OUTPUT, ...structs], exports, enums: [], classes };
+}
+
+function includeDirs() {
+  if (process.env.TSCB_TEST_INCLUDE) {
+    return { dirs: process.env.TSCB_TEST_INCLUDE.split(path.delimiter).filter(Boolean) };
+  }
+  let addonApi;
+  try {
+    addonApi = require('node-addon-api').include_dir.replace(/^"|"$/g, '');
+  } catch (error) {
+    return { error: 'node-addon-api not found: run npm install' };
+  }
+  const nodeHeaders = [
+    path.join(path.dirname(process.execPath), '..', 'include', 'node'),
+    path.join(os.homedir(), '.cache', 'node-gyp', process.versions.node, 'include', 'node'),
+  ].find(dir => fs.existsSync(path.join(dir, 'node_api.h')));
+  if (!nodeHeaders) {
+    return { error: 'Node.js headers (node_api.h) not found: set TSCB_TEST_INCLUDE or run node-gyp install' };
+  }
+  return { dirs: [addonApi, nodeHeaders] };
+}
+
+const CXX = process.env.CXX || 'g++';
+const INCLUDES = includeDirs();
+const HAS_CXX = spawnSync(CXX, ['--version'], { stdio: 'ignore' }).status === 0;
+// Addon собирается прямым вызовом компилятора, на Windows для этого нужен MSVC и node.lib
+const ADDON_SKIP = !HAS_CXX ? `${CXX} not found` : process.platform === 'win32' ? 'addon build is not supported on Windows' : false;
+
+/**
+ * Генерирует C++ и TS файлы схемы в <root>/src временного каталога, возвращает { root, dir, read(file) }
+ */
+function generate(parseResult, options = {}) {
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tscb-test-'));
+  const dir = path.join(root, 'src');
+  fs.mkdirSync(dir);
+  const generator = new CppGenerator();
+  generator.generateCppCode(parseResult, dir, options);
+  generator.generateTypesFile(parseResult, dir);
+  generator.generateAddonFile(parseResult, dir);
+  return { root, dir, read: file => fs.readFileSync(path.join(dir, file), 'utf-8') };
+}
+
+function compilerIncludes(dir) {
+  assert.ok(INCLUDES.dirs, INCLUDES.error);
+  return [dir, ...INCLUDES.dirs].map(include => `-I${include}`);
+}
+
+function syntaxCheck(t, dir) {
+  if (!HAS_CXX) {
+    t.skip(`${CXX} not found`);
+    return;
+  }
+  const includes = compilerIncludes(dir);
+  for (const file of fs.readdirSync(dir).filter(name => name.endsWith('.cpp'))) {
+    const result = spawnSync(CXX, ['-std=c++17', '-fsyntax-only', '-DNAPI_CPP_EXCEPTIONS', ...includes, path.join(dir, file)], { encoding: 'utf-8' });
+    assert.strictEqual(result.status, 0, `${file}:\n${result.stderr}`);
+  }
+}
+
+/**
+ * Компилирует sources в разделяемую библиотеку target (addon N-API)
+ */
+function compileAddon(sources, dir, target, defines = []) {
+  fs.mkdirSync(path.dirname(target), { recursive: true });
+  // -fvisibility=hidden: addon'ы теста загружены в один процесс и не должны делить static из generated_runtime.hpp
+  const flags = ['-std=c++17', '-shared', '-fPIC', '-fvisibility=hidden', '-pthread', '-DNAPI_CPP_EXCEPTIONS', ...defines.map(name => `-D${name}`)];
+  if (process.platform === 'darwin') {
+    flags.push('-undefined', 'dynamic_lookup');
+  }
+  const result = spawnSync(CXX, [...flags, ...compilerIncludes(dir), '-o', target, ...sources], { encoding: 'utf-8' });
+  assert.strictEqual(result.status, 0, result.stderr);
+}
+
+/**
+ * Собирает <root>/build/Release/addon.node из сгенерированных .cpp и реализации
+ */
+function buildAddon(output, implementation, defines = []) {
+  const source = path.join(output.root, 'implementation.cpp');
+  fs.writeFileSync(source, `#include "generated_api.h"\n#include <stdexcept>\n#include <thread>\n\n${implementation}`);
+  const sources = fs.readdirSync(output.dir).filter(name => name.endsWith('.cpp')).map(name => path.join(output.dir, name));
+  compileAddon([source, ...sources], output.dir, path.join(output.root, 'build', 'Release', 'addon.node'), defines);
+}
+
+/**
+ * Транспилирует generated_*.ts в CommonJS рядом с исходниками и загружает generated_api
+ */
+function loadApi(output) {
+  const ts = require('typescript');
+  for (const file of fs.readdirSync(output.dir).filter(name => name.endsWith('.ts') && !name.endsWith('.d.ts'))) {
+    const { outputText } = ts.transpileModule(output.read(file), {
+      compilerOptions: { module: ts.ModuleKind.CommonJS, target: ts.ScriptTarget.ES2020 },
+    });
+    fs.writeFileSync(path.join(output.dir, file.replace(/\.ts$/, '.js')), outputText);
+  }
+  return require(path.join(output.dir, 'generated_api.js'));
+}
+
+// expectations: файл -> фрагменты, которые должны быть в нем; фрагмент с '!' - которых быть не должно
+function checkOption(name, parseResult, expectations, options = {}) {
+  test(name, t => {
+    const output = generate(parseResult, options);
+    try {
+      for (const [file, snippets] of Object.entries(expectations)) {
+        const content = output.read(file);
+        for (const snippet of snippets) {
+          if (snippet.startsWith('!')) {
+            assert.ok(!content.includes(snippet.slice(1)), `${file} contains '${snippet.slice(1)}'`);
+          } else {
+            assert.ok(content.includes(snippet), `${file} does not contain '${snippet}'`);
+          }
+        }
+      }
+      syntaxCheck(t, output.dir);
+    } finally {
+      fs.rmSync(output.root, { recursive: true, force: true });
+    }
+  });
+}
+
+// Собирает addon схемы с реализацией implementation и вызывает run(api, output).
+// Загруженный addon нельзя выгрузить, поэтому каталоги удаляются при выходе из процесса
+const addonRoots = [];
+process.on('exit', () => addonRoots.forEach(root => fs.rmSync(root, { recursive: true, force: true })));
+
+function checkAddon(name, parseResult, implementation, run, { options = {}, defines = [] } = {}) {
+  test(name, async t => {
+    if (ADDON_SKIP) {
+      t.skip(ADDON_SKIP);
+      return;
+    }
+    const output = generate(parseResult, options);
+    addonRoots.push(output.root);
+    buildAddon(output, implementation, defines);
+    await run(loadApi(output), output);
+  });
+}
+
+// @CppField({ view: true }): ArrayView над буфером, копия для async входа
+const VIEW_SCHEMA = schema(
+  [
+    { name: 'Signal', fields: [typedArray('samples', 'Float32Array', 'float', { isView: true }), field('gain', 'number', 'double')] },
+    { name: 'Frame', fields: [typedArray('values', 'Float64Array', 'double'), typedArray('codes', 'Int32Array', 'int32_t')] },
+  ],
+  [
+    exported('Dsp', 'scale', 'Signal', 'OutputData'),
+    exported('Dsp', 'scaleAsync', 'Signal', 'OutputData', { isAsync: true }),
+    exported('Dsp', 'echo', 'Frame', 'Frame'),
+  ]
+);
+
+checkOption('view field', VIEW_SCHEMA, {
+  'generated_structs.hpp': ['tscb::ArrayView<float> samples'],
+  'generated_api.cpp': ['tscb::OwnedViewScope ownViews;'],
+});
+
+checkAddon('typed arrays and views', VIEW_SCHEMA, `
+OutputData Dsp_scale(const Signal& input) {
+    OutputData result;
+    for (float sample : input.samples) {
+        result.squared.push_back(sample * input.gain);
+    }
+    return result;
+}
+
+OutputData Dsp_scaleAsync(const Signal& input) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return Dsp_scale(input);
+}
+
+Frame Dsp_echo(const Frame& input) {
+    Frame result = input;
+    result.values.push_back(input.values.size());
+    return result;
+}
+`, async ({ Dsp }) => {
+  assert.deepStrictEqual(Dsp.scale({ samples: new Float32Array([1, 2, 3]), gain: 2 }).squared, [2, 4, 6]);
+
+  // Async вход копируется при разборе: изменение буфера после вызова не видно задаче
+  const samples = new Float32Array([1, 2, 3]);
+  const pending = Dsp.scaleAsync({ samples, gain: 10 });
+  samples.fill(0);
+  assert.deepStrictEqual((await pending).squared, [10, 20, 30]);
+
+  const echoed = Dsp.echo({ values: new Float64Array([0.5, 1.5]), codes: [7, -8] });
+  assert.ok(echoed.values instanceof Float64Array);
+  assert.deepStrictEqual(Array.from(echoed.values), [0.5, 1.5, 2]);
+  assert.ok(echoed.codes instanceof Int32Array);
+  assert.deepStrictEqual(Array.from(echoed.codes), [7, -8]);
+});
+
+// Ключи свойств создаются один раз на Napi::Env: повторные вызовы и второй Env в worker_threads
+const PROCESS_IMPL = `
+OutputData Solver_process(const InputData& input) {
+    if (input.name == "bad") {
+        throw std::runtime_error("bad input");
+    }
+    OutputData result;
+    result.greeting = "Hello, " + input.name;
+    for (double number : input.numbers) {
+        result.squared.push_back(number * number);
+    }
+    return result;
+}
+`;
+
+checkAddon('property keys per env', schema([], [exported('Solver', 'process', 'InputData', 'OutputData')]), PROCESS_IMPL, async ({ Solver }, output) => {
+  for (let i = 0; i < 1000; i++) {
+    const result = Solver.process({ name: `n${i}`, value: i, numbers: [i, 2] });
+    assert.strictEqual(result.greeting, `Hello, n${i}`);
+    assert.deepStrictEqual(Array.from(result.squared), [i * i, 4]);
+  }
+  const { Worker } = require('worker_threads');
+  const worker = new Worker(`
+    const { parentPort, workerData } = require('worker_threads');
+    const result = require(workerData).Solver_process({ name: 'worker', value: 0, numbers: [3] });
+    parentPort.postMessage({ greeting: result.greeting, squared: Array.from(result.squared) });
+  `, { eval: true, workerData: path.join(output.root, 'build', 'Release', 'addon.node') });
+  const [message] = await once(worker, 'message');
+  assert.deepStrictEqual(message, { greeting: 'Hello, worker', squared: [9] });
+  await once(worker, 'exit');
+});
+
+// *_batch: пакет за один переход, ошибка элемента отклоняет весь пакет
+checkAddon('batch calls', schema([], [
+  exported('Solver', 'process', 'InputData', 'OutputData'),
+  exported('Solver', 'processAsync', 'InputData', 'OutputData', { isAsync: true }),
+]), PROCESS_IMPL + `
+OutputData Solver_processAsync(const InputData& input) {
+    return Solver_process(input);
+}
+`, async ({ Solver }) => {
+  const inputs = Array.from({ length: 50 }, (_, i) => ({ name: `n${i}`, value: i, numbers: [i] }));
+  const expected = inputs.map(input => `Hello, ${input.name}`);
+  assert.deepStrictEqual(Solver.processBatch(inputs).map(result => result.greeting), expected);
+  assert.deepStrictEqual((await Solver.processAsyncBatch(inputs)).map(result => result.greeting), expected);
+  assert.deepStrictEqual(Solver.processBatch([]), []);
+
+  const withBad = [...inputs, { name: 'bad', value: 0, numbers: [] }];
+  assert.throws(() => Solver.processBatch(withBad), /bad input/);
+  await assert.rejects(Solver.processAsyncBatch(withBad), /bad input/);
+});
+
+// @CppAsync({ pool: 'native' }): много одновременных задач, размер пула задается до первого вызова
+checkAddon('native pool', schema([], [
+  exported('Solver', 'heavy', 'InputData', 'OutputData', { isAsync: true, pool: 'native', poolSize: 4 }),
+]), PROCESS_IMPL.replace('Solver_process', 'Solver_heavy'), async ({ Solver, initThreadPool }) => {
+  initThreadPool(3);
+  const inputs = Array.from({ length: 2000 }, (_, i) => ({ name: `n${i}`, value: i, numbers: [i] }));
+  const results = await Promise.all(inputs.map(input => Solver.heavy(input)));
+  assert.deepStrictEqual(results.map(result => result.squared[0]), inputs.map((_, i) => i * i));
+
+  const batch = await Solver.heavyBatch(inputs.slice(0, 100));
+  assert.strictEqual(batch[99].greeting, 'Hello, n99');
+  await assert.rejects(Solver.heavy({ name: 'bad', value: 0, numbers: [] }), /bad input/);
+});
+
+// Promise разрешается из OnOK/OnError worker'а: результат и ошибка C++
+checkAddon('async resolve and reject', schema([], [
+  exported('Solver', 'run', 'InputData', 'OutputData', { isAsync: true }),
+]), PROCESS_IMPL + `
+OutputData Solver_run(const InputData& input) {
+    return Solver_process(input);
+}
+`, async ({ Solver }) => {
+  assert.strictEqual((await Solver.run({ name: 'x', value: 1, numbers: [] })).greeting, 'Hello, x');
+  await assert.rejects(Solver.run({ name: 'bad', value: 1, numbers: [] }), { message: 'bad input' });
+  await assert.rejects(Solver.run({ name: 1, value: 1, numbers: [] }), /InputData/);
+});
+
+// signature: 'move' забирает буферы входа, 'out' пишет результат в объект worker'а
+checkAddon('move and out signatures', schema([], [
+  exported('Solver', 'take', 'InputData', 'OutputData', { signature: 'move' }),
+  exported('Solver', 'fill', 'InputData', 'OutputData', { isAsync: true, signature: 'out' }),
+]), `
+OutputData Solver_take(InputData&& input) {
+    OutputData result;
+    result.greeting = std::move(input.name);
+    result.squared = std::move(input.numbers);
+    return result;
+}
+
+void Solver_fill(const InputData& input, OutputData& result) {
+    result.greeting = input.name + "!";
+    result.squared.assign(input.numbers.begin(), input.numbers.end());
+}
+`, async ({ Solver }) => {
+  const taken = Solver.take({ name: 'moved', value: 0, numbers: [1, 2] });
+  assert.strictEqual(taken.greeting, 'moved');
+  assert.deepStrictEqual(Array.from(taken.squared), [1, 2]);
+  const filled = await Solver.fill({ name: 'out', value: 0, numbers: [3] });
+  assert.strictEqual(filled.greeting, 'out!');
+  assert.deepStrictEqual(Array.from(filled.squared), [3]);
+});
+
+// ts-cpp-bridge bench: addon с пустыми реализациями собирается и выводит замеры в JSON
+test('benchmark harness', t => {
+  if (ADDON_SKIP) {
+    t.skip(ADDON_SKIP);
+    return;
+  }
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tscb-bench-'));
+  try {
+    new CppGenerator().generateBenchmark(schema([], [
+      exported('Solver', 'process', 'InputData', 'OutputData'),
+      exported('Solver', 'processAsync', 'InputData', 'OutputData', { isAsync: true }),
+    ]), root, { sizes: [1], iterations: 10 });
+    const src = path.join(root, 'src');
+    const sources = fs.readdirSync(src).filter(name => name.endsWith('.cpp')).map(name => path.join(src, name));
+    compileAddon(sources, src, path.join(root, 'build', 'Release', 'bench.node'));
+
+    const run = spawnSync(process.execPath, ['bench.js', '--json', '--sizes', '1,8', '--iterations', '20'], { cwd: root, encoding: 'utf-8' });
+    assert.strictEqual(run.status, 0, run.stderr);
+    const rows = JSON.parse(run.stdout);
+    const calls = rows.filter(row => row.name === 'Solver_process' || row.name === 'Solver_processAsync');
+    assert.strictEqual(calls.length, 4);
+    for (const row of calls) {
+      assert.ok(Number.isFinite(row.totalNs) && row.totalNs > 0, JSON.stringify(row));
+      assert.ok(Number.isFinite(row.decodeNs) && Number.isFinite(row.callNs), JSON.stringify(row));
+    }
+    assert.ok(calls.some(row => row.mode === 'async' && Number.isFinite(row.throughputNs)));
+    assert.ok(rows.some(row => row.name === 'InputData' && row.mode === 'struct' && row.size === 8));
+  } finally {
+    fs.rmSync(root, { recursive: true, force: true });
+  }
+});
+
+// -DTSCB_PROFILE: счетчики по фазам для каждого экспорта, чтение с обнулением
+checkAddon('profile counters', schema([], [
+  exported('Solver', 'process', 'InputData', 'OutputData'),
+  exported('Solver', 'processAsync', 'InputData', 'OutputData', { isAsync: true }),
+]), PROCESS_IMPL + `
+OutputData Solver_processAsync(const InputData& input) {
+    return Solver_process(input);
+}
+`, async ({ Solver, bridgeStats }) => {
+  bridgeStats(true);
+  const input = { name: 'x', value: 1, numbers: [1, 2, 3] };
+  for (let i = 0; i < 3; i++) {
+    Solver.process(input);
+  }
+  await Promise.all([Solver.processAsync(input), Solver.processAsync(input)]);
+  Solver.processBatch([input, input]);
+
+  const stats = bridgeStats(true);
+  for (const phase of ['decode', 'execute', 'encode']) {
+    assert.strictEqual(stats.Solver_process[phase].count, 3, phase);
+    assert.strictEqual(stats.Solver_processAsync[phase].count, 2, phase);
+  }
+  assert.strictEqual(stats.Solver_processAsync.queueWait.count, 2);
+  assert.ok(stats.Solver_process.execute.totalNs >= stats.Solver_process.execute.maxNs);
+  assert.ok(stats.Solver_process_batch.execute.count >= 1);
+  assert.ok(!bridgeStats().Solver_process || bridgeStats().Solver_process.decode.count === 0);
+}, { defines: ['TSCB_PROFILE'] });
+
+// @CppStruct({ view: true }): поля конвертируются при чтении, view передается обратно без разбора
+checkAddon('lazy struct views', schema([
+  { name: 'Report', isView: true, fields: [field('summary', 'string', 'std::string'), array('values', 'number', 'double'), field('source', 'InputData', 'InputData')] },
+], [
+  exported('Solver', 'report', 'InputData', 'Report'),
+  exported('Solver', 'total', 'Report', 'OutputData'),
+]), `
+Report Solver_report(const InputData& input) {
+    Report result;
+    result.summary = "report for " + input.name;
+    result.values = input.numbers;
+    result.source = input;
+    return result;
+}
+
+OutputData Solver_total(const Report& input) {
+    OutputData result;
+    result.greeting = input.summary;
+    double sum = 0;
+    for (double value : input.values) {
+        sum += value;
+    }
+    result.squared.push_back(sum);
+    return result;
+}
+`, async ({ Solver }) => {
+  const view = Solver.report({ name: 'x', value: 2, numbers: [1, 2, 3] });
+  assert.deepStrictEqual(Object.keys(view), []);
+  assert.strictEqual(view.summary, 'report for x');
+  assert.strictEqual(view.source.name, 'x');
+  assert.strictEqual(view.values, view.values);
+  assert.deepStrictEqual(JSON.parse(JSON.stringify(view)), {
+    summary: 'report for x', values: [1, 2, 3], source: { name: 'x', value: 2, numbers: [1, 2, 3] },
+  });
+
+  // Непрочитанный view копируется в C++ напрямую, измененный массив разбирается заново
+  const fresh = Solver.report({ name: 'y', value: 0, numbers: [4, 5] });
+  assert.deepStrictEqual(Solver.total(fresh).squared, [9]);
+  fresh.values.push(10);
+  assert.deepStrictEqual(Solver.total(fresh).squared, [19]);
+  assert.deepStrictEqual(Solver.total({ summary: 'plain', values: [1], source: { name: '', value: 0, numbers: [] } }).squared, [1]);
+});
+
+// Экспорты без входа или результата: без пакетных вариантов, код компилируется
+checkOption('void signatures', schema([], [
+  exported('Solver', 'reset', 'void', 'void'),
+  exported('Solver', 'stats', 'void', 'OutputData', { isAsync: true }),
+  exported('Solver', 'consume', 'InputData', 'void'),
+]), {
+  'generated_api.cpp': ['Solver_reset_wrapper', 'Solver_stats_wrapper', '!Solver_reset_batch', '!Solver_stats_batch', '!Solver_consume_batch'],
+  'generated_addon.ts': ['!Solver_reset_batch'],
+});
+
+// Async экспорт без результата разрешает Promise значением undefined
+checkAddon('async void results', schema([], [
+  exported('Solver', 'touch', 'InputData', 'void', { isAsync: true }),
+]), `
+void Solver_touch(const InputData& input) {
+    if (input.name == "bad") {
+        throw std::runtime_error("touch failed");
+    }
+}
+`, async ({ Solver }) => {
+  assert.strictEqual(await Solver.touch({ name: 'x', value: 1, numbers: [] }), undefined);
+  await assert.rejects(Solver.touch({ name: 'bad', value: 1, numbers: [] }), { message: 'touch failed' });
+});
+
+// @CppClass: состояние между вызовами, async методы экземпляра по очереди,
+// синхронный метод занятого экземпляра не блокирует главный поток
+const COUNTER_CLASS = {
+  name: 'Counter', constructorParamType: 'InputData', methods: [
+    exported('Counter', 'add', 'InputData', 'OutputData', { isStatic: false, selfType: 'Counter' }),
+    exported('Counter', 'addSlowly', 'InputData', 'OutputData', { isStatic: false, isAsync: true, selfType: 'Counter' }),
+  ],
+};
+
+checkAddon('stateful classes', schema([], [], [COUNTER_CLASS]), `
+class Counter {
+public:
+    double total = 0;
+    std::vector<double> history;
+};
+
+std::shared_ptr<Counter> Counter_new(const InputData& config) {
+    auto counter = std::make_shared<Counter>();
+    counter->total = config.value;
+    return counter;
+}
+
+static OutputData Snapshot(const Counter& self) {
+    OutputData result;
+    result.greeting = std::to_string(static_cast<int>(self.total));
+    result.squared = self.history;
+    return result;
+}
+
+OutputData Counter_add(Counter& self, const InputData& input) {
+    self.total += input.value;
+    self.history.push_back(input.value);
+    return Snapshot(self);
+}
+
+OutputData Counter_addSlowly(Counter& self, const InputData& input) {
+    // Чтение и запись разнесены во времени: без очереди экземпляра одновременные вызовы потеряли бы сумму
+    double total = self.total;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    self.total = total + input.value;
+    self.history.push_back(input.value);
+    return Snapshot(self);
+}
+`, async ({ Counter }) => {
+  const counter = new Counter({ name: '', value: 10, numbers: [] });
+  assert.strictEqual(counter.add({ name: '', value: 1, numbers: [] }).greeting, '11');
+
+  const inputs = Array.from({ length: 20 }, (_, i) => ({ name: '', value: i + 1, numbers: [] }));
+  const pending = Promise.all(inputs.map(input => counter.addSlowly(input)));
+  assert.throws(() => counter.add({ name: '', value: 100, numbers: [] }), /instance busy/);
+  const results = await pending;
+  assert.strictEqual(results[19].greeting, String(11 + 210));
+  assert.deepStrictEqual(results[19].squared, [1, ...inputs.map(input => input.value)]);
+  assert.strictEqual(counter.add({ name: '', value: 1, numbers: [] }).greeting, String(222));
+
+  const other = new Counter({ name: '', value: 0, numbers: [] });
+  assert.strictEqual(other.add({ name: '', value: 5, numbers: [] }).greeting, '5');
+  other.dispose();
+  assert.throws(() => other.add({ name: '', value: 5, numbers: [] }), /Counter has been disposed/);
+});
+
+// transport: 'binary': вход и результат одним буфером через кодек generated_wire.ts
+const PACKET = { name: 'Packet', fields: [
+  field('id', 'number', 'double'), field('label', 'string', 'std::string'), field('flag', 'boolean', 'bool'),
+  array('tags', 'string', 'std::string'), typedArray('samples', 'Float64Array', 'double'), field('inner', 'InputData', 'InputData'),
+] };
+
+checkAddon('binary transport', schema([PACKET], [
+  exported('Wire', 'echo', 'Packet', 'Packet', { transport: 'binary' }),
+  exported('Wire', 'echoAsync', 'Packet', 'Packet', { isAsync: true, transport: 'binary' }),
+]), `
+Packet Wire_echo(const Packet& input) {
+    Packet result = input;
+    result.id = input.id + 1;
+    result.label = input.label + "-" + input.inner.name;
+    result.tags.push_back("echo");
+    result.flag = !input.flag;
+    return result;
+}
+
+Packet Wire_echoAsync(const Packet& input) {
+    return Wire_echo(input);
+}
+`, async ({ Wire }, output) => {
+  assert.ok(output.read('generated_api.ts').includes('_wire('));
+  const packet = { id: 1, label: 'p', flag: true, tags: ['a', 'юникод'], samples: new Float64Array([0.25, -1]), inner: { name: 'in', value: 3, numbers: [1, 2] } };
+  for (const result of [Wire.echo(packet), await Wire.echoAsync(packet)]) {
+    assert.strictEqual(result.id, 2);
+    assert.strictEqual(result.label, 'p-in');
+    assert.strictEqual(result.flag, false);
+    assert.deepStrictEqual(result.tags, ['a', 'юникод', 'echo']);
+    assert.deepStrictEqual(Array.from(result.samples), [0.25, -1]);
+    assert.deepStrictEqual({ ...result.inner, numbers: Array.from(result.inner.numbers) }, { name: 'in', value: 3, numbers: [1, 2] });
+  }
+});
+
+// @CppStream: чанки через for await, break останавливает производителя, ошибка отклоняет next()
+checkAddon('streams', schema([], [
+  exported('Stream', 'scan', 'InputData', 'OutputData', { isStream: true, highWaterMark: 2 }),
+  exported('Stream', 'progress', 'void', 'OutputData'),
+]), `
+#include <atomic>
+
+static std::atomic<int> emitted{0};
+static std::atomic<bool> finished{false};
+
+void Stream_scan(const InputData& input, tscb::StreamEmitter<OutputData>& emit) {
+    emitted = 0;
+    finished = false;
+    for (int i = 0; i < static_cast<int>(input.value); i++) {
+        if (input.name == "bad" && i == 2) {
+            finished = true;
+            throw std::runtime_error("scan failed");
+        }
+        OutputData chunk;
+        chunk.greeting = input.name;
+        chunk.squared.push_back(i);
+        emitted++;
+        if (!emit.Emit(std::move(chunk))) {
+            break;
+        }
+    }
+    finished = true;
+}
+
+OutputData Stream_progress() {
+    OutputData result;
+    result.greeting = finished ? "done" : "running";
+    result.squared.push_back(emitted);
+    return result;
+}
+`, async ({ Stream }) => {
+  const all = [];
+  for await (const chunk of Stream.scan({ name: 'all', value: 5, numbers: [] })) {
+    all.push(chunk.squared[0]);
+  }
+  assert.deepStrictEqual(all, [0, 1, 2, 3, 4]);
+
+  let seen = 0;
+  for await (const chunk of Stream.scan({ name: 'early', value: 100000, numbers: [] })) {
+    if (++seen === 3) {
+      break;
+    }
+  }
+  while (Stream.progress().greeting !== 'done') {
+    await new Promise(resolve => setTimeout(resolve, 5));
+  }
+  // Производитель остановился: очередь ограничена highWaterMark
+  assert.ok(Stream.progress().squared[0] < 10, `emitted ${Stream.progress().squared[0]}`);
+
+  await assert.rejects(async () => {
+    for await (const chunk of Stream.scan({ name: 'bad', value: 5, numbers: [] })) {
+      assert.ok(chunk.squared[0] < 2);
+    }
+  }, /scan failed/);
+});
+
+// @CppAsync({ cancellable: true }): токен отмены в обоих пулах
+const CANCELLABLE_SCHEMA = schema([], [
+  exported('Solver', 'run', 'InputData', 'OutputData', { isAsync: true, cancellable: true }),
+  exported('Solver', 'runNative', 'InputData', 'OutputData', { isAsync: true, cancellable: true, pool: 'native' }),
+]);
+
+checkOption('cancellable', CANCELLABLE_SCHEMA, {
+  'generated_api.h': ['const tscb::CancelToken& cancel'],
+  'generated_api.ts': ['withCancel(options'],
+});
+
+checkAddon('cancellation and deadlines', CANCELLABLE_SCHEMA, `
+OutputData Solver_run(const InputData& input, const tscb::CancelToken& cancel) {
+    // value - длительность в миллисекундах
+    for (int i = 0; i < static_cast<int>(input.value); i++) {
+        cancel.ThrowIfCancelled();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    OutputData result;
+    result.greeting = "done " + input.name;
+    return result;
+}
+
+OutputData Solver_runNative(const InputData& input, const tscb::CancelToken& cancel) {
+    return Solver_run(input, cancel);
+}
+`, async ({ Solver }) => {
+  const quick = { name: 'quick', value: 1, numbers: [] };
+  const slow = { name: 'slow', value: 5000, numbers: [] };
+  for (const run of [Solver.run, Solver.runNative]) {
+    assert.strictEqual((await run(quick)).greeting, 'done quick');
+    assert.strictEqual((await run(quick, { timeoutMs: 5000 })).greeting, 'done quick');
+
+    const controller = new AbortController();
+    const pending = run(slow, { signal: controller.signal });
+    setTimeout(() => controller.abort(new Error('stopped by test')), 20);
+    await assert.rejects(pending, { message: 'stopped by test' });
+
+    await assert.rejects(run(slow, { timeoutMs: 20 }), { message: 'Deadline exceeded' });
+
+    const aborted = new AbortController();
+    aborted.abort(new Error('already aborted'));
+    await assert.rejects(run(quick, { signal: aborted.signal }), { message: 'already aborted' });
+  }
+});
+
+// @CppStruct({ arena: true }): pmr строки и векторы входа в арене вызова
+checkAddon('arena inputs', schema([
+  { name: 'Document', isArena: true, fields: [field('title', 'string', 'std::string'), array('words', 'string', 'std::string'), array('weights', 'number', 'double')] },
+], [
+  exported('Index', 'build', 'Document', 'OutputData'),
+  exported('Index', 'buildAsync', 'Document', 'OutputData', { isAsync: true }),
+]), `
+OutputData Index_build(const Document& input) {
+    OutputData result;
+    result.greeting = std::string(input.title);
+    for (const std::pmr::string& word : input.words) {
+        result.greeting += " " + std::string(word);
+    }
+    for (double weight : input.weights) {
+        result.squared.push_back(weight * 2);
+    }
+    return result;
+}
+
+OutputData Index_buildAsync(const Document& input) {
+    return Index_build(input);
+}
+`, async ({ Index }) => {
+  // Строки длиннее буфера на стеке арены и много элементов: арена выделяет новые блоки
+  const words = Array.from({ length: 500 }, (_, i) => `word-${i}-${'x'.repeat(i % 40)}`);
+  const document = { title: 'doc', words, weights: [1, 2.5] };
+  const expected = ['doc', ...words].join(' ');
+  for (let i = 0; i < 3; i++) {
+    const result = Index.build(document);
+    assert.strictEqual(result.greeting, expected);
+    assert.deepStrictEqual(Array.from(result.squared), [2, 5]);
+  }
+  assert.strictEqual((await Index.buildAsync(document)).greeting, expected);
+  assert.deepStrictEqual(Index.buildBatch([document, { title: 't', words: ['a'], weights: [] }]).map(result => result.greeting), [expected, 't a']);
+});
+
+// cache: LRU результатов по разобранному входу, одинаковые async вызовы ждут одну задачу
+checkAddon('result cache', schema([], [
+  exported('Solver', 'process', 'InputData', 'OutputData', { cache: { maxEntries: 2, ttlMs: 0 } }),
+  exported('Solver', 'processAsync', 'InputData', 'OutputData', { isAsync: true, cache: { maxEntries: 16, ttlMs: 0 } }),
+  exported('Solver', 'calls', 'void', 'OutputData'),
+]), `
+#include <atomic>
+
+static std::atomic<int> calls{0};
+
+OutputData Solver_process(const InputData& input) {
+    calls++;
+    if (input.name == "bad") {
+        throw std::runtime_error("bad input");
+    }
+    OutputData result;
+    result.greeting = "Hello, " + input.name;
+    return result;
+}
+
+OutputData Solver_processAsync(const InputData& input) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return Solver_process(input);
+}
+
+OutputData Solver_calls() {
+    OutputData result;
+    result.squared.push_back(calls);
+    return result;
+}
+`, async ({ Solver }) => {
+  const calls = () => Solver.calls().squared[0];
+  const a = { name: 'a', value: 1, numbers: [1, 2] };
+  const first = Solver.process(a);
+  const second = Solver.process({ name: 'a', value: 1, numbers: [1, 2] });
+  assert.strictEqual(calls(), 1);
+  assert.notStrictEqual(first, second);
+  assert.deepStrictEqual(first, second);
+
+  Solver.process({ ...a, numbers: [1, 3] });
+  assert.strictEqual(calls(), 2);
+  // maxEntries: 2 - третий вход вытесняет самый старый
+  Solver.process({ ...a, name: 'b' });
+  Solver.process(a);
+  assert.strictEqual(calls(), 4);
+
+  // Ошибка не кэшируется
+  assert.throws(() => Solver.process({ name: 'bad', value: 0, numbers: [] }), /bad input/);
+  assert.throws(() => Solver.process({ name: 'bad', value: 0, numbers: [] }), /bad input/);
+  assert.strictEqual(calls(), 6);
+
+  const results = await Promise.all([1, 2, 3].map(() => Solver.processAsync({ name: 'async', value: 0, numbers: [] })));
+  assert.strictEqual(calls(), 7);
+  assert.ok(results.every(result => result.greeting === 'Hello, async'));
+  await Solver.processAsync({ name: 'async', value: 0, numbers: [] });
+  assert.strictEqual(calls(), 7);
+});
+
+// @CppField({ shared: true }): результат над SharedArrayBuffer, postMessage передает ту же память
+checkAddon('shared array buffers', schema([
+  { name: 'Frame', fields: [typedArray('pixels', 'Float32Array', 'float', { isShared: true }), field('width', 'number', 'double')] },
+  { name: 'Probe', fields: [typedArray('data', 'Float32Array', 'float', { isView: true })] },
+], [
+  exported('Image', 'make', 'InputData', 'Frame'),
+  exported('Image', 'sum', 'Probe', 'OutputData'),
+]), `
+Frame Image_make(const InputData& input) {
+    Frame frame;
+    frame.width = input.value;
+    for (double number : input.numbers) {
+        frame.pixels.push_back(static_cast<float>(number));
+    }
+    return frame;
+}
+
+OutputData Image_sum(const Probe& input) {
+    OutputData result;
+    double sum = 0;
+    for (float value : input.data) {
+        sum += value;
+    }
+    result.squared.push_back(sum);
+    return result;
+}
+`, async ({ Image }) => {
+  const frame = Image.make({ name: '', value: 2, numbers: [1, 2, 3] });
+  assert.ok(frame.pixels.buffer instanceof SharedArrayBuffer);
+  assert.deepStrictEqual(Array.from(frame.pixels), [1, 2, 3]);
+
+  const { Worker } = require('worker_threads');
+  const worker = new Worker(`
+    const { parentPort } = require('worker_threads');
+    parentPort.once('message', frame => { frame.pixels[0] = 42; parentPort.postMessage('done'); });
+  `, { eval: true });
+  worker.postMessage(frame);
+  await once(worker, 'message');
+  await worker.terminate();
+  assert.strictEqual(frame.pixels[0], 42);
+
+  // Вход над SharedArrayBuffer принимается и полем view
+  const data = new Float32Array(new SharedArrayBuffer(12));
+  data.set([1, 2, 4]);
+  assert.deepStrictEqual(Image.sum({ data }).squared, [7]);
+});
+
+// Уточняемые скаляры: целые до 32 бит по модулю, i64/u64 - число или BigInt с проверкой диапазона
+const PRECISE_SCALARS = { name: 'Scalars', fields: [
+  field('small', 'u8', 'uint8_t'), field('half', 'i16', 'int16_t'), field('word', 'u32', 'uint32_t'),
+  field('big', 'i64', 'int64_t'), field('ubig', 'u64', 'uint64_t'), array('stamps', 'i64', 'int64_t'),
+] };
+
+checkAddon('precise scalars', schema([PRECISE_SCALARS], [exported('Precise', 'echo', 'Scalars', 'Scalars')]), `
+Scalars Precise_echo(const Scalars& input) {
+    return input;
+}
+`, async ({ Precise }, output) => {
+  assert.match(output.read('generated_types.ts'), /export type i64 = number/);
+  const base = { small: 1, half: 2, word: 3, big: 4, ubig: 5, stamps: [] };
+  assert.deepStrictEqual(Precise.echo(base), base);
+  assert.deepStrictEqual(Precise.echo({ ...base, small: 300, half: 70000, word: -1 }), { ...base, small: 44, half: 4464, word: 4294967295 });
+  assert.deepStrictEqual(Precise.echo({ ...base, small: -1, half: NaN, word: 2.9 }), { ...base, small: 255, half: 0, word: 2 });
+
+  assert.strictEqual(Precise.echo({ ...base, big: -(2 ** 53) }).big, -(2 ** 53));
+  assert.strictEqual(Precise.echo({ ...base, big: 10n, ubig: 2n ** 40n }).ubig, 2 ** 40);
+  assert.throws(() => Precise.echo({ ...base, big: 2 ** 63 }), /out of int64 range/);
+  assert.throws(() => Precise.echo({ ...base, big: NaN }), /out of int64 range/);
+  assert.throws(() => Precise.echo({ ...base, ubig: -1 }), /out of uint64 range/);
+  assert.throws(() => Precise.echo({ ...base, big: 2n ** 64n }), /out of int64 range/);
+});
+
+// Массивы уточняемых типов - TypedArray, элементы Set/Map приводятся так же, как скаляры
+const PRECISE_CONTAINERS = { name: 'Containers', fields: [
+  typedArray('bytes', 'Uint8Array', 'uint8_t'), array('stamps', 'i64', 'int64_t'),
+  field('tags', 'Set<u8>', 'std::unordered_set<uint8_t>', { isSet: true, setElementType: 'uint8_t' }),
+  field('totals', 'Map<string, i64>', 'std::unordered_map<std::string, int64_t>', { isMap: true, mapKeyType: 'std::string', mapValueType: 'int64_t' }),
+] };
+
+checkAddon('precise containers', schema([PRECISE_CONTAINERS], [exported('Precise', 'echo', 'Containers', 'Containers')]), `
+Containers Precise_echo(const Containers& input) {
+    return input;
+}
+`, async ({ Precise }) => {
+  const base = { bytes: new Uint8Array([1, 2]), stamps: [], tags: new Set(), totals: new Map() };
+  const result = Precise.echo({ ...base, bytes: [-1, 300], stamps: [-(2 ** 53), 7] });
+  assert.ok(result.bytes instanceof Uint8Array);
+  assert.deepStrictEqual(Array.from(result.bytes), [255, 44]);
+  assert.deepStrictEqual(result.stamps, [-(2 ** 53), 7]);
+  assert.throws(() => Precise.echo({ ...base, stamps: [1, 2 ** 64] }), /out of int64 range/);
+
+  assert.deepStrictEqual([...Precise.echo({ ...base, tags: [257] }).tags].sort(), [1]);
+  assert.deepStrictEqual([...Precise.echo({ ...base, tags: new Set([3, 259]) }).tags].sort(), [3]);
+  const totals = Precise.echo({ ...base, totals: new Map([['a', 2 ** 40], ['b', 10n]]) }).totals;
+  assert.deepStrictEqual([...totals].sort(), [['a', 2 ** 40], ['b', 10]]);
+  assert.throws(() => Precise.echo({ ...base, totals: { a: 2 ** 70 } }), /out of int64 range/);
+});
+
+// Обычный массив в TypedArray-поле: одинаковые правила до и после kBulkArrayThreshold (32)
+checkAddon('bulk array reads', schema([
+  { name: 'Samples', fields: [typedArray('bytes', 'Uint8Array', 'uint8_t'), typedArray('values', 'Float64Array', 'double')] },
+], [exported('Bulk', 'echo', 'Samples', 'Samples')]), `
+Samples Bulk_echo(const Samples& input) {
+    return input;
+}
+`, async ({ Bulk }) => {
+  for (const length of [31, 32, 1000]) {
+    const bytes = Array.from({ length }, (_, i) => i === 0 ? -1 : i + 256);
+    const values = Array.from({ length }, (_, i) => i + 0.5);
+    const result = Bulk.echo({ bytes, values });
+    assert.deepStrictEqual(Array.from(result.bytes), Array.from(new Uint8Array(bytes)), `length ${length}`);
+    assert.deepStrictEqual(Array.from(result.values), values, `length ${length}`);
+
+    const invalid = [...values];
+    invalid[length - 1] = 'x';
+    assert.throws(() => Bulk.echo({ bytes: [], values: invalid }), new RegExp(`Expected a number at index ${length - 1}$`));
+  }
+  // Повторные вызовы переиспользуют внешний ArrayBuffer над памятью вектора
+  for (let i = 0; i < 200; i++) {
+    assert.strictEqual(Bulk.echo({ bytes: [], values: Array(64).fill(i) }).values[63], i);
+  }
+});
+
+// tscb::ParallelFor/ParallelReduce: результат как у последовательного цикла, исключение части доходит до вызова
+checkAddon('parallel loops', schema([], [
+  exported('Parallel', 'run', 'InputData', 'OutputData'),
+  exported('Parallel', 'runNative', 'InputData', 'OutputData', { isAsync: true, pool: 'native' }),
+]), `
+OutputData Parallel_run(const InputData& input) {
+    OutputData result;
+    result.squared.resize(input.numbers.size());
+    tscb::ParallelFor(size_t(0), input.numbers.size(), [&](size_t i) {
+        if (input.name == "throw" && i == 7) {
+            throw std::runtime_error("chunk failed");
+        }
+        result.squared[i] = input.numbers[i] * input.numbers[i];
+    });
+    result.greeting = tscb::ParallelReduce(size_t(0), input.numbers.size(), std::string(),
+        [&](size_t i) { return std::to_string(static_cast<int>(input.numbers[i])); },
+        [](std::string acc, std::string part) { return acc + part; }, 3);
+    return result;
+}
+
+OutputData Parallel_runNative(const InputData& input) {
+    return Parallel_run(input);
+}
+`, async ({ Parallel }) => {
+  const numbers = Array.from({ length: 1000 }, (_, i) => i % 10);
+  const expected = { greeting: numbers.join(''), squared: numbers.map(n => n * n) };
+  const result = Parallel.run({ name: '', value: 0, numbers });
+  assert.deepStrictEqual({ greeting: result.greeting, squared: Array.from(result.squared) }, expected);
+
+  const results = await Promise.all(Array.from({ length: 20 }, () => Parallel.runNative({ name: '', value: 0, numbers })));
+  for (const native of results) {
+    assert.strictEqual(native.greeting, expected.greeting);
+  }
+  assert.strictEqual(Parallel.run({ name: '', value: 0, numbers: [] }).greeting, '');
+  assert.throws(() => Parallel.run({ name: 'throw', value: 0, numbers }), /chunk failed/);
+  await assert.rejects(Parallel.runNative({ name: 'throw', value: 0, numbers }), /chunk failed/);
+});
+
+// --split-structs: единица трансляции на структуру и список исходников для node-gyp
+checkOption('split structs', schema(
+  [{ name: 'Signal', fields: [typedArray('samples', 'Float64Array', 'double'), field('input', 'InputData', 'InputData')] }],
+  [exported('Dsp', 'filter', 'Signal', 'OutputData', { isAsync: true })]
+), {
+  'generated_struct_Signal.hpp': ['#include "generated_struct_InputData.hpp"'],
+  'generated_sources.gypi': ['generated_struct_Signal.cpp'],
+}, { splitStructs: true });
+
+// Экспорты без входа или результата: без пакетных вариантов, код компилируется
+
+// Повторная генерация не трогает неизмененные файлы, файлы удаленной структуры удаляются
+test('incremental output', () => {
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'tscb-test-'));
+  try {
+    const Signal = { name: 'Signal', fields: [typedArray('samples', 'Float64Array', 'double')] };
+    const exports = [exported('Dsp', 'filter', 'Signal', 'OutputData')];
+    const generator = new CppGenerator();
+    generator.generateCppCode(schema([Signal], exports), dir, { splitStructs: true });
+    assert.ok(generator.takeWriteStats().written.length > 0);
+
+    const api = path.join(dir, 'generated_api.cpp');
+    const past = new Date(Date.now() - 60000);
+    fs.utimesSync(api, past, past);
+    const mtime = fs.statSync(api).mtimeMs;
+    generator.generateCppCode(schema([Signal], exports), dir, { splitStructs: true });
+    assert.deepStrictEqual(generator.takeWriteStats().written, []);
+    assert.strictEqual(fs.statSync(api).mtimeMs, mtime);
+
+    generator.generateCppCode(schema([], [exported('Solver', 'process', 'InputData', 'OutputData')]), dir, { splitStructs: true });
+    assert.ok(!fs.existsSync(path.join(dir, 'generated_struct_Signal.cpp')));
+    assert.ok(!fs.existsSync(path.join(dir, 'generated_struct_Signal.hpp')));
+    assert.ok(fs.existsSync(path.join(dir, 'generated_struct_InputData.cpp')));
+    assert.ok(!fs.readFileSync(path.join(dir, 'generated_sources.gypi'), 'utf-8').includes('Signal'));
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+});
+
+// Set/Map: вход из JS Set/Map или массива/объекта, на выходе настоящие Set/Map
+const CONTAINERS = { name: 'Catalog', fields: [
+  field('names', 'Set<string>', 'std::unordered_set<std::string>', { isSet: true, setElementType: 'std::string' }),
+  field('ids', 'Set<number>', 'std::unordered_set<double>', { isSet: true, setElementType: 'double' }),
+  field('scores', 'Map<string, number>', 'std::unordered_map<std::string, double>', { isMap: true, mapKeyType: 'std::string', mapValueType: 'double' }),
+  field('weights', 'Map<number, number>', 'std::unordered_map<double, double>', { isMap: true, mapKeyType: 'double', mapValueType: 'double' }),
+  field('sorted', 'Map<number, string>', 'std::unordered_map<double, std::string>', { isMap: true, mapKeyType: 'double', mapValueType: 'std::string', isFlatMap: true }),
+] };
+
+checkAddon('sets and maps', schema([CONTAINERS], [exported('Index', 'echo', 'Catalog', 'Catalog')]), `
+Catalog Index_echo(const Catalog& input) {
+    Catalog result = input;
+    result.sorted.append_unsorted(0, "zero");
+    result.sorted.sort_unique();
+    return result;
+}
+`, async ({ Index }) => {
+  const result = Index.echo({
+    names: new Set(['a', 'b']), ids: new Set([1, 2, 3]),
+    scores: new Map([['x', 1.5]]), weights: new Map([[1, 10], [2, 20]]), sorted: new Map([[3, 'c'], [1, 'a']]),
+  });
+  assert.ok(result.names instanceof Set && result.scores instanceof Map);
+  assert.deepStrictEqual([...result.names].sort(), ['a', 'b']);
+  assert.deepStrictEqual([...result.ids].sort(), [1, 2, 3]);
+  assert.deepStrictEqual([...result.scores], [['x', 1.5]]);
+  assert.deepStrictEqual([...result.weights].sort(), [[1, 10], [2, 20]]);
+  // flat_map отдается в порядке ключей
+  assert.deepStrictEqual([...result.sorted], [[0, 'zero'], [1, 'a'], [3, 'c']]);
+
+  // Массивы вместо Set и объекты вместо Map: ключи объекта приводятся ToNumber()
+  const plain = Index.echo({ names: ['a', 'a'], ids: [4], scores: { y: 2 }, weights: { 5: 50 }, sorted: { 2: 'b' } });
+  assert.deepStrictEqual([...plain.names], ['a']);
+  assert.deepStrictEqual([...plain.ids], [4]);
+  assert.deepStrictEqual([...plain.scores], [['y', 2]]);
+  assert.deepStrictEqual([...plain.weights], [[5, 50]]);
+  assert.deepStrictEqual([...plain.sorted], [[0, 'zero'], [2, 'b']]);
+});
+
+// @CppStruct({ layout: 'columnar' }): колонки в C++ и хелперы в TS
+const POINT = { name: 'Point', isColumnar: true, fields: [field('x', 'number', 'double'), field('visible', 'boolean', 'bool'), field('label', 'string', 'std::string', { isOptional: true })] };
+const CLOUD = { name: 'Cloud', fields: [array('points', 'Point', 'Point')] };
+
+checkOption('columnar', schema([POINT, CLOUD], [exported('Cloud', 'run', 'Cloud', 'Cloud')]), {
+  'generated_structs.hpp': ['PointColumns points'],
+  'generated_types.ts': ['export const PointColumns', 'MISSING_COLUMN_STRING'],
+});
+
+checkAddon('columnar round trip', schema([POINT, CLOUD], [exported('Points', 'scale', 'Cloud', 'Cloud')]), `
+Cloud Points_scale(const Cloud& input) {
+    Cloud result = input;
+    for (double& x : result.points.x) {
+        x *= 2;
+    }
+    Point extra = input.points.row(0);
+    extra.label = "extra";
+    result.points.push_back(extra);
+    return result;
+}
+`, async ({ Points }, output) => {
+  const { PointColumns } = require(path.join(output.dir, 'generated_types.js'));
+  const rows = [{ x: 1, visible: true, label: 'a' }, { x: 2, visible: false }, { x: 3, visible: true, label: 'a' }];
+  const columns = PointColumns.from(rows);
+  assert.deepStrictEqual(columns.strings, ['', 'a']);
+  assert.deepStrictEqual(Array.from({ length: 3 }, (_, i) => PointColumns.row(columns, i)), [...rows.slice(0, 1), { x: 2, visible: false, label: undefined }, rows[2]]);
+
+  const result = Points.scale({ points: columns }).points;
+  assert.strictEqual(result.length, 4);
+  assert.ok(result.x instanceof Float64Array);
+  assert.deepStrictEqual(Array.from(result.x), [2, 4, 6, 1]);
+  assert.deepStrictEqual(PointColumns.row(result, 3), { x: 1, visible: true, label: 'extra' });
+  // Отсутствующая строка в C++ читается пустой
+  assert.strictEqual(PointColumns.row(result, 1).label, '');
+
+  // Массив объектов тоже принимается на входе
+  const fromRows = Points.scale({ points: rows }).points;
+  assert.deepStrictEqual(Array.from(fromRows.x), [2, 4, 6, 1]);
+  assert.strictEqual(PointColumns.row(fromRows, 2).label, 'a');
+});
+
+// @CppExport({ noexcept: true }): несовпадение типа - TypeError из TryFromNapi без C++ исключения
+checkAddon('noexcept exports', schema([
+  { name: 'Pair', fields: [field('v', 'number', 'double'), field('w', 'number', 'double'), field('tag', 'string', 'std::string')] },
+], [exported('Geometry', 'dot', 'Pair', 'double', { noexcept: true })]), `
+double Geometry_dot(const Pair& input) noexcept {
+    return input.v * input.w + static_cast<double>(input.tag.size());
+}
+`, async ({ Geometry }, output) => {
+  assert.ok(output.read('generated_api.cpp').includes('Pair::TryFromNapi('));
+  assert.strictEqual(Geometry.dot({ v: 2, w: 3, tag: 'ab' }), 8);
+  assert.throws(() => Geometry.dot({ v: 2, w: 'x', tag: '' }), { name: 'TypeError', message: 'Pair.w: expected a number' });
+  assert.throws(() => Geometry.dot({ v: 2, w: 3, tag: 1 }), { name: 'TypeError', message: 'Pair.tag: expected a string' });
+});
+
+// Вход только из скаляров и TypedArray: обертка вызывает <name>_flat с позиционными аргументами
+checkAddon('positional scalar inputs', schema([
+  { name: 'Segment', fields: [field('x0', 'number', 'double'), field('x1', 'number', 'double'), field('scale', 'f32', 'float'), field('closed', 'boolean', 'bool'), typedArray('weights', 'Float64Array', 'double')] },
+], [exported('Geometry', 'length', 'Segment', 'double')]), `
+double Geometry_length(const Segment& input) {
+    double weight = 0;
+    for (double value : input.weights) {
+        weight += value;
+    }
+    return (input.x1 - input.x0) * input.scale + weight + (input.closed ? 100 : 0);
+}
+`, async ({ Geometry }, output) => {
+  assert.ok(output.read('generated_api.ts').includes('addon.Geometry_length_flat(input.x0, input.x1, input.scale, input.closed, input.weights)'));
+  const segment = { x0: 1, x1: 4, scale: 0.5, closed: true, weights: new Float64Array([1, 2]) };
+  assert.strictEqual(Geometry.length(segment), 104.5);
+
+  const addon = require(path.join(output.root, 'build', 'Release', 'addon.node'));
+  assert.strictEqual(addon.Geometry_length_flat(0, 2, 1, false, new Float64Array(0)), 2);
+  // Обычная точка входа с объектом остается
+  assert.strictEqual(addon.Geometry_length(segment), 104.5);
+  assert.throws(() => Geometry.length({ ...segment, x1: 'x' }), /x1/);
+});
+
+// @CppAsync({ coalesce }): вызовы окна уходят одним <name>_settle
+checkOption('coalesce', schema([], [
+  exported('Solver', 'run', 'InputData', 'OutputData', { isAsync: true, coalesce: { windowMs: 1, maxItems: 32 } }),
+]), {
+  'generated_api.cpp': ['Solver_run_settle_wrapper'],
+  'generated_api.ts': ['new Coalescer<', 'addon.Solver_run_settle(inputs)'],
+});
+
+// Ошибка одного входа отклоняет только его вызов, остальные выполняются один раз
+checkAddon('coalesced calls', schema([], [
+  exported('Batcher', 'run', 'InputData', 'OutputData', { isAsync: true, coalesce: { windowMs: 0, maxItems: 8 } }),
+  exported('Batcher', 'calls', 'void', 'OutputData'),
+]), `
+#include <atomic>
+
+static std::atomic<int> calls{0};
+
+${PROCESS_IMPL.replace('Solver_process', 'Batcher_run').replace('    if (input.name', '    calls++;\n    if (input.name')}
+OutputData Batcher_calls() {
+    OutputData result;
+    result.greeting = std::to_string(calls.load());
+    return result;
+}
+`, async ({ Batcher }) => {
+  const inputs = Array.from({ length: 20 }, (_, i) => ({ name: i === 5 ? 'bad' : `n${i}`, value: i, numbers: [i] }));
+  inputs[9] = { name: 42, value: 9, numbers: [] };
+  const settled = await Promise.allSettled(inputs.map(input => Batcher.run(input)));
+  assert.strictEqual(settled[5].status, 'rejected');
+  assert.match(settled[5].reason.message, /bad input/);
+  assert.strictEqual(settled[9].status, 'rejected');
+  const fulfilled = settled.filter(result => result.status === 'fulfilled');
+  assert.strictEqual(fulfilled.length, 18);
+  assert.strictEqual(settled[19].value.greeting, 'Hello, n19');
+  // Декодированные входы выполнены ровно по разу, без повтора пакета
+  assert.strictEqual(Batcher.calls().greeting, '19');
+});
+
+// bridgeMemory(): вход незавершенного async вызова учитывается до его завершения
+checkAddon('native memory gauges', schema([], [
+  exported('Memory', 'slow', 'InputData', 'OutputData', { isAsync: true }),
+]), `
+OutputData Memory_slow(const InputData& input) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    OutputData result;
+    result.greeting = input.name;
+    return result;
+}
+`, async ({ Memory, bridgeMemory }) => {
+  const pending = Memory.slow({ name: 'x'.repeat(100000), value: 0, numbers: new Array(1000).fill(1) });
+  const during = bridgeMemory().Memory_slow;
+  assert.ok(during.bytes > 100000 + 1000 * 8, `bytes ${during.bytes}`);
+  assert.strictEqual((await pending).greeting.length, 100000);
+  const after = bridgeMemory().Memory_slow;
+  assert.strictEqual(after.bytes, 0);
+  assert.ok(after.peakBytes >= during.bytes);
+});
+
+// @CppField({ intern: true }) и encoding: 'latin1'
+checkOption('intern', schema([
+  { name: 'Tag', fields: [field('kind', 'string', 'std::string', { isInterned: true }), field('code', 'string', 'std::string', { isLatin1: true })] },
+], [exported('Tags', 'echo', 'Tag', 'Tag'), exported('Tags', 'echoAsync', 'Tag', 'Tag', { isAsync: true })]), {
+  'generated_structs.hpp': ['tscb::InternedString kind'],
+  'generated_structs.cpp': ['tscb::ReadInterned', 'tscb::ReadLatin1'],
+});
+
+
+checkAddon('interned strings', schema([
+  { name: 'Tag', fields: [field('kind', 'string', 'std::string', { isInterned: true }), field('code', 'string', 'std::string', { isLatin1: true })] },
+], [exported('Tags', 'echo', 'Tag', 'Tag'), exported('Tags', 'echoAsync', 'Tag', 'Tag', { isAsync: true })]), `
+Tag Tags_echo(const Tag& input) {
+    Tag result = input;
+    result.code = input.code + "|" + std::to_string(input.kind.view().size());
+    return result;
+}
+
+Tag Tags_echoAsync(const Tag& input) {
+    return Tags_echo(input);
+}
+`, async ({ Tags }) => {
+  const long = 'k'.repeat(200);
+  for (const kind of ['click', 'клик', long, '']) {
+    assert.deepStrictEqual(Tags.echo({ kind, code: 'é' }), { kind, code: `é|${Buffer.byteLength(kind)}` });
+    assert.deepStrictEqual(await Tags.echoAsync({ kind, code: 'a' }), { kind, code: `a|${Buffer.byteLength(kind)}` });
+  }
+  for (let i = 0; i < 100; i++) {
+    assert.strictEqual(Tags.echo({ kind: `k${i % 10}`, code: '' }).kind, `k${i % 10}`);
+  }
+  assert.throws(() => Tags.echo({ kind: 'click', code: 'Ω' }), /Expected a Latin-1 string/);
+});
+
+// @CppAsync({ recycle }): вход и результат следующего вызова сохраняют емкость прошлого
+checkAddon('recycled objects', schema([], [
+  exported('Pool', 'fill', 'InputData', 'OutputData', { isAsync: true, signature: 'out', recycle: { maxFree: 4 } }),
+  exported('Pool', 'fillNative', 'InputData', 'OutputData', { isAsync: true, signature: 'out', pool: 'native', recycle: { maxFree: 4 } }),
+]), `
+void Pool_fill(const InputData& input, OutputData& result) {
+    // Пустой результат пришел из пула со старой емкостью
+    result.greeting = std::to_string(input.numbers.capacity()) + "/" + std::to_string(result.squared.capacity()) + "/" + std::to_string(result.squared.size());
+    for (double number : input.numbers) {
+        result.squared.push_back(number * number);
+    }
+}
+
+void Pool_fillNative(const InputData& input, OutputData& result) {
+    Pool_fill(input, result);
+}
+`, async ({ Pool }) => {
+  for (const fill of [Pool.fill, Pool.fillNative]) {
+    const first = await fill({ name: '', value: 0, numbers: new Array(100).fill(2) });
+    assert.strictEqual(first.squared.length, 100);
+    const second = await fill({ name: '', value: 0, numbers: [3] });
+    const [inputCapacity, resultCapacity, resultSize] = second.greeting.split('/').map(Number);
+    assert.ok(inputCapacity >= 100, second.greeting);
+    assert.ok(resultCapacity >= 100, second.greeting);
+    assert.strictEqual(resultSize, 0);
+    assert.deepStrictEqual(Array.from(second.squared), [9]);
+  }
+});
+
+// example/load-test.ts на собранном примере: ячейки, пропуск по --max-inflight и сравнение с --baseline
+test('example load test', async t => {
+  if (ADDON_SKIP) {
+    t.skip(ADDON_SKIP);
+    return;
+  }
+  const example = path.join(__dirname, '..', 'example');
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tscb-test-'));
+  addonRoots.push(root);
+  fs.cpSync(path.join(example, 'src'), path.join(root, 'src'), { recursive: true });
+  for (const file of ['implementation.cpp', 'load-test.ts']) {
+    fs.copyFileSync(path.join(example, file), path.join(root, file));
+  }
+  const output = { root, dir: path.join(root, 'src'), read: file => fs.readFileSync(path.join(root, 'src', file), 'utf-8') };
+  const sources = ['implementation.cpp', 'src/generated_structs.cpp', 'src/generated_api.cpp'].map(file => path.join(root, file));
+  compileAddon(sources, output.dir, path.join(root, 'build', 'Release', 'addon.node'));
+  loadApi(output);
+  const ts = require('typescript');
+  const { outputText } = ts.transpileModule(fs.readFileSync(path.join(root, 'load-test.ts'), 'utf-8'), {
+    compilerOptions: { module: ts.ModuleKind.CommonJS, target: ts.ScriptTarget.ES2020 },
+  });
+  fs.writeFileSync(path.join(root, 'load-test.js'), outputText);
+
+  const loadTest = (...args) => spawnSync(process.execPath, ['load-test.js', '--modes', 'sync,native', '--concurrency', '1,4',
+    '--sizes', '10,1000', '--max-inflight', '1000', '--duration', '20', ...args], { cwd: root, encoding: 'utf-8' });
+  const first = loadTest('--out', 'first.json');
+  assert.strictEqual(first.status, 0, first.stderr);
+  const report = JSON.parse(fs.readFileSync(path.join(root, 'first.json'), 'utf-8'));
+  assert.strictEqual(report.meta.node, process.version);
+  assert.strictEqual(report.results.length, 8);
+  assert.deepStrictEqual(report.results.filter(row => row.skipped).map(row => `${row.mode} ${row.concurrency}x${row.size}`), ['sync 4x1000', 'native 4x1000']);
+  for (const row of report.results.filter(row => !row.skipped)) {
+    assert.ok(row.calls > 0 && row.throughput > 0 && row.p50Ms <= row.p99Ms && row.p99Ms <= row.maxMs, JSON.stringify(row));
+  }
+  // native держит вызов 500 мс в реализации примера
+  assert.ok(report.results.find(row => row.mode === 'native' && !row.skipped).p50Ms >= 500);
+
+  // Базовый прогон заведомо хуже текущего: регрессий нет
+  for (const row of report.results.filter(row => !row.skipped)) {
+    Object.assign(row, { throughput: 0, p99Ms: 1e12 });
+  }
+  fs.writeFileSync(path.join(root, 'baseline.json'), JSON.stringify(report));
+  const second = loadTest('--out', 'second.json', '--baseline', 'baseline.json', '--modes', 'sync');
+  assert.strictEqual(second.status, 0, second.stderr);
+  assert.match(second.stdout, /No regressions/);
+
+  report.results.find(row => row.mode === 'sync' && row.size === 10 && row.concurrency === 1).throughput = 1e12;
+  fs.writeFileSync(path.join(root, 'baseline.json'), JSON.stringify(report));
+  const third = loadTest('--out', 'third.json', '--baseline', 'baseline.json', '--modes', 'sync');
+  assert.strictEqual(third.status, 1);
+  assert.match(third.stderr, /1 regression\(s\)/);
+  assert.match(third.stderr, /sync c=1 size=10: throughput/);
+});
+
+// Экспорты создаются при первом чтении свойства, generated_addon.ts загружает addon при первом вызове
+checkAddon('lazy exports', schema([], [
+  exported('Solver', 'process', 'InputData', 'OutputData'),
+  exported('Solver', 'other', 'InputData', 'OutputData'),
+]), PROCESS_IMPL + PROCESS_IMPL.replace('Solver_process', 'Solver_other'), async ({ Solver }, output) => {
+  const addonPath = path.join(output.root, 'build', 'Release', 'addon.node');
+  assert.strictEqual(require.cache[addonPath], undefined);
+  assert.strictEqual(Solver.process({ name: 'lazy', value: 0, numbers: [] }).greeting, 'Hello, lazy');
+  assert.ok(require.cache[addonPath]);
+
+  const addon = require(addonPath);
+  assert.strictEqual(typeof Object.getOwnPropertyDescriptor(addon, 'Solver_other').get, 'function');
+  assert.strictEqual(addon.Solver_other({ name: 'x', value: 0, numbers: [] }).greeting, 'Hello, x');
+  const descriptor = Object.getOwnPropertyDescriptor(addon, 'Solver_other');
+  assert.strictEqual(descriptor.get, undefined);
+  assert.strictEqual(typeof descriptor.value, 'function');
+  assert.ok(Object.keys(addon).includes('Solver_process_batch'));
+});
+
+// ts-cpp-bridge build: ключ кэша по исходникам и окружению, повторная сборка копирует бинарник из кэша
+test('build cache', () => {
+  const { cachedBuild, computeBuildKey, buildConfiguration, buildCommandEnv } = require('../dist/prebuild');
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'tscb-test-'));
+  const saved = { CXXFLAGS: process.env.CXXFLAGS, npm_config_debug: process.env.npm_config_debug };
+  try {
+    delete process.env.CXXFLAGS;
+    delete process.env.npm_config_debug;
+    const project = path.join(root, 'project');
+    fs.mkdirSync(project);
+    fs.writeFileSync(path.join(project, 'binding.gyp'), '{ "targets": [] }');
+    fs.writeFileSync(path.join(project, 'addon.cpp'), 'int x = 1;\n');
+    // Вместо node-gyp: пишет build/<Release|Debug>/addon.node и считает запуски
+    fs.writeFileSync(path.join(project, 'fake-build.js'), `
+      const fs = require('fs');
+      const out = 'build/' + (process.argv.includes('--debug') ? 'Debug' : 'Release');
+      fs.mkdirSync(out, { recursive: true });
+      fs.writeFileSync(out + '/addon.node', 'binary');
+      fs.appendFileSync('runs.txt', 'x');
+    `);
+    const buildCommand = `"${process.execPath}" fake-build.js`;
+    const runs = () => fs.readFileSync(path.join(project, 'runs.txt'), 'utf-8').length;
+    const options = { projectDir: project, cacheDir: path.join(root, 'cache'), buildCommand };
+
+    const miss = cachedBuild(options);
+    assert.deepStrictEqual([miss.hit, miss.files], [false, ['addon.node']]);
+    fs.rmSync(path.join(project, 'build'), { recursive: true });
+    const hit = cachedBuild(options);
+    assert.deepStrictEqual([hit.hit, hit.key, runs()], [true, miss.key, 1]);
+    assert.ok(fs.existsSync(path.join(project, 'build', 'Release', 'addon.node')));
+
+    fs.writeFileSync(path.join(project, 'addon.cpp'), 'int x = 2;\n');
+    assert.notStrictEqual(computeBuildKey(project, buildCommand), miss.key);
+    const edited = computeBuildKey(project, buildCommand);
+    process.env.CXXFLAGS = '-O0';
+    assert.notStrictEqual(computeBuildKey(project, buildCommand), edited);
+    delete process.env.CXXFLAGS;
+
+    assert.strictEqual(buildConfiguration('node-gyp rebuild'), 'Release');
+    assert.strictEqual(buildConfiguration('node-gyp rebuild --debug'), 'Debug');
+    const debug = cachedBuild({ ...options, buildCommand: `${buildCommand} --debug` });
+    assert.strictEqual(debug.hit, false);
+    assert.notStrictEqual(debug.key, edited);
+    assert.ok(fs.existsSync(path.join(project, 'build', 'Debug', 'addon.node')));
+
+    // node-gyp из поставки npm доступен без npx и глобальной установки
+    const result = spawnSync('node-gyp --version', { env: buildCommandEnv(), shell: true, encoding: 'utf-8' });
+    assert.strictEqual(result.status, 0, result.stderr);
+  } finally {
+    for (const [name, value] of Object.entries(saved)) {
+      if (value === undefined) {
+        delete process.env[name];
+      } else {
+        process.env[name] = value;
+      }
+    }
+    fs.rmSync(root, { recursive: true, force: true });
+  }
+});